@@ -0,0 +1,1347 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: assetcookerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "assetcookerclass.h"
+#include "../Engine/loadlogclass.h"
+#include "../Engine/mappedfileclass.h"
+#include "../Engine/meshcacheclass.h"
+#include "../Engine/meshwelderclass.h"
+#include "../Engine/tangentgeneratorclass.h"
+#include "../Engine/vertexlayouts.h"
+#include "bcdecoderclass.h"
+#include "bcencoderclass.h"
+#include "ddsreaderclass.h"
+#include "ddswriterclass.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <sstream>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Textures that are not sRGB color tiling across the surface, by the sampler and the use the shaders make of them.
+static const AssetCookerClass::TextureRuleType TEXTURE_RULES[] =
+{
+	{ "fire01.dds", MIP_CONTENT_COLOR, MIP_ADDRESS_CLAMP },
+	{ "noise01.dds", MIP_CONTENT_LINEAR, MIP_ADDRESS_WRAP },
+	{ "alpha01.dds", MIP_CONTENT_LINEAR, MIP_ADDRESS_CLAMP },
+	{ "normal.dds", MIP_CONTENT_NORMAL, MIP_ADDRESS_WRAP },
+	{ "2k_earth_normal_map.dds", MIP_CONTENT_NORMAL, MIP_ADDRESS_WRAP }
+};
+
+// Textures of the same format and size that are drawn together, the fire shader samples all three of the first.
+static const AssetCookerClass::TextureArrayRuleType TEXTURE_ARRAYS[] =
+{
+	{ "fire_array.dds", { "fire01.dds", "noise01.dds", "alpha01.dds" } },
+	{ "planet_array.dds", { "2k_saturn.dds", "2k_earth_with_clouds.dds" } },
+	{ "prop_array.dds", { "rocket.dds", "satellite.dds" } },
+	{ "scenery_array.dds", { "tree.dds", "saturnring.dds" } }
+};
+
+
+AssetCookerClass::AssetCookerClass()
+{
+	m_OldArchive = 0;
+	m_JobSystem = 0;
+	m_mipFilter = MIP_FILTER_KAISER;
+	m_useBc7 = false;
+	memset(&m_statistics, 0, sizeof(StatisticsType));
+}
+
+
+AssetCookerClass::AssetCookerClass(const AssetCookerClass& other)
+{
+}
+
+
+AssetCookerClass::~AssetCookerClass()
+{
+}
+
+
+bool AssetCookerClass::Initialize(const char* inputDirectory, const char* archiveFilename, bool force, MipFilterType mipFilter, bool useBc7)
+{
+	bool result;
+
+
+	m_archiveFilename = archiveFilename;
+	m_mipFilter = mipFilter;
+	m_useBc7 = useBc7;
+
+	// Create the job system object, mip levels are filtered and compressed on it a band of rows at a time.
+	m_JobSystem = new JobSystemClass;
+	if(!m_JobSystem)
+	{
+		return false;
+	}
+
+	result = m_JobSystem->Initialize(0, 0);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Find every mesh and texture in the data folder.
+	result = FindInputs(inputDirectory);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Open the archive from the last run so unchanged assets can be carried over, unless everything is to be cooked again.
+	if(!force)
+	{
+		m_OldArchive = new AssetArchiveClass;
+		if(!m_OldArchive)
+		{
+			return false;
+		}
+
+		result = m_OldArchive->Initialize(archiveFilename);
+		if(!result)
+		{
+			delete m_OldArchive;
+			m_OldArchive = 0;
+		}
+	}
+
+	return true;
+}
+
+
+bool AssetCookerClass::Cook()
+{
+	filesystem::path tempFilename;
+	error_code error;
+	bool result;
+
+
+	// Hash every source along with the settings it is cooked with.
+	result = HashInputs();
+	if(!result)
+	{
+		return false;
+	}
+
+	// Group the textures the array rules pack together.
+	FindArrays();
+
+	// Leave the archive alone if it already holds exactly these sources.
+	if(IsUpToDate())
+	{
+		printf("%s is up to date, %d sources\n", m_archiveFilename.c_str(), (int)m_inputs.size());
+		return true;
+	}
+
+	// Write the new archive next to the old one so a failed cook never leaves a broken archive behind.
+	tempFilename = m_archiveFilename + ".tmp";
+
+	result = WriteArchive(tempFilename.string());
+	if(!result)
+	{
+		filesystem::remove(tempFilename, error);
+		return false;
+	}
+
+	// Close the old archive before replacing it, a file that is still mapped cannot be replaced on Windows.
+	if(m_OldArchive)
+	{
+		m_OldArchive->Shutdown();
+		delete m_OldArchive;
+		m_OldArchive = 0;
+	}
+
+	filesystem::rename(tempFilename, m_archiveFilename, error);
+	if(error)
+	{
+		fprintf(stderr, "could not replace %s: %s\n", m_archiveFilename.c_str(), error.message().c_str());
+		filesystem::remove(tempFilename, error);
+		return false;
+	}
+
+	printf("%s: %d entries, %d sources cooked (%llu bytes), %d carried over (%llu bytes)\n", m_archiveFilename.c_str(),
+		   (int)m_entries.size(), m_statistics.cooked, m_statistics.cookedBytes, m_statistics.reused, m_statistics.reusedBytes);
+
+	return true;
+}
+
+
+void AssetCookerClass::Shutdown()
+{
+	// Release the old archive.
+	if(m_OldArchive)
+	{
+		m_OldArchive->Shutdown();
+		delete m_OldArchive;
+		m_OldArchive = 0;
+	}
+
+	// Release the job system object.
+	if(m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+		delete m_JobSystem;
+		m_JobSystem = 0;
+	}
+
+	m_inputs.clear();
+	m_arrays.clear();
+	m_entries.clear();
+
+	return;
+}
+
+
+bool AssetCookerClass::Verify()
+{
+	AssetArchiveClass* Archive;
+	const AssetArchiveClass::EntryType* entry;
+	const AssetArchiveClass::EntryType* arrayEntry;
+	const AssetArchiveClass::SliceType* slice;
+	int textureCount, failedCount, i;
+	bool result;
+
+
+	// Open the archive as the engine would.
+	Archive = new AssetArchiveClass;
+	if(!Archive)
+	{
+		return false;
+	}
+
+	result = Archive->Initialize(m_archiveFilename.c_str());
+	if(!result)
+	{
+		fprintf(stderr, "could not open %s\n", m_archiveFilename.c_str());
+		delete Archive;
+		return false;
+	}
+
+	// Check every blob against its hash, then decode every texture on the CPU and hold it up against its source.
+	textureCount = 0;
+	failedCount = 0;
+	for(i=0; i<Archive->GetEntryCount(); i++)
+	{
+		entry = Archive->GetEntry(i);
+
+		result = Archive->Verify(entry);
+		if(!result)
+		{
+			fprintf(stderr, "%s: the blob does not match its hash\n", entry->name);
+			failedCount++;
+			continue;
+		}
+
+		if(entry->type == ASSET_TYPE_TEXTURE)
+		{
+			result = VerifyTexture(entry->name, Archive->GetData(entry), (size_t)entry->size, 0);
+			if(!result)
+			{
+				failedCount++;
+			}
+			textureCount++;
+		}
+
+		// A texture packed into an array is held up against its source through its slice.
+		if(entry->type == ASSET_TYPE_TEXTURE_SLICE)
+		{
+			slice = (const AssetArchiveClass::SliceType*)Archive->GetData(entry);
+			arrayEntry = 0;
+			if(entry->size == sizeof(AssetArchiveClass::SliceType) && slice->array[ASSET_ARCHIVE_NAME_LENGTH - 1] == 0)
+			{
+				arrayEntry = Archive->Find(slice->array, ASSET_TYPE_TEXTURE);
+			}
+
+			if(arrayEntry)
+			{
+				result = VerifyTexture(entry->name, Archive->GetData(arrayEntry), (size_t)arrayEntry->size, (int)slice->slice);
+			}
+			else
+			{
+				fprintf(stderr, "%s: the texture array it is packed into is not in the archive\n", entry->name);
+				result = false;
+			}
+
+			if(!result)
+			{
+				failedCount++;
+			}
+			textureCount++;
+		}
+	}
+
+	printf("%s: %d entries verified, %d textures decoded, %d failed\n", m_archiveFilename.c_str(), Archive->GetEntryCount(), textureCount, failedCount);
+
+	// Release the archive.
+	Archive->Shutdown();
+	delete Archive;
+	Archive = 0;
+
+	return failedCount == 0;
+}
+
+
+bool AssetCookerClass::FindInputs(const char* inputDirectory)
+{
+	filesystem::directory_iterator file;
+	error_code error;
+	InputType input;
+	string extension;
+	size_t i;
+
+
+	file = filesystem::directory_iterator(filesystem::path(inputDirectory), error);
+	if(error)
+	{
+		fprintf(stderr, "could not read %s: %s\n", inputDirectory, error.message().c_str());
+		return false;
+	}
+
+	// Text files are meshes and DDS files are textures, anything else in the folder is not an asset.
+	for(; file!=filesystem::directory_iterator(); file++)
+	{
+		if(!file->is_regular_file())
+		{
+			continue;
+		}
+
+		extension = file->path().extension().string();
+		for(i=0; i<extension.size(); i++)
+		{
+			extension[i] = (char)tolower((unsigned char)extension[i]);
+		}
+
+		if(extension == ".txt")
+		{
+			input.type = ASSET_TYPE_MESH;
+		}
+		else if(extension == ".dds")
+		{
+			input.type = ASSET_TYPE_TEXTURE;
+		}
+		else
+		{
+			continue;
+		}
+
+		input.filename = file->path().string();
+		input.name = AssetArchiveClass::GetAssetName(input.filename);
+		input.sourceHash = 0;
+		input.array = -1;
+
+		if(input.name.size() >= ASSET_ARCHIVE_NAME_LENGTH)
+		{
+			fprintf(stderr, "%s: the name is too long for the archive\n", input.filename.c_str());
+			return false;
+		}
+
+		m_inputs.push_back(input);
+	}
+
+	// The table of contents is sorted by name so the engine can binary search it.
+	sort(m_inputs.begin(), m_inputs.end(), [](const InputType& a, const InputType& b)
+	{
+		return strcmp(a.name.c_str(), b.name.c_str()) < 0;
+	});
+
+	// Names are case blind, so two files differing only in case would end up as one asset.
+	for(i=1; i<m_inputs.size(); i++)
+	{
+		if(m_inputs[i].name == m_inputs[i - 1].name)
+		{
+			fprintf(stderr, "%s and %s have the same asset name\n", m_inputs[i - 1].filename.c_str(), m_inputs[i].filename.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool AssetCookerClass::HashInputs()
+{
+	MappedFileClass sourceFile;
+	bool result;
+	size_t i;
+
+
+	for(i=0; i<m_inputs.size(); i++)
+	{
+		result = sourceFile.Initialize(m_inputs[i].filename.c_str());
+		if(!result)
+		{
+			fprintf(stderr, "could not read %s\n", m_inputs[i].filename.c_str());
+			return false;
+		}
+
+		m_inputs[i].sourceHash = AssetArchiveClass::Hash(sourceFile.GetData(), sourceFile.GetSize(), GetSettingsHash(m_inputs[i]));
+
+		sourceFile.Shutdown();
+	}
+
+	return true;
+}
+
+
+void AssetCookerClass::FindArrays()
+{
+	ArrayType array;
+	const char* member;
+	unsigned long long hash;
+	size_t rule, i;
+	int j;
+
+
+	m_arrays.clear();
+
+	for(rule=0; rule<sizeof(TEXTURE_ARRAYS) / sizeof(TEXTURE_ARRAYS[0]); rule++)
+	{
+		// Every member has to be in the data folder and in no other array, otherwise they are all cooked on their own.
+		array.members.clear();
+		for(j=0; j<TEXTURE_ARRAY_MAX_MEMBERS && TEXTURE_ARRAYS[rule].members[j]; j++)
+		{
+			member = TEXTURE_ARRAYS[rule].members[j];
+			for(i=0; i<m_inputs.size(); i++)
+			{
+				if(m_inputs[i].type == ASSET_TYPE_TEXTURE && m_inputs[i].name == member && m_inputs[i].array < 0)
+				{
+					break;
+				}
+			}
+
+			if(i == m_inputs.size())
+			{
+				break;
+			}
+			array.members.push_back((int)i);
+		}
+
+		if(j < TEXTURE_ARRAY_MAX_MEMBERS && TEXTURE_ARRAYS[rule].members[j])
+		{
+			printf("skipped   %s: %s is not in the data folder or is in another array\n", TEXTURE_ARRAYS[rule].name, TEXTURE_ARRAYS[rule].members[j]);
+			continue;
+		}
+
+		// The array has a name of its own in the archive, a source with that name would hide it.
+		for(i=0; i<m_inputs.size(); i++)
+		{
+			if(m_inputs[i].name == TEXTURE_ARRAYS[rule].name)
+			{
+				break;
+			}
+		}
+
+		if(i < m_inputs.size() || array.members.size() < 2)
+		{
+			printf("skipped   %s: the name is taken or it has fewer than two textures\n", TEXTURE_ARRAYS[rule].name);
+			continue;
+		}
+
+		// The array is packed again when any of its members changes, or the order they are packed in.
+		array.input.filename = "";
+		array.input.name = TEXTURE_ARRAYS[rule].name;
+		array.input.type = ASSET_TYPE_TEXTURE;
+		array.input.array = -1;
+
+		hash = AssetArchiveClass::Hash(array.input.name.c_str(), array.input.name.size(), ASSET_ARCHIVE_HASH_SEED);
+		for(j=0; j<(int)array.members.size(); j++)
+		{
+			hash = AssetArchiveClass::Hash(m_inputs[array.members[j]].name.c_str(), m_inputs[array.members[j]].name.size(), hash);
+			hash = AssetArchiveClass::Hash(&m_inputs[array.members[j]].sourceHash, sizeof(unsigned long long), hash);
+		}
+		array.input.sourceHash = hash;
+
+		for(j=0; j<(int)array.members.size(); j++)
+		{
+			m_inputs[array.members[j]].array = (int)m_arrays.size();
+		}
+
+		m_arrays.push_back(array);
+	}
+
+	return;
+}
+
+
+bool AssetCookerClass::IsUpToDate()
+{
+	int entryCount;
+	size_t i;
+
+
+	if(!m_OldArchive)
+	{
+		return false;
+	}
+
+	// Every entry the sources would cook to has to be there unchanged, and nothing else.  A texture packed into an array is
+	// only its slice entry.
+	entryCount = 0;
+	for(i=0; i<m_inputs.size(); i++)
+	{
+		if(!FindReusable(m_inputs[i], m_inputs[i].array >= 0 ? (unsigned int)ASSET_TYPE_TEXTURE_SLICE : m_inputs[i].type))
+		{
+			return false;
+		}
+		entryCount++;
+
+		if(m_inputs[i].type == ASSET_TYPE_MESH)
+		{
+			if(!FindReusable(m_inputs[i], ASSET_TYPE_TANGENT_VERTICES))
+			{
+				return false;
+			}
+			entryCount++;
+		}
+	}
+
+	for(i=0; i<m_arrays.size(); i++)
+	{
+		if(!FindReusable(m_arrays[i].input, ASSET_TYPE_TEXTURE))
+		{
+			return false;
+		}
+		entryCount++;
+	}
+
+	return entryCount == m_OldArchive->GetEntryCount();
+}
+
+
+bool AssetCookerClass::WriteArchive(const string& filename)
+{
+	ofstream fout;
+	AssetArchiveClass::HeaderType header;
+	vector<char> table;
+	size_t offset, entryCount, i;
+	bool result;
+
+
+	// Count the entries up front, a mesh cooks to the mesh itself and its tangent frames.  Each texture array adds one if its
+	// textures can be packed, the table keeps room for it either way.
+	entryCount = m_arrays.size();
+	for(i=0; i<m_inputs.size(); i++)
+	{
+		entryCount += m_inputs[i].type == ASSET_TYPE_MESH ? 2 : 1;
+	}
+
+	fout.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if(fout.fail())
+	{
+		fprintf(stderr, "could not create %s\n", filename.c_str());
+		return false;
+	}
+
+	// Leave room for the header and the table of contents, they are filled in once every blob has its place.
+	table.resize(sizeof(AssetArchiveClass::HeaderType) + entryCount * sizeof(AssetArchiveClass::EntryType), 0);
+	fout.write(table.data(), (streamsize)table.size());
+	offset = table.size();
+
+	m_entries.clear();
+
+	for(i=0; i<m_inputs.size(); i++)
+	{
+		if(m_inputs[i].type == ASSET_TYPE_MESH)
+		{
+			// The mesh and its tangent frames come from the same source, so they are carried over or cooked together.
+			if(FindReusable(m_inputs[i], ASSET_TYPE_MESH) && FindReusable(m_inputs[i], ASSET_TYPE_TANGENT_VERTICES))
+			{
+				result = ReuseAsset(fout, m_inputs[i], ASSET_TYPE_MESH, offset) &&
+						 ReuseAsset(fout, m_inputs[i], ASSET_TYPE_TANGENT_VERTICES, offset);
+			}
+			else
+			{
+				result = CookMesh(fout, m_inputs[i], offset);
+			}
+		}
+		else if(m_inputs[i].array >= 0)
+		{
+			// Textures packed into an array are cooked with it once the rest are done.
+			continue;
+		}
+		else
+		{
+			if(FindReusable(m_inputs[i], ASSET_TYPE_TEXTURE))
+			{
+				result = ReuseAsset(fout, m_inputs[i], ASSET_TYPE_TEXTURE, offset);
+			}
+			else
+			{
+				result = CookTexture(fout, m_inputs[i], offset);
+			}
+		}
+
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	for(i=0; i<m_arrays.size(); i++)
+	{
+		result = CookTextureArray(fout, m_arrays[i], offset);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	// The arrays went in after the other assets, so sort the table of contents again for Find.
+	sort(m_entries.begin(), m_entries.end(), [](const AssetArchiveClass::EntryType& a, const AssetArchiveClass::EntryType& b)
+	{
+		return AssetArchiveClass::Compare(a.name, a.type, b) < 0;
+	});
+
+	// Fill in the header and the table of contents.
+	memset(&header, 0, sizeof(header));
+	header.magic = ASSET_ARCHIVE_MAGIC;
+	header.version = ASSET_ARCHIVE_VERSION;
+	header.alignment = ASSET_ARCHIVE_ALIGNMENT;
+	header.entryCount = (unsigned int)m_entries.size();
+	header.fileSize = (unsigned long long)offset;
+	header.tableHash = AssetArchiveClass::Hash(m_entries.data(), m_entries.size() * sizeof(AssetArchiveClass::EntryType), ASSET_ARCHIVE_HASH_SEED);
+
+	fout.seekp(0, ios::beg);
+	fout.write((const char*)&header, sizeof(header));
+	fout.write((const char*)m_entries.data(), (streamsize)(m_entries.size() * sizeof(AssetArchiveClass::EntryType)));
+
+	fout.close();
+	if(fout.fail())
+	{
+		fprintf(stderr, "could not write %s\n", filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+bool AssetCookerClass::WriteAsset(ofstream& fout, const InputType& input, unsigned int type, const unsigned char* data, size_t size,
+								  size_t& offset)
+{
+	static const char padding[ASSET_ARCHIVE_ALIGNMENT] = {};
+	AssetArchiveClass::EntryType entry;
+	size_t paddingSize;
+
+
+	// Start every blob on a page of its own.
+	paddingSize = (ASSET_ARCHIVE_ALIGNMENT - offset % ASSET_ARCHIVE_ALIGNMENT) % ASSET_ARCHIVE_ALIGNMENT;
+	fout.write(padding, (streamsize)paddingSize);
+	offset += paddingSize;
+
+	memset(&entry, 0, sizeof(entry));
+	memcpy(entry.name, input.name.c_str(), input.name.size());
+	entry.type = type;
+	entry.offset = (unsigned long long)offset;
+	entry.size = (unsigned long long)size;
+	entry.sourceHash = input.sourceHash;
+	entry.contentHash = AssetArchiveClass::Hash(data, size, ASSET_ARCHIVE_HASH_SEED);
+
+	fout.write((const char*)data, (streamsize)size);
+	if(fout.fail())
+	{
+		return false;
+	}
+
+	offset += size;
+	m_entries.push_back(entry);
+
+	return true;
+}
+
+
+bool AssetCookerClass::ReuseAsset(ofstream& fout, const InputType& input, unsigned int type, size_t& offset)
+{
+	const AssetArchiveClass::EntryType* entry;
+	bool result;
+
+
+	// Copy the blob over from the old archive, its content hash was checked when it was found.
+	entry = FindReusable(input, type);
+
+	result = WriteAsset(fout, input, type, m_OldArchive->GetData(entry), (size_t)entry->size, offset);
+	if(!result)
+	{
+		return false;
+	}
+
+	if(type == input.type)
+	{
+		printf("unchanged %s\n", input.name.c_str());
+		m_statistics.reused++;
+	}
+	m_statistics.reusedBytes += entry->size;
+
+	return true;
+}
+
+
+bool AssetCookerClass::CookMesh(ofstream& fout, const InputType& input, size_t& offset)
+{
+	MeshCacheClass mesh;
+	ostringstream stream;
+	string filename, meshData;
+	TangentVertexLayout::VertexType* vertices;
+	const MeshCacheClass::VertexType* model;
+	TangentGeneratorClass::StatisticsType tangentStatistics;
+	bool result;
+	int vertexCount, i;
+
+
+	// Build the mesh just as the engine would from the text file, then store it as its binary cache.
+	filename = input.filename;
+
+	result = mesh.InitializeFromText(&filename[0], MESH_WELD_EPSILON);
+	if(!result)
+	{
+		fprintf(stderr, "could not cook %s\n", input.filename.c_str());
+		mesh.Shutdown();
+		return false;
+	}
+
+	result = mesh.Write(stream);
+	if(!result)
+	{
+		mesh.Shutdown();
+		return false;
+	}
+
+	meshData = stream.str();
+
+	result = WriteAsset(fout, input, ASSET_TYPE_MESH, (const unsigned char*)meshData.data(), meshData.size(), offset);
+	if(!result)
+	{
+		mesh.Shutdown();
+		return false;
+	}
+
+	// Generate the tangent layout the same way MeshRegistryClass::BuildVertexData does, so the engine can use it in place.
+	model = mesh.GetVertices();
+	vertexCount = mesh.GetVertexCount();
+
+	vertices = new TangentVertexLayout::VertexType[vertexCount > 0 ? vertexCount : 1];
+	if(!vertices)
+	{
+		mesh.Shutdown();
+		return false;
+	}
+
+	for(i=0; i<vertexCount; i++)
+	{
+		vertices[i].x = model[i].x;
+		vertices[i].y = model[i].y;
+		vertices[i].z = model[i].z;
+		vertices[i].tu = model[i].tu;
+		vertices[i].tv = model[i].tv;
+		vertices[i].nx = model[i].nx;
+		vertices[i].ny = model[i].ny;
+		vertices[i].nz = model[i].nz;
+	}
+
+	result = TangentGeneratorClass::Generate(&vertices[0].x, vertexCount, TangentVertexLayout::format, mesh.GetIndices(),
+											 (int)mesh.GetLod(0).indexCount, tangentStatistics);
+	if(result)
+	{
+		result = WriteAsset(fout, input, ASSET_TYPE_TANGENT_VERTICES, (const unsigned char*)vertices,
+							(size_t)vertexCount * sizeof(TangentVertexLayout::VertexType), offset);
+	}
+
+	delete [] vertices;
+	vertices = 0;
+
+	if(result)
+	{
+		printf("cooked    %s: %d vertices, %d indices in %d LODs and %d cluster blocks, %d degenerate tangent triangles\n", input.name.c_str(),
+			   mesh.GetVertexCount(), mesh.GetIndexCount(), mesh.GetLodCount(), mesh.GetClusterBlockCount(), tangentStatistics.degenerateTriangles);
+
+		m_statistics.cooked++;
+		m_statistics.cookedBytes += (unsigned long long)meshData.size() + (unsigned long long)vertexCount * sizeof(TangentVertexLayout::VertexType);
+	}
+
+	mesh.Shutdown();
+
+	return result;
+}
+
+
+bool AssetCookerClass::CookTexture(ofstream& fout, const InputType& input, size_t& offset)
+{
+	string textureData;
+	bool result;
+
+
+	result = BuildTexture(input, textureData);
+	if(!result)
+	{
+		return false;
+	}
+
+	return WriteAsset(fout, input, ASSET_TYPE_TEXTURE, (const unsigned char*)textureData.data(), textureData.size(), offset);
+}
+
+
+bool AssetCookerClass::CookTextureArray(ofstream& fout, const ArrayType& array, size_t& offset)
+{
+	const AssetArchiveClass::EntryType* entry;
+	DdsReaderClass textureReaders[TEXTURE_ARRAY_MAX_MEMBERS];
+	string textureData[TEXTURE_ARRAY_MAX_MEMBERS];
+	AssetArchiveClass::SliceType slice;
+	ostringstream stream;
+	string arrayData;
+	vector<unsigned char> chains;
+	DdsFormatType format;
+	size_t chainSize;
+	int memberCount, width, height, mipCount, i;
+	bool reusable, packed, result;
+
+
+	memberCount = (int)array.members.size();
+
+	// The array and the slice entries of its textures are carried over together, they were packed from the same sources.
+	reusable = FindReusable(array.input, ASSET_TYPE_TEXTURE) != 0;
+	for(i=0; i<memberCount && reusable; i++)
+	{
+		reusable = FindReusable(m_inputs[array.members[i]], ASSET_TYPE_TEXTURE_SLICE) != 0;
+	}
+
+	if(reusable)
+	{
+		result = ReuseAsset(fout, array.input, ASSET_TYPE_TEXTURE, offset);
+		for(i=0; i<memberCount && result; i++)
+		{
+			result = ReuseAsset(fout, m_inputs[array.members[i]], ASSET_TYPE_TEXTURE_SLICE, offset);
+		}
+
+		return result;
+	}
+
+	// Cook each texture just as it would be cooked on its own, or take it from the old archive if it was stored on its own there.
+	result = true;
+	for(i=0; i<memberCount && result; i++)
+	{
+		entry = FindReusable(m_inputs[array.members[i]], ASSET_TYPE_TEXTURE);
+		if(entry)
+		{
+			textureData[i].assign((const char*)m_OldArchive->GetData(entry), (size_t)entry->size);
+		}
+		else
+		{
+			result = BuildTexture(m_inputs[array.members[i]], textureData[i]);
+		}
+
+		if(result)
+		{
+			result = textureReaders[i].Initialize((const unsigned char*)textureData[i].data(), textureData[i].size());
+		}
+	}
+
+	// Only plain 2D textures of one format, size and mip count go into an array.
+	format = textureReaders[0].GetFormat();
+	width = textureReaders[0].GetWidth();
+	height = textureReaders[0].GetHeight();
+	mipCount = textureReaders[0].GetMipCount();
+
+	packed = result;
+	for(i=0; i<memberCount && packed; i++)
+	{
+		packed = textureReaders[i].GetFormat() == format && textureReaders[i].GetWidth() == width && textureReaders[i].GetHeight() == height &&
+				 textureReaders[i].GetMipCount() == mipCount && textureReaders[i].GetArraySize() == 1 && textureReaders[i].GetDepth() == 1;
+	}
+
+	// Each texture's chain goes in whole, one after the other, which the writer turns down for a format it does not know.
+	if(packed)
+	{
+		chainSize = DdsFormatClass::GetChainSize(format, width, height, mipCount);
+		chains.resize(chainSize * memberCount);
+		for(i=0; i<memberCount; i++)
+		{
+			memcpy(&chains[chainSize * i], textureReaders[i].GetLevelData(0, 0), chainSize);
+		}
+
+		packed = DdsWriterClass::Write(stream, format, width, height, mipCount, chains.data(), memberCount);
+	}
+
+	for(i=0; i<memberCount; i++)
+	{
+		textureReaders[i].Shutdown();
+	}
+
+	if(!result)
+	{
+		fprintf(stderr, "could not cook %s\n", array.input.name.c_str());
+		return false;
+	}
+
+	// A group that cannot be packed still works, it just binds a texture per member.
+	if(!packed)
+	{
+		printf("separate  %s: its textures do not share a format, size and mip count, stored on their own\n", array.input.name.c_str());
+
+		for(i=0; i<memberCount && result; i++)
+		{
+			result = WriteAsset(fout, m_inputs[array.members[i]], ASSET_TYPE_TEXTURE, (const unsigned char*)textureData[i].data(),
+								textureData[i].size(), offset);
+		}
+
+		return result;
+	}
+
+	arrayData = stream.str();
+
+	result = WriteAsset(fout, array.input, ASSET_TYPE_TEXTURE, (const unsigned char*)arrayData.data(), arrayData.size(), offset);
+
+	// Then where each texture sits in the array, under the texture's own name.
+	for(i=0; i<memberCount && result; i++)
+	{
+		memset(&slice, 0, sizeof(slice));
+		memcpy(slice.array, array.input.name.c_str(), array.input.name.size());
+		slice.slice = (unsigned int)i;
+		slice.sliceCount = (unsigned int)memberCount;
+
+		result = WriteAsset(fout, m_inputs[array.members[i]], ASSET_TYPE_TEXTURE_SLICE, (const unsigned char*)&slice, sizeof(slice), offset);
+	}
+
+	if(result)
+	{
+		printf("packed    %s: %d textures, %s, %d x %d, %d mips, %u bytes\n", array.input.name.c_str(), memberCount, DdsFormatClass::GetName(format),
+			   width, height, mipCount, (unsigned int)arrayData.size());
+	}
+
+	return result;
+}
+
+
+bool AssetCookerClass::BuildTexture(const InputType& input, string& textureData)
+{
+	MappedFileClass textureFile;
+	DdsReaderClass textureReader;
+	vector<unsigned char> levels;
+	double startTime;
+	int mipCount;
+	bool result;
+
+
+	startTime = LoadLogClass::GetTime();
+
+	result = textureFile.Initialize(input.filename.c_str());
+	if(!result)
+	{
+		return false;
+	}
+
+	// Check it is a DDS file the engine will take and that every surface its header promises is there.
+	result = textureReader.Initialize(textureFile.GetData(), textureFile.GetSize());
+	if(!result)
+	{
+		fprintf(stderr, "%s: %s\n", input.filename.c_str(), textureReader.GetError());
+		textureFile.Shutdown();
+		return false;
+	}
+
+	// Expand the texture to a full chain of 32 bit texels if it is one the cooker compresses, anything else is stored as it is.
+	result = ExpandTexture(input, textureReader, levels, mipCount);
+	if(result && !levels.empty())
+	{
+		result = CompressTexture(input, textureReader.GetWidth(), textureReader.GetHeight(), mipCount, levels.data(), textureData);
+	}
+
+	if(!result)
+	{
+		fprintf(stderr, "could not cook %s\n", input.filename.c_str());
+		textureReader.Shutdown();
+		textureFile.Shutdown();
+		return false;
+	}
+
+	if(levels.empty())
+	{
+		textureData.assign((const char*)textureFile.GetData(), textureFile.GetSize());
+		mipCount = textureReader.GetMipCount();
+	}
+
+	printf("cooked    %s: %d x %d, %d mips in %.1f ms, %u bytes\n", input.name.c_str(), textureReader.GetWidth(), textureReader.GetHeight(),
+		   mipCount, LoadLogClass::GetTime() - startTime, (unsigned int)textureData.size());
+
+	m_statistics.cooked++;
+	m_statistics.cookedBytes += textureData.size();
+
+	textureReader.Shutdown();
+	textureFile.Shutdown();
+
+	return true;
+}
+
+
+bool AssetCookerClass::ExpandTexture(const InputType& input, DdsReaderClass& textureReader, vector<unsigned char>& levels, int& mipCount)
+{
+	int width, height;
+	bool result;
+
+
+	// Only plain 2D textures are cooked, arrays, cube maps and volumes are stored as they are.
+	if(textureReader.GetArraySize() != 1 || textureReader.GetDepth() != 1)
+	{
+		return true;
+	}
+
+	width = textureReader.GetWidth();
+	height = textureReader.GetHeight();
+
+	// 32 bit BGRA texels with no mips, the same layout the writer puts out, get their whole chain built.
+	if(textureReader.GetFormat() == DDS_FORMAT_BGRA8 && textureReader.GetMipCount() == 1)
+	{
+		mipCount = MipGeneratorClass::GetLevelCount(width, height);
+		levels.resize(MipGeneratorClass::GetChainSize(width, height));
+
+		result = MipGeneratorClass::Generate(textureReader.GetLevelData(0, 0), width, height, GetMipSettings(input.name), m_JobSystem, levels.data());
+		if(!result)
+		{
+			return false;
+		}
+
+		printf("generated %s: %d mips with the %s filter\n", input.name.c_str(), mipCount, m_mipFilter == MIP_FILTER_BOX ? "box" : "Kaiser");
+
+		return true;
+	}
+
+	// A normal map that came as BC1 is taken apart so it can go to BC5, its mips are kept as they are.
+	if(GetMipSettings(input.name).content == MIP_CONTENT_NORMAL && textureReader.GetFormat() == DDS_FORMAT_BC1)
+	{
+		mipCount = textureReader.GetMipCount();
+		levels.resize(DdsFormatClass::GetChainSize(DDS_FORMAT_BGRA8, width, height, mipCount));
+
+		result = BcDecoderClass::Decode(textureReader.GetLevelData(0, 0), width, height, mipCount, DDS_FORMAT_BC1, levels.data());
+		if(!result)
+		{
+			return false;
+		}
+
+		printf("decoded   %s: %d mips of BC1\n", input.name.c_str(), mipCount);
+	}
+
+	return true;
+}
+
+
+bool AssetCookerClass::CompressTexture(const InputType& input, int width, int height, int mipCount, const unsigned char* levels,
+									   string& textureData)
+{
+	ostringstream stream;
+	vector<unsigned char> blocks, decoded;
+	DdsFormatType format;
+	double startTime, encodeTime;
+	size_t levelsSize;
+	bool result;
+
+
+	format = GetTextureFormat(input.name, levels, (size_t)width * height);
+	levelsSize = DdsFormatClass::GetChainSize(DDS_FORMAT_BGRA8, width, height, mipCount);
+
+	blocks.resize(DdsFormatClass::GetChainSize(format, width, height, mipCount));
+
+	// Compress every level at once on the job system.
+	startTime = LoadLogClass::GetTime();
+
+	result = BcEncoderClass::Encode(levels, width, height, mipCount, format, m_JobSystem, blocks.data());
+	if(!result)
+	{
+		return false;
+	}
+
+	encodeTime = LoadLogClass::GetTime() - startTime;
+
+	// Decode the blocks again to see what was lost.
+	decoded.resize(levelsSize);
+
+	result = BcDecoderClass::Decode(blocks.data(), width, height, mipCount, format, decoded.data());
+	if(!result)
+	{
+		return false;
+	}
+
+	printf("encoded   %s: %s, %.2f dB PSNR, %.1f MB/s over %d threads\n", input.name.c_str(), DdsFormatClass::GetName(format),
+		   BcDecoderClass::GetPsnr(levels, decoded.data(), levelsSize / 4, format), (double)levelsSize / (1024.0 * 1024.0) / (encodeTime / 1000.0),
+		   m_JobSystem->GetThreadCount());
+
+	result = DdsWriterClass::Write(stream, format, width, height, mipCount, blocks.data());
+	if(!result)
+	{
+		return false;
+	}
+
+	textureData = stream.str();
+
+	return true;
+}
+
+
+bool AssetCookerClass::VerifyTexture(const char* name, const unsigned char* data, size_t size, int slice)
+{
+	MappedFileClass sourceFile;
+	DdsReaderClass cookedReader, sourceReader;
+	double startTime, decodeTime, psnr;
+	size_t texelCount;
+	int levelCount, item, level;
+	unsigned int i;
+	bool result;
+
+
+	result = cookedReader.Initialize(data, size);
+	if(result)
+	{
+		startTime = LoadLogClass::GetTime();
+		result = cookedReader.Decode(m_JobSystem);
+		decodeTime = LoadLogClass::GetTime() - startTime;
+	}
+
+	if(!result)
+	{
+		fprintf(stderr, "%s: %s\n", name, cookedReader.GetError());
+		cookedReader.Shutdown();
+		return false;
+	}
+
+	if(slice >= cookedReader.GetArraySize())
+	{
+		fprintf(stderr, "%s: slice %d is past the end of its texture array\n", name, slice);
+		cookedReader.Shutdown();
+		return false;
+	}
+
+	texelCount = 0;
+	for(item=0; item<cookedReader.GetArraySize(); item++)
+	{
+		for(level=0; level<cookedReader.GetMipCount(); level++)
+		{
+			texelCount += (size_t)cookedReader.GetLevelWidth(level) * cookedReader.GetLevelHeight(level) * cookedReader.GetLevelDepth(level);
+		}
+	}
+
+	// Decode the source the texture was cooked from, if it is still in the data folder, and compare the two.
+	psnr = 0.0;
+	levelCount = 0;
+	for(i=0; i<m_inputs.size(); i++)
+	{
+		if(m_inputs[i].type == ASSET_TYPE_TEXTURE && m_inputs[i].name == name)
+		{
+			result = sourceFile.Initialize(m_inputs[i].filename.c_str());
+			if(result)
+			{
+				result = sourceReader.Initialize(sourceFile.GetData(), sourceFile.GetSize()) && sourceReader.Decode(m_JobSystem);
+				if(result)
+				{
+					psnr = GetTexturePsnr(cookedReader, slice, sourceReader, levelCount);
+				}
+				else
+				{
+					fprintf(stderr, "%s: %s\n", m_inputs[i].filename.c_str(), sourceReader.GetError());
+				}
+
+				sourceReader.Shutdown();
+				sourceFile.Shutdown();
+			}
+			break;
+		}
+	}
+
+	printf("verified  %s: %s, %d x %d, %d mips, decoded at %.1f MB/s over %d threads", name, DdsFormatClass::GetName(cookedReader.GetFormat()),
+		   cookedReader.GetWidth(), cookedReader.GetHeight(), cookedReader.GetMipCount(),
+		   (double)texelCount * 4.0 / (1024.0 * 1024.0) / (decodeTime > 0.0 ? decodeTime / 1000.0 : 1.0), m_JobSystem->GetThreadCount());
+	if(levelCount > 0)
+	{
+		printf(", %.2f dB PSNR against the source over %d mips\n", psnr, levelCount);
+	}
+	else
+	{
+		printf(", no source to compare with\n");
+	}
+
+	cookedReader.Shutdown();
+
+	if(levelCount > 0 && psnr < VERIFY_MIN_PSNR)
+	{
+		fprintf(stderr, "%s: %.2f dB is too far from the source\n", name, psnr);
+		return false;
+	}
+
+	return true;
+}
+
+
+DdsFormatType AssetCookerClass::GetTextureFormat(const string& name, const unsigned char* texels, size_t texelCount)
+{
+	size_t i;
+
+
+	// Normal maps keep their X and Y in BC5, the shader works out Z.
+	if(GetMipSettings(name).content == MIP_CONTENT_NORMAL)
+	{
+		return DDS_FORMAT_BC5;
+	}
+
+	if(m_useBc7)
+	{
+		return DDS_FORMAT_BC7;
+	}
+
+	// Opaque textures need no alpha block, half the size of BC3.
+	for(i=0; i<texelCount; i++)
+	{
+		if(texels[i * 4 + 3] != 255)
+		{
+			return DDS_FORMAT_BC3;
+		}
+	}
+
+	return DDS_FORMAT_BC1;
+}
+
+
+double AssetCookerClass::GetTexturePsnr(DdsReaderClass& cooked, int slice, DdsReaderClass& source, int& levelCount)
+{
+	const float *cookedTexels, *sourceTexels;
+	double error, difference;
+	size_t texelCount, sampleCount, k;
+	unsigned int channels;
+	int level, i;
+
+
+	// Compare the levels the slice and the source have in common, over the channels the cooked format keeps, on the 8 bit scale.
+	channels = DdsFormatClass::GetChannels(cooked.GetFormat());
+	error = 0.0;
+	sampleCount = 0;
+	levelCount = 0;
+	for(level=0; level<cooked.GetMipCount() && level<source.GetMipCount(); level++)
+	{
+		if(cooked.GetLevelWidth(level) != source.GetLevelWidth(level) || cooked.GetLevelHeight(level) != source.GetLevelHeight(level) ||
+		   cooked.GetLevelDepth(level) != source.GetLevelDepth(level))
+		{
+			break;
+		}
+
+		cookedTexels = cooked.GetTexels(slice, level);
+		sourceTexels = source.GetTexels(0, level);
+		texelCount = (size_t)cooked.GetLevelWidth(level) * cooked.GetLevelHeight(level) * cooked.GetLevelDepth(level);
+		for(k=0; k<texelCount; k++)
+		{
+			for(i=0; i<4; i++)
+			{
+				if(channels & (1 << i))
+				{
+					difference = 255.0 * ((double)cookedTexels[k * 4 + i] - (double)sourceTexels[k * 4 + i]);
+					error += difference * difference;
+					sampleCount++;
+				}
+			}
+		}
+
+		levelCount++;
+	}
+
+	if(sampleCount == 0)
+	{
+		return 0.0;
+	}
+
+	error /= (double)sampleCount;
+	if(error == 0.0)
+	{
+		return 99.0;
+	}
+
+	return 10.0 * log10(255.0 * 255.0 / error);
+}
+
+
+const AssetArchiveClass::EntryType* AssetCookerClass::FindReusable(const InputType& input, unsigned int type)
+{
+	const AssetArchiveClass::EntryType* entry;
+
+
+	if(!m_OldArchive)
+	{
+		return 0;
+	}
+
+	// An entry can be carried over if it was cooked from the same bytes with the same settings and has not been damaged since.
+	entry = m_OldArchive->Find(input.name.c_str(), type);
+	if(!entry || entry->sourceHash != input.sourceHash || !m_OldArchive->Verify(entry))
+	{
+		return 0;
+	}
+
+	return entry;
+}
+
+
+unsigned long long AssetCookerClass::GetSettingsHash(const InputType& input)
+{
+	MipGeneratorClass::SettingsType mipSettings;
+	unsigned int settings[4];
+	float weldEpsilon;
+	unsigned long long hash;
+
+
+	// Everything that changes what a source cooks to goes into the hash along with the source itself.
+	settings[0] = ASSET_ARCHIVE_VERSION;
+	settings[1] = ASSET_COOK_VERSION;
+	settings[2] = input.type;
+	settings[3] = 0;
+
+	hash = AssetArchiveClass::Hash(settings, sizeof(settings), ASSET_ARCHIVE_HASH_SEED);
+
+	if(input.type == ASSET_TYPE_MESH)
+	{
+		settings[0] = MESH_CACHE_VERSION;
+		settings[1] = (unsigned int)sizeof(MeshCacheClass::VertexType);
+		settings[2] = (unsigned int)sizeof(TangentVertexLayout::VertexType);
+		settings[3] = (unsigned int)sizeof(ClusterCullerClass::ClusterBlockType);
+		weldEpsilon = MESH_WELD_EPSILON;
+
+		hash = AssetArchiveClass::Hash(settings, sizeof(settings), hash);
+		hash = AssetArchiveClass::Hash(&weldEpsilon, sizeof(weldEpsilon), hash);
+	}
+	else
+	{
+		mipSettings = GetMipSettings(input.name);
+
+		settings[0] = (unsigned int)mipSettings.filter;
+		settings[1] = (unsigned int)mipSettings.content;
+		settings[2] = (unsigned int)mipSettings.address;
+		settings[3] = m_useBc7 ? 1 : 0;
+
+		hash = AssetArchiveClass::Hash(settings, sizeof(settings), hash);
+	}
+
+	return hash;
+}
+
+
+MipGeneratorClass::SettingsType AssetCookerClass::GetMipSettings(const string& name)
+{
+	MipGeneratorClass::SettingsType settings;
+	size_t i;
+
+
+	// Anything not in the rules is sRGB color that tiles.
+	settings.filter = m_mipFilter;
+	settings.content = MIP_CONTENT_COLOR;
+	settings.address = MIP_ADDRESS_WRAP;
+
+	for(i=0; i<sizeof(TEXTURE_RULES) / sizeof(TEXTURE_RULES[0]); i++)
+	{
+		if(name == TEXTURE_RULES[i].name)
+		{
+			settings.content = TEXTURE_RULES[i].content;
+			settings.address = TEXTURE_RULES[i].address;
+		}
+	}
+
+	return settings;
+}
@@ -0,0 +1,153 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: assetcookerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _ASSETCOOKERCLASS_H_
+#define _ASSETCOOKERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "../Engine/assetarchiveclass.h"
+#include "../Engine/jobsystemclass.h"
+#include "ddsreaderclass.h"
+#include "ddswriterclass.h"
+#include "mipgeneratorclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Raise this whenever the cooked output changes for the same source, every asset is then cooked again.
+const unsigned int ASSET_COOK_VERSION = 4;
+
+// A cooked texture further than this from its source fails verification, BC1 lands around 35 dB.
+const double VERIFY_MIN_PSNR = 30.0;
+
+const int TEXTURE_ARRAY_MAX_MEMBERS = 4;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: AssetCookerClass
+//
+// Cooks the loose meshes and textures of a data folder into one asset archive.
+// Each text mesh is welded, optimized, simplified into its levels of detail
+// and split into clusters exactly as the engine does on a cache miss, and its
+// tangent frames are generated once here rather than on every load.  Textures
+// stored as plain 32 bit texels without mips get their whole mip chain and
+// are compressed to BC1, or BC3 when they have alpha, or BC7 on request.
+// Normal maps go to BC5, even one that came as BC1.  The rest are checked and
+// stored as they are.
+//
+// Once every texture is cooked, the groups named in the texture array rules
+// are packed into one array each, so the draws using them bind one view and
+// pick their slice.  A group whose textures did not cook to the same format,
+// size and mip count is stored as separate textures instead.
+//
+// The hash of each source and the settings it is cooked with is kept in the
+// archive.  On the next run any asset whose hash has not changed is copied
+// over from the old archive instead of being cooked again, and if nothing has
+// changed at all the archive is left alone.
+//
+// Verify opens the archive again, checks every blob against its hash and
+// decodes every texture on the CPU to compare it with its source, so a build
+// machine without a GPU can still catch a broken or badly compressed asset.
+////////////////////////////////////////////////////////////////////////////////
+class AssetCookerClass
+{
+public:
+	// How the mips of one texture are built, picked by its name.
+	struct TextureRuleType
+	{
+		const char* name;
+		MipContentType content;
+		MipAddressType address;
+	};
+
+	// Textures packed into one texture array, by their asset names.  Unused members are null.
+	struct TextureArrayRuleType
+	{
+		const char* name;
+		const char* members[TEXTURE_ARRAY_MAX_MEMBERS];
+	};
+
+private:
+	struct InputType
+	{
+		string filename;
+		string name;
+		unsigned int type;
+		unsigned long long sourceHash;
+		int array;
+	};
+
+	// An array stands in for an input of its own, its source hash covers every member.
+	struct ArrayType
+	{
+		InputType input;
+		vector<int> members;
+	};
+
+	struct StatisticsType
+	{
+		int cooked;
+		int reused;
+		unsigned long long cookedBytes;
+		unsigned long long reusedBytes;
+	};
+
+public:
+	AssetCookerClass();
+	AssetCookerClass(const AssetCookerClass&);
+	~AssetCookerClass();
+
+	bool Initialize(const char*, const char*, bool, MipFilterType, bool);
+	bool Cook();
+	bool Verify();
+	void Shutdown();
+
+private:
+	bool FindInputs(const char*);
+	bool HashInputs();
+	void FindArrays();
+	bool IsUpToDate();
+	bool WriteArchive(const string&);
+	bool WriteAsset(ofstream&, const InputType&, unsigned int, const unsigned char*, size_t, size_t&);
+	bool ReuseAsset(ofstream&, const InputType&, unsigned int, size_t&);
+	bool CookMesh(ofstream&, const InputType&, size_t&);
+	bool CookTexture(ofstream&, const InputType&, size_t&);
+	bool CookTextureArray(ofstream&, const ArrayType&, size_t&);
+	bool BuildTexture(const InputType&, string&);
+	bool ExpandTexture(const InputType&, DdsReaderClass&, vector<unsigned char>&, int&);
+	bool CompressTexture(const InputType&, int, int, int, const unsigned char*, string&);
+	bool VerifyTexture(const char*, const unsigned char*, size_t, int);
+
+	const AssetArchiveClass::EntryType* FindReusable(const InputType&, unsigned int);
+	unsigned long long GetSettingsHash(const InputType&);
+	MipGeneratorClass::SettingsType GetMipSettings(const string&);
+	DdsFormatType GetTextureFormat(const string&, const unsigned char*, size_t);
+
+	static double GetTexturePsnr(DdsReaderClass&, int, DdsReaderClass&, int&);
+
+private:
+	AssetArchiveClass* m_OldArchive;
+	JobSystemClass* m_JobSystem;
+	MipFilterType m_mipFilter;
+	bool m_useBc7;
+	string m_archiveFilename;
+	vector<InputType> m_inputs;
+	vector<ArrayType> m_arrays;
+	vector<AssetArchiveClass::EntryType> m_entries;
+	StatisticsType m_statistics;
+};
+
+#endif
@@ -0,0 +1,963 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: bcdecoderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "bcdecoderclass.h"
+
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int BC6H_MODE_COUNT = 14;
+const int BC6H_MAX_FIELDS = 23;
+
+// The weights of the 2, 3 and 4 bit indices out of 64, shared by BC6H and BC7.
+static const int BC7_WEIGHTS2[4] = { 0, 21, 43, 64 };
+static const int BC7_WEIGHTS3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static const int* BC7_WEIGHTS[5] = { 0, 0, BC7_WEIGHTS2, BC7_WEIGHTS3, BC7_WEIGHTS4 };
+
+// How a BC7 mode lays out the bits after its mode bits.
+struct Bc7ModeType
+{
+	int subsets;
+	int partitionBits;
+	int rotationBits;
+	int indexSelectionBits;
+	int colorBits;
+	int alphaBits;
+	int endpointPBits;
+	int sharedPBits;
+	int indexBits;
+	int secondIndexBits;
+};
+
+static const Bc7ModeType BC7_MODES[8] =
+{
+	{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+	{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+	{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+	{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+	{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+	{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+	{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+	{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+};
+
+// The endpoint components a BC6H field fills, red, green and blue of the first
+// and second endpoints of the first subset and then of the second.
+enum Bc6hValueType
+{
+	BC6H_R0, BC6H_G0, BC6H_B0,
+	BC6H_R1, BC6H_G1, BC6H_B1,
+	BC6H_R2, BC6H_G2, BC6H_B2,
+	BC6H_R3, BC6H_G3, BC6H_B3
+};
+
+// A run of bits of one component, stored from bit last to bit first, which reverses the run when first is the lower.
+struct Bc6hFieldType
+{
+	unsigned char value;
+	unsigned char first;
+	unsigned char last;
+};
+
+struct Bc6hModeType
+{
+	int modeBits;
+	bool transformed;
+	int regions;
+	int endpointBits;
+	int deltaBits[3];
+	int fieldCount;
+	Bc6hFieldType fields[BC6H_MAX_FIELDS];
+};
+
+// Which subset each texel of the 64 two subset partitions is in, a bit a texel, BC6H uses the first 32.
+static const unsigned short BC7_PARTITIONS2[64] =
+{
+	0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+	0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+	0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+	0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+	0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+	0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+	0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+	0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+};
+
+// Which subset each texel of the 64 three subset partitions is in.
+static const unsigned char BC7_PARTITIONS3[64][16] =
+{
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+	{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1 },
+	{ 0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2 },
+	{ 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2 },
+	{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+	{ 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0 },
+	{ 0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2 },
+	{ 0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0 },
+	{ 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1 },
+	{ 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2 },
+	{ 0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2 },
+	{ 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0 },
+	{ 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0 },
+	{ 0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2 },
+	{ 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0 },
+	{ 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1 },
+	{ 0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2 },
+	{ 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1 },
+	{ 0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1 },
+	{ 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2 },
+	{ 0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2 },
+	{ 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0 },
+	{ 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0 },
+	{ 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0 },
+	{ 0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0 },
+	{ 0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1 },
+	{ 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1 },
+	{ 0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1 },
+	{ 0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1 },
+	{ 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1 },
+	{ 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2 },
+	{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1 },
+	{ 0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2 },
+	{ 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2 },
+	{ 0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2 },
+	{ 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2 },
+	{ 0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2 },
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2 },
+	{ 0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1 },
+	{ 0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2 },
+	{ 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2 },
+	{ 0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0 }
+};
+
+// The texel whose index is a bit shorter in the second subset, and the second and third of three, the first subset's is texel zero.
+static const unsigned char BC7_ANCHORS2[64] =
+{
+	15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+	15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+	15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+	6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+};
+
+static const unsigned char BC7_ANCHORS3_SECOND[64] =
+{
+	3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+	3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+	8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+	3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+};
+
+static const unsigned char BC7_ANCHORS3_THIRD[64] =
+{
+	15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+	15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+	15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+	15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+};
+
+// The 14 BC6H modes, found by their two or five mode bits.
+static const Bc6hModeType BC6H_MODES[BC6H_MODE_COUNT] =
+{
+	{ 0x00, true, 2, 10, { 5, 5, 5 }, 19,
+		{
+			{ BC6H_G2, 4, 4 }, { BC6H_B2, 4, 4 }, { BC6H_B3, 4, 4 }, { BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 },
+			{ BC6H_R1, 4, 0 }, { BC6H_G3, 4, 4 }, { BC6H_G2, 3, 0 }, { BC6H_G1, 4, 0 }, { BC6H_B3, 0, 0 }, { BC6H_G3, 3, 0 },
+			{ BC6H_B1, 4, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 4, 0 }, { BC6H_B3, 2, 2 }, { BC6H_R3, 4, 0 },
+			{ BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x01, true, 2, 7, { 6, 6, 6 }, 23,
+		{
+			{ BC6H_G2, 5, 5 }, { BC6H_G3, 4, 4 }, { BC6H_G3, 5, 5 }, { BC6H_R0, 6, 0 }, { BC6H_B3, 0, 0 }, { BC6H_B3, 1, 1 },
+			{ BC6H_B2, 4, 4 }, { BC6H_G0, 6, 0 }, { BC6H_B2, 5, 5 }, { BC6H_B3, 2, 2 }, { BC6H_G2, 4, 4 }, { BC6H_B0, 6, 0 },
+			{ BC6H_B3, 3, 3 }, { BC6H_B3, 5, 5 }, { BC6H_B3, 4, 4 }, { BC6H_R1, 5, 0 }, { BC6H_G2, 3, 0 }, { BC6H_G1, 5, 0 },
+			{ BC6H_G3, 3, 0 }, { BC6H_B1, 5, 0 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 5, 0 }, { BC6H_R3, 5, 0 }
+		}
+	},
+	{ 0x02, true, 2, 11, { 5, 4, 4 }, 18,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 4, 0 }, { BC6H_R0, 10, 10 }, { BC6H_G2, 3, 0 },
+			{ BC6H_G1, 3, 0 }, { BC6H_G0, 10, 10 }, { BC6H_B3, 0, 0 }, { BC6H_G3, 3, 0 }, { BC6H_B1, 3, 0 }, { BC6H_B0, 10, 10 },
+			{ BC6H_B3, 1, 1 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 4, 0 }, { BC6H_B3, 2, 2 }, { BC6H_R3, 4, 0 }, { BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x06, true, 2, 11, { 4, 5, 4 }, 20,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 3, 0 }, { BC6H_R0, 10, 10 }, { BC6H_G3, 4, 4 },
+			{ BC6H_G2, 3, 0 }, { BC6H_G1, 4, 0 }, { BC6H_G0, 10, 10 }, { BC6H_G3, 3, 0 }, { BC6H_B1, 3, 0 }, { BC6H_B0, 10, 10 },
+			{ BC6H_B3, 1, 1 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 3, 0 }, { BC6H_B3, 0, 0 }, { BC6H_B3, 2, 2 }, { BC6H_R3, 3, 0 },
+			{ BC6H_G2, 4, 4 }, { BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x0a, true, 2, 11, { 4, 4, 5 }, 20,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 3, 0 }, { BC6H_R0, 10, 10 }, { BC6H_B2, 4, 4 },
+			{ BC6H_G2, 3, 0 }, { BC6H_G1, 3, 0 }, { BC6H_G0, 10, 10 }, { BC6H_B3, 0, 0 }, { BC6H_G3, 3, 0 }, { BC6H_B1, 4, 0 },
+			{ BC6H_B0, 10, 10 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 3, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B3, 2, 2 }, { BC6H_R3, 3, 0 },
+			{ BC6H_B3, 4, 4 }, { BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x0e, true, 2, 9, { 5, 5, 5 }, 19,
+		{
+			{ BC6H_R0, 8, 0 }, { BC6H_B2, 4, 4 }, { BC6H_G0, 8, 0 }, { BC6H_G2, 4, 4 }, { BC6H_B0, 8, 0 }, { BC6H_B3, 4, 4 },
+			{ BC6H_R1, 4, 0 }, { BC6H_G3, 4, 4 }, { BC6H_G2, 3, 0 }, { BC6H_G1, 4, 0 }, { BC6H_B3, 0, 0 }, { BC6H_G3, 3, 0 },
+			{ BC6H_B1, 4, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 4, 0 }, { BC6H_B3, 2, 2 }, { BC6H_R3, 4, 0 },
+			{ BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x12, true, 2, 8, { 6, 5, 5 }, 19,
+		{
+			{ BC6H_R0, 7, 0 }, { BC6H_G3, 4, 4 }, { BC6H_B2, 4, 4 }, { BC6H_G0, 7, 0 }, { BC6H_B3, 2, 2 }, { BC6H_G2, 4, 4 },
+			{ BC6H_B0, 7, 0 }, { BC6H_B3, 3, 3 }, { BC6H_B3, 4, 4 }, { BC6H_R1, 5, 0 }, { BC6H_G2, 3, 0 }, { BC6H_G1, 4, 0 },
+			{ BC6H_B3, 0, 0 }, { BC6H_G3, 3, 0 }, { BC6H_B1, 4, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 5, 0 },
+			{ BC6H_R3, 5, 0 }
+		}
+	},
+	{ 0x16, true, 2, 8, { 5, 6, 5 }, 21,
+		{
+			{ BC6H_R0, 7, 0 }, { BC6H_B3, 0, 0 }, { BC6H_B2, 4, 4 }, { BC6H_G0, 7, 0 }, { BC6H_G2, 5, 5 }, { BC6H_G2, 4, 4 },
+			{ BC6H_B0, 7, 0 }, { BC6H_G3, 5, 5 }, { BC6H_B3, 4, 4 }, { BC6H_R1, 4, 0 }, { BC6H_G3, 4, 4 }, { BC6H_G2, 3, 0 },
+			{ BC6H_G1, 5, 0 }, { BC6H_G3, 3, 0 }, { BC6H_B1, 4, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 4, 0 },
+			{ BC6H_B3, 2, 2 }, { BC6H_R3, 4, 0 }, { BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x1a, true, 2, 8, { 5, 5, 6 }, 21,
+		{
+			{ BC6H_R0, 7, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B2, 4, 4 }, { BC6H_G0, 7, 0 }, { BC6H_B2, 5, 5 }, { BC6H_G2, 4, 4 },
+			{ BC6H_B0, 7, 0 }, { BC6H_B3, 5, 5 }, { BC6H_B3, 4, 4 }, { BC6H_R1, 4, 0 }, { BC6H_G3, 4, 4 }, { BC6H_G2, 3, 0 },
+			{ BC6H_G1, 4, 0 }, { BC6H_B3, 0, 0 }, { BC6H_G3, 3, 0 }, { BC6H_B1, 5, 0 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 4, 0 },
+			{ BC6H_B3, 2, 2 }, { BC6H_R3, 4, 0 }, { BC6H_B3, 3, 3 }
+		}
+	},
+	{ 0x1e, false, 2, 6, { 6, 6, 6 }, 23,
+		{
+			{ BC6H_R0, 5, 0 }, { BC6H_G3, 4, 4 }, { BC6H_B3, 0, 0 }, { BC6H_B3, 1, 1 }, { BC6H_B2, 4, 4 }, { BC6H_G0, 5, 0 },
+			{ BC6H_G2, 5, 5 }, { BC6H_B2, 5, 5 }, { BC6H_B3, 2, 2 }, { BC6H_G2, 4, 4 }, { BC6H_B0, 5, 0 }, { BC6H_G3, 5, 5 },
+			{ BC6H_B3, 3, 3 }, { BC6H_B3, 5, 5 }, { BC6H_B3, 4, 4 }, { BC6H_R1, 5, 0 }, { BC6H_G2, 3, 0 }, { BC6H_G1, 5, 0 },
+			{ BC6H_G3, 3, 0 }, { BC6H_B1, 5, 0 }, { BC6H_B2, 3, 0 }, { BC6H_R2, 5, 0 }, { BC6H_R3, 5, 0 }
+		}
+	},
+	{ 0x03, false, 1, 10, { 10, 10, 10 }, 6,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 9, 0 }, { BC6H_G1, 9, 0 }, { BC6H_B1, 9, 0 }
+		}
+	},
+	{ 0x07, true, 1, 11, { 9, 9, 9 }, 9,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 8, 0 }, { BC6H_R0, 10, 10 }, { BC6H_G1, 8, 0 },
+			{ BC6H_G0, 10, 10 }, { BC6H_B1, 8, 0 }, { BC6H_B0, 10, 10 }
+		}
+	},
+	{ 0x0b, true, 1, 12, { 8, 8, 8 }, 9,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 7, 0 }, { BC6H_R0, 10, 11 }, { BC6H_G1, 7, 0 },
+			{ BC6H_G0, 10, 11 }, { BC6H_B1, 7, 0 }, { BC6H_B0, 10, 11 }
+		}
+	},
+	{ 0x0f, true, 1, 16, { 4, 4, 4 }, 9,
+		{
+			{ BC6H_R0, 9, 0 }, { BC6H_G0, 9, 0 }, { BC6H_B0, 9, 0 }, { BC6H_R1, 3, 0 }, { BC6H_R0, 10, 15 }, { BC6H_G1, 3, 0 },
+			{ BC6H_G0, 10, 15 }, { BC6H_B1, 3, 0 }, { BC6H_B0, 10, 15 }
+		}
+	}
+};
+
+
+bool BcDecoderClass::Decode(const unsigned char* data, int width, int height, int mipCount, DdsFormatType format, unsigned char* output)
+{
+	float texels[64];
+	size_t blockSize;
+	int blocksWide, blocksHigh, level, x, y;
+	bool result;
+
+
+	if(!DdsFormatClass::IsCompressed(format))
+	{
+		return false;
+	}
+	blockSize = DdsFormatClass::GetBlockSize(format);
+
+	for(level=0; level<mipCount; level++)
+	{
+		blocksWide = (width + DDS_BLOCK_SIZE - 1) / DDS_BLOCK_SIZE;
+		blocksHigh = (height + DDS_BLOCK_SIZE - 1) / DDS_BLOCK_SIZE;
+
+		for(y=0; y<blocksHigh; y++)
+		{
+			for(x=0; x<blocksWide; x++)
+			{
+				result = DecodeBlock(data, format, texels);
+				if(!result)
+				{
+					return false;
+				}
+
+				WriteBlock(texels, width, height, x * DDS_BLOCK_SIZE, y * DDS_BLOCK_SIZE, output);
+				data += blockSize;
+			}
+		}
+
+		output += (size_t)width * height * 4;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return true;
+}
+
+
+bool BcDecoderClass::DecodeBlock(const unsigned char* block, DdsFormatType format, float* texels)
+{
+	int i;
+
+
+	switch(format)
+	{
+		case DDS_FORMAT_BC1:
+		case DDS_FORMAT_BC1_SRGB:
+		{
+			DecodeColorBlock(block, true, texels);
+			return true;
+		}
+
+		// BC2 and BC3 keep the alpha ahead of a color block that is always four colors.
+		case DDS_FORMAT_BC2:
+		case DDS_FORMAT_BC2_SRGB:
+		{
+			DecodeColorBlock(block + 8, false, texels);
+			DecodeExplicitAlphaBlock(block, texels);
+			return true;
+		}
+
+		case DDS_FORMAT_BC3:
+		case DDS_FORMAT_BC3_SRGB:
+		{
+			DecodeColorBlock(block + 8, false, texels);
+			DecodeAlphaBlock(block, false, 3, texels);
+			return true;
+		}
+
+		case DDS_FORMAT_BC4:
+		case DDS_FORMAT_BC4_SNORM:
+		case DDS_FORMAT_BC5:
+		case DDS_FORMAT_BC5_SNORM:
+		{
+			for(i=0; i<16; i++)
+			{
+				_mm_storeu_ps(&texels[i * 4], _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+			}
+
+			DecodeAlphaBlock(block, format == DDS_FORMAT_BC4_SNORM || format == DDS_FORMAT_BC5_SNORM, 0, texels);
+			if(format == DDS_FORMAT_BC5 || format == DDS_FORMAT_BC5_SNORM)
+			{
+				DecodeAlphaBlock(block + 8, format == DDS_FORMAT_BC5_SNORM, 1, texels);
+			}
+			return true;
+		}
+
+		case DDS_FORMAT_BC6H_UF16:
+		case DDS_FORMAT_BC6H_SF16:
+		{
+			return DecodeBc6hBlock(block, format == DDS_FORMAT_BC6H_SF16, texels);
+		}
+
+		case DDS_FORMAT_BC7:
+		case DDS_FORMAT_BC7_SRGB:
+		{
+			return DecodeBc7Block(block, texels);
+		}
+
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+
+double BcDecoderClass::GetPsnr(const unsigned char* source, const unsigned char* decoded, size_t texelCount, DdsFormatType format)
+{
+	double error, difference;
+	int channels[4], channelCount, i;
+	size_t k;
+
+
+	// Only the channels the format keeps count, BC1 drops alpha and BC5 keeps just red and green.
+	channelCount = 0;
+	if(format != DDS_FORMAT_BC5)
+	{
+		channels[channelCount++] = 0;
+	}
+	channels[channelCount++] = 1;
+	channels[channelCount++] = 2;
+	if(format == DDS_FORMAT_BC3 || format == DDS_FORMAT_BC7)
+	{
+		channels[channelCount++] = 3;
+	}
+
+	error = 0.0;
+	for(k=0; k<texelCount; k++)
+	{
+		for(i=0; i<channelCount; i++)
+		{
+			difference = (double)source[k * 4 + channels[i]] - (double)decoded[k * 4 + channels[i]];
+			error += difference * difference;
+		}
+	}
+
+	error /= (double)texelCount * channelCount;
+	if(error == 0.0)
+	{
+		return 99.0;
+	}
+
+	return 10.0 * log10(255.0 * 255.0 / error);
+}
+
+
+void BcDecoderClass::DecodeColorBlock(const unsigned char* block, bool allowTransparent, float* texels)
+{
+	__m128 palette[4], scale, third;
+	unsigned int color0, color1, indexBits;
+	int i;
+
+
+	color0 = (unsigned int)block[0] | ((unsigned int)block[1] << 8);
+	color1 = (unsigned int)block[2] | ((unsigned int)block[3] << 8);
+	indexBits = (unsigned int)block[4] | ((unsigned int)block[5] << 8) | ((unsigned int)block[6] << 16) | ((unsigned int)block[7] << 24);
+
+	// Expand the 565 endpoints to 8 bits by repeating their top bits, as the hardware does.
+	scale = _mm_set1_ps(1.0f / 255.0f);
+	palette[0] = _mm_mul_ps(_mm_setr_ps((float)(((color0 >> 11) << 3) | ((color0 >> 11) >> 2)),
+										(float)((((color0 >> 5) & 0x3f) << 2) | (((color0 >> 5) & 0x3f) >> 4)),
+										(float)(((color0 & 0x1f) << 3) | ((color0 & 0x1f) >> 2)), 255.0f), scale);
+	palette[1] = _mm_mul_ps(_mm_setr_ps((float)(((color1 >> 11) << 3) | ((color1 >> 11) >> 2)),
+										(float)((((color1 >> 5) & 0x3f) << 2) | (((color1 >> 5) & 0x3f) >> 4)),
+										(float)(((color1 & 0x1f) << 3) | ((color1 & 0x1f) >> 2)), 255.0f), scale);
+
+	// BC1 switches to three colors and transparent black when the first endpoint is not the larger, BC2 and BC3 never do.
+	if(color0 > color1 || !allowTransparent)
+	{
+		third = _mm_set1_ps(1.0f / 3.0f);
+		palette[2] = _mm_mul_ps(_mm_add_ps(_mm_add_ps(palette[0], palette[0]), palette[1]), third);
+		palette[3] = _mm_mul_ps(_mm_add_ps(_mm_add_ps(palette[1], palette[1]), palette[0]), third);
+	}
+	else
+	{
+		palette[2] = _mm_mul_ps(_mm_add_ps(palette[0], palette[1]), _mm_set1_ps(0.5f));
+		palette[3] = _mm_setzero_ps();
+	}
+
+	for(i=0; i<16; i++)
+	{
+		_mm_storeu_ps(&texels[i * 4], palette[(indexBits >> (i * 2)) & 3]);
+	}
+
+	return;
+}
+
+
+void BcDecoderClass::DecodeExplicitAlphaBlock(const unsigned char* block, float* texels)
+{
+	int i;
+
+
+	// Four bits of alpha a texel, low nibble first.
+	for(i=0; i<16; i++)
+	{
+		texels[i * 4 + 3] = (float)((block[i / 2] >> ((i & 1) * 4)) & 0xf) / 15.0f;
+	}
+
+	return;
+}
+
+
+void BcDecoderClass::DecodeAlphaBlock(const unsigned char* block, bool isSigned, int channel, float* texels)
+{
+	float palette[8];
+	unsigned long long indexBits;
+	int value0, value1, i;
+	float scale;
+
+
+	// SNORM endpoints are signed bytes, with -128 read as -127 so zero sits in the middle.
+	if(isSigned)
+	{
+		value0 = (signed char)block[0] < -127 ? -127 : (signed char)block[0];
+		value1 = (signed char)block[1] < -127 ? -127 : (signed char)block[1];
+		scale = 1.0f / 127.0f;
+	}
+	else
+	{
+		value0 = block[0];
+		value1 = block[1];
+		scale = 1.0f / 255.0f;
+	}
+
+	palette[0] = (float)value0 * scale;
+	palette[1] = (float)value1 * scale;
+
+	// Eight evenly spaced values when the first endpoint is the larger, otherwise six and the two extremes.
+	if(value0 > value1)
+	{
+		for(i=2; i<8; i++)
+		{
+			palette[i] = (float)((8 - i) * value0 + (i - 1) * value1) / 7.0f * scale;
+		}
+	}
+	else
+	{
+		for(i=2; i<6; i++)
+		{
+			palette[i] = (float)((6 - i) * value0 + (i - 1) * value1) / 5.0f * scale;
+		}
+		palette[6] = isSigned ? -1.0f : 0.0f;
+		palette[7] = 1.0f;
+	}
+
+	indexBits = 0;
+	for(i=0; i<6; i++)
+	{
+		indexBits |= (unsigned long long)block[2 + i] << (i * 8);
+	}
+
+	for(i=0; i<16; i++)
+	{
+		texels[i * 4 + channel] = palette[(indexBits >> (i * 3)) & 7];
+	}
+
+	return;
+}
+
+
+bool BcDecoderClass::DecodeBc6hBlock(const unsigned char* block, bool isSigned, float* texels)
+{
+	const Bc6hModeType* mode;
+	const int* weights;
+	int endpoints[12], modeBits, position, partition, mask, value, subset, index, indexBits, weight, bit, i, j;
+	bool anchor;
+
+
+	// Two mode bits when the second is clear, otherwise five.
+	if(block[0] & 0x2)
+	{
+		modeBits = block[0] & 0x1f;
+		position = 5;
+	}
+	else
+	{
+		modeBits = block[0] & 0x3;
+		position = 2;
+	}
+
+	mode = 0;
+	for(i=0; i<BC6H_MODE_COUNT; i++)
+	{
+		if(BC6H_MODES[i].modeBits == modeBits)
+		{
+			mode = &BC6H_MODES[i];
+			break;
+		}
+	}
+
+	// The reserved modes decode to black.
+	if(!mode)
+	{
+		for(i=0; i<16; i++)
+		{
+			_mm_storeu_ps(&texels[i * 4], _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+		}
+		return false;
+	}
+
+	// Gather the endpoint bits, which the modes scatter over the block to fit their precisions in.
+	memset(endpoints, 0, sizeof(endpoints));
+	for(i=0; i<mode->fieldCount; i++)
+	{
+		const Bc6hFieldType& field = mode->fields[i];
+
+		if(field.first >= field.last)
+		{
+			for(bit=field.last; bit<=field.first; bit++)
+			{
+				endpoints[field.value] |= ReadBits(block, position, 1) << bit;
+			}
+		}
+		else
+		{
+			for(bit=field.last; bit>=field.first; bit--)
+			{
+				endpoints[field.value] |= ReadBits(block, position, 1) << bit;
+			}
+		}
+	}
+
+	partition = mode->regions == 2 ? ReadBits(block, position, 5) : 0;
+
+	// The other endpoints of a transformed mode are signed deltas from the first, wrapped to its precision.
+	mask = (1 << mode->endpointBits) - 1;
+	if(isSigned)
+	{
+		for(j=0; j<3; j++)
+		{
+			endpoints[j] = SignExtend(endpoints[j], mode->endpointBits);
+		}
+	}
+	for(i=1; i<mode->regions * 2; i++)
+	{
+		for(j=0; j<3; j++)
+		{
+			value = endpoints[i * 3 + j];
+			if(mode->transformed)
+			{
+				value = (endpoints[j] + SignExtend(value, mode->deltaBits[j])) & mask;
+			}
+			if(isSigned)
+			{
+				value = SignExtend(value, mode->endpointBits);
+			}
+			endpoints[i * 3 + j] = value;
+		}
+	}
+
+	for(i=0; i<mode->regions * 6; i++)
+	{
+		endpoints[i] = UnquantizeBc6h(endpoints[i], mode->endpointBits, isSigned);
+	}
+
+	// Three bit indices with two subsets, four with one, the first index of each subset a bit shorter.
+	indexBits = mode->regions == 2 ? 3 : 4;
+	weights = BC7_WEIGHTS[indexBits];
+	for(i=0; i<16; i++)
+	{
+		subset = mode->regions == 2 ? (BC7_PARTITIONS2[partition] >> i) & 1 : 0;
+		anchor = i == 0 || (mode->regions == 2 && i == BC7_ANCHORS2[partition]);
+		index = ReadBits(block, position, anchor ? indexBits - 1 : indexBits);
+		weight = weights[index];
+
+		for(j=0; j<3; j++)
+		{
+			value = ((64 - weight) * endpoints[subset * 6 + j] + weight * endpoints[subset * 6 + 3 + j] + 32) >> 6;
+			texels[i * 4 + j] = DdsFormatClass::HalfToFloat(FinishBc6h(value, isSigned));
+		}
+		texels[i * 4 + 3] = 1.0f;
+	}
+
+	return true;
+}
+
+
+bool BcDecoderClass::DecodeBc7Block(const unsigned char* block, float* texels)
+{
+	const Bc7ModeType* mode;
+	__m128i starts[3], ends[3], start, end, weights, value, zero;
+	__m128 scale;
+	int endpoints[6][4], pBits[6], indices[16], secondIndices[16], colorWeights[16], alphaWeights[16];
+	int modeIndex, position, partition, rotation, indexSelection, endpointCount, bits, subset, i, j;
+	float swap;
+	bool anchor;
+
+
+	// The mode is the number of zero bits before the first one, eight zeros is reserved and decodes to nothing.
+	for(modeIndex=0; modeIndex<8 && !(block[0] & (1 << modeIndex)); modeIndex++)
+	{
+	}
+	if(modeIndex == 8)
+	{
+		memset(texels, 0, sizeof(float) * 64);
+		return false;
+	}
+
+	mode = &BC7_MODES[modeIndex];
+	position = modeIndex + 1;
+	partition = ReadBits(block, position, mode->partitionBits);
+	rotation = ReadBits(block, position, mode->rotationBits);
+	indexSelection = ReadBits(block, position, mode->indexSelectionBits);
+	endpointCount = mode->subsets * 2;
+
+	// Each channel of every endpoint in turn, then alpha, then the p-bits.
+	for(j=0; j<3; j++)
+	{
+		for(i=0; i<endpointCount; i++)
+		{
+			endpoints[i][j] = ReadBits(block, position, mode->colorBits);
+		}
+	}
+	for(i=0; i<endpointCount; i++)
+	{
+		endpoints[i][3] = mode->alphaBits ? ReadBits(block, position, mode->alphaBits) : 255;
+	}
+
+	for(i=0; i<endpointCount; i++)
+	{
+		pBits[i] = mode->endpointPBits ? ReadBits(block, position, 1) : 0;
+	}
+	for(i=0; i<mode->sharedPBits * mode->subsets; i++)
+	{
+		pBits[i * 2] = ReadBits(block, position, 1);
+		pBits[i * 2 + 1] = pBits[i * 2];
+	}
+
+	// The p-bit is the lowest bit, then the value is widened to 8 bits by repeating its top bits.
+	for(i=0; i<endpointCount; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			bits = j < 3 ? mode->colorBits : mode->alphaBits;
+			if(bits == 0)
+			{
+				continue;
+			}
+
+			if(mode->endpointPBits || mode->sharedPBits)
+			{
+				endpoints[i][j] = (endpoints[i][j] << 1) | pBits[i];
+				bits++;
+			}
+			endpoints[i][j] = (endpoints[i][j] << (8 - bits)) | (endpoints[i][j] >> (2 * bits - 8));
+		}
+	}
+
+	// The first texel of each subset has its top index bit left out, it is always zero.
+	for(i=0; i<16; i++)
+	{
+		anchor = i == 0;
+		if(mode->subsets == 2)
+		{
+			anchor = anchor || i == BC7_ANCHORS2[partition];
+		}
+		else if(mode->subsets == 3)
+		{
+			anchor = anchor || i == BC7_ANCHORS3_SECOND[partition] || i == BC7_ANCHORS3_THIRD[partition];
+		}
+		indices[i] = ReadBits(block, position, anchor ? mode->indexBits - 1 : mode->indexBits);
+	}
+	for(i=0; i<16 && mode->secondIndexBits; i++)
+	{
+		secondIndices[i] = ReadBits(block, position, i == 0 ? mode->secondIndexBits - 1 : mode->secondIndexBits);
+	}
+
+	// Modes 4 and 5 weight alpha by the second set of indices, or color by them when the selection bit is set.
+	for(i=0; i<16; i++)
+	{
+		if(!mode->secondIndexBits)
+		{
+			colorWeights[i] = BC7_WEIGHTS[mode->indexBits][indices[i]];
+			alphaWeights[i] = colorWeights[i];
+		}
+		else if(indexSelection)
+		{
+			colorWeights[i] = BC7_WEIGHTS[mode->secondIndexBits][secondIndices[i]];
+			alphaWeights[i] = BC7_WEIGHTS[mode->indexBits][indices[i]];
+		}
+		else
+		{
+			colorWeights[i] = BC7_WEIGHTS[mode->indexBits][indices[i]];
+			alphaWeights[i] = BC7_WEIGHTS[mode->secondIndexBits][secondIndices[i]];
+		}
+	}
+
+	for(i=0; i<mode->subsets; i++)
+	{
+		starts[i] = _mm_setr_epi16((short)endpoints[i * 2][0], (short)endpoints[i * 2][1], (short)endpoints[i * 2][2], (short)endpoints[i * 2][3], 0, 0, 0, 0);
+		ends[i] = _mm_setr_epi16((short)endpoints[i * 2 + 1][0], (short)endpoints[i * 2 + 1][1], (short)endpoints[i * 2 + 1][2], (short)endpoints[i * 2 + 1][3],
+								 0, 0, 0, 0);
+	}
+
+	// Interpolate two texels at a time in 16 bit lanes, the products stay below 64 * 255.
+	zero = _mm_setzero_si128();
+	scale = _mm_set1_ps(1.0f / 255.0f);
+	for(i=0; i<16; i+=2)
+	{
+		start = zero;
+		end = zero;
+		for(j=0; j<2; j++)
+		{
+			if(mode->subsets == 1)
+			{
+				subset = 0;
+			}
+			else if(mode->subsets == 2)
+			{
+				subset = (BC7_PARTITIONS2[partition] >> (i + j)) & 1;
+			}
+			else
+			{
+				subset = BC7_PARTITIONS3[partition][i + j];
+			}
+
+			if(j == 0)
+			{
+				start = starts[subset];
+				end = ends[subset];
+			}
+			else
+			{
+				start = _mm_unpacklo_epi64(start, starts[subset]);
+				end = _mm_unpacklo_epi64(end, ends[subset]);
+			}
+		}
+
+		weights = _mm_setr_epi16((short)colorWeights[i], (short)colorWeights[i], (short)colorWeights[i], (short)alphaWeights[i],
+								 (short)colorWeights[i + 1], (short)colorWeights[i + 1], (short)colorWeights[i + 1], (short)alphaWeights[i + 1]);
+		value = _mm_add_epi16(_mm_mullo_epi16(start, _mm_sub_epi16(_mm_set1_epi16(64), weights)), _mm_mullo_epi16(end, weights));
+		value = _mm_srli_epi16(_mm_add_epi16(value, _mm_set1_epi16(32)), 6);
+
+		_mm_storeu_ps(&texels[i * 4], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(value, zero)), scale));
+		_mm_storeu_ps(&texels[i * 4 + 4], _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(value, zero)), scale));
+	}
+
+	// A rotation swaps alpha with one of the color channels, so the separately indexed channel can be any of the four.
+	if(rotation)
+	{
+		for(i=0; i<16; i++)
+		{
+			swap = texels[i * 4 + 3];
+			texels[i * 4 + 3] = texels[i * 4 + rotation - 1];
+			texels[i * 4 + rotation - 1] = swap;
+		}
+	}
+
+	return true;
+}
+
+
+int BcDecoderClass::UnquantizeBc6h(int value, int bits, bool isSigned)
+{
+	bool negative;
+
+
+	// Spread the endpoint over the full 16 bits, the largest value landing on the largest the finish step keeps.
+	if(!isSigned)
+	{
+		if(bits >= 15 || value == 0)
+		{
+			return value;
+		}
+		if(value == (1 << bits) - 1)
+		{
+			return 0xffff;
+		}
+		return ((value << 16) + 0x8000) >> bits;
+	}
+
+	if(bits >= 16)
+	{
+		return value;
+	}
+
+	negative = value < 0;
+	if(negative)
+	{
+		value = -value;
+	}
+
+	if(value >= (1 << (bits - 1)) - 1)
+	{
+		value = 0x7fff;
+	}
+	else if(value != 0)
+	{
+		value = ((value << 15) + 0x4000) >> (bits - 1);
+	}
+
+	return negative ? -value : value;
+}
+
+
+unsigned short BcDecoderClass::FinishBc6h(int value, bool isSigned)
+{
+	// Scale the interpolated value to the range of a finite half, 31/64 of it unsigned and 31/32 signed.
+	if(!isSigned)
+	{
+		return (unsigned short)((value * 31) >> 6);
+	}
+
+	if(value < 0)
+	{
+		return (unsigned short)(0x8000 | ((-value * 31) >> 5));
+	}
+
+	return (unsigned short)((value * 31) >> 5);
+}
+
+
+int BcDecoderClass::SignExtend(int value, int bits)
+{
+	if(value & (1 << (bits - 1)))
+	{
+		return value | ~((1 << bits) - 1);
+	}
+
+	return value;
+}
+
+
+void BcDecoderClass::WriteBlock(const float* texels, int width, int height, int x, int y, unsigned char* output)
+{
+	unsigned char* texel;
+	float value;
+	int i, j, k;
+
+
+	// Texels of the block past the edge of a small level are dropped, the rest go in blue first.
+	for(j=0; j<DDS_BLOCK_SIZE && y + j < height; j++)
+	{
+		for(i=0; i<DDS_BLOCK_SIZE && x + i < width; i++)
+		{
+			texel = &output[((size_t)(y + j) * width + x + i) * 4];
+			for(k=0; k<4; k++)
+			{
+				value = texels[(j * DDS_BLOCK_SIZE + i) * 4 + (k < 3 ? 2 - k : 3)];
+				value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+				texel[k] = (unsigned char)(value * 255.0f + 0.5f);
+			}
+		}
+	}
+
+	return;
+}
+
+
+int BcDecoderClass::ReadBits(const unsigned char* block, int& position, int count)
+{
+	int value, i;
+
+
+	value = 0;
+	for(i=0; i<count; i++)
+	{
+		value |= ((block[position >> 3] >> (position & 7)) & 1) << i;
+		position++;
+	}
+
+	return value;
+}
@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: bcdecoderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _BCDECODERCLASS_H_
+#define _BCDECODERCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "ddsformatclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: BcDecoderClass
+//
+// Expands BC1 to BC7 blocks the way the hardware samples them.  DecodeBlock
+// gives the sixteen texels of one block as RGBA floats, as stored, so sRGB
+// is left to the caller, BC4 and BC5 SNORM come back from -1 to 1 and BC6H
+// as the half floats it holds.  Channels a format does not have are zero,
+// and one for alpha.  Decode expands a whole chain of an 8 bit format to
+// 32 bit BGRA for the cooker to measure what the encoder lost, GetPsnr
+// measures it over the channels the format keeps.
+//
+// The palettes are built and the texels interpolated four channels at a
+// time with SSE, BC7 two texels at a time.
+////////////////////////////////////////////////////////////////////////////////
+class BcDecoderClass
+{
+public:
+	static bool Decode(const unsigned char*, int, int, int, DdsFormatType, unsigned char*);
+	static bool DecodeBlock(const unsigned char*, DdsFormatType, float*);
+	static double GetPsnr(const unsigned char*, const unsigned char*, size_t, DdsFormatType);
+
+private:
+	static void DecodeColorBlock(const unsigned char*, bool, float*);
+	static void DecodeExplicitAlphaBlock(const unsigned char*, float*);
+	static void DecodeAlphaBlock(const unsigned char*, bool, int, float*);
+	static bool DecodeBc6hBlock(const unsigned char*, bool, float*);
+	static bool DecodeBc7Block(const unsigned char*, float*);
+
+	static int UnquantizeBc6h(int, int, bool);
+	static unsigned short FinishBc6h(int, bool);
+	static int SignExtend(int, int);
+	static void WriteBlock(const float*, int, int, int, int, unsigned char*);
+	static int ReadBits(const unsigned char*, int&, int);
+};
+
+#endif
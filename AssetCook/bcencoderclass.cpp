@@ -0,0 +1,687 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: bcencoderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "bcencoderclass.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <xmmintrin.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// How far along from the first endpoint to the second each palette index lies.
+static const float COLOR_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+static const float ALPHA_WEIGHTS[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+// The BC7 interpolation weights of a four bit index, in 64ths.
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+static const float BC7_FRACTIONS[16] = { 0.0f / 64.0f, 4.0f / 64.0f, 9.0f / 64.0f, 13.0f / 64.0f, 17.0f / 64.0f, 21.0f / 64.0f, 26.0f / 64.0f,
+										 30.0f / 64.0f, 34.0f / 64.0f, 38.0f / 64.0f, 43.0f / 64.0f, 47.0f / 64.0f, 51.0f / 64.0f, 55.0f / 64.0f,
+										 60.0f / 64.0f, 64.0f / 64.0f };
+static const int BC7_MODE = 6;
+
+
+bool BcEncoderClass::Encode(const unsigned char* levels, int width, int height, int mipCount, DdsFormatType format, JobSystemClass* jobSystem,
+							unsigned char* output)
+{
+	int blockRows, first, last, i;
+
+
+	if(format != DDS_FORMAT_BC1 && format != DDS_FORMAT_BC3 && format != DDS_FORMAT_BC5 && format != DDS_FORMAT_BC7)
+	{
+		return false;
+	}
+
+	// Every band of block rows of every level is independent, so they all go to the job system before waiting once.
+	for(i=0; i<mipCount; i++)
+	{
+		blockRows = (height + DDS_BLOCK_SIZE - 1) / DDS_BLOCK_SIZE;
+		for(first=0; first<blockRows; first+=BC_BLOCK_ROWS_PER_JOB)
+		{
+			last = first + BC_BLOCK_ROWS_PER_JOB < blockRows ? first + BC_BLOCK_ROWS_PER_JOB : blockRows;
+			if(jobSystem)
+			{
+				jobSystem->Submit("bc blocks", [levels, width, height, format, first, last, output]()
+				{
+					EncodeRows(levels, width, height, format, first, last, output);
+				});
+			}
+			else
+			{
+				EncodeRows(levels, width, height, format, first, last, output);
+			}
+		}
+
+		levels += (size_t)width * height * 4;
+		output += DdsFormatClass::GetLevelSize(format, width, height);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	if(jobSystem)
+	{
+		jobSystem->Wait();
+	}
+
+	return true;
+}
+
+
+void BcEncoderClass::EncodeRows(const unsigned char* pixels, int width, int height, DdsFormatType format, int firstRow, int lastRow,
+								unsigned char* output)
+{
+	BlockType block;
+	unsigned char* blockOutput;
+	size_t blockSize;
+	int blocksWide, x, y;
+
+
+	blockSize = DdsFormatClass::GetBlockSize(format);
+	blocksWide = (width + DDS_BLOCK_SIZE - 1) / DDS_BLOCK_SIZE;
+
+	for(y=firstRow; y<lastRow; y++)
+	{
+		for(x=0; x<blocksWide; x++)
+		{
+			ReadBlock(pixels, width, height, x * DDS_BLOCK_SIZE, y * DDS_BLOCK_SIZE, block);
+
+			blockOutput = &output[((size_t)y * blocksWide + x) * blockSize];
+			switch(format)
+			{
+				case DDS_FORMAT_BC1:
+				{
+					EncodeColorBlock(block, blockOutput);
+					break;
+				}
+
+				case DDS_FORMAT_BC3:
+				{
+					EncodeAlphaBlock(block.channels[3], blockOutput);
+					EncodeColorBlock(block, blockOutput + 8);
+					break;
+				}
+
+				case DDS_FORMAT_BC5:
+				{
+					EncodeAlphaBlock(block.channels[0], blockOutput);
+					EncodeAlphaBlock(block.channels[1], blockOutput + 8);
+					break;
+				}
+
+				default:
+				{
+					EncodeBc7Block(block, blockOutput);
+					break;
+				}
+			}
+		}
+	}
+
+	return;
+}
+
+
+void BcEncoderClass::ReadBlock(const unsigned char* pixels, int width, int height, int x, int y, BlockType& block)
+{
+	const unsigned char* texel;
+	int texelX, texelY, i, j;
+
+
+	// Levels smaller than a block repeat their edge texels to fill it.
+	for(j=0; j<DDS_BLOCK_SIZE; j++)
+	{
+		texelY = y + j < height ? y + j : height - 1;
+		for(i=0; i<DDS_BLOCK_SIZE; i++)
+		{
+			texelX = x + i < width ? x + i : width - 1;
+			texel = &pixels[((size_t)texelY * width + texelX) * 4];
+
+			block.channels[0][j * DDS_BLOCK_SIZE + i] = (float)texel[2];
+			block.channels[1][j * DDS_BLOCK_SIZE + i] = (float)texel[1];
+			block.channels[2][j * DDS_BLOCK_SIZE + i] = (float)texel[0];
+			block.channels[3][j * DDS_BLOCK_SIZE + i] = (float)texel[3];
+		}
+	}
+
+	return;
+}
+
+
+void BcEncoderClass::EncodeColorBlock(const BlockType& block, unsigned char* output)
+{
+	EndpointsType endpoints;
+	float palette[4][4];
+	int indices[16], bestIndices[16];
+	unsigned short color0, color1, bestColor0, bestColor1, swap;
+	unsigned int indexBits;
+	float error, bestError;
+	int iteration, i;
+
+
+	FindEndpoints(block, 3, endpoints);
+
+	bestError = FLT_MAX;
+	bestColor0 = 0;
+	bestColor1 = 0;
+	memset(bestIndices, 0, sizeof(bestIndices));
+
+	for(iteration=0; iteration<=BC_REFINE_ITERATIONS; iteration++)
+	{
+		// Quantize the endpoints to 565 and build the four color palette the hardware will decode.
+		color0 = QuantizeColor(endpoints.start, palette[0]);
+		color1 = QuantizeColor(endpoints.end, palette[1]);
+		for(i=0; i<3; i++)
+		{
+			palette[2][i] = (2.0f * palette[0][i] + palette[1][i]) / 3.0f;
+			palette[3][i] = (palette[0][i] + 2.0f * palette[1][i]) / 3.0f;
+		}
+
+		error = FindIndices(block, 3, palette, 4, indices);
+		if(error < bestError)
+		{
+			bestError = error;
+			bestColor0 = color0;
+			bestColor1 = color1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+
+		if(!RefineEndpoints(block, 3, indices, COLOR_WEIGHTS, endpoints))
+		{
+			break;
+		}
+	}
+
+	// The four color palette is only used when the first color is the larger, swapping them swaps the index pairs.
+	if(bestColor0 < bestColor1)
+	{
+		swap = bestColor0;
+		bestColor0 = bestColor1;
+		bestColor1 = swap;
+		for(i=0; i<16; i++)
+		{
+			bestIndices[i] ^= 1;
+		}
+	}
+	else if(bestColor0 == bestColor1)
+	{
+		memset(bestIndices, 0, sizeof(bestIndices));
+	}
+
+	indexBits = 0;
+	for(i=0; i<16; i++)
+	{
+		indexBits |= (unsigned int)bestIndices[i] << (i * 2);
+	}
+
+	output[0] = (unsigned char)(bestColor0 & 0xff);
+	output[1] = (unsigned char)(bestColor0 >> 8);
+	output[2] = (unsigned char)(bestColor1 & 0xff);
+	output[3] = (unsigned char)(bestColor1 >> 8);
+	output[4] = (unsigned char)(indexBits & 0xff);
+	output[5] = (unsigned char)((indexBits >> 8) & 0xff);
+	output[6] = (unsigned char)((indexBits >> 16) & 0xff);
+	output[7] = (unsigned char)(indexBits >> 24);
+
+	return;
+}
+
+
+void BcEncoderClass::EncodeAlphaBlock(const float* values, unsigned char* output)
+{
+	BlockType block;
+	EndpointsType endpoints;
+	int indices[16], bestIndices[16];
+	int alpha0, alpha1, bestAlpha0, bestAlpha1, iteration, i;
+	unsigned long long indexBits;
+	float error, bestError;
+
+
+	// The refit works on blocks, so the one channel goes in the first of them.
+	memcpy(block.channels[0], values, sizeof(block.channels[0]));
+
+	endpoints.start[0] = values[0];
+	endpoints.end[0] = values[0];
+	for(i=1; i<16; i++)
+	{
+		endpoints.start[0] = values[i] > endpoints.start[0] ? values[i] : endpoints.start[0];
+		endpoints.end[0] = values[i] < endpoints.end[0] ? values[i] : endpoints.end[0];
+	}
+
+	bestError = FLT_MAX;
+	bestAlpha0 = 0;
+	bestAlpha1 = 0;
+	memset(bestIndices, 0, sizeof(bestIndices));
+
+	for(iteration=0; iteration<=BC_REFINE_ITERATIONS; iteration++)
+	{
+		// The eight value palette needs the first endpoint to be the larger.
+		alpha0 = (int)(endpoints.start[0] + 0.5f);
+		alpha1 = (int)(endpoints.end[0] + 0.5f);
+		if(alpha0 < alpha1)
+		{
+			i = alpha0;
+			alpha0 = alpha1;
+			alpha1 = i;
+		}
+
+		error = FindAlphaIndices(values, alpha0, alpha1, indices);
+		if(error < bestError)
+		{
+			bestError = error;
+			bestAlpha0 = alpha0;
+			bestAlpha1 = alpha1;
+			memcpy(bestIndices, indices, sizeof(indices));
+		}
+
+		// A flat block is already exact.
+		if(alpha0 == alpha1)
+		{
+			break;
+		}
+
+		endpoints.start[0] = (float)alpha0;
+		endpoints.end[0] = (float)alpha1;
+		if(!RefineEndpoints(block, 1, indices, ALPHA_WEIGHTS, endpoints))
+		{
+			break;
+		}
+	}
+
+	indexBits = 0;
+	for(i=0; i<16; i++)
+	{
+		indexBits |= (unsigned long long)bestIndices[i] << (i * 3);
+	}
+
+	output[0] = (unsigned char)bestAlpha0;
+	output[1] = (unsigned char)bestAlpha1;
+	for(i=0; i<6; i++)
+	{
+		output[2 + i] = (unsigned char)((indexBits >> (i * 8)) & 0xff);
+	}
+
+	return;
+}
+
+
+void BcEncoderClass::EncodeBc7Block(const BlockType& block, unsigned char* output)
+{
+	EndpointsType endpoints;
+	float palette[16][4];
+	int indices[16], roundIndices[16], bestIndices[16];
+	int start[4], end[4], bestStart[4], bestEnd[4];
+	int startBit, endBit, bestStartBit, bestEndBit, iteration, position, swap, i, j;
+	float error, roundError, bestError;
+
+
+	FindEndpoints(block, 4, endpoints);
+
+	bestError = FLT_MAX;
+	bestStartBit = 0;
+	bestEndBit = 0;
+	memset(bestStart, 0, sizeof(bestStart));
+	memset(bestEnd, 0, sizeof(bestEnd));
+	memset(bestIndices, 0, sizeof(bestIndices));
+
+	for(iteration=0; iteration<=BC_REFINE_ITERATIONS; iteration++)
+	{
+		// Mode 6 stores seven bits a channel and one shared low bit an endpoint, so every pair of low bits is tried.
+		roundError = FLT_MAX;
+		for(startBit=0; startBit<2; startBit++)
+		{
+			for(endBit=0; endBit<2; endBit++)
+			{
+				for(i=0; i<4; i++)
+				{
+					start[i] = (int)((endpoints.start[i] - (float)startBit) * 0.5f + 0.5f);
+					start[i] = start[i] < 0 ? 0 : (start[i] > 127 ? 127 : start[i]);
+					end[i] = (int)((endpoints.end[i] - (float)endBit) * 0.5f + 0.5f);
+					end[i] = end[i] < 0 ? 0 : (end[i] > 127 ? 127 : end[i]);
+				}
+
+				for(j=0; j<16; j++)
+				{
+					for(i=0; i<4; i++)
+					{
+						palette[j][i] = (float)(((64 - BC7_WEIGHTS[j]) * (start[i] * 2 + startBit) + BC7_WEIGHTS[j] * (end[i] * 2 + endBit) + 32) >> 6);
+					}
+				}
+
+				error = FindIndices(block, 4, palette, 16, indices);
+				if(error < roundError)
+				{
+					roundError = error;
+					memcpy(roundIndices, indices, sizeof(indices));
+				}
+				if(error < bestError)
+				{
+					bestError = error;
+					bestStartBit = startBit;
+					bestEndBit = endBit;
+					memcpy(bestStart, start, sizeof(start));
+					memcpy(bestEnd, end, sizeof(end));
+					memcpy(bestIndices, indices, sizeof(indices));
+				}
+			}
+		}
+
+		if(!RefineEndpoints(block, 4, roundIndices, BC7_FRACTIONS, endpoints))
+		{
+			break;
+		}
+	}
+
+	// The top bit of the first index is implied zero, so flip the block round when it would be set.
+	if(bestIndices[0] >= 8)
+	{
+		for(i=0; i<4; i++)
+		{
+			swap = bestStart[i];
+			bestStart[i] = bestEnd[i];
+			bestEnd[i] = swap;
+		}
+
+		swap = bestStartBit;
+		bestStartBit = bestEndBit;
+		bestEndBit = swap;
+
+		for(i=0; i<16; i++)
+		{
+			bestIndices[i] = 15 - bestIndices[i];
+		}
+	}
+
+	// Pack the mode bit, the endpoints a channel at a time, the low bits and then the indices.
+	memset(output, 0, 16);
+	position = 0;
+	WriteBits(output, position, 1 << BC7_MODE, BC7_MODE + 1);
+	for(i=0; i<4; i++)
+	{
+		WriteBits(output, position, bestStart[i], 7);
+		WriteBits(output, position, bestEnd[i], 7);
+	}
+	WriteBits(output, position, bestStartBit, 1);
+	WriteBits(output, position, bestEndBit, 1);
+	for(i=0; i<16; i++)
+	{
+		WriteBits(output, position, bestIndices[i], i == 0 ? 3 : 4);
+	}
+
+	return;
+}
+
+
+void BcEncoderClass::FindEndpoints(const BlockType& block, int channelCount, EndpointsType& endpoints)
+{
+	float mean[4], covariance[4][4], axis[4], product[4];
+	float projection, low, high, length, largest, centered[4];
+	int iteration, i, j, k;
+
+
+	// The mean and covariance of the texels.
+	for(i=0; i<channelCount; i++)
+	{
+		mean[i] = 0.0f;
+		for(k=0; k<16; k++)
+		{
+			mean[i] += block.channels[i][k];
+		}
+		mean[i] /= 16.0f;
+	}
+
+	for(i=0; i<channelCount; i++)
+	{
+		for(j=0; j<channelCount; j++)
+		{
+			covariance[i][j] = 0.0f;
+			for(k=0; k<16; k++)
+			{
+				covariance[i][j] += (block.channels[i][k] - mean[i]) * (block.channels[j][k] - mean[j]);
+			}
+		}
+	}
+
+	// Power iteration from the diagonal finds the principal axis.
+	for(i=0; i<channelCount; i++)
+	{
+		axis[i] = covariance[i][i];
+	}
+
+	for(iteration=0; iteration<8; iteration++)
+	{
+		largest = 0.0f;
+		for(i=0; i<channelCount; i++)
+		{
+			product[i] = 0.0f;
+			for(j=0; j<channelCount; j++)
+			{
+				product[i] += covariance[i][j] * axis[j];
+			}
+			largest = fabsf(product[i]) > largest ? fabsf(product[i]) : largest;
+		}
+
+		if(largest == 0.0f)
+		{
+			break;
+		}
+
+		for(i=0; i<channelCount; i++)
+		{
+			axis[i] = product[i] / largest;
+		}
+	}
+
+	length = 0.0f;
+	for(i=0; i<channelCount; i++)
+	{
+		length += axis[i] * axis[i];
+	}
+
+	// A flat block has no axis, both endpoints sit on the mean.
+	if(length < 1e-12f)
+	{
+		for(i=0; i<channelCount; i++)
+		{
+			endpoints.start[i] = mean[i];
+			endpoints.end[i] = mean[i];
+		}
+		return;
+	}
+
+	length = sqrtf(length);
+	for(i=0; i<channelCount; i++)
+	{
+		axis[i] /= length;
+	}
+
+	// The endpoints start at the extremes of the texels along the axis.
+	low = FLT_MAX;
+	high = -FLT_MAX;
+	for(k=0; k<16; k++)
+	{
+		projection = 0.0f;
+		for(i=0; i<channelCount; i++)
+		{
+			centered[i] = block.channels[i][k] - mean[i];
+			projection += centered[i] * axis[i];
+		}
+		low = projection < low ? projection : low;
+		high = projection > high ? projection : high;
+	}
+
+	for(i=0; i<channelCount; i++)
+	{
+		endpoints.start[i] = mean[i] + low * axis[i];
+		endpoints.start[i] = endpoints.start[i] < 0.0f ? 0.0f : (endpoints.start[i] > 255.0f ? 255.0f : endpoints.start[i]);
+		endpoints.end[i] = mean[i] + high * axis[i];
+		endpoints.end[i] = endpoints.end[i] < 0.0f ? 0.0f : (endpoints.end[i] > 255.0f ? 255.0f : endpoints.end[i]);
+	}
+
+	return;
+}
+
+
+bool BcEncoderClass::RefineEndpoints(const BlockType& block, int channelCount, const int* indices, const float* weights, EndpointsType& endpoints)
+{
+	float startSum, crossSum, endSum, startValues[4], endValues[4], weight, determinant;
+	int i, k;
+
+
+	// Least squares for the endpoints that best reproduce the texels with the indices they were given.
+	startSum = 0.0f;
+	crossSum = 0.0f;
+	endSum = 0.0f;
+	for(i=0; i<channelCount; i++)
+	{
+		startValues[i] = 0.0f;
+		endValues[i] = 0.0f;
+	}
+
+	for(k=0; k<16; k++)
+	{
+		weight = weights[indices[k]];
+		startSum += (1.0f - weight) * (1.0f - weight);
+		crossSum += (1.0f - weight) * weight;
+		endSum += weight * weight;
+		for(i=0; i<channelCount; i++)
+		{
+			startValues[i] += (1.0f - weight) * block.channels[i][k];
+			endValues[i] += weight * block.channels[i][k];
+		}
+	}
+
+	// Every texel on the same index leaves the system singular.
+	determinant = startSum * endSum - crossSum * crossSum;
+	if(fabsf(determinant) < 1e-6f)
+	{
+		return false;
+	}
+
+	for(i=0; i<channelCount; i++)
+	{
+		endpoints.start[i] = (endSum * startValues[i] - crossSum * endValues[i]) / determinant;
+		endpoints.start[i] = endpoints.start[i] < 0.0f ? 0.0f : (endpoints.start[i] > 255.0f ? 255.0f : endpoints.start[i]);
+		endpoints.end[i] = (startSum * endValues[i] - crossSum * startValues[i]) / determinant;
+		endpoints.end[i] = endpoints.end[i] < 0.0f ? 0.0f : (endpoints.end[i] > 255.0f ? 255.0f : endpoints.end[i]);
+	}
+
+	return true;
+}
+
+
+float BcEncoderClass::FindIndices(const BlockType& block, int channelCount, const float (*palette)[4], int paletteSize, int* indices)
+{
+	__m128 distance, difference, best, bestIndex, closer;
+	float bestValues[4], indexValues[4], error;
+	int i, k, c;
+
+
+	// Four texels at a time, the nearest palette entry of each kept along with its distance.
+	error = 0.0f;
+	for(k=0; k<16; k+=4)
+	{
+		best = _mm_set1_ps(FLT_MAX);
+		bestIndex = _mm_setzero_ps();
+		for(i=0; i<paletteSize; i++)
+		{
+			distance = _mm_setzero_ps();
+			for(c=0; c<channelCount; c++)
+			{
+				difference = _mm_sub_ps(_mm_loadu_ps(&block.channels[c][k]), _mm_set1_ps(palette[i][c]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+			}
+
+			closer = _mm_cmplt_ps(distance, best);
+			best = _mm_min_ps(distance, best);
+			bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)i)), _mm_andnot_ps(closer, bestIndex));
+		}
+
+		_mm_storeu_ps(bestValues, best);
+		_mm_storeu_ps(indexValues, bestIndex);
+		for(i=0; i<4; i++)
+		{
+			indices[k + i] = (int)indexValues[i];
+			error += bestValues[i];
+		}
+	}
+
+	return error;
+}
+
+
+float BcEncoderClass::FindAlphaIndices(const float* values, int alpha0, int alpha1, int* indices)
+{
+	float decoded, error;
+	int step, k;
+
+
+	error = 0.0f;
+
+	// Equal endpoints decode every index to the first one.
+	if(alpha0 == alpha1)
+	{
+		for(k=0; k<16; k++)
+		{
+			indices[k] = 0;
+			error += (values[k] - (float)alpha0) * (values[k] - (float)alpha0);
+		}
+		return error;
+	}
+
+	// The eight values are evenly spaced, so the nearest is found by rounding the step from the lower endpoint.
+	for(k=0; k<16; k++)
+	{
+		step = (int)((values[k] - (float)alpha1) * 7.0f / (float)(alpha0 - alpha1) + 0.5f);
+		step = step < 0 ? 0 : (step > 7 ? 7 : step);
+
+		indices[k] = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+
+		decoded = (float)((step * alpha0 + (7 - step) * alpha1) / 7);
+		error += (values[k] - decoded) * (values[k] - decoded);
+	}
+
+	return error;
+}
+
+
+unsigned short BcEncoderClass::QuantizeColor(const float* color, float* expanded)
+{
+	int red, green, blue;
+
+
+	red = (int)(color[0] * 31.0f / 255.0f + 0.5f);
+	green = (int)(color[1] * 63.0f / 255.0f + 0.5f);
+	blue = (int)(color[2] * 31.0f / 255.0f + 0.5f);
+	red = red < 0 ? 0 : (red > 31 ? 31 : red);
+	green = green < 0 ? 0 : (green > 63 ? 63 : green);
+	blue = blue < 0 ? 0 : (blue > 31 ? 31 : blue);
+
+	// The value the hardware expands it back to, the high bits repeated into the low ones.
+	expanded[0] = (float)((red << 3) | (red >> 2));
+	expanded[1] = (float)((green << 2) | (green >> 4));
+	expanded[2] = (float)((blue << 3) | (blue >> 2));
+
+	return (unsigned short)((red << 11) | (green << 5) | blue);
+}
+
+
+void BcEncoderClass::WriteBits(unsigned char* block, int& position, int value, int count)
+{
+	int i;
+
+
+	// BC7 fields are packed from the lowest bit of the first byte up.
+	for(i=0; i<count; i++)
+	{
+		if(value & (1 << i))
+		{
+			block[position >> 3] |= (unsigned char)(1 << (position & 7));
+		}
+		position++;
+	}
+
+	return;
+}
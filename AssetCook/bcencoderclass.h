@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: bcencoderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _BCENCODERCLASS_H_
+#define _BCENCODERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "../Engine/jobsystemclass.h"
+#include "ddsformatclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Rows of blocks of a level compressed by one job.
+const int BC_BLOCK_ROWS_PER_JOB = 4;
+
+// Rounds of fitting the endpoints again to the indices they produced.
+const int BC_REFINE_ITERATIONS = 2;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: BcEncoderClass
+//
+// Compresses a 32 bit BGRA mip chain into BC1, BC3, BC5 or BC7 blocks.  The
+// endpoints of a block start at the ends of the principal axis of its texels
+// and are then fitted again by least squares to the indices they gave, with
+// the better of each round kept.  The texels of a block are held a channel to
+// an array so SSE measures four texels against the palette at once, and every
+// band of block rows of every level is a job of its own.
+//
+// BC7 uses mode 6 only, one pair of RGBA endpoints with a 16 entry palette,
+// which already matches BC3 in size and beats it on quality.  BC5 keeps the
+// red and green channels, the X and Y of a normal map.
+////////////////////////////////////////////////////////////////////////////////
+class BcEncoderClass
+{
+private:
+	// The sixteen texels of a block, red, green, blue and alpha a channel to an array.
+	struct BlockType
+	{
+		float channels[4][16];
+	};
+
+	// A pair of endpoints, the palette is interpolated between them.
+	struct EndpointsType
+	{
+		float start[4];
+		float end[4];
+	};
+
+public:
+	static bool Encode(const unsigned char*, int, int, int, DdsFormatType, JobSystemClass*, unsigned char*);
+
+private:
+	static void EncodeRows(const unsigned char*, int, int, DdsFormatType, int, int, unsigned char*);
+	static void ReadBlock(const unsigned char*, int, int, int, int, BlockType&);
+	static void EncodeColorBlock(const BlockType&, unsigned char*);
+	static void EncodeAlphaBlock(const float*, unsigned char*);
+	static void EncodeBc7Block(const BlockType&, unsigned char*);
+
+	static void FindEndpoints(const BlockType&, int, EndpointsType&);
+	static bool RefineEndpoints(const BlockType&, int, const int*, const float*, EndpointsType&);
+	static float FindIndices(const BlockType&, int, const float (*)[4], int, int*);
+	static float FindAlphaIndices(const float*, int, int, int*);
+	static unsigned short QuantizeColor(const float*, float*);
+	static void WriteBits(unsigned char*, int&, int, int);
+};
+
+#endif
@@ -0,0 +1,475 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ddsformatclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ddsformatclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int DDPF_ALPHA = 0x2;
+const unsigned int DDPF_FOURCC = 0x4;
+const unsigned int DDPF_RGB = 0x40;
+const unsigned int DDPF_LUMINANCE = 0x20000;
+
+#define DDS_FOURCC(a, b, c, d) ((unsigned int)(a) | ((unsigned int)(b) << 8) | ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+#define DDS_RGB (DDS_CHANNEL_RED | DDS_CHANNEL_GREEN | DDS_CHANNEL_BLUE)
+#define DDS_RGBA (DDS_CHANNEL_RED | DDS_CHANNEL_GREEN | DDS_CHANNEL_BLUE | DDS_CHANNEL_ALPHA)
+#define DDS_RG (DDS_CHANNEL_RED | DDS_CHANNEL_GREEN)
+
+struct DdsFormatInfoType
+{
+	DdsFormatType format;
+	const char* name;
+	unsigned int dxgiFormat;
+	int blockWidth;
+	int blockHeight;
+	int blockSize;
+	unsigned int channels;
+	bool srgb;
+};
+
+// One row a format, in the order of DdsFormatType.
+static const DdsFormatInfoType FORMATS[DDS_FORMAT_COUNT] =
+{
+	{ DDS_FORMAT_UNKNOWN, "unknown", 0, 1, 1, 0, 0, false },
+	{ DDS_FORMAT_BGRA8, "B8G8R8A8", 87, 1, 1, 4, DDS_RGBA, false },
+	{ DDS_FORMAT_BGRA8_SRGB, "B8G8R8A8 sRGB", 91, 1, 1, 4, DDS_RGBA, true },
+	{ DDS_FORMAT_BGRX8, "B8G8R8X8", 88, 1, 1, 4, DDS_RGB, false },
+	{ DDS_FORMAT_BGRX8_SRGB, "B8G8R8X8 sRGB", 93, 1, 1, 4, DDS_RGB, true },
+	{ DDS_FORMAT_RGBA8, "R8G8B8A8", 28, 1, 1, 4, DDS_RGBA, false },
+	{ DDS_FORMAT_RGBA8_SRGB, "R8G8B8A8 sRGB", 29, 1, 1, 4, DDS_RGBA, true },
+	{ DDS_FORMAT_R10G10B10A2, "R10G10B10A2", 24, 1, 1, 4, DDS_RGBA, false },
+	{ DDS_FORMAT_B5G6R5, "B5G6R5", 85, 1, 1, 2, DDS_RGB, false },
+	{ DDS_FORMAT_B5G5R5A1, "B5G5R5A1", 86, 1, 1, 2, DDS_RGBA, false },
+	{ DDS_FORMAT_B4G4R4A4, "B4G4R4A4", 115, 1, 1, 2, DDS_RGBA, false },
+	{ DDS_FORMAT_R8, "R8", 61, 1, 1, 1, DDS_CHANNEL_RED, false },
+	{ DDS_FORMAT_R8G8, "R8G8", 49, 1, 1, 2, DDS_RG, false },
+	{ DDS_FORMAT_A8, "A8", 65, 1, 1, 1, DDS_CHANNEL_ALPHA, false },
+	{ DDS_FORMAT_R16, "R16", 56, 1, 1, 2, DDS_CHANNEL_RED, false },
+	{ DDS_FORMAT_R16G16, "R16G16", 35, 1, 1, 4, DDS_RG, false },
+	{ DDS_FORMAT_R16G16B16A16, "R16G16B16A16", 11, 1, 1, 8, DDS_RGBA, false },
+	{ DDS_FORMAT_R16G16B16A16_SNORM, "R16G16B16A16 SNORM", 13, 1, 1, 8, DDS_RGBA, false },
+	{ DDS_FORMAT_R16_FLOAT, "R16 float", 54, 1, 1, 2, DDS_CHANNEL_RED, false },
+	{ DDS_FORMAT_R16G16_FLOAT, "R16G16 float", 34, 1, 1, 4, DDS_RG, false },
+	{ DDS_FORMAT_R16G16B16A16_FLOAT, "R16G16B16A16 float", 10, 1, 1, 8, DDS_RGBA, false },
+	{ DDS_FORMAT_R32_FLOAT, "R32 float", 41, 1, 1, 4, DDS_CHANNEL_RED, false },
+	{ DDS_FORMAT_R32G32_FLOAT, "R32G32 float", 16, 1, 1, 8, DDS_RG, false },
+	{ DDS_FORMAT_R32G32B32A32_FLOAT, "R32G32B32A32 float", 2, 1, 1, 16, DDS_RGBA, false },
+	{ DDS_FORMAT_R8G8_B8G8, "R8G8_B8G8", 68, 2, 1, 4, DDS_RGB, false },
+	{ DDS_FORMAT_G8R8_G8B8, "G8R8_G8B8", 69, 2, 1, 4, DDS_RGB, false },
+	{ DDS_FORMAT_YUY2, "YUY2", 107, 2, 1, 4, DDS_RGB, false },
+	{ DDS_FORMAT_BC1, "BC1", 71, 4, 4, 8, DDS_RGB, false },
+	{ DDS_FORMAT_BC1_SRGB, "BC1 sRGB", 72, 4, 4, 8, DDS_RGB, true },
+	{ DDS_FORMAT_BC2, "BC2", 74, 4, 4, 16, DDS_RGBA, false },
+	{ DDS_FORMAT_BC2_SRGB, "BC2 sRGB", 75, 4, 4, 16, DDS_RGBA, true },
+	{ DDS_FORMAT_BC3, "BC3", 77, 4, 4, 16, DDS_RGBA, false },
+	{ DDS_FORMAT_BC3_SRGB, "BC3 sRGB", 78, 4, 4, 16, DDS_RGBA, true },
+	{ DDS_FORMAT_BC4, "BC4", 80, 4, 4, 8, DDS_CHANNEL_RED, false },
+	{ DDS_FORMAT_BC4_SNORM, "BC4 SNORM", 81, 4, 4, 8, DDS_CHANNEL_RED, false },
+	{ DDS_FORMAT_BC5, "BC5", 83, 4, 4, 16, DDS_RG, false },
+	{ DDS_FORMAT_BC5_SNORM, "BC5 SNORM", 84, 4, 4, 16, DDS_RG, false },
+	{ DDS_FORMAT_BC6H_UF16, "BC6H UF16", 95, 4, 4, 16, DDS_RGB, false },
+	{ DDS_FORMAT_BC6H_SF16, "BC6H SF16", 96, 4, 4, 16, DDS_RGB, false },
+	{ DDS_FORMAT_BC7, "BC7", 98, 4, 4, 16, DDS_RGBA, false },
+	{ DDS_FORMAT_BC7_SRGB, "BC7 sRGB", 99, 4, 4, 16, DDS_RGBA, true }
+};
+
+
+DdsFormatType DdsFormatClass::GetFormat(const HeaderType& header, const HeaderDx10Type* headerDx10)
+{
+	const PixelFormatType& pixelFormat = header.pixelFormat;
+
+
+	if(headerDx10)
+	{
+		return GetFormatFromDxgi(headerDx10->dxgiFormat);
+	}
+
+	// The same masks the engine's loader maps, anything it does not know is unknown here too.
+	if(pixelFormat.flags & DDPF_RGB)
+	{
+		if(pixelFormat.rgbBitCount == 32)
+		{
+			if(pixelFormat.redMask == 0x000000ff && pixelFormat.greenMask == 0x0000ff00 && pixelFormat.blueMask == 0x00ff0000 &&
+			   pixelFormat.alphaMask == 0xff000000)
+			{
+				return DDS_FORMAT_RGBA8;
+			}
+			if(pixelFormat.redMask == 0x00ff0000 && pixelFormat.greenMask == 0x0000ff00 && pixelFormat.blueMask == 0x000000ff &&
+			   pixelFormat.alphaMask == 0xff000000)
+			{
+				return DDS_FORMAT_BGRA8;
+			}
+			if(pixelFormat.redMask == 0x00ff0000 && pixelFormat.greenMask == 0x0000ff00 && pixelFormat.blueMask == 0x000000ff &&
+			   pixelFormat.alphaMask == 0)
+			{
+				return DDS_FORMAT_BGRX8;
+			}
+
+			// The loader takes these masks as R10G10B10A2 even though they are the other way round, as D3DX wrote them.
+			if(pixelFormat.redMask == 0x3ff00000 && pixelFormat.greenMask == 0x000ffc00 && pixelFormat.blueMask == 0x000003ff &&
+			   pixelFormat.alphaMask == 0xc0000000)
+			{
+				return DDS_FORMAT_R10G10B10A2;
+			}
+			if(pixelFormat.redMask == 0x0000ffff && pixelFormat.greenMask == 0xffff0000 && pixelFormat.blueMask == 0 && pixelFormat.alphaMask == 0)
+			{
+				return DDS_FORMAT_R16G16;
+			}
+			if(pixelFormat.redMask == 0xffffffff && pixelFormat.greenMask == 0 && pixelFormat.blueMask == 0 && pixelFormat.alphaMask == 0)
+			{
+				return DDS_FORMAT_R32_FLOAT;
+			}
+		}
+		else if(pixelFormat.rgbBitCount == 16)
+		{
+			if(pixelFormat.redMask == 0x7c00 && pixelFormat.greenMask == 0x03e0 && pixelFormat.blueMask == 0x001f && pixelFormat.alphaMask == 0x8000)
+			{
+				return DDS_FORMAT_B5G5R5A1;
+			}
+			if(pixelFormat.redMask == 0xf800 && pixelFormat.greenMask == 0x07e0 && pixelFormat.blueMask == 0x001f && pixelFormat.alphaMask == 0)
+			{
+				return DDS_FORMAT_B5G6R5;
+			}
+			if(pixelFormat.redMask == 0x0f00 && pixelFormat.greenMask == 0x00f0 && pixelFormat.blueMask == 0x000f && pixelFormat.alphaMask == 0xf000)
+			{
+				return DDS_FORMAT_B4G4R4A4;
+			}
+		}
+	}
+	else if(pixelFormat.flags & DDPF_LUMINANCE)
+	{
+		if(pixelFormat.rgbBitCount == 8 && pixelFormat.redMask == 0x000000ff && pixelFormat.alphaMask == 0)
+		{
+			return DDS_FORMAT_R8;
+		}
+		if(pixelFormat.rgbBitCount == 16 && pixelFormat.redMask == 0x0000ffff && pixelFormat.alphaMask == 0)
+		{
+			return DDS_FORMAT_R16;
+		}
+		if(pixelFormat.rgbBitCount == 16 && pixelFormat.redMask == 0x000000ff && pixelFormat.alphaMask == 0x0000ff00)
+		{
+			return DDS_FORMAT_R8G8;
+		}
+	}
+	else if(pixelFormat.flags & DDPF_ALPHA)
+	{
+		if(pixelFormat.rgbBitCount == 8)
+		{
+			return DDS_FORMAT_A8;
+		}
+	}
+	else if(pixelFormat.flags & DDPF_FOURCC)
+	{
+		switch(pixelFormat.fourCC)
+		{
+			case DDS_FOURCC('D', 'X', 'T', '1'):
+			{
+				return DDS_FORMAT_BC1;
+			}
+
+			case DDS_FOURCC('D', 'X', 'T', '2'):
+			case DDS_FOURCC('D', 'X', 'T', '3'):
+			{
+				return DDS_FORMAT_BC2;
+			}
+
+			case DDS_FOURCC('D', 'X', 'T', '4'):
+			case DDS_FOURCC('D', 'X', 'T', '5'):
+			{
+				return DDS_FORMAT_BC3;
+			}
+
+			case DDS_FOURCC('A', 'T', 'I', '1'):
+			case DDS_FOURCC('B', 'C', '4', 'U'):
+			{
+				return DDS_FORMAT_BC4;
+			}
+
+			case DDS_FOURCC('B', 'C', '4', 'S'):
+			{
+				return DDS_FORMAT_BC4_SNORM;
+			}
+
+			case DDS_FOURCC('A', 'T', 'I', '2'):
+			case DDS_FOURCC('B', 'C', '5', 'U'):
+			{
+				return DDS_FORMAT_BC5;
+			}
+
+			case DDS_FOURCC('B', 'C', '5', 'S'):
+			{
+				return DDS_FORMAT_BC5_SNORM;
+			}
+
+			case DDS_FOURCC('R', 'G', 'B', 'G'):
+			{
+				return DDS_FORMAT_R8G8_B8G8;
+			}
+
+			case DDS_FOURCC('G', 'R', 'G', 'B'):
+			{
+				return DDS_FORMAT_G8R8_G8B8;
+			}
+
+			case DDS_FOURCC('Y', 'U', 'Y', '2'):
+			{
+				return DDS_FORMAT_YUY2;
+			}
+
+			// D3DFORMAT values written as the four character code.
+			case 36:
+			{
+				return DDS_FORMAT_R16G16B16A16;
+			}
+
+			case 110:
+			{
+				return DDS_FORMAT_R16G16B16A16_SNORM;
+			}
+
+			case 111:
+			{
+				return DDS_FORMAT_R16_FLOAT;
+			}
+
+			case 112:
+			{
+				return DDS_FORMAT_R16G16_FLOAT;
+			}
+
+			case 113:
+			{
+				return DDS_FORMAT_R16G16B16A16_FLOAT;
+			}
+
+			case 114:
+			{
+				return DDS_FORMAT_R32_FLOAT;
+			}
+
+			case 115:
+			{
+				return DDS_FORMAT_R32G32_FLOAT;
+			}
+
+			case 116:
+			{
+				return DDS_FORMAT_R32G32B32A32_FLOAT;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	}
+
+	return DDS_FORMAT_UNKNOWN;
+}
+
+
+DdsFormatType DdsFormatClass::GetFormatFromDxgi(unsigned int dxgiFormat)
+{
+	int i;
+
+
+	// The typeless formats read as their UNORM twins.
+	switch(dxgiFormat)
+	{
+		case 27:
+		{
+			return DDS_FORMAT_RGBA8;
+		}
+
+		case 70:
+		{
+			return DDS_FORMAT_BC1;
+		}
+
+		case 73:
+		{
+			return DDS_FORMAT_BC2;
+		}
+
+		case 76:
+		{
+			return DDS_FORMAT_BC3;
+		}
+
+		case 79:
+		{
+			return DDS_FORMAT_BC4;
+		}
+
+		case 82:
+		{
+			return DDS_FORMAT_BC5;
+		}
+
+		case 90:
+		{
+			return DDS_FORMAT_BGRA8;
+		}
+
+		case 92:
+		{
+			return DDS_FORMAT_BGRX8;
+		}
+
+		case 94:
+		{
+			return DDS_FORMAT_BC6H_UF16;
+		}
+
+		case 97:
+		{
+			return DDS_FORMAT_BC7;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+
+	for(i=1; i<DDS_FORMAT_COUNT; i++)
+	{
+		if(FORMATS[i].dxgiFormat == dxgiFormat)
+		{
+			return FORMATS[i].format;
+		}
+	}
+
+	return DDS_FORMAT_UNKNOWN;
+}
+
+
+unsigned int DdsFormatClass::GetDxgiFormat(DdsFormatType format)
+{
+	return FORMATS[format].dxgiFormat;
+}
+
+
+bool DdsFormatClass::HasDx10Header(const HeaderType& header)
+{
+	return (header.pixelFormat.flags & DDPF_FOURCC) && header.pixelFormat.fourCC == DDS_FOURCC('D', 'X', '1', '0');
+}
+
+
+const char* DdsFormatClass::GetName(DdsFormatType format)
+{
+	return FORMATS[format].name;
+}
+
+
+int DdsFormatClass::GetBlockWidth(DdsFormatType format)
+{
+	return FORMATS[format].blockWidth;
+}
+
+
+int DdsFormatClass::GetBlockHeight(DdsFormatType format)
+{
+	return FORMATS[format].blockHeight;
+}
+
+
+size_t DdsFormatClass::GetBlockSize(DdsFormatType format)
+{
+	return (size_t)FORMATS[format].blockSize;
+}
+
+
+size_t DdsFormatClass::GetLevelSize(DdsFormatType format, int width, int height)
+{
+	int blockWidth, blockHeight;
+
+
+	// A level is covered with whole blocks, so the smallest levels of a block format still take one block each.
+	blockWidth = FORMATS[format].blockWidth;
+	blockHeight = FORMATS[format].blockHeight;
+
+	return (size_t)((width + blockWidth - 1) / blockWidth) * ((height + blockHeight - 1) / blockHeight) * FORMATS[format].blockSize;
+}
+
+
+size_t DdsFormatClass::GetChainSize(DdsFormatType format, int width, int height, int mipCount)
+{
+	size_t size;
+	int i;
+
+
+	size = 0;
+	for(i=0; i<mipCount; i++)
+	{
+		size += GetLevelSize(format, width, height);
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return size;
+}
+
+
+unsigned int DdsFormatClass::GetChannels(DdsFormatType format)
+{
+	return FORMATS[format].channels;
+}
+
+
+bool DdsFormatClass::IsCompressed(DdsFormatType format)
+{
+	return FORMATS[format].blockHeight == DDS_BLOCK_SIZE;
+}
+
+
+bool DdsFormatClass::IsSrgb(DdsFormatType format)
+{
+	return FORMATS[format].srgb;
+}
+
+
+float DdsFormatClass::HalfToFloat(unsigned short half)
+{
+	union
+	{
+		unsigned int bits;
+		float value;
+	} result;
+	unsigned int sign, exponent, mantissa;
+
+
+	sign = (unsigned int)(half & 0x8000) << 16;
+	exponent = (half >> 10) & 0x1f;
+	mantissa = half & 0x3ff;
+
+	if(exponent == 0x1f)
+	{
+		// Infinity and NaN keep their mantissa.
+		result.bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else if(exponent != 0)
+	{
+		result.bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else if(mantissa != 0)
+	{
+		// A denormal half is a normal float, shift the mantissa up until its leading one is the implied bit.
+		exponent = 113;
+		while(!(mantissa & 0x400))
+		{
+			mantissa <<= 1;
+			exponent--;
+		}
+		result.bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+	}
+	else
+	{
+		result.bits = sign;
+	}
+
+	return result.value;
+}
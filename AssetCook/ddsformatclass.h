@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ddsformatclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _DDSFORMATCLASS_H_
+#define _DDSFORMATCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int DDS_MAGIC_NUMBER = 0x20534444;	// "DDS "
+const unsigned int DDS_HEADER_SIZE = 124;
+
+// The block every BC format is made of, a 4x4 tile of texels.
+const int DDS_BLOCK_SIZE = 4;
+
+// Every format the engine's DDS loader recognizes, in the order of the table in ddsformatclass.cpp.
+enum DdsFormatType
+{
+	DDS_FORMAT_UNKNOWN,
+	DDS_FORMAT_BGRA8,		// 32 bits a texel, blue in the lowest byte, the layout of the uncompressed textures in the data folder
+	DDS_FORMAT_BGRA8_SRGB,
+	DDS_FORMAT_BGRX8,
+	DDS_FORMAT_BGRX8_SRGB,
+	DDS_FORMAT_RGBA8,
+	DDS_FORMAT_RGBA8_SRGB,
+	DDS_FORMAT_R10G10B10A2,
+	DDS_FORMAT_B5G6R5,
+	DDS_FORMAT_B5G5R5A1,
+	DDS_FORMAT_B4G4R4A4,
+	DDS_FORMAT_R8,
+	DDS_FORMAT_R8G8,
+	DDS_FORMAT_A8,
+	DDS_FORMAT_R16,
+	DDS_FORMAT_R16G16,
+	DDS_FORMAT_R16G16B16A16,
+	DDS_FORMAT_R16G16B16A16_SNORM,
+	DDS_FORMAT_R16_FLOAT,
+	DDS_FORMAT_R16G16_FLOAT,
+	DDS_FORMAT_R16G16B16A16_FLOAT,
+	DDS_FORMAT_R32_FLOAT,
+	DDS_FORMAT_R32G32_FLOAT,
+	DDS_FORMAT_R32G32B32A32_FLOAT,
+	DDS_FORMAT_R8G8_B8G8,	// two texels in four bytes sharing red and blue
+	DDS_FORMAT_G8R8_G8B8,
+	DDS_FORMAT_YUY2,		// two texels in four bytes sharing the chroma
+	DDS_FORMAT_BC1,			// 4x4 blocks of 8 bytes, two 565 colors and two bit indices, opaque color
+	DDS_FORMAT_BC1_SRGB,
+	DDS_FORMAT_BC2,			// 4x4 blocks of 16 bytes, four bit alpha followed by a BC1 color block
+	DDS_FORMAT_BC2_SRGB,
+	DDS_FORMAT_BC3,			// 4x4 blocks of 16 bytes, a BC4 alpha block followed by a BC1 color block
+	DDS_FORMAT_BC3_SRGB,
+	DDS_FORMAT_BC4,			// 4x4 blocks of 8 bytes, one channel
+	DDS_FORMAT_BC4_SNORM,
+	DDS_FORMAT_BC5,			// 4x4 blocks of 16 bytes, two BC4 blocks holding the red and green channels, for normal maps
+	DDS_FORMAT_BC5_SNORM,
+	DDS_FORMAT_BC6H_UF16,	// 4x4 blocks of 16 bytes, half float color
+	DDS_FORMAT_BC6H_SF16,
+	DDS_FORMAT_BC7,			// 4x4 blocks of 16 bytes, higher quality color and alpha, needs the DX10 header
+	DDS_FORMAT_BC7_SRGB,
+	DDS_FORMAT_COUNT
+};
+
+// The channels a format stores, the rest read back as zero, or one for alpha.
+const unsigned int DDS_CHANNEL_RED = 0x1;
+const unsigned int DDS_CHANNEL_GREEN = 0x2;
+const unsigned int DDS_CHANNEL_BLUE = 0x4;
+const unsigned int DDS_CHANNEL_ALPHA = 0x8;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: DdsFormatClass
+//
+// The DDS header and what each format looks like in memory, shared by the
+// cooker's reader and writer.  GetFormat follows the engine loader's
+// GetDXGIFormat, so a file is read here as the GPU would see it, including
+// the DX10 header and the old masks and four character codes.
+////////////////////////////////////////////////////////////////////////////////
+class DdsFormatClass
+{
+public:
+	struct PixelFormatType
+	{
+		unsigned int size;
+		unsigned int flags;
+		unsigned int fourCC;
+		unsigned int rgbBitCount;
+		unsigned int redMask;
+		unsigned int greenMask;
+		unsigned int blueMask;
+		unsigned int alphaMask;
+	};
+
+	// The magic number and the header, as they are at the start of the file.
+	struct HeaderType
+	{
+		unsigned int magic;
+		unsigned int size;
+		unsigned int flags;
+		unsigned int height;
+		unsigned int width;
+		unsigned int pitchOrLinearSize;
+		unsigned int depth;
+		unsigned int mipMapCount;
+		unsigned int reserved1[11];
+		PixelFormatType pixelFormat;
+		unsigned int caps;
+		unsigned int caps2;
+		unsigned int caps3;
+		unsigned int caps4;
+		unsigned int reserved2;
+	};
+
+	struct HeaderDx10Type
+	{
+		unsigned int dxgiFormat;
+		unsigned int resourceDimension;
+		unsigned int miscFlag;
+		unsigned int arraySize;
+		unsigned int miscFlags2;
+	};
+
+public:
+	static DdsFormatType GetFormat(const HeaderType&, const HeaderDx10Type*);
+	static DdsFormatType GetFormatFromDxgi(unsigned int);
+	static unsigned int GetDxgiFormat(DdsFormatType);
+	static bool HasDx10Header(const HeaderType&);
+	static const char* GetName(DdsFormatType);
+	static int GetBlockWidth(DdsFormatType);
+	static int GetBlockHeight(DdsFormatType);
+	static size_t GetBlockSize(DdsFormatType);
+	static size_t GetLevelSize(DdsFormatType, int, int);
+	static size_t GetChainSize(DdsFormatType, int, int, int);
+	static unsigned int GetChannels(DdsFormatType);
+	static bool IsCompressed(DdsFormatType);
+	static bool IsSrgb(DdsFormatType);
+	static float HalfToFloat(unsigned short);
+};
+
+#endif
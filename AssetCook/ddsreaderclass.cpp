@@ -0,0 +1,731 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ddsreaderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ddsreaderclass.h"
+#include "bcdecoderclass.h"
+
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int DDSD_HEIGHT = 0x2;
+const unsigned int DDSD_DEPTH = 0x800000;
+const unsigned int DDSCAPS2_CUBEMAP = 0x200;
+const unsigned int DDSCAPS2_CUBEMAP_ALLFACES = 0xfc00;
+
+const unsigned int RESOURCE_DIMENSION_TEXTURE1D = 2;
+const unsigned int RESOURCE_DIMENSION_TEXTURE2D = 3;
+const unsigned int RESOURCE_DIMENSION_TEXTURE3D = 4;
+const unsigned int RESOURCE_MISC_TEXTURECUBE = 0x4;
+
+
+DdsReaderClass::DdsReaderClass()
+{
+	m_data = 0;
+	m_format = DDS_FORMAT_UNKNOWN;
+	m_width = 0;
+	m_height = 0;
+	m_depth = 0;
+	m_mipCount = 0;
+	m_arraySize = 0;
+	m_texels = 0;
+	m_invalidBlocks = 0;
+}
+
+
+DdsReaderClass::DdsReaderClass(const DdsReaderClass& other)
+{
+}
+
+
+DdsReaderClass::~DdsReaderClass()
+{
+}
+
+
+bool DdsReaderClass::Initialize(const unsigned char* data, size_t size)
+{
+	DdsFormatClass::HeaderType header;
+	DdsFormatClass::HeaderDx10Type headerDx10;
+	SurfaceType surface;
+	size_t offset;
+	int maxDimension, levelCount, width, height, depth, item, level;
+	bool isVolume;
+
+
+	m_data = data;
+	m_surfaces.clear();
+	m_error.clear();
+
+	// The magic number and the header, then the DX10 header if the four character code asks for one.
+	if(size < sizeof(DdsFormatClass::HeaderType))
+	{
+		m_error = "too small for a DDS header";
+		return false;
+	}
+	memcpy(&header, data, sizeof(DdsFormatClass::HeaderType));
+	if(header.magic != DDS_MAGIC_NUMBER || header.size != DDS_HEADER_SIZE || header.pixelFormat.size != sizeof(DdsFormatClass::PixelFormatType))
+	{
+		m_error = "not a DDS file";
+		return false;
+	}
+	offset = sizeof(DdsFormatClass::HeaderType);
+
+	if(DdsFormatClass::HasDx10Header(header))
+	{
+		if(size < offset + sizeof(DdsFormatClass::HeaderDx10Type))
+		{
+			m_error = "the DX10 header is cut off";
+			return false;
+		}
+		memcpy(&headerDx10, data + offset, sizeof(DdsFormatClass::HeaderDx10Type));
+		offset += sizeof(DdsFormatClass::HeaderDx10Type);
+
+		m_format = DdsFormatClass::GetFormatFromDxgi(headerDx10.dxgiFormat);
+		if(m_format == DDS_FORMAT_UNKNOWN)
+		{
+			m_error = "DXGI format " + to_string(headerDx10.dxgiFormat) + " is not one the loader takes";
+			return false;
+		}
+	}
+	else
+	{
+		m_format = DdsFormatClass::GetFormat(header, 0);
+		if(m_format == DDS_FORMAT_UNKNOWN)
+		{
+			m_error = "the pixel format is not one the loader takes";
+			return false;
+		}
+	}
+
+	m_width = (int)header.width;
+	m_height = (int)header.height;
+	m_depth = 1;
+	m_mipCount = header.mipMapCount ? (int)header.mipMapCount : 1;
+	m_arraySize = 1;
+	isVolume = false;
+
+	// Work out the shape the same way the loader does, a 1D texture is a row and a cube map is an array of six faces.
+	if(DdsFormatClass::HasDx10Header(header))
+	{
+		m_arraySize = (int)headerDx10.arraySize;
+		if(m_arraySize <= 0)
+		{
+			m_error = "the array size is zero";
+			return false;
+		}
+
+		switch(headerDx10.resourceDimension)
+		{
+			case RESOURCE_DIMENSION_TEXTURE1D:
+			{
+				if((header.flags & DDSD_HEIGHT) && m_height != 1)
+				{
+					m_error = "a 1D texture with a height";
+					return false;
+				}
+				m_height = 1;
+				break;
+			}
+
+			case RESOURCE_DIMENSION_TEXTURE2D:
+			{
+				if(headerDx10.miscFlag & RESOURCE_MISC_TEXTURECUBE)
+				{
+					m_arraySize *= 6;
+				}
+				break;
+			}
+
+			case RESOURCE_DIMENSION_TEXTURE3D:
+			{
+				if(!(header.flags & DDSD_DEPTH) || m_arraySize > 1)
+				{
+					m_error = "a volume texture without a depth or with an array";
+					return false;
+				}
+				isVolume = true;
+				break;
+			}
+
+			default:
+			{
+				m_error = "resource dimension " + to_string(headerDx10.resourceDimension) + " is not a texture";
+				return false;
+			}
+		}
+	}
+	else if(header.flags & DDSD_DEPTH)
+	{
+		isVolume = true;
+	}
+	else if(header.caps2 & DDSCAPS2_CUBEMAP)
+	{
+		if((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+		{
+			m_error = "a cube map without all six faces";
+			return false;
+		}
+		m_arraySize = 6;
+	}
+
+	if(isVolume)
+	{
+		m_depth = (int)header.depth;
+	}
+
+	// Hold the header to the hardware limits rather than trusting it, the sizes below are worked out from it.
+	maxDimension = isVolume ? DDS_MAX_VOLUME_DIMENSION : DDS_MAX_DIMENSION;
+	if(header.width == 0 || header.height == 0 || header.width > (unsigned int)maxDimension || header.height > (unsigned int)maxDimension ||
+	   (isVolume && (header.depth == 0 || header.depth > (unsigned int)maxDimension)) || m_arraySize > DDS_MAX_ARRAY_SIZE)
+	{
+		m_error = to_string(header.width) + " x " + to_string(header.height) + " x " + to_string(isVolume ? header.depth : 1) + " and " +
+				  to_string(m_arraySize) + " items is outside the limits";
+		return false;
+	}
+
+	levelCount = 1;
+	while((m_width >> levelCount) > 0 || (m_height >> levelCount) > 0 || (m_depth >> levelCount) > 0)
+	{
+		levelCount++;
+	}
+	if(m_mipCount > DDS_MAX_MIP_LEVELS || m_mipCount > levelCount)
+	{
+		m_error = to_string(m_mipCount) + " mips is more than the chain has";
+		return false;
+	}
+
+	// Every mip of the first item, then every mip of the next, each level of a volume its slices one after another.
+	for(item=0; item<m_arraySize; item++)
+	{
+		width = m_width;
+		height = m_height;
+		depth = m_depth;
+
+		for(level=0; level<m_mipCount; level++)
+		{
+			surface.data = data + offset;
+			surface.sliceSize = DdsFormatClass::GetLevelSize(m_format, width, height);
+			surface.width = width;
+			surface.height = height;
+			surface.depth = depth;
+			surface.texels = 0;
+
+			if(size - offset < surface.sliceSize * depth)
+			{
+				m_error = "the file is cut off at mip " + to_string(level) + " of item " + to_string(item);
+				m_surfaces.clear();
+				return false;
+			}
+			offset += surface.sliceSize * depth;
+
+			m_surfaces.push_back(surface);
+
+			width = width > 1 ? width / 2 : 1;
+			height = height > 1 ? height / 2 : 1;
+			depth = depth > 1 ? depth / 2 : 1;
+		}
+	}
+
+	return true;
+}
+
+
+void DdsReaderClass::Shutdown()
+{
+	// Release the texels.
+	if(m_texels)
+	{
+		delete [] m_texels;
+		m_texels = 0;
+	}
+
+	m_surfaces.clear();
+	m_data = 0;
+
+	return;
+}
+
+
+bool DdsReaderClass::Decode(JobSystemClass* jobSystem)
+{
+	size_t texelCount;
+	int rowCount, first, last, slice, i;
+
+
+	if(m_surfaces.empty())
+	{
+		return false;
+	}
+
+	// One buffer holds the texels of every surface.
+	texelCount = 0;
+	for(i=0; i<(int)m_surfaces.size(); i++)
+	{
+		texelCount += (size_t)m_surfaces[i].width * m_surfaces[i].height * m_surfaces[i].depth;
+	}
+
+	if(m_texels)
+	{
+		delete [] m_texels;
+		m_texels = 0;
+	}
+
+	m_texels = new float[texelCount * 4];
+	if(!m_texels)
+	{
+		return false;
+	}
+
+	texelCount = 0;
+	for(i=0; i<(int)m_surfaces.size(); i++)
+	{
+		m_surfaces[i].texels = m_texels + texelCount * 4;
+		texelCount += (size_t)m_surfaces[i].width * m_surfaces[i].height * m_surfaces[i].depth;
+	}
+
+	// Every band of rows of every slice of every surface is independent, so they all go to the job system before waiting once.
+	m_invalidBlocks = 0;
+	for(i=0; i<(int)m_surfaces.size(); i++)
+	{
+		rowCount = (m_surfaces[i].height + DdsFormatClass::GetBlockHeight(m_format) - 1) / DdsFormatClass::GetBlockHeight(m_format);
+		for(slice=0; slice<m_surfaces[i].depth; slice++)
+		{
+			for(first=0; first<rowCount; first+=DDS_ROWS_PER_JOB)
+			{
+				last = first + DDS_ROWS_PER_JOB < rowCount ? first + DDS_ROWS_PER_JOB : rowCount;
+				if(jobSystem)
+				{
+					jobSystem->Submit("dds rows", [this, i, slice, first, last]()
+					{
+						DecodeRows(m_surfaces[i], slice, first, last);
+					});
+				}
+				else
+				{
+					DecodeRows(m_surfaces[i], slice, first, last);
+				}
+			}
+		}
+	}
+
+	if(jobSystem)
+	{
+		jobSystem->Wait();
+	}
+
+	// Reserved BC6H and BC7 modes decode to black on the GPU too, but no encoder writes them on purpose.
+	if(m_invalidBlocks > 0)
+	{
+		m_error = to_string(m_invalidBlocks) + " blocks use a reserved mode";
+		return false;
+	}
+
+	return true;
+}
+
+
+DdsFormatType DdsReaderClass::GetFormat()
+{
+	return m_format;
+}
+
+
+int DdsReaderClass::GetWidth()
+{
+	return m_width;
+}
+
+
+int DdsReaderClass::GetHeight()
+{
+	return m_height;
+}
+
+
+int DdsReaderClass::GetDepth()
+{
+	return m_depth;
+}
+
+
+int DdsReaderClass::GetMipCount()
+{
+	return m_mipCount;
+}
+
+
+int DdsReaderClass::GetArraySize()
+{
+	return m_arraySize;
+}
+
+
+int DdsReaderClass::GetLevelWidth(int level)
+{
+	return m_surfaces[level].width;
+}
+
+
+int DdsReaderClass::GetLevelHeight(int level)
+{
+	return m_surfaces[level].height;
+}
+
+
+int DdsReaderClass::GetLevelDepth(int level)
+{
+	return m_surfaces[level].depth;
+}
+
+
+const unsigned char* DdsReaderClass::GetLevelData(int item, int level)
+{
+	return m_surfaces[item * m_mipCount + level].data;
+}
+
+
+const float* DdsReaderClass::GetTexels(int item, int level)
+{
+	return m_surfaces[item * m_mipCount + level].texels;
+}
+
+
+void DdsReaderClass::GetTexels8(int item, int level, unsigned char* output)
+{
+	const SurfaceType& surface = m_surfaces[item * m_mipCount + level];
+	__m128i value;
+	unsigned int bits;
+	size_t texelCount, i;
+
+
+	// Clamp, round and pack four channels at a time, RGBA in that order.
+	texelCount = (size_t)surface.width * surface.height * surface.depth;
+	for(i=0; i<texelCount; i++)
+	{
+		value = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&surface.texels[i * 4]), _mm_setzero_ps()), _mm_set1_ps(1.0f)),
+										   _mm_set1_ps(255.0f)));
+		value = _mm_packus_epi16(_mm_packs_epi32(value, value), value);
+		bits = (unsigned int)_mm_cvtsi128_si32(value);
+		memcpy(&output[i * 4], &bits, 4);
+	}
+
+	return;
+}
+
+
+const char* DdsReaderClass::GetError()
+{
+	return m_error.c_str();
+}
+
+
+void DdsReaderClass::DecodeRows(const SurfaceType& surface, int slice, int first, int last)
+{
+	const unsigned char* data;
+	float block[64], *texels;
+	size_t blockSize, rowPitch;
+	int blocksWide, firstRow, lastRow, x, y, i, j;
+	bool result;
+
+
+	data = surface.data + surface.sliceSize * slice;
+	texels = surface.texels + (size_t)surface.width * surface.height * slice * 4;
+
+	if(DdsFormatClass::IsCompressed(m_format))
+	{
+		// Each block goes out a row of four texels at a time, the texels past the edge of a small level are dropped.
+		blockSize = DdsFormatClass::GetBlockSize(m_format);
+		blocksWide = (surface.width + DDS_BLOCK_SIZE - 1) / DDS_BLOCK_SIZE;
+		for(y=first; y<last; y++)
+		{
+			for(x=0; x<blocksWide; x++)
+			{
+				result = BcDecoderClass::DecodeBlock(data + ((size_t)y * blocksWide + x) * blockSize, m_format, block);
+				if(!result)
+				{
+					m_invalidBlocks++;
+				}
+
+				for(j=0; j<DDS_BLOCK_SIZE && y * DDS_BLOCK_SIZE + j < surface.height; j++)
+				{
+					for(i=0; i<DDS_BLOCK_SIZE && x * DDS_BLOCK_SIZE + i < surface.width; i++)
+					{
+						memcpy(&texels[((size_t)(y * DDS_BLOCK_SIZE + j) * surface.width + x * DDS_BLOCK_SIZE + i) * 4], &block[(j * DDS_BLOCK_SIZE + i) * 4],
+							   sizeof(float) * 4);
+					}
+				}
+			}
+		}
+
+		firstRow = first * DDS_BLOCK_SIZE;
+		lastRow = last * DDS_BLOCK_SIZE < surface.height ? last * DDS_BLOCK_SIZE : surface.height;
+	}
+	else
+	{
+		rowPitch = DdsFormatClass::GetLevelSize(m_format, surface.width, 1);
+		for(y=first; y<last; y++)
+		{
+			DecodeRow(data + rowPitch * y, surface.width, &texels[(size_t)y * surface.width * 4]);
+		}
+
+		firstRow = first;
+		lastRow = last;
+	}
+
+	if(DdsFormatClass::IsSrgb(m_format))
+	{
+		ConvertToLinear(&texels[(size_t)firstRow * surface.width * 4], (size_t)(lastRow - firstRow) * surface.width);
+	}
+
+	return;
+}
+
+
+void DdsReaderClass::DecodeRow(const unsigned char* row, int width, float* texels)
+{
+	__m128i value, zero;
+	__m128 texel, scale;
+	unsigned int bits;
+	unsigned short halves[4];
+	signed short signedValues[4];
+	float luma, blueDifference, redDifference;
+	int channelCount, x, i;
+
+
+	// Start every texel as opaque black so a format only fills in the channels it has.
+	for(x=0; x<width; x++)
+	{
+		_mm_storeu_ps(&texels[x * 4], _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+
+	switch(m_format)
+	{
+		// The 8 bit four channel formats widen a texel at a time with SSE, the BGR ones swapping red and blue on the way.
+		case DDS_FORMAT_BGRA8:
+		case DDS_FORMAT_BGRA8_SRGB:
+		case DDS_FORMAT_BGRX8:
+		case DDS_FORMAT_BGRX8_SRGB:
+		case DDS_FORMAT_RGBA8:
+		case DDS_FORMAT_RGBA8_SRGB:
+		{
+			zero = _mm_setzero_si128();
+			scale = _mm_set1_ps(1.0f / 255.0f);
+			for(x=0; x<width; x++)
+			{
+				memcpy(&bits, &row[x * 4], 4);
+				value = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)bits), zero), zero);
+				texel = _mm_mul_ps(_mm_cvtepi32_ps(value), scale);
+				if(m_format != DDS_FORMAT_RGBA8 && m_format != DDS_FORMAT_RGBA8_SRGB)
+				{
+					texel = _mm_shuffle_ps(texel, texel, _MM_SHUFFLE(3, 0, 1, 2));
+				}
+				_mm_storeu_ps(&texels[x * 4], texel);
+
+				if(m_format == DDS_FORMAT_BGRX8 || m_format == DDS_FORMAT_BGRX8_SRGB)
+				{
+					texels[x * 4 + 3] = 1.0f;
+				}
+			}
+			break;
+		}
+
+		case DDS_FORMAT_R10G10B10A2:
+		{
+			for(x=0; x<width; x++)
+			{
+				memcpy(&bits, &row[x * 4], 4);
+				texels[x * 4 + 0] = (float)(bits & 0x3ff) / 1023.0f;
+				texels[x * 4 + 1] = (float)((bits >> 10) & 0x3ff) / 1023.0f;
+				texels[x * 4 + 2] = (float)((bits >> 20) & 0x3ff) / 1023.0f;
+				texels[x * 4 + 3] = (float)(bits >> 30) / 3.0f;
+			}
+			break;
+		}
+
+		case DDS_FORMAT_B5G6R5:
+		case DDS_FORMAT_B5G5R5A1:
+		case DDS_FORMAT_B4G4R4A4:
+		{
+			for(x=0; x<width; x++)
+			{
+				bits = (unsigned int)row[x * 2] | ((unsigned int)row[x * 2 + 1] << 8);
+				if(m_format == DDS_FORMAT_B5G6R5)
+				{
+					texels[x * 4 + 0] = (float)(bits >> 11) / 31.0f;
+					texels[x * 4 + 1] = (float)((bits >> 5) & 0x3f) / 63.0f;
+					texels[x * 4 + 2] = (float)(bits & 0x1f) / 31.0f;
+				}
+				else if(m_format == DDS_FORMAT_B5G5R5A1)
+				{
+					texels[x * 4 + 0] = (float)((bits >> 10) & 0x1f) / 31.0f;
+					texels[x * 4 + 1] = (float)((bits >> 5) & 0x1f) / 31.0f;
+					texels[x * 4 + 2] = (float)(bits & 0x1f) / 31.0f;
+					texels[x * 4 + 3] = (float)(bits >> 15);
+				}
+				else
+				{
+					texels[x * 4 + 0] = (float)((bits >> 8) & 0xf) / 15.0f;
+					texels[x * 4 + 1] = (float)((bits >> 4) & 0xf) / 15.0f;
+					texels[x * 4 + 2] = (float)(bits & 0xf) / 15.0f;
+					texels[x * 4 + 3] = (float)(bits >> 12) / 15.0f;
+				}
+			}
+			break;
+		}
+
+		case DDS_FORMAT_R8:
+		case DDS_FORMAT_R8G8:
+		{
+			for(x=0; x<width; x++)
+			{
+				for(i=0; i<(m_format == DDS_FORMAT_R8 ? 1 : 2); i++)
+				{
+					texels[x * 4 + i] = (float)row[x * (m_format == DDS_FORMAT_R8 ? 1 : 2) + i] / 255.0f;
+				}
+			}
+			break;
+		}
+
+		case DDS_FORMAT_A8:
+		{
+			for(x=0; x<width; x++)
+			{
+				texels[x * 4 + 3] = (float)row[x] / 255.0f;
+			}
+			break;
+		}
+
+		case DDS_FORMAT_R16:
+		case DDS_FORMAT_R16G16:
+		case DDS_FORMAT_R16G16B16A16:
+		{
+			channelCount = m_format == DDS_FORMAT_R16 ? 1 : (m_format == DDS_FORMAT_R16G16 ? 2 : 4);
+			for(x=0; x<width; x++)
+			{
+				memcpy(halves, &row[x * channelCount * 2], channelCount * 2);
+				for(i=0; i<channelCount; i++)
+				{
+					texels[x * 4 + i] = (float)halves[i] / 65535.0f;
+				}
+			}
+			break;
+		}
+
+		case DDS_FORMAT_R16G16B16A16_SNORM:
+		{
+			// -32768 reads as -32767, so both ends are exactly one.
+			for(x=0; x<width; x++)
+			{
+				memcpy(signedValues, &row[x * 8], 8);
+				for(i=0; i<4; i++)
+				{
+					texels[x * 4 + i] = signedValues[i] < -32767 ? -1.0f : (float)signedValues[i] / 32767.0f;
+				}
+			}
+			break;
+		}
+
+		case DDS_FORMAT_R16_FLOAT:
+		case DDS_FORMAT_R16G16_FLOAT:
+		case DDS_FORMAT_R16G16B16A16_FLOAT:
+		{
+			channelCount = m_format == DDS_FORMAT_R16_FLOAT ? 1 : (m_format == DDS_FORMAT_R16G16_FLOAT ? 2 : 4);
+			for(x=0; x<width; x++)
+			{
+				memcpy(halves, &row[x * channelCount * 2], channelCount * 2);
+				for(i=0; i<channelCount; i++)
+				{
+					texels[x * 4 + i] = DdsFormatClass::HalfToFloat(halves[i]);
+				}
+			}
+			break;
+		}
+
+		case DDS_FORMAT_R32_FLOAT:
+		case DDS_FORMAT_R32G32_FLOAT:
+		case DDS_FORMAT_R32G32B32A32_FLOAT:
+		{
+			channelCount = m_format == DDS_FORMAT_R32_FLOAT ? 1 : (m_format == DDS_FORMAT_R32G32_FLOAT ? 2 : 4);
+			for(x=0; x<width; x++)
+			{
+				memcpy(&texels[x * 4], &row[x * channelCount * 4], channelCount * 4);
+			}
+			break;
+		}
+
+		// Two texels to four bytes, sharing red and blue and each with its own green.
+		case DDS_FORMAT_R8G8_B8G8:
+		case DDS_FORMAT_G8R8_G8B8:
+		{
+			for(x=0; x<width; x++)
+			{
+				if(m_format == DDS_FORMAT_R8G8_B8G8)
+				{
+					texels[x * 4 + 0] = (float)row[(x / 2) * 4 + 0] / 255.0f;
+					texels[x * 4 + 1] = (float)row[(x / 2) * 4 + 1 + (x & 1) * 2] / 255.0f;
+					texels[x * 4 + 2] = (float)row[(x / 2) * 4 + 2] / 255.0f;
+				}
+				else
+				{
+					texels[x * 4 + 0] = (float)row[(x / 2) * 4 + 1] / 255.0f;
+					texels[x * 4 + 1] = (float)row[(x / 2) * 4 + (x & 1) * 2] / 255.0f;
+					texels[x * 4 + 2] = (float)row[(x / 2) * 4 + 3] / 255.0f;
+				}
+			}
+			break;
+		}
+
+		// Two texels to four bytes, each with its own luma and sharing the chroma, taken to RGB by BT.601 in video range.
+		case DDS_FORMAT_YUY2:
+		{
+			for(x=0; x<width; x++)
+			{
+				luma = 1.164383f * ((float)row[(x / 2) * 4 + (x & 1) * 2] - 16.0f);
+				blueDifference = (float)row[(x / 2) * 4 + 1] - 128.0f;
+				redDifference = (float)row[(x / 2) * 4 + 3] - 128.0f;
+
+				texels[x * 4 + 0] = (luma + 1.596027f * redDifference) / 255.0f;
+				texels[x * 4 + 1] = (luma - 0.391762f * blueDifference - 0.812968f * redDifference) / 255.0f;
+				texels[x * 4 + 2] = (luma + 2.017232f * blueDifference) / 255.0f;
+				for(i=0; i<3; i++)
+				{
+					texels[x * 4 + i] = texels[x * 4 + i] < 0.0f ? 0.0f : (texels[x * 4 + i] > 1.0f ? 1.0f : texels[x * 4 + i]);
+				}
+			}
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+
+	return;
+}
+
+
+void DdsReaderClass::ConvertToLinear(float* texels, size_t texelCount)
+{
+	float value;
+	size_t i;
+	int j;
+
+
+	// The sRGB curve on the color channels, alpha is always linear.
+	for(i=0; i<texelCount; i++)
+	{
+		for(j=0; j<3; j++)
+		{
+			value = texels[i * 4 + j];
+			texels[i * 4 + j] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+		}
+	}
+
+	return;
+}
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ddsreaderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _DDSREADERCLASS_H_
+#define _DDSREADERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "../Engine/jobsystemclass.h"
+#include "ddsformatclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The Direct3D 11 limits the engine's loader holds a file to.
+const int DDS_MAX_MIP_LEVELS = 15;
+const int DDS_MAX_DIMENSION = 16384;
+const int DDS_MAX_VOLUME_DIMENSION = 2048;
+const int DDS_MAX_ARRAY_SIZE = 2048;
+
+// Rows of blocks of a surface, or rows of texels for the uncompressed formats, decoded by one job.
+const int DDS_ROWS_PER_JOB = 16;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: DdsReaderClass
+//
+// Reads a DDS file held in memory without a GPU.  Initialize checks the header
+// the way the engine's loader does and that every surface is there, and
+// Decode expands every surface of every mip level, array item and cube face
+// to linear RGBA floats.  Channels the format does not store read as zero,
+// or one for alpha, and sRGB formats are taken to linear light.
+//
+// Decode hands every band of rows of every surface to the job system before
+// waiting once, so a chain decodes in parallel across its mips.  The data is
+// not copied, it must stay where it is until Shutdown.
+////////////////////////////////////////////////////////////////////////////////
+class DdsReaderClass
+{
+private:
+	struct SurfaceType
+	{
+		const unsigned char* data;
+		size_t sliceSize;
+		int width;
+		int height;
+		int depth;
+		float* texels;
+	};
+
+public:
+	DdsReaderClass();
+	DdsReaderClass(const DdsReaderClass&);
+	~DdsReaderClass();
+
+	bool Initialize(const unsigned char*, size_t);
+	void Shutdown();
+	bool Decode(JobSystemClass*);
+
+	DdsFormatType GetFormat();
+	int GetWidth();
+	int GetHeight();
+	int GetDepth();
+	int GetMipCount();
+	int GetArraySize();
+	int GetLevelWidth(int);
+	int GetLevelHeight(int);
+	int GetLevelDepth(int);
+	const unsigned char* GetLevelData(int, int);
+	const float* GetTexels(int, int);
+	void GetTexels8(int, int, unsigned char*);
+	const char* GetError();
+
+private:
+	void DecodeRows(const SurfaceType&, int, int, int);
+	void DecodeRow(const unsigned char*, int, float*);
+	void ConvertToLinear(float*, size_t);
+
+private:
+	const unsigned char* m_data;
+	DdsFormatType m_format;
+	int m_width, m_height, m_depth, m_mipCount, m_arraySize;
+	vector<SurfaceType> m_surfaces;
+	float* m_texels;
+	atomic<int> m_invalidBlocks;
+	string m_error;
+};
+
+#endif
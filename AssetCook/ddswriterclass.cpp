@@ -0,0 +1,117 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ddswriterclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ddswriterclass.h"
+
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int DDSD_CAPS = 0x1;
+const unsigned int DDSD_HEIGHT = 0x2;
+const unsigned int DDSD_WIDTH = 0x4;
+const unsigned int DDSD_PITCH = 0x8;
+const unsigned int DDSD_LINEARSIZE = 0x80000;
+const unsigned int DDSD_PIXELFORMAT = 0x1000;
+const unsigned int DDSD_MIPMAPCOUNT = 0x20000;
+const unsigned int DDPF_ALPHAPIXELS = 0x1;
+const unsigned int DDPF_FOURCC = 0x4;
+const unsigned int DDPF_RGB = 0x40;
+const unsigned int DDSCAPS_COMPLEX = 0x8;
+const unsigned int DDSCAPS_TEXTURE = 0x1000;
+const unsigned int DDSCAPS_MIPMAP = 0x400000;
+const unsigned int DDS_DIMENSION_TEXTURE2D = 3;
+
+#define DDS_FOURCC(a, b, c, d) ((unsigned int)(a) | ((unsigned int)(b) << 8) | ((unsigned int)(c) << 16) | ((unsigned int)(d) << 24))
+
+
+bool DdsWriterClass::Write(ostream& stream, DdsFormatType format, int width, int height, int mipCount, const unsigned char* data,
+						   int arraySize)
+{
+	DdsFormatClass::HeaderType header;
+	DdsFormatClass::HeaderDx10Type headerDx10;
+
+
+	static_assert(sizeof(DdsFormatClass::HeaderType) == sizeof(unsigned int) + DDS_HEADER_SIZE, "HeaderType must match the DDS header");
+
+	// Fill in the header, everything not set stays zero.
+	memset(&header, 0, sizeof(header));
+	header.magic = DDS_MAGIC_NUMBER;
+	header.size = DDS_HEADER_SIZE;
+	header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | (mipCount > 1 ? DDSD_MIPMAPCOUNT : 0);
+	header.height = (unsigned int)height;
+	header.width = (unsigned int)width;
+	header.mipMapCount = mipCount > 1 ? (unsigned int)mipCount : 0;
+	header.pixelFormat.size = sizeof(DdsFormatClass::PixelFormatType);
+	header.caps = DDSCAPS_TEXTURE | (mipCount > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0);
+
+	switch(format)
+	{
+		case DDS_FORMAT_BGRA8:
+		{
+			header.flags |= DDSD_PITCH;
+			header.pitchOrLinearSize = (unsigned int)width * 4;
+			header.pixelFormat.flags = DDPF_RGB | DDPF_ALPHAPIXELS;
+			header.pixelFormat.rgbBitCount = 32;
+			header.pixelFormat.redMask = 0x00ff0000;
+			header.pixelFormat.greenMask = 0x0000ff00;
+			header.pixelFormat.blueMask = 0x000000ff;
+			header.pixelFormat.alphaMask = 0xff000000;
+			break;
+		}
+
+		case DDS_FORMAT_BC1:
+		case DDS_FORMAT_BC3:
+		case DDS_FORMAT_BC5:
+		case DDS_FORMAT_BC7:
+		{
+			header.flags |= DDSD_LINEARSIZE;
+			header.pitchOrLinearSize = (unsigned int)DdsFormatClass::GetLevelSize(format, width, height);
+			header.pixelFormat.flags = DDPF_FOURCC;
+			header.pixelFormat.fourCC = format == DDS_FORMAT_BC1 ? DDS_FOURCC('D', 'X', 'T', '1') :
+										format == DDS_FORMAT_BC3 ? DDS_FOURCC('D', 'X', 'T', '5') :
+										format == DDS_FORMAT_BC5 ? DDS_FOURCC('A', 'T', 'I', '2') : DDS_FOURCC('D', 'X', '1', '0');
+			break;
+		}
+
+		default:
+		{
+			return false;
+		}
+	}
+
+	if(arraySize < 1)
+	{
+		return false;
+	}
+
+	// The DX10 extension says what the format is, the pixel format only points to it.
+	if(format == DDS_FORMAT_BC7 || arraySize > 1)
+	{
+		memset(&header.pixelFormat, 0, sizeof(header.pixelFormat));
+		header.pixelFormat.size = sizeof(DdsFormatClass::PixelFormatType);
+		header.pixelFormat.flags = DDPF_FOURCC;
+		header.pixelFormat.fourCC = DDS_FOURCC('D', 'X', '1', '0');
+	}
+
+	// Write the header followed by every level, BC7 and arrays put the DX10 extension in between.
+	stream.write((const char*)&header, sizeof(header));
+	if(format == DDS_FORMAT_BC7 || arraySize > 1)
+	{
+		memset(&headerDx10, 0, sizeof(headerDx10));
+		headerDx10.dxgiFormat = DdsFormatClass::GetDxgiFormat(format);
+		headerDx10.resourceDimension = DDS_DIMENSION_TEXTURE2D;
+		headerDx10.arraySize = (unsigned int)arraySize;
+
+		stream.write((const char*)&headerDx10, sizeof(headerDx10));
+	}
+	stream.write((const char*)data, (streamsize)(DdsFormatClass::GetChainSize(format, width, height, mipCount) * arraySize));
+	if(stream.fail())
+	{
+		return false;
+	}
+
+	return true;
+}
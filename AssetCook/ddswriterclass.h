@@ -0,0 +1,38 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ddswriterclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _DDSWRITERCLASS_H_
+#define _DDSWRITERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <fstream>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "ddsformatclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: DdsWriterClass
+//
+// Writes a 2D texture and its mip chain as a DDS file the engine's loader
+// takes, with the levels packed one after another from the largest down.
+// BC1, BC3 and BC5 use the old four character codes, BC7 has no code of its
+// own and follows the header with the DX10 extension.
+//
+// An array of textures is the whole chain of each one after the other, and
+// always has the DX10 extension since only that holds the array size.
+////////////////////////////////////////////////////////////////////////////////
+class DdsWriterClass
+{
+public:
+	static bool Write(ostream&, DdsFormatType, int, int, int, const unsigned char*, int = 1);
+};
+
+#endif
@@ -0,0 +1,103 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: main.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "assetcookerclass.h"
+
+#include <cstdio>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The same relative paths the engine loads from, so the cooker can be run from either project folder.
+const char DEFAULT_INPUT_DIRECTORY[] = "../Engine/data";
+const char DEFAULT_ARCHIVE_FILENAME[] = "../Engine/data/assets.pak";
+
+
+int main(int argc, char** argv)
+{
+	AssetCookerClass* AssetCooker;
+	const char* inputDirectory;
+	const char* archiveFilename;
+	MipFilterType mipFilter;
+	bool force, useBc7, verify, result;
+	int argument;
+
+
+	inputDirectory = DEFAULT_INPUT_DIRECTORY;
+	archiveFilename = DEFAULT_ARCHIVE_FILENAME;
+	force = false;
+	mipFilter = MIP_FILTER_KAISER;
+	useBc7 = false;
+	verify = false;
+
+	// assetcook [-f] [-box] [-bc7] [-verify] [data folder [archive]], -f cooks every asset again even if its source has not changed,
+	// -box builds the mips with a box filter instead of the sharper Kaiser filter, -bc7 compresses color to BC7 and -verify
+	// decodes every texture in the archive afterwards and compares it with its source.
+	argument = 1;
+	while(argument < argc && argv[argument][0] == '-')
+	{
+		if(strcmp(argv[argument], "-f") == 0)
+		{
+			force = true;
+		}
+		else if(strcmp(argv[argument], "-box") == 0)
+		{
+			mipFilter = MIP_FILTER_BOX;
+		}
+		else if(strcmp(argv[argument], "-bc7") == 0)
+		{
+			useBc7 = true;
+		}
+		else if(strcmp(argv[argument], "-verify") == 0)
+		{
+			verify = true;
+		}
+		else
+		{
+			break;
+		}
+		argument++;
+	}
+	if(argument < argc)
+	{
+		inputDirectory = argv[argument];
+		argument++;
+	}
+	if(argument < argc)
+	{
+		archiveFilename = argv[argument];
+		argument++;
+	}
+	if(argument < argc)
+	{
+		fprintf(stderr, "usage: assetcook [-f] [-box] [-bc7] [-verify] [data folder [archive]]\n");
+		return 1;
+	}
+
+	// Create the asset cooker object.
+	AssetCooker = new AssetCookerClass;
+	if(!AssetCooker)
+	{
+		return 1;
+	}
+
+	// Initialize and run it.
+	result = AssetCooker->Initialize(inputDirectory, archiveFilename, force, mipFilter, useBc7);
+	if(result)
+	{
+		result = AssetCooker->Cook();
+	}
+	if(result && verify)
+	{
+		result = AssetCooker->Verify();
+	}
+
+	// Shutdown and release the asset cooker object.
+	AssetCooker->Shutdown();
+	delete AssetCooker;
+	AssetCooker = 0;
+
+	return result ? 0 : 1;
+}
@@ -0,0 +1,427 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mipgeneratorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mipgeneratorclass.h"
+
+#include <cmath>
+#include <cstring>
+#include <xmmintrin.h>
+
+
+int MipGeneratorClass::GetLevelCount(int width, int height)
+{
+	int levelCount;
+
+
+	// Halve the larger side until it reaches one texel.
+	levelCount = 1;
+	while(width > 1 || height > 1)
+	{
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+		levelCount++;
+	}
+
+	return levelCount;
+}
+
+
+size_t MipGeneratorClass::GetChainSize(int width, int height)
+{
+	size_t size;
+	int levelCount, i;
+
+
+	levelCount = GetLevelCount(width, height);
+
+	size = 0;
+	for(i=0; i<levelCount; i++)
+	{
+		size += (size_t)width * height * 4;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return size;
+}
+
+
+bool MipGeneratorClass::Generate(const unsigned char* pixels, int width, int height, const SettingsType& settings, JobSystemClass* jobSystem,
+								 unsigned char* output)
+{
+	FilterType rowFilter, columnFilter;
+	float *source, *rows, *level;
+	unsigned char* levelOutput;
+	int levelCount, levelWidth, levelHeight, first, last, i;
+	bool result;
+
+
+	levelCount = GetLevelCount(width, height);
+
+	// The top level is stored as it is.
+	memcpy(output, pixels, (size_t)width * height * 4);
+	levelOutput = output + (size_t)width * height * 4;
+
+	source = new float[(size_t)width * height * 4];
+	if(!source)
+	{
+		return false;
+	}
+
+	Decode(pixels, width * height, settings.content, source);
+
+	for(i=1; i<levelCount; i++)
+	{
+		levelWidth = width > 1 ? width / 2 : 1;
+		levelHeight = height > 1 ? height / 2 : 1;
+
+		// Create the level and the rows filtered along one axis only, between the two passes.
+		rows = new float[(size_t)levelWidth * height * 4];
+		level = new float[(size_t)levelWidth * levelHeight * 4];
+		if(!rows || !level)
+		{
+			return false;
+		}
+
+		result = BuildFilter(width, levelWidth, settings, rowFilter);
+		if(!result)
+		{
+			return false;
+		}
+
+		result = BuildFilter(height, levelHeight, settings, columnFilter);
+		if(!result)
+		{
+			return false;
+		}
+
+		// Filter along the rows first, every band of rows is a job of its own.
+		for(first=0; first<height; first+=MIP_ROWS_PER_JOB)
+		{
+			last = first + MIP_ROWS_PER_JOB < height ? first + MIP_ROWS_PER_JOB : height;
+			if(jobSystem)
+			{
+				jobSystem->Submit("mip rows", [source, width, &rowFilter, levelWidth, rows, first, last]()
+				{
+					FilterRows(source, width, rowFilter, levelWidth, rows, first, last);
+				});
+			}
+			else
+			{
+				FilterRows(source, width, rowFilter, levelWidth, rows, first, last);
+			}
+		}
+		if(jobSystem)
+		{
+			jobSystem->Wait();
+		}
+
+		// Then along the columns, each job writes its rows of the level out as soon as they are done.
+		for(first=0; first<levelHeight; first+=MIP_ROWS_PER_JOB)
+		{
+			last = first + MIP_ROWS_PER_JOB < levelHeight ? first + MIP_ROWS_PER_JOB : levelHeight;
+			if(jobSystem)
+			{
+				jobSystem->Submit("mip columns", [rows, levelWidth, &columnFilter, level, first, last, &settings, levelOutput]()
+				{
+					FilterColumns(rows, levelWidth, columnFilter, level, first, last);
+					Encode(&level[(size_t)first * levelWidth * 4], (last - first) * levelWidth, settings.content,
+						   &levelOutput[(size_t)first * levelWidth * 4]);
+				});
+			}
+			else
+			{
+				FilterColumns(rows, levelWidth, columnFilter, level, first, last);
+				Encode(&level[(size_t)first * levelWidth * 4], (last - first) * levelWidth, settings.content,
+					   &levelOutput[(size_t)first * levelWidth * 4]);
+			}
+		}
+		if(jobSystem)
+		{
+			jobSystem->Wait();
+		}
+
+		ReleaseFilter(rowFilter);
+		ReleaseFilter(columnFilter);
+
+		// The next level is built from this one.
+		delete [] rows;
+		delete [] source;
+		source = level;
+
+		levelOutput += (size_t)levelWidth * levelHeight * 4;
+		width = levelWidth;
+		height = levelHeight;
+	}
+
+	delete [] source;
+
+	return true;
+}
+
+
+bool MipGeneratorClass::BuildFilter(int sourceSize, int levelSize, const SettingsType& settings, FilterType& filter)
+{
+	float scale, support, center, total;
+	int first, tap, index, i, k;
+
+
+	// The filter is stretched over the texels of the level, so it covers twice as many of the level above.
+	scale = (float)sourceSize / (float)levelSize;
+	support = (settings.filter == MIP_FILTER_KAISER ? MIP_KAISER_WIDTH : 0.5f) * scale;
+
+	filter.tapCount = (int)ceilf(support * 2.0f) + 1;
+	filter.indices = new int[levelSize * filter.tapCount];
+	filter.weights = new float[levelSize * filter.tapCount];
+	if(!filter.indices || !filter.weights)
+	{
+		return false;
+	}
+
+	for(i=0; i<levelSize; i++)
+	{
+		// Where the center of this texel falls on the level above, in its texels.
+		center = ((float)i + 0.5f) * scale - 0.5f;
+		first = (int)ceilf(center - support);
+
+		total = 0.0f;
+		for(k=0; k<filter.tapCount; k++)
+		{
+			tap = first + k;
+
+			// Wrap round or repeat the edge for the taps that fall off the side.
+			if(settings.address == MIP_ADDRESS_WRAP)
+			{
+				index = ((tap % sourceSize) + sourceSize) % sourceSize;
+			}
+			else
+			{
+				index = tap < 0 ? 0 : (tap >= sourceSize ? sourceSize - 1 : tap);
+			}
+
+			filter.indices[i * filter.tapCount + k] = index;
+			filter.weights[i * filter.tapCount + k] = GetWeight(settings.filter, ((float)tap - center) / scale);
+			total += filter.weights[i * filter.tapCount + k];
+		}
+
+		// Normalize the weights so a flat area stays exactly the same.
+		for(k=0; k<filter.tapCount; k++)
+		{
+			filter.weights[i * filter.tapCount + k] /= total;
+		}
+	}
+
+	return true;
+}
+
+
+void MipGeneratorClass::ReleaseFilter(FilterType& filter)
+{
+	if(filter.indices)
+	{
+		delete [] filter.indices;
+		filter.indices = 0;
+	}
+
+	if(filter.weights)
+	{
+		delete [] filter.weights;
+		filter.weights = 0;
+	}
+
+	return;
+}
+
+
+void MipGeneratorClass::FilterRows(const float* source, int sourceWidth, const FilterType& filter, int levelWidth, float* rows, int first,
+								   int last)
+{
+	const float* sourceRow;
+	const int* indices;
+	const float* weights;
+	__m128 sum;
+	int y, x, k;
+
+
+	// Each texel is a whole SSE register, so every tap weighs all four channels at once.
+	for(y=first; y<last; y++)
+	{
+		sourceRow = &source[(size_t)y * sourceWidth * 4];
+		for(x=0; x<levelWidth; x++)
+		{
+			indices = &filter.indices[x * filter.tapCount];
+			weights = &filter.weights[x * filter.tapCount];
+
+			sum = _mm_setzero_ps();
+			for(k=0; k<filter.tapCount; k++)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(&sourceRow[indices[k] * 4]), _mm_set1_ps(weights[k])));
+			}
+
+			_mm_storeu_ps(&rows[((size_t)y * levelWidth + x) * 4], sum);
+		}
+	}
+
+	return;
+}
+
+
+void MipGeneratorClass::FilterColumns(const float* rows, int width, const FilterType& filter, float* level, int first, int last)
+{
+	const float* sourceRow;
+	float* levelRow;
+	__m128 weight;
+	int y, x, k;
+
+
+	// Add up whole weighted rows, so the inner loop walks straight along memory.
+	for(y=first; y<last; y++)
+	{
+		levelRow = &level[(size_t)y * width * 4];
+		memset(levelRow, 0, sizeof(float) * width * 4);
+
+		for(k=0; k<filter.tapCount; k++)
+		{
+			// Skip the padding taps.
+			if(filter.weights[y * filter.tapCount + k] == 0.0f)
+			{
+				continue;
+			}
+
+			sourceRow = &rows[(size_t)filter.indices[y * filter.tapCount + k] * width * 4];
+			weight = _mm_set1_ps(filter.weights[y * filter.tapCount + k]);
+
+			for(x=0; x<width; x++)
+			{
+				_mm_storeu_ps(&levelRow[x * 4], _mm_add_ps(_mm_loadu_ps(&levelRow[x * 4]), _mm_mul_ps(_mm_loadu_ps(&sourceRow[x * 4]), weight)));
+			}
+		}
+	}
+
+	return;
+}
+
+
+void MipGeneratorClass::Decode(const unsigned char* pixels, int pixelCount, MipContentType content, float* output)
+{
+	float table[256], value;
+	int i, k;
+
+
+	// Color is stored in sRGB, so it is turned back into linear light before it is averaged.
+	for(i=0; i<256; i++)
+	{
+		value = (float)i / 255.0f;
+		if(content == MIP_CONTENT_COLOR)
+		{
+			value = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+		}
+		table[i] = value;
+	}
+
+	for(i=0; i<pixelCount; i++)
+	{
+		for(k=0; k<3; k++)
+		{
+			output[i * 4 + k] = table[pixels[i * 4 + k]];
+		}
+		output[i * 4 + 3] = (float)pixels[i * 4 + 3] / 255.0f;
+	}
+
+	return;
+}
+
+
+void MipGeneratorClass::Encode(float* level, int pixelCount, MipContentType content, unsigned char* output)
+{
+	float vector[3], length, value;
+	int i, k;
+
+
+	for(i=0; i<pixelCount; i++)
+	{
+		// Averaging shortens the normals, put them back to unit length.  This level is what the next one is built from.
+		if(content == MIP_CONTENT_NORMAL)
+		{
+			for(k=0; k<3; k++)
+			{
+				vector[k] = level[i * 4 + k] * 2.0f - 1.0f;
+			}
+
+			length = sqrtf(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+			if(length > 0.0f)
+			{
+				for(k=0; k<3; k++)
+				{
+					level[i * 4 + k] = (vector[k] / length) * 0.5f + 0.5f;
+				}
+			}
+		}
+
+		for(k=0; k<4; k++)
+		{
+			// The Kaiser filter rings a little, so a channel can fall just outside the range.
+			value = level[i * 4 + k];
+			value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+
+			if(content == MIP_CONTENT_COLOR && k < 3)
+			{
+				value = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+			}
+
+			output[i * 4 + k] = (unsigned char)(value * 255.0f + 0.5f);
+		}
+	}
+
+	return;
+}
+
+
+float MipGeneratorClass::GetWeight(MipFilterType filterType, float distance)
+{
+	float x, window;
+
+
+	distance = fabsf(distance);
+
+	// The box takes the texels under the new texel, with the ones on its edge shared between both sides.
+	if(filterType == MIP_FILTER_BOX)
+	{
+		return distance < 0.5f ? 1.0f : (distance == 0.5f ? 0.5f : 0.0f);
+	}
+
+	if(distance >= MIP_KAISER_WIDTH)
+	{
+		return 0.0f;
+	}
+
+	// A sinc cut off smoothly by the Kaiser window.
+	x = distance / MIP_KAISER_WIDTH;
+	window = BesselI0(MIP_KAISER_ALPHA * sqrtf(1.0f - x * x)) / BesselI0(MIP_KAISER_ALPHA);
+
+	if(distance < 1.0e-6f)
+	{
+		return window;
+	}
+
+	return sinf(3.14159265f * distance) / (3.14159265f * distance) * window;
+}
+
+
+float MipGeneratorClass::BesselI0(float x)
+{
+	float sum, term;
+	int k;
+
+
+	// The power series of the modified Bessel function of the first kind, it converges quickly for the window's range.
+	sum = 1.0f;
+	term = 1.0f;
+	for(k=1; k<20; k++)
+	{
+		term *= (x * 0.5f / (float)k) * (x * 0.5f / (float)k);
+		sum += term;
+	}
+
+	return sum;
+}
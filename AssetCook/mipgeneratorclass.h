@@ -0,0 +1,97 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mipgeneratorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MIPGENERATORCLASS_H_
+#define _MIPGENERATORCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "../Engine/jobsystemclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+enum MipFilterType
+{
+	MIP_FILTER_BOX,		// the average of the texels each texel of the next level covers
+	MIP_FILTER_KAISER	// a sinc windowed by a Kaiser window, sharper and with less aliasing than the box
+};
+
+enum MipContentType
+{
+	MIP_CONTENT_COLOR,	// sRGB color, filtered in linear light
+	MIP_CONTENT_LINEAR,	// data such as noise or masks, filtered as it is stored
+	MIP_CONTENT_NORMAL	// a tangent space normal map, renormalized on every level
+};
+
+enum MipAddressType
+{
+	MIP_ADDRESS_WRAP,	// the filter reaches round to the other side, for textures that tile
+	MIP_ADDRESS_CLAMP	// the filter repeats the edge texels
+};
+
+// Half the width of the Kaiser filter in texels of the level being built, and the shape of its window.
+const float MIP_KAISER_WIDTH = 3.0f;
+const float MIP_KAISER_ALPHA = 4.0f;
+
+// Rows of a level filtered by one job.
+const int MIP_ROWS_PER_JOB = 16;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MipGeneratorClass
+//
+// Builds the full mip chain of a four channel, eight bit texture.  Every level
+// is resampled from the one before it in floating point, first along the rows
+// and then along the columns, with SSE working on the four channels of a texel
+// at once and the rows split into jobs on the job system.  The top level is
+// kept exactly as it was.
+//
+// The channel order does not matter to it, the first three channels are color
+// or the normal and the fourth is alpha, which is always filtered linearly.
+////////////////////////////////////////////////////////////////////////////////
+class MipGeneratorClass
+{
+public:
+	struct SettingsType
+	{
+		MipFilterType filter;
+		MipContentType content;
+		MipAddressType address;
+	};
+
+private:
+	// The taps of one texel of a level along one axis, every texel has the same number and unused ones weigh nothing.
+	struct FilterType
+	{
+		int tapCount;
+		int* indices;
+		float* weights;
+	};
+
+public:
+	static int GetLevelCount(int, int);
+	static size_t GetChainSize(int, int);
+	static bool Generate(const unsigned char*, int, int, const SettingsType&, JobSystemClass*, unsigned char*);
+
+private:
+	static bool BuildFilter(int, int, const SettingsType&, FilterType&);
+	static void ReleaseFilter(FilterType&);
+	static void FilterRows(const float*, int, const FilterType&, int, float*, int, int);
+	static void FilterColumns(const float*, int, const FilterType&, float*, int, int);
+	static void Decode(const unsigned char*, int, MipContentType, float*);
+	static void Encode(float*, int, MipContentType, unsigned char*);
+	static float GetWeight(MipFilterType, float);
+	static float BesselI0(float);
+};
+
+#endif
@@ -0,0 +1,238 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: assetarchiveclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "assetarchiveclass.h"
+#include "loadlogclass.h"
+
+#include <cctype>
+#include <cstring>
+
+
+AssetArchiveClass::AssetArchiveClass()
+{
+	m_MappedFile = 0;
+	m_header = 0;
+	m_entries = 0;
+	m_entryCount = 0;
+}
+
+
+AssetArchiveClass::AssetArchiveClass(const AssetArchiveClass& other)
+{
+}
+
+
+AssetArchiveClass::~AssetArchiveClass()
+{
+}
+
+
+bool AssetArchiveClass::Initialize(const char* filename)
+{
+	const HeaderType* header;
+	const EntryType* entries;
+	size_t size;
+	double startTime;
+	bool result;
+	int i;
+
+
+	startTime = LoadLogClass::GetTime();
+
+	// Create the mapped file object.
+	m_MappedFile = new MappedFileClass;
+	if(!m_MappedFile)
+	{
+		return false;
+	}
+
+	// Map the whole archive, this is the only handle the assets are read through.
+	result = m_MappedFile->Initialize(filename);
+	if(!result)
+	{
+		delete m_MappedFile;
+		m_MappedFile = 0;
+		return false;
+	}
+
+	// Check the header and that the table of contents is whole before trusting any offset in it.
+	size = m_MappedFile->GetSize();
+	header = (const HeaderType*)m_MappedFile->GetData();
+	entries = (const EntryType*)(m_MappedFile->GetData() + sizeof(HeaderType));
+	result = size >= sizeof(HeaderType) && header->magic == ASSET_ARCHIVE_MAGIC && header->version == ASSET_ARCHIVE_VERSION &&
+			 header->alignment == ASSET_ARCHIVE_ALIGNMENT && header->fileSize == (unsigned long long)size &&
+			 (size - sizeof(HeaderType)) / sizeof(EntryType) >= header->entryCount;
+	if(result)
+	{
+		result = Hash(entries, (size_t)header->entryCount * sizeof(EntryType), ASSET_ARCHIVE_HASH_SEED) == header->tableHash;
+	}
+	for(i=0; result && i<(int)header->entryCount; i++)
+	{
+		result = entries[i].name[ASSET_ARCHIVE_NAME_LENGTH - 1] == 0 && entries[i].offset % ASSET_ARCHIVE_ALIGNMENT == 0 &&
+				 entries[i].offset <= header->fileSize && entries[i].size <= header->fileSize - entries[i].offset;
+
+		// Find relies on the table being sorted.
+		if(result && i > 0)
+		{
+			result = Compare(entries[i].name, entries[i].type, entries[i - 1]) > 0;
+		}
+	}
+
+	if(!result)
+	{
+		LoadLogClass::Write("asset archive %s: not a valid archive", filename);
+		Shutdown();
+		return false;
+	}
+
+	m_header = header;
+	m_entries = entries;
+	m_entryCount = (int)header->entryCount;
+
+	LoadLogClass::Write("asset archive %s: %d entries, %llu bytes mapped in %.3f ms", filename, m_entryCount, header->fileSize,
+						LoadLogClass::GetTime() - startTime);
+
+	return true;
+}
+
+
+void AssetArchiveClass::Shutdown()
+{
+	// Release the mapping, every pointer handed out by GetData goes with it.
+	if(m_MappedFile)
+	{
+		m_MappedFile->Shutdown();
+		delete m_MappedFile;
+		m_MappedFile = 0;
+	}
+
+	m_header = 0;
+	m_entries = 0;
+	m_entryCount = 0;
+
+	return;
+}
+
+
+const AssetArchiveClass::EntryType* AssetArchiveClass::Find(const char* name, unsigned int type)
+{
+	char assetName[ASSET_ARCHIVE_NAME_LENGTH];
+	string lowerName;
+	int first, last, middle, order;
+
+
+	// Look the asset up by its file name in lower case, the same way the cooker stored it.
+	lowerName = GetAssetName(name);
+	if(lowerName.size() >= ASSET_ARCHIVE_NAME_LENGTH)
+	{
+		return 0;
+	}
+	memcpy(assetName, lowerName.c_str(), lowerName.size() + 1);
+
+	// Binary search the sorted table of contents.
+	first = 0;
+	last = m_entryCount - 1;
+	while(first <= last)
+	{
+		middle = (first + last) / 2;
+		order = Compare(assetName, type, m_entries[middle]);
+		if(order == 0)
+		{
+			return &m_entries[middle];
+		}
+
+		if(order < 0)
+		{
+			last = middle - 1;
+		}
+		else
+		{
+			first = middle + 1;
+		}
+	}
+
+	return 0;
+}
+
+
+const unsigned char* AssetArchiveClass::GetData(const EntryType* entry)
+{
+	return m_MappedFile->GetData() + entry->offset;
+}
+
+
+bool AssetArchiveClass::Verify(const EntryType* entry)
+{
+	// Reads the whole blob, so it is for the cooker and tools rather than the load path.
+	return Hash(GetData(entry), (size_t)entry->size, ASSET_ARCHIVE_HASH_SEED) == entry->contentHash;
+}
+
+
+int AssetArchiveClass::GetEntryCount()
+{
+	return m_entryCount;
+}
+
+
+const AssetArchiveClass::EntryType* AssetArchiveClass::GetEntry(int index)
+{
+	return &m_entries[index];
+}
+
+
+string AssetArchiveClass::GetAssetName(const string& filename)
+{
+	string name;
+	size_t separator, i;
+
+
+	// Only the file name is kept, so the archive does not depend on where the game is run from.
+	separator = filename.find_last_of("/\\");
+	name = separator == string::npos ? filename : filename.substr(separator + 1);
+
+	for(i=0; i<name.size(); i++)
+	{
+		name[i] = (char)tolower((unsigned char)name[i]);
+	}
+
+	return name;
+}
+
+
+int AssetArchiveClass::Compare(const char* name, unsigned int type, const EntryType& entry)
+{
+	int order;
+
+
+	// Entries are sorted by name and then by type, so the assets cooked from one source sit together.
+	order = strcmp(name, entry.name);
+	if(order != 0)
+	{
+		return order;
+	}
+
+	if(type != entry.type)
+	{
+		return type < entry.type ? -1 : 1;
+	}
+
+	return 0;
+}
+
+
+unsigned long long AssetArchiveClass::Hash(const void* data, size_t size, unsigned long long hash)
+{
+	const unsigned char* bytes;
+	size_t i;
+
+
+	// 64 bit FNV-1a, the seed lets the cook settings be folded in ahead of the data.
+	bytes = (const unsigned char*)data;
+	for(i=0; i<size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001B3ULL;
+	}
+
+	return hash;
+}
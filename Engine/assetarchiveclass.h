@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: assetarchiveclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _ASSETARCHIVECLASS_H_
+#define _ASSETARCHIVECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+#include <string>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mappedfileclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int ASSET_ARCHIVE_MAGIC = 0x4B505452;	// "RTPK"
+const unsigned int ASSET_ARCHIVE_VERSION = 1;
+const unsigned int ASSET_ARCHIVE_ALIGNMENT = 4096;		// every blob starts on a page so it can be used straight out of the mapping
+const int ASSET_ARCHIVE_NAME_LENGTH = 64;
+const unsigned long long ASSET_ARCHIVE_HASH_SEED = 0xCBF29CE484222325ULL;
+
+enum AssetType
+{
+	ASSET_TYPE_MESH = 1,			// a mesh cache file, see MeshCacheClass
+	ASSET_TYPE_TANGENT_VERTICES,	// the mesh in TangentVertexLayout with its tangent frames already generated
+	ASSET_TYPE_TEXTURE,				// a DDS file
+	ASSET_TYPE_TEXTURE_SLICE		// where a texture the cooker packed into a texture array sits in it, see SliceType
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: AssetArchiveClass
+//
+// One file holding every cooked asset, written offline by the asset cooker.  A
+// header and a table of contents sorted by name and type come first, then each
+// asset as a blob aligned to a page.  The whole archive is mapped once and the
+// blobs are handed out as pointers into the mapping, nothing is copied.
+//
+// Each entry keeps a hash of the source file and the settings it was cooked
+// with, so the cooker can carry it over unchanged, and a hash of the blob so a
+// carried over blob can be checked.  Names are the file name of the source in
+// lower case, without its directory.
+//
+// Textures drawn together can be packed into one texture array.  The array is
+// a texture entry of its own and each texture in it has a slice entry naming
+// the array and its slice, in place of a texture entry.
+////////////////////////////////////////////////////////////////////////////////
+class AssetArchiveClass
+{
+public:
+	struct HeaderType
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int alignment;
+		unsigned int entryCount;
+		unsigned long long fileSize;
+		unsigned long long tableHash;
+	};
+
+	struct EntryType
+	{
+		char name[ASSET_ARCHIVE_NAME_LENGTH];
+		unsigned int type;
+		unsigned int reserved;
+		unsigned long long offset;
+		unsigned long long size;
+		unsigned long long sourceHash;
+		unsigned long long contentHash;
+	};
+
+	// The blob of a texture slice entry.
+	struct SliceType
+	{
+		char array[ASSET_ARCHIVE_NAME_LENGTH];
+		unsigned int slice;
+		unsigned int sliceCount;
+	};
+
+public:
+	AssetArchiveClass();
+	AssetArchiveClass(const AssetArchiveClass&);
+	~AssetArchiveClass();
+
+	bool Initialize(const char*);
+	void Shutdown();
+
+	// Find and GetData only read the mapping, so loader threads can call them at the same time.
+	const EntryType* Find(const char*, unsigned int);
+	const unsigned char* GetData(const EntryType*);
+	bool Verify(const EntryType*);
+	int GetEntryCount();
+	const EntryType* GetEntry(int);
+
+	static string GetAssetName(const string&);
+	static int Compare(const char*, unsigned int, const EntryType&);
+	static unsigned long long Hash(const void*, size_t, unsigned long long);
+
+private:
+	MappedFileClass* m_MappedFile;
+	const HeaderType* m_header;
+	const EntryType* m_entries;
+	int m_entryCount;
+};
+
+#endif
@@ -6,12 +6,11 @@
 /////////////
 // GLOBALS //
 /////////////
-cbuffer MatrixBuffer
-{
-	matrix worldMatrix;
-	matrix viewMatrix;
-	matrix projectionMatrix;
-};
+#include "constantbuffers.hlsli"
+
+#ifdef COMPRESSED_VERTICES
+#include "vertexcompression.hlsli"
+#endif
 
 
 //////////////
@@ -21,9 +20,14 @@ struct VertexInputType
 {
     float4 position : POSITION;
     float2 tex : TEXCOORD0;
+#ifdef COMPRESSED_VERTICES
+	float2 normal : NORMAL;
+	float2 tangent : TANGENT;
+#else
 	float3 normal : NORMAL;
 	float3 tangent : TANGENT;
 	float3 binormal : BINORMAL;
+#endif
 };
 
 struct PixelInputType
@@ -42,29 +46,43 @@ struct PixelInputType
 PixelInputType BumpMapVertexShader(VertexInputType input)
 {
     PixelInputType output;
-    
+	float3 normal, tangent, binormal;
+
+
+#ifdef COMPRESSED_VERTICES
+	// Unpack the tangent frame, the binormal is rebuilt from the normal, the tangent and the handedness sign.
+	normal = DecodeOctahedral(input.normal);
+	tangent = DecodeOctahedral(input.tangent);
+	binormal = cross(normal, tangent) * DecodeBinormalSign(input.position);
+
+	// Expand the quantized position back out to model space.
+	input.position.xyz = DecodePosition(input.position);
+#else
+	normal = input.normal;
+	tangent = input.tangent;
+	binormal = input.binormal;
+#endif
 
 	// Change the position vector to be 4 units for proper matrix calculations.
     input.position.w = 1.0f;
 
-	// Calculate the position of the vertex against the world, view, and projection matrices.
+	// Calculate the position of the vertex against the world matrix and the view and projection matrices multiplied together.
     output.position = mul(input.position, worldMatrix);
-    output.position = mul(output.position, viewMatrix);
-    output.position = mul(output.position, projectionMatrix);
+    output.position = mul(output.position, viewProjectionMatrix);
     
 	// Store the texture coordinates for the pixel shader.
 	output.tex = input.tex;
     
     // Calculate the normal vector against the world matrix only and then normalize the final value.
-    output.normal = mul(input.normal, (float3x3)worldMatrix);
+    output.normal = mul(normal, (float3x3)worldMatrix);
     output.normal = normalize(output.normal);
 
 	// Calculate the tangent vector against the world matrix only and then normalize the final value.
-    output.tangent = mul(input.tangent, (float3x3)worldMatrix);
+    output.tangent = mul(tangent, (float3x3)worldMatrix);
     output.tangent = normalize(output.tangent);
 
     // Calculate the binormal vector against the world matrix only and then normalize the final value.
-    output.binormal = mul(input.binormal, (float3x3)worldMatrix);
+    output.binormal = mul(binormal, (float3x3)worldMatrix);
     output.binormal = normalize(output.binormal);
 
     return output;
@@ -3,15 +3,18 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "bumpmapshaderclass.h"
 
+#include <cstring>
+
 
 BumpMapShaderClass::BumpMapShaderClass()
 {
+	m_StateCache = 0;
 	m_vertexShader = 0;
 	m_pixelShader = 0;
 	m_layout = 0;
-	m_matrixBuffer = 0;
 	m_sampleState = 0;
-	m_lightBuffer = 0;
+	m_materialBuffer = 0;
+	m_materialWritten = false;
 }
 
 
@@ -25,11 +28,14 @@ BumpMapShaderClass::~BumpMapShaderClass()
 }
 
 
-bool BumpMapShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool BumpMapShaderClass::Initialize(ID3D11Device* device, HWND hwnd, StateCacheClass* stateCache)
 {
 	bool result;
 
 
+	// Everything the shader binds goes through the state cache, so what is bound already is not set again.
+	m_StateCache = stateCache;
+
 	// Initialize the vertex and pixel shaders.
 	result = InitializeShader(device, hwnd, L"../Engine/bumpmap.vs", L"../Engine/bumpmap.ps");
 	if(!result)
@@ -50,23 +56,21 @@ void BumpMapShaderClass::Shutdown()
 }
 
 
-bool BumpMapShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix,
-	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* colorTexture, ID3D11ShaderResourceView* normalMapTexture,
-	XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
+bool BumpMapShaderClass::Render(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, ID3D11ShaderResourceView* colorTexture, int colorSlice,
+	ID3D11ShaderResourceView* normalMapTexture, int normalMapSlice)
 {
 	bool result;
 
 
 	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, colorTexture, normalMapTexture, 
-								 lightDirection, diffuseColor);
+	result = SetShaderParameters(deviceContext, colorTexture, colorSlice, normalMapTexture, normalMapSlice);
 	if(!result)
 	{
 		return false;
 	}
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(deviceContext, drawList);
 
 	return true;
 }
@@ -79,10 +83,10 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	ID3D10Blob* vertexShaderBuffer;
 	ID3D10Blob* pixelShaderBuffer;
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[5];
+	D3D_SHADER_MACRO defines[2];
 	unsigned int numElements;
-	D3D11_BUFFER_DESC matrixBufferDesc;
     D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
+	D3D11_BUFFER_DESC materialBufferDesc;
 
 
 	// Initialize the pointers this function will use to null.
@@ -90,9 +94,15 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	vertexShaderBuffer = 0;
 	pixelShaderBuffer = 0;
 
+	// Build the vertex shader for the packed vertex formats when vertex compression is on.
+	defines[0].Name = "COMPRESSED_VERTICES";
+	defines[0].Definition = "1";
+	defines[1].Name = NULL;
+	defines[1].Definition = NULL;
+
     // Compile the vertex shader code.
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "BumpMapVertexShader", "vs_5_0",
-		D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
+	result = D3DCompileFromFile(vsFilename, VERTEX_COMPRESSION_ENABLED ? defines : NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"BumpMapVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 
 	if(FAILED(result))
 	{
@@ -111,7 +121,7 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	}
 
     // Compile the pixel shader code.
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "BumpMapPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
+	result = D3DCompileFromFile(psFilename, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "BumpMapPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
 
 	if(FAILED(result))
 	{
@@ -146,10 +156,10 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	}
 
 	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
+	// This setup needs to match the vertex layout in vertexlayouts.h and in the shader.
 	polygonLayout[0].SemanticName = "POSITION";
 	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[0].InputSlot = 0;
 	polygonLayout[0].AlignedByteOffset = 0;
 	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -157,7 +167,7 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 
 	polygonLayout[1].SemanticName = "TEXCOORD";
 	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
 	polygonLayout[1].InputSlot = 0;
 	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -165,7 +175,7 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 
 	polygonLayout[2].SemanticName = "NORMAL";
 	polygonLayout[2].SemanticIndex = 0;
-	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[2].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[2].InputSlot = 0;
 	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -173,7 +183,7 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 
 	polygonLayout[3].SemanticName = "TANGENT";
 	polygonLayout[3].SemanticIndex = 0;
-	polygonLayout[3].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[3].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[3].InputSlot = 0;
 	polygonLayout[3].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[3].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -190,6 +200,12 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	// Get a count of the elements in the layout.
     numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
 
+	// The compressed vertex has no binormal, the shader rebuilds it from the normal and tangent.
+	if(VERTEX_COMPRESSION_ENABLED)
+	{
+		numElements--;
+	}
+
 	// Create the vertex input layout.
 	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), 
 									   vertexShaderBuffer->GetBufferSize(), &m_layout);
@@ -205,21 +221,6 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	pixelShaderBuffer->Release();
 	pixelShaderBuffer = 0;
 
-    // Setup the description of the matrix dynamic constant buffer that is in the vertex shader.
-    matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-    matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the matrix constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
-	if(FAILED(result))
-	{
-		return false;
-	}
-
 	// Create a texture sampler state description.
     samplerDesc.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
     samplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -242,16 +243,16 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 		return false;
 	}
 
-	// Setup the description of the light dynamic constant buffer that is in the pixel shader.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
+	// Setup the description of the material dynamic constant buffer that is in the pixel shader.
+	materialBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	materialBufferDesc.ByteWidth = sizeof(MaterialBufferType);
+	materialBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	materialBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	materialBufferDesc.MiscFlags = 0;
+	materialBufferDesc.StructureByteStride = 0;
 
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &m_lightBuffer);
+	// Create the constant buffer pointer so we can access the pixel shader constant buffer from within this class.
+	result = device->CreateBuffer(&materialBufferDesc, NULL, &m_materialBuffer);
 	if(FAILED(result))
 	{
 		return false;
@@ -263,12 +264,13 @@ bool BumpMapShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 
 void BumpMapShaderClass::ShutdownShader()
 {
-	// Release the light constant buffer.
-	if(m_lightBuffer)
+	// Release the material constant buffer.
+	if(m_materialBuffer)
 	{
-		m_lightBuffer->Release();
-		m_lightBuffer = 0;
+		m_materialBuffer->Release();
+		m_materialBuffer = 0;
 	}
+	m_materialWritten = false;
 
 	// Release the sampler state.
 	if(m_sampleState)
@@ -277,13 +279,6 @@ void BumpMapShaderClass::ShutdownShader()
 		m_sampleState = 0;
 	}
 
-	// Release the matrix constant buffer.
-	if(m_matrixBuffer)
-	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = 0;
-	}
-
 	// Release the layout.
 	if(m_layout)
 	{
@@ -345,89 +340,78 @@ void BumpMapShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND
 }
 
 
-bool BumpMapShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix,
-	const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix,
-											 ID3D11ShaderResourceView* colorTexture, ID3D11ShaderResourceView* normalMapTexture, 
-											 XMFLOAT3 lightDirection, XMFLOAT4 diffuseColor)
+bool BumpMapShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* colorTexture, int colorSlice,
+	ID3D11ShaderResourceView* normalMapTexture, int normalMapSlice)
 {
 	HRESULT result;
     D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	unsigned int bufferNumber;
-	LightBufferType* dataPtr2;
-
+	MaterialBufferType material;
+	ID3D11ShaderResourceView* textures[2];
 
-	// Transpose the matrices to prepare them for the shader.
-
-	// Lock the matrix constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
-	{
-		return false;
-	}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	// Set shader texture resources in the pixel shader, both slots in one call.
+	textures[0] = colorTexture;
+	textures[1] = normalMapTexture;
+	m_StateCache->SetPixelShaderResources(0, 2, textures);
 
-	// Copy the matrices into the constant buffer.
-	dataPtr->world = XMMatrixTranspose(worldMatrix);
-	dataPtr->view = XMMatrixTranspose(viewMatrix);
-	dataPtr->projection = XMMatrixTranspose(projectionMatrix);
+	// The matrices and light are in the frame and object buffers, only the slices of the texture arrays to sample are left for this one.
+	material.colorSlice = (float)colorSlice;
+	material.normalMapSlice = (float)normalMapSlice;
+	material.padding = XMFLOAT2(0.0f, 0.0f);
 
-	// Unlock the matrix constant buffer.
-    deviceContext->Unmap(m_matrixBuffer, 0);
-
-	// Set the position of the matrix constant buffer in the vertex shader.
-	bufferNumber = 0;
-
-	// Now set the matrix constant buffer in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
-
-	// Set shader texture resources in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &colorTexture);
-	deviceContext->PSSetShaderResources(1, 1, &normalMapTexture);
-
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(m_lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	// Only upload the material when it differs from the last one written.
+	if(!m_materialWritten || memcmp(&material, &m_material, sizeof(material)) != 0)
 	{
-		return false;
-	}
-
-	// Get a pointer to the data in the constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
+		// Lock the material constant buffer so it can be written to.
+		result = deviceContext->Map(m_materialBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		if(FAILED(result))
+		{
+			return false;
+		}
 
-	// Copy the lighting variables into the constant buffer.
-	dataPtr2->diffuseColor = diffuseColor;
-	dataPtr2->lightDirection = lightDirection;
+		// Copy the material into the constant buffer.
+		memcpy(mappedResource.pData, &material, sizeof(material));
 
-	// Unlock the constant buffer.
-	deviceContext->Unmap(m_lightBuffer, 0);
+		// Unlock the constant buffer.
+		deviceContext->Unmap(m_materialBuffer, 0);
 
-	// Set the position of the light constant buffer in the pixel shader.
-	bufferNumber = 0;
+		m_material = material;
+		m_materialWritten = true;
+	}
 
-	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &m_lightBuffer);
+	// Set the material constant buffer in the pixel shader.
+	m_StateCache->SetPixelConstantBuffers(MATERIAL_BUFFER_SLOT, 1, &m_materialBuffer);
 
 	return true;
 }
 
 
-void BumpMapShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+void BumpMapShaderClass::SetShader(ID3D11DeviceContext* deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout);
+	m_StateCache->SetInputLayout(m_layout);
 
     // Set the vertex and pixel shaders that will be used to render this triangle.
-    deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-    deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+    m_StateCache->SetVertexShader(m_vertexShader);
+    m_StateCache->SetPixelShader(m_pixelShader);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
+	m_StateCache->SetPixelSamplers(0, 1, &m_sampleState);
+
+	return;
+}
+
 
-	// Render the triangles.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+void BumpMapShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList)
+{
+	int i;
+
+
+	// Render the triangles, one draw for each range of the model that survived culling.
+	for(i=0; i<drawList.rangeCount; i++)
+	{
+		deviceContext->DrawIndexed(drawList.ranges[i].indexCount, drawList.ranges[i].firstIndex, 0);
+	}
 
 	return;
 }
\ No newline at end of file
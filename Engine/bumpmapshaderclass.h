@@ -17,24 +17,30 @@ using namespace DirectX;
 using namespace std;
 
 
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "vertexcompressionclass.h"
+#include "drawlist.h"
+#include "statecacheclass.h"
+#include "constantbuffers.h"
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: BumpMapShaderClass
+//
+// Lights with the diffuse color and direction in the frame buffer
+// ShaderManagerClass has bound, the slices of the color and normal map are all
+// the shader keeps in its own material buffer.
 ////////////////////////////////////////////////////////////////////////////////
 class BumpMapShaderClass
 {
 private:
-	struct MatrixBufferType
-	{
-		XMMATRIX world;
-		XMMATRIX view;
-		XMMATRIX projection;
-	};
-
-	struct LightBufferType
+	struct MaterialBufferType
 	{
-		XMFLOAT4 diffuseColor;
-		XMFLOAT3 lightDirection;
-		float padding;
+		float colorSlice;
+		float normalMapSlice;
+		XMFLOAT2 padding;
 	};
 
 public:
@@ -42,27 +48,28 @@ public:
 	BumpMapShaderClass(const BumpMapShaderClass&);
 	~BumpMapShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(ID3D11Device*, HWND, StateCacheClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*,
-		ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4);
+	bool Render(ID3D11DeviceContext*, const DrawListType&, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int);
+	void SetShader(ID3D11DeviceContext*);
 
 private:
 	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
 	void ShutdownShader();
 	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*,
-		ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(ID3D11DeviceContext*, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int);
+	void RenderShader(ID3D11DeviceContext*, const DrawListType&);
 
 private:
 	ID3D11VertexShader* m_vertexShader;
 	ID3D11PixelShader* m_pixelShader;
 	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
 	ID3D11SamplerState* m_sampleState;
-	ID3D11Buffer* m_lightBuffer;
+	ID3D11Buffer* m_materialBuffer;
+	MaterialBufferType m_material;
+	bool m_materialWritten;
+	StateCacheClass* m_StateCache;
 };
 
 #endif
\ No newline at end of file
@@ -5,92 +5,17 @@
 #define _BUMPMODELCLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3d11_1.h>
-#include <directXMath.h>
-using namespace DirectX;
-
-#include <fstream>
-using namespace std;
-
-
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
-#include "textureclass.h"
+#include "modeltemplateclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: BumpModelClass
+//
+// Draws with the position, texture, normal, tangent and binormal layout and a color and a normal map texture.
 ////////////////////////////////////////////////////////////////////////////////
-class BumpModelClass
-{
-private:
-	struct VertexType
-	{
-		XMFLOAT3 position;
-		XMFLOAT2 texture;
-		XMFLOAT3 normal;
-		XMFLOAT3 tangent;
-		XMFLOAT3 binormal;
-	};
-
-	struct ModelType
-	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
-		float tx, ty, tz;
-		float bx, by, bz;
-	};
-
-	struct TempVertexType
-	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
-	};
-
-	struct VectorType
-	{
-		float x, y, z;
-	};
-
-public:
-	BumpModelClass();
-	BumpModelClass(const BumpModelClass&);
-	~BumpModelClass();
-
-	bool Initialize(ID3D11Device*, char*, WCHAR*, WCHAR*);
-	void Shutdown();
-	void Render(ID3D11DeviceContext*);
-
-	int GetIndexCount();
-	ID3D11ShaderResourceView* GetColorTexture();
-	ID3D11ShaderResourceView* GetNormalMapTexture();
-
-private:
-	bool InitializeBuffers(ID3D11Device*);
-	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
-
-	bool LoadTextures(ID3D11Device*, WCHAR*, WCHAR*);
-	void ReleaseTextures();
-
-	bool LoadModel(char*);
-	void ReleaseModel();
-
-	void CalculateModelVectors();
-	void CalculateTangentBinormal(TempVertexType, TempVertexType, TempVertexType, VectorType&, VectorType&);
-
-private:
-	ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
-	int m_vertexCount, m_indexCount;
-	ModelType* m_model;
-	TextureClass* m_ColorTexture;
-	TextureClass* m_NormalMapTexture;
-};
+typedef ModelTemplateClass<TangentVertexLayout, 2> BumpModelClass;
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,156 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: clustercullerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "clustercullerclass.h"
+
+#include <cmath>
+#include <xmmintrin.h>
+
+
+void ClusterCullerClass::BuildFrustum(const float* worldViewProjection, const float* camera, FrustumType& frustum)
+{
+	float column[4][4];
+	float length;
+	int i, j;
+
+
+	// The matrix transforms row vectors, so the clip coordinates are the dot products with its columns.
+	for(i=0; i<4; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			column[i][j] = worldViewProjection[j * 4 + i];
+		}
+	}
+
+	// Left, right, bottom, top, near and far, with Direct3D's clip depth of 0 to w.
+	for(j=0; j<4; j++)
+	{
+		frustum.planes[0][j] = column[3][j] + column[0][j];
+		frustum.planes[1][j] = column[3][j] - column[0][j];
+		frustum.planes[2][j] = column[3][j] + column[1][j];
+		frustum.planes[3][j] = column[3][j] - column[1][j];
+		frustum.planes[4][j] = column[2][j];
+		frustum.planes[5][j] = column[3][j] - column[2][j];
+	}
+
+	// Normalize the planes so a sphere can be tested against them by its radius.
+	for(i=0; i<6; i++)
+	{
+		length = sqrtf(frustum.planes[i][0] * frustum.planes[i][0] + frustum.planes[i][1] * frustum.planes[i][1] +
+					   frustum.planes[i][2] * frustum.planes[i][2]);
+		if(length > 0.0f)
+		{
+			for(j=0; j<4; j++)
+			{
+				frustum.planes[i][j] /= length;
+			}
+		}
+	}
+
+	// The cones are only tested when there is a camera to test them against.
+	frustum.cones = camera != 0;
+	frustum.camera[0] = camera ? camera[0] : 0.0f;
+	frustum.camera[1] = camera ? camera[1] : 0.0f;
+	frustum.camera[2] = camera ? camera[2] : 0.0f;
+
+	return;
+}
+
+
+int ClusterCullerClass::Cull(const ClusterBlockType* blocks, int blockCount, const FrustumType& frustum, DrawRangeType* draws,
+							 StatisticsType& statistics)
+{
+	__m128 planes[6][4];
+	__m128 cameraX, cameraY, cameraZ, centerX, centerY, centerZ, radius, negativeRadius, distance, inside, x, y, z, length, facing, culled;
+	int drawCount, block, plane, lane, frustumMask, coneMask;
+	unsigned int firstIndex, indexCount;
+
+
+	// Spread each plane and the camera across all four lanes once.
+	for(plane=0; plane<6; plane++)
+	{
+		for(lane=0; lane<4; lane++)
+		{
+			planes[plane][lane] = _mm_set1_ps(frustum.planes[plane][lane]);
+		}
+	}
+
+	cameraX = _mm_set1_ps(frustum.camera[0]);
+	cameraY = _mm_set1_ps(frustum.camera[1]);
+	cameraZ = _mm_set1_ps(frustum.camera[2]);
+
+	drawCount = 0;
+
+	for(block=0; block<blockCount; block++)
+	{
+		centerX = _mm_loadu_ps(blocks[block].centerX);
+		centerY = _mm_loadu_ps(blocks[block].centerY);
+		centerZ = _mm_loadu_ps(blocks[block].centerZ);
+		radius = _mm_loadu_ps(blocks[block].radius);
+		negativeRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+		// A sphere is outside the frustum if it lies entirely behind any one of the planes.
+		inside = _mm_cmpeq_ps(radius, radius);
+		for(plane=0; plane<6; plane++)
+		{
+			distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[plane][0], centerX), _mm_mul_ps(planes[plane][1], centerY)),
+								  _mm_add_ps(_mm_mul_ps(planes[plane][2], centerZ), planes[plane][3]));
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+		}
+
+		// Every triangle of a cluster faces away when the view direction to its sphere lies inside the cone
+		// of directions that all its normals point away from.
+		x = _mm_sub_ps(centerX, cameraX);
+		y = _mm_sub_ps(centerY, cameraY);
+		z = _mm_sub_ps(centerZ, cameraZ);
+		length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_loadu_ps(blocks[block].axisX)), _mm_mul_ps(y, _mm_loadu_ps(blocks[block].axisY))),
+							_mm_mul_ps(z, _mm_loadu_ps(blocks[block].axisZ)));
+		culled = _mm_cmpge_ps(facing, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(blocks[block].cutoff), length), radius));
+
+		frustumMask = _mm_movemask_ps(inside);
+		coneMask = frustum.cones ? _mm_movemask_ps(culled) : 0;
+
+		for(lane=0; lane<4; lane++)
+		{
+			firstIndex = blocks[block].firstIndex[lane];
+			indexCount = blocks[block].indexCount[lane];
+			if(indexCount == 0)
+			{
+				continue;
+			}
+
+			statistics.clusters++;
+			statistics.triangles += indexCount / 3;
+
+			if(!(frustumMask & (1 << lane)))
+			{
+				statistics.frustumCulled++;
+				continue;
+			}
+
+			if(coneMask & (1 << lane))
+			{
+				statistics.coneCulled++;
+				continue;
+			}
+
+			statistics.drawnTriangles += indexCount / 3;
+
+			// Clusters are stored in index order, so neighbours that both survive become one draw.
+			if(drawCount > 0 && draws[drawCount - 1].firstIndex + draws[drawCount - 1].indexCount == firstIndex)
+			{
+				draws[drawCount - 1].indexCount += indexCount;
+			}
+			else
+			{
+				draws[drawCount].firstIndex = firstIndex;
+				draws[drawCount].indexCount = indexCount;
+				drawCount++;
+			}
+		}
+	}
+
+	return drawCount;
+}
@@ -0,0 +1,53 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: clustercullerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CLUSTERCULLERCLASS_H_
+#define _CLUSTERCULLERCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "drawlist.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ClusterCullerClass
+//
+// Tests the clusters of a mesh against the view frustum and their normal cones
+// four at a time with SSE, and turns the survivors into a draw list.  Nothing
+// here touches Direct3D so the kernel can be built and timed on its own.
+////////////////////////////////////////////////////////////////////////////////
+class ClusterCullerClass
+{
+public:
+	// Four clusters side by side so one SSE register holds the same field of each.  A lane
+	// with no indices is padding.  Everything is in model space.
+	struct ClusterBlockType
+	{
+		float centerX[4], centerY[4], centerZ[4], radius[4];
+		float axisX[4], axisY[4], axisZ[4], cutoff[4];
+		unsigned int firstIndex[4], indexCount[4];
+	};
+
+	// The frustum planes and the camera position in the model space of the mesh being culled.  Without a camera the
+	// normal cones are not tested.
+	struct FrustumType
+	{
+		float planes[6][4];
+		float camera[3];
+		bool cones;
+	};
+
+	struct StatisticsType
+	{
+		int clusters, frustumCulled, coneCulled;
+		long long triangles, drawnTriangles;
+	};
+
+public:
+	static void BuildFrustum(const float*, const float*, FrustumType&);
+	static int Cull(const ClusterBlockType*, int, const FrustumType&, DrawRangeType*, StatisticsType&);
+};
+
+#endif
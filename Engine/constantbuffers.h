@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantbuffers.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CONSTANTBUFFERS_H_
+#define _CONSTANTBUFFERS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <DirectXMath.h>
+using namespace DirectX;
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Slots of the constant buffers, matching the registers in constantbuffers.hlsli.  Slot 2 is the vertex compression buffer
+// of the mesh, so the material buffer of each shader comes after it.
+const int FRAME_BUFFER_SLOT = 0;
+const int OBJECT_BUFFER_SLOT = 1;
+const int MATERIAL_BUFFER_SLOT = 3;
+
+
+// Everything that stays the same for a whole frame, bound to both stages of every shader.  The view and projection are
+// multiplied together once here rather than for every vertex.
+struct FrameBufferType
+{
+	XMMATRIX viewProjection;
+	XMFLOAT4 ambientColor;
+	XMFLOAT4 diffuseColor;
+	XMFLOAT4 specularColor;
+	XMFLOAT3 lightDirection;
+	float specularPower;
+	XMFLOAT3 cameraPosition;
+	float padding;
+};
+
+// What changes with each object drawn.
+struct ObjectBufferType
+{
+	XMMATRIX world;
+};
+
+#endif
@@ -0,0 +1,26 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantbuffers.hlsli
+////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Matches FrameBufferType in constantbuffers.h, set once a frame.
+cbuffer FrameBuffer : register(b0)
+{
+	matrix viewProjectionMatrix;
+	float4 ambientColor;
+	float4 diffuseColor;
+	float4 specularColor;
+	float3 lightDirection;
+	float specularPower;
+	float3 cameraPosition;
+	float framePadding;
+};
+
+// Matches ObjectBufferType in constantbuffers.h, set for each object drawn.
+cbuffer ObjectBuffer : register(b1)
+{
+	matrix worldMatrix;
+};
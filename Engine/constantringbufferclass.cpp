@@ -0,0 +1,288 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantringbufferclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "constantringbufferclass.h"
+
+#include <cstring>
+
+
+ConstantRingBufferClass::ConstantRingBufferClass()
+{
+	int i;
+
+
+	m_device = 0;
+	m_buffer = 0;
+	m_bufferWritten = false;
+	m_Allocator = 0;
+	for(i=0; i<CONSTANT_RING_FRAMES; i++)
+	{
+		m_queries[i] = 0;
+		m_queryFrames[i] = 0;
+		m_queryPending[i] = false;
+	}
+	m_frame = 0;
+	m_grows = 0;
+}
+
+
+ConstantRingBufferClass::ConstantRingBufferClass(const ConstantRingBufferClass& other)
+{
+}
+
+
+ConstantRingBufferClass::~ConstantRingBufferClass()
+{
+}
+
+
+bool ConstantRingBufferClass::Initialize(ID3D11Device* device, unsigned int size)
+{
+	HRESULT result;
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+	D3D11_QUERY_DESC queryDesc;
+	int i;
+
+
+	// Binding with an offset and mapping a constant buffer with no overwrite both need the Direct3D 11.1 runtime and a driver that
+	// does them.
+	memset(&options, 0, sizeof(options));
+	result = device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if(FAILED(result) || !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+	{
+		return false;
+	}
+
+	m_device = device;
+
+	// Create the allocator that places the chunks in the ring.
+	m_Allocator = new RingAllocatorClass;
+	if(!m_Allocator)
+	{
+		return false;
+	}
+
+	if(!m_Allocator->Initialize(size, CONSTANT_RING_ALIGNMENT))
+	{
+		return false;
+	}
+
+	// Create the buffer the size the allocator rounded it to.
+	if(!CreateBuffer(m_Allocator->GetSize(), &m_buffer))
+	{
+		return false;
+	}
+	m_bufferWritten = false;
+
+	// Create the event queries that mark the end of each frame in flight.
+	queryDesc.Query = D3D11_QUERY_EVENT;
+	queryDesc.MiscFlags = 0;
+
+	for(i=0; i<CONSTANT_RING_FRAMES; i++)
+	{
+		result = device->CreateQuery(&queryDesc, &m_queries[i]);
+		if(FAILED(result))
+		{
+			return false;
+		}
+	}
+
+	m_frame = 0;
+	m_grows = 0;
+
+	return true;
+}
+
+
+void ConstantRingBufferClass::Shutdown()
+{
+	int i;
+
+
+	// Release the queries.
+	for(i=0; i<CONSTANT_RING_FRAMES; i++)
+	{
+		if(m_queries[i])
+		{
+			m_queries[i]->Release();
+			m_queries[i] = 0;
+		}
+		m_queryPending[i] = false;
+	}
+
+	// Release the allocator.
+	if(m_Allocator)
+	{
+		m_Allocator->Shutdown();
+		delete m_Allocator;
+		m_Allocator = 0;
+	}
+
+	// Release the buffer.
+	if(m_buffer)
+	{
+		m_buffer->Release();
+		m_buffer = 0;
+	}
+
+	m_device = 0;
+
+	return;
+}
+
+
+void ConstantRingBufferClass::BeginFrame(ID3D11DeviceContext* deviceContext)
+{
+	unsigned int completedFrame;
+	bool completed;
+	int i;
+
+
+	// Find the latest frame the GPU has finished, without flushing the commands still queued to get an answer.  The frames
+	// finish in order, so retiring it retires every frame before it too.
+	completedFrame = 0;
+	completed = false;
+	for(i=0; i<CONSTANT_RING_FRAMES; i++)
+	{
+		if(m_queryPending[i] && deviceContext->GetData(m_queries[i], NULL, 0, D3D11_ASYNC_GETDATA_DONOTFLUSH) == S_OK)
+		{
+			m_queryPending[i] = false;
+			if(!completed || (int)(m_queryFrames[i] - completedFrame) > 0)
+			{
+				completedFrame = m_queryFrames[i];
+				completed = true;
+			}
+		}
+	}
+
+	if(completed)
+	{
+		m_Allocator->Retire(completedFrame);
+	}
+
+	m_frame++;
+	m_Allocator->BeginFrame(m_frame);
+
+	return;
+}
+
+
+bool ConstantRingBufferClass::Write(ID3D11DeviceContext* deviceContext, const void* data, unsigned int stride, int count, unsigned int* offsets)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	ID3D11Buffer* buffer;
+	unsigned int alignedStride, size;
+	int i;
+
+
+	if(count == 0)
+	{
+		return true;
+	}
+
+	// Place a chunk for every element.  If the ring is full replace it with a larger one and place them all again, the runtime
+	// keeps the old buffer while the GPU still reads from it.
+	alignedStride = (stride + CONSTANT_RING_ALIGNMENT - 1) & ~(CONSTANT_RING_ALIGNMENT - 1);
+
+	for(i=0; i<count; i++)
+	{
+		if(!m_Allocator->Allocate(stride, offsets[i]))
+		{
+			// Make the larger buffer before anything is changed, so a failure leaves the old buffer and ring in use.
+			size = m_Allocator->GetGrowSize(alignedStride * count);
+			if(!CreateBuffer(size, &buffer))
+			{
+				return false;
+			}
+
+			m_buffer->Release();
+			m_buffer = buffer;
+			m_bufferWritten = false;
+
+			m_Allocator->Grow(size);
+			m_grows++;
+			i = -1;
+		}
+	}
+
+	// Map the ring once for the whole frame.  No overwrite leaves the chunks of the frames in flight alone, a new buffer is
+	// discarded the first time since nothing has been written to it.
+	result = deviceContext->Map(m_buffer, 0, m_bufferWritten ? D3D11_MAP_WRITE_NO_OVERWRITE : D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	for(i=0; i<count; i++)
+	{
+		memcpy((unsigned char*)mappedResource.pData + offsets[i], (const unsigned char*)data + i * stride, stride);
+	}
+
+	deviceContext->Unmap(m_buffer, 0);
+
+	m_bufferWritten = true;
+
+	return true;
+}
+
+
+void ConstantRingBufferClass::EndFrame(ID3D11DeviceContext* deviceContext)
+{
+	int slot;
+
+
+	// Mark the end of the frame.  If its query is still waiting on a frame this many back that frame is only retired when a later
+	// one is, which is no sooner than it would have been.
+	slot = m_frame % CONSTANT_RING_FRAMES;
+	deviceContext->End(m_queries[slot]);
+	m_queryFrames[slot] = m_frame;
+	m_queryPending[slot] = true;
+
+	m_Allocator->EndFrame();
+
+	return;
+}
+
+
+ID3D11Buffer* ConstantRingBufferClass::GetBuffer()
+{
+	return m_buffer;
+}
+
+
+void ConstantRingBufferClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics.size = m_Allocator->GetSize();
+	statistics.used = m_Allocator->GetUsed();
+	statistics.framesInFlight = m_Allocator->GetFramesInFlight();
+	statistics.grows = m_grows;
+	m_grows = 0;
+
+	return;
+}
+
+
+bool ConstantRingBufferClass::CreateBuffer(unsigned int size, ID3D11Buffer** buffer)
+{
+	HRESULT result;
+	D3D11_BUFFER_DESC bufferDesc;
+
+
+	// Setup the description of the dynamic constant buffer the CPU writes the frames into.
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = size;
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	// Create the buffer.
+	result = m_device->CreateBuffer(&bufferDesc, NULL, buffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: constantringbufferclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _CONSTANTRINGBUFFERCLASS_H_
+#define _CONSTANTRINGBUFFERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "ringallocatorclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Every allocation starts on a multiple of 256 bytes and is a multiple of it long, 16 constants, which is what
+// VSSetConstantBuffers1 and PSSetConstantBuffers1 take as an offset and size.
+const unsigned int CONSTANT_RING_ALIGNMENT = 256;
+const unsigned int CONSTANT_RING_SIZE = 64 * 1024;
+
+// Frames the GPU can be behind by before their queries are used again.
+const int CONSTANT_RING_FRAMES = 3;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ConstantRingBufferClass
+//
+// One large dynamic constant buffer the constants of every draw in a frame
+// are written to, each in its own 256 byte aligned chunk, with a single map
+// for the whole frame.  The draws then bind their chunk with an offset
+// instead of mapping a small buffer of their own.
+//
+// The ring is mapped with no overwrite, so the GPU keeps reading what the
+// frames before wrote.  RingAllocatorClass decides where the chunks go, an
+// event query at the end of each frame tells it when the GPU is done with
+// that frame so its chunks can be used again.  If the ring fills up before
+// that a buffer twice the size replaces it, the old one is released and the
+// runtime keeps it until the frames reading it have finished.  If the larger
+// buffer cannot be made the old one and the ring are left as they were and
+// Write fails.
+//
+// Initialize fails on a device or driver that cannot bind constant buffers
+// with an offset or map them with no overwrite, the caller keeps mapping
+// buffers per draw then.
+////////////////////////////////////////////////////////////////////////////////
+class ConstantRingBufferClass
+{
+public:
+	struct StatisticsType
+	{
+		unsigned int size;
+		unsigned int used;
+		int framesInFlight;
+		int grows;
+	};
+
+public:
+	ConstantRingBufferClass();
+	ConstantRingBufferClass(const ConstantRingBufferClass&);
+	~ConstantRingBufferClass();
+
+	bool Initialize(ID3D11Device*, unsigned int);
+	void Shutdown();
+
+	void BeginFrame(ID3D11DeviceContext*);
+	bool Write(ID3D11DeviceContext*, const void*, unsigned int, int, unsigned int*);
+	void EndFrame(ID3D11DeviceContext*);
+
+	ID3D11Buffer* GetBuffer();
+	void GetStatistics(StatisticsType&);
+
+private:
+	bool CreateBuffer(unsigned int, ID3D11Buffer**);
+
+private:
+	ID3D11Device* m_device;
+	ID3D11Buffer* m_buffer;
+	bool m_bufferWritten;
+	RingAllocatorClass* m_Allocator;
+	ID3D11Query* m_queries[CONSTANT_RING_FRAMES];
+	unsigned int m_queryFrames[CONSTANT_RING_FRAMES];
+	bool m_queryPending[CONSTANT_RING_FRAMES];
+	unsigned int m_frame;
+	int m_grows;
+};
+
+#endif
\ No newline at end of file
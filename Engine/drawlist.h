@@ -0,0 +1,22 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: drawlist.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _DRAWLIST_H_
+#define _DRAWLIST_H_
+
+
+// One DrawIndexed call, a range of the index buffer the model has bound.
+struct DrawRangeType
+{
+	unsigned int firstIndex;
+	unsigned int indexCount;
+};
+
+// Everything one model draws, the ranges of its clusters that survived culling.
+struct DrawListType
+{
+	const DrawRangeType* ranges;
+	int rangeCount;
+};
+
+#endif
@@ -6,14 +6,13 @@
 /////////////
 // GLOBALS //
 /////////////
-cbuffer MatrixBuffer
-{
-	matrix worldMatrix;
-	matrix viewMatrix;
-	matrix projectionMatrix;
-};
+#include "constantbuffers.hlsli"
 
-cbuffer NoiseBuffer
+#ifdef COMPRESSED_VERTICES
+#include "vertexcompression.hlsli"
+#endif
+
+cbuffer NoiseBuffer : register(b3)
 {
 	float frameTime;
 	float3 scrollSpeeds;
@@ -49,13 +48,17 @@ PixelInputType FireVertexShader(VertexInputType input)
     PixelInputType output;
     
 
+#ifdef COMPRESSED_VERTICES
+	// Expand the quantized position back out to model space.
+	input.position.xyz = DecodePosition(input.position);
+#endif
+
 	// Change the position vector to be 4 units for proper matrix calculations.
     input.position.w = 1.0f;
 
-	// Calculate the position of the vertex against the world, view, and projection matrices.
+	// Calculate the position of the vertex against the world matrix and the view and projection matrices multiplied together.
     output.position = mul(input.position, worldMatrix);
-    output.position = mul(output.position, viewMatrix);
-    output.position = mul(output.position, projectionMatrix);
+    output.position = mul(output.position, viewProjectionMatrix);
     
 	// Store the texture coordinates for the pixel shader.
 	output.tex = input.tex;
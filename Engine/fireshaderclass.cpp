@@ -3,17 +3,21 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "fireshaderclass.h"
 
+#include <cstring>
+
 
 FireShaderClass::FireShaderClass()
 {
+	m_StateCache = 0;
 	m_vertexShader = 0;
 	m_pixelShader = 0;
 	m_layout = 0;
-	m_matrixBuffer = 0;
 	m_noiseBuffer = 0;
 	m_sampleState = 0;
 	m_sampleState2 = 0;
 	m_distortionBuffer = 0;
+	m_noiseWritten = false;
+	m_distortionWritten = false;
 }
 
 
@@ -27,11 +31,14 @@ FireShaderClass::~FireShaderClass()
 }
 
 
-bool FireShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool FireShaderClass::Initialize(ID3D11Device* device, HWND hwnd, StateCacheClass* stateCache)
 {
 	bool result;
 
 
+	// Everything the shader binds goes through the state cache, so what is bound already is not set again.
+	m_StateCache = stateCache;
+
 	// Initialize the vertex and pixel shaders.
 	result = InitializeShader(device, hwnd, L"../Engine/fire.vs", L"../Engine/fire.ps");
 	if(!result)
@@ -52,9 +59,8 @@ void FireShaderClass::Shutdown()
 }
 
 
-bool FireShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix,
-	const XMMATRIX& projectionMatrix, ID3D11ShaderResourceView* fireTexture,
-							 ID3D11ShaderResourceView* noiseTexture, ID3D11ShaderResourceView* alphaTexture, float frameTime,
+bool FireShaderClass::Render(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, ID3D11ShaderResourceView* fireTexture, int fireSlice,
+							 ID3D11ShaderResourceView* noiseTexture, int noiseSlice, ID3D11ShaderResourceView* alphaTexture, int alphaSlice, float frameTime,
 	XMFLOAT3 scrollSpeeds, XMFLOAT3 scales, XMFLOAT2 distortion1, XMFLOAT2 distortion2,
 	XMFLOAT2 distortion3, float distortionScale, float distortionBias)
 {
@@ -62,8 +68,8 @@ bool FireShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount,
 
 
 	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, fireTexture, noiseTexture, alphaTexture, 
-								 frameTime, scrollSpeeds, scales, distortion1, distortion2, distortion3, distortionScale, 
+	result = SetShaderParameters(deviceContext, fireTexture, fireSlice, noiseTexture, noiseSlice,
+								 alphaTexture, alphaSlice, frameTime, scrollSpeeds, scales, distortion1, distortion2, distortion3, distortionScale, 
 								 distortionBias);
 	if(!result)
 	{
@@ -71,7 +77,7 @@ bool FireShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount,
 	}
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(deviceContext, drawList);
 
 	return true;
 }
@@ -84,8 +90,8 @@ bool FireShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* v
 	ID3D10Blob* vertexShaderBuffer;
 	ID3D10Blob* pixelShaderBuffer;
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
+	D3D_SHADER_MACRO defines[2];
 	unsigned int numElements;
-	D3D11_BUFFER_DESC matrixBufferDesc;
 	D3D11_BUFFER_DESC noiseBufferDesc;
     D3D11_SAMPLER_DESC samplerDesc;
     D3D11_SAMPLER_DESC samplerDesc2;
@@ -97,9 +103,15 @@ bool FireShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* v
 	vertexShaderBuffer = 0;
 	pixelShaderBuffer = 0;
 
+	// Build the vertex shader for the packed vertex formats when vertex compression is on.
+	defines[0].Name = "COMPRESSED_VERTICES";
+	defines[0].Definition = "1";
+	defines[1].Name = NULL;
+	defines[1].Definition = NULL;
+
     // Compile the vertex shader code.
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "FireVertexShader", "vs_5_0",
-		D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
+	result = D3DCompileFromFile(vsFilename, VERTEX_COMPRESSION_ENABLED ? defines : NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"FireVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 
 	if(FAILED(result))
 	{
@@ -152,10 +164,10 @@ bool FireShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* v
 	}
 
 	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
+	// This setup needs to match the vertex layout in vertexlayouts.h and in the shader.
 	polygonLayout[0].SemanticName = "POSITION";
 	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[0].InputSlot = 0;
 	polygonLayout[0].AlignedByteOffset = 0;
 	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -163,7 +175,7 @@ bool FireShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* v
 
 	polygonLayout[1].SemanticName = "TEXCOORD";
 	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
 	polygonLayout[1].InputSlot = 0;
 	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -187,21 +199,6 @@ bool FireShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR* v
 	pixelShaderBuffer->Release();
 	pixelShaderBuffer = 0;
 
-    // Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-    matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-    matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the matrix buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
-	if(FAILED(result))
-	{
-		return false;
-	}
-
     // Setup the description of the dynamic noise constant buffer that is in the vertex shader.
     noiseBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
 	noiseBufferDesc.ByteWidth = sizeof(NoiseBufferType);
@@ -310,12 +307,8 @@ void FireShaderClass::ShutdownShader()
 		m_noiseBuffer = 0;
 	}
 
-	// Release the matrix constant buffer.
-	if(m_matrixBuffer)
-	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = 0;
-	}
+	m_noiseWritten = false;
+	m_distortionWritten = false;
 
 	// Release the layout.
 	if(m_layout)
@@ -378,121 +371,117 @@ void FireShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND hw
 }
 
 
-bool FireShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix,
-	const XMMATRIX& projectionMatrix, ID3D11ShaderResourceView* fireTexture,
-										  ID3D11ShaderResourceView* noiseTexture, ID3D11ShaderResourceView* alphaTexture, 
-										  float frameTime, XMFLOAT3 scrollSpeeds, XMFLOAT3 scales, XMFLOAT2 distortion1,
+bool FireShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* fireTexture, int fireSlice,
+										  ID3D11ShaderResourceView* noiseTexture, int noiseSlice, ID3D11ShaderResourceView* alphaTexture,
+										  int alphaSlice, float frameTime, XMFLOAT3 scrollSpeeds, XMFLOAT3 scales, XMFLOAT2 distortion1,
 	XMFLOAT2 distortion2, XMFLOAT2 distortion3, float distortionScale,
 										  float distortionBias)
 {
 	HRESULT result;
     D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	NoiseBufferType* dataPtr2;
-	DistortionBufferType* dataPtr3;
-	unsigned int bufferNumber;
+	NoiseBufferType noise;
+	DistortionBufferType distortion;
+	ID3D11ShaderResourceView* textures[3];
 
-	// Transpose the matrices to prepare them for the shader.
 
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if (FAILED(result))
-	{
-		return false;
-	}
-
-	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
-
-	// Copy the matrices into the constant buffer.
-	dataPtr->world = XMMatrixTranspose(worldMatrix);
-	dataPtr->view = XMMatrixTranspose(viewMatrix);
-	dataPtr->projection = XMMatrixTranspose(projectionMatrix);
-
-	// Unlock the constant buffer.
-	deviceContext->Unmap(m_matrixBuffer, 0);
+	// The matrices are in the frame and object buffers, the noise and distortion buffers are only written when they change.
+	noise.frameTime = frameTime;
+	noise.scrollSpeeds = scrollSpeeds;
+	noise.scales = scales;
+	noise.padding = 0.0f;
 
-	// Set the position of the matrix constant buffer in the vertex shader.
-	bufferNumber = 0;
-
-	// Now set the matrix constant buffer in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
-
-	// Lock the noise constant buffer so it can be written to.
-	result = deviceContext->Map(m_noiseBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	if(!m_noiseWritten || memcmp(&noise, &m_noise, sizeof(noise)) != 0)
 	{
-		return false;
-	}
-
-	// Get a pointer to the data in the noise constant buffer.
-	dataPtr2 = (NoiseBufferType*)mappedResource.pData;
-
-	// Copy the data into the noise constant buffer.
-	dataPtr2->frameTime = frameTime;
-	dataPtr2->scrollSpeeds = scrollSpeeds;
-	dataPtr2->scales = scales;
-	dataPtr2->padding = 0.0f;
-
-	// Unlock the noise constant buffer.
-    deviceContext->Unmap(m_noiseBuffer, 0);
-
-	// Set the position of the noise constant buffer in the vertex shader.
-	bufferNumber = 1;
+		// Lock the noise constant buffer so it can be written to.
+		result = deviceContext->Map(m_noiseBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		if(FAILED(result))
+		{
+			return false;
+		}
 
-	// Now set the noise constant buffer in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_noiseBuffer);
+		// Copy the data into the noise constant buffer.
+		memcpy(mappedResource.pData, &noise, sizeof(noise));
 
-	// Set the three shader texture resources in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &fireTexture);
-	deviceContext->PSSetShaderResources(1, 1, &noiseTexture);
-	deviceContext->PSSetShaderResources(2, 1, &alphaTexture);
+		// Unlock the noise constant buffer.
+		deviceContext->Unmap(m_noiseBuffer, 0);
 
-	// Lock the distortion constant buffer so it can be written to.
-	result = deviceContext->Map(m_distortionBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
-	{
-		return false;
+		m_noise = noise;
+		m_noiseWritten = true;
 	}
 
-	// Get a pointer to the data in the distortion constant buffer.
-	dataPtr3 = (DistortionBufferType*)mappedResource.pData;
+	// Set the noise constant buffer in the material slot of the vertex shader.
+    m_StateCache->SetVertexConstantBuffers(MATERIAL_BUFFER_SLOT, 1, &m_noiseBuffer);
+
+	// Set the three shader texture resources in the pixel shader in one call.  When the cooker packed them into one texture array
+	// the three are the same view and only the slices differ.
+	textures[0] = fireTexture;
+	textures[1] = noiseTexture;
+	textures[2] = alphaTexture;
+	m_StateCache->SetPixelShaderResources(0, 3, textures);
+
+	distortion.distortion1 = distortion1;
+	distortion.distortion2 = distortion2;
+	distortion.distortion3 = distortion3;
+	distortion.distortionScale = distortionScale;
+	distortion.distortionBias = distortionBias;
+	distortion.fireSlice = (float)fireSlice;
+	distortion.noiseSlice = (float)noiseSlice;
+	distortion.alphaSlice = (float)alphaSlice;
+	distortion.padding = 0.0f;
+
+	if(!m_distortionWritten || memcmp(&distortion, &m_distortion, sizeof(distortion)) != 0)
+	{
+		// Lock the distortion constant buffer so it can be written to.
+		result = deviceContext->Map(m_distortionBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		if(FAILED(result))
+		{
+			return false;
+		}
 
-	// Copy the data into the distortion constant buffer.
-	dataPtr3->distortion1 = distortion1;
-	dataPtr3->distortion2 = distortion2;
-	dataPtr3->distortion3 = distortion3;
-	dataPtr3->distortionScale = distortionScale;
-	dataPtr3->distortionBias = distortionBias;
+		// Copy the data into the distortion constant buffer.
+		memcpy(mappedResource.pData, &distortion, sizeof(distortion));
 
-	// Unlock the distortion constant buffer.
-    deviceContext->Unmap(m_distortionBuffer, 0);
+		// Unlock the distortion constant buffer.
+		deviceContext->Unmap(m_distortionBuffer, 0);
 
-	// Set the position of the distortion constant buffer in the pixel shader.
-	bufferNumber = 0;
+		m_distortion = distortion;
+		m_distortionWritten = true;
+	}
 
-	// Now set the distortion constant buffer in the pixel shader with the updated values.
-    deviceContext->PSSetConstantBuffers(bufferNumber, 1, &m_distortionBuffer);
+	// Set the distortion constant buffer in the material slot of the pixel shader.
+    m_StateCache->SetPixelConstantBuffers(MATERIAL_BUFFER_SLOT, 1, &m_distortionBuffer);
 
 	return true;
 }
 
 
-void FireShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+void FireShaderClass::SetShader(ID3D11DeviceContext* deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout);
+	m_StateCache->SetInputLayout(m_layout);
 
     // Set the vertex and pixel shaders that will be used to render this triangle.
-    deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-    deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+    m_StateCache->SetVertexShader(m_vertexShader);
+    m_StateCache->SetPixelShader(m_pixelShader);
 
 	// Set the sampler states in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
-	deviceContext->PSSetSamplers(1, 1, &m_sampleState2);
+	m_StateCache->SetPixelSamplers(0, 1, &m_sampleState);
+	m_StateCache->SetPixelSamplers(1, 1, &m_sampleState2);
+
+	return;
+}
+
 
-	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+void FireShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList)
+{
+	int i;
+
+
+	// Render the triangles, one draw for each range of the model that survived culling.
+	for(i=0; i<drawList.rangeCount; i++)
+	{
+		deviceContext->DrawIndexed(drawList.ranges[i].indexCount, drawList.ranges[i].firstIndex, 0);
+	}
 
 	return;
 }
\ No newline at end of file
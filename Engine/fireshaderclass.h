@@ -17,19 +17,25 @@ using namespace DirectX;
 using namespace std;
 
 
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "vertexcompressionclass.h"
+#include "drawlist.h"
+#include "statecacheclass.h"
+#include "constantbuffers.h"
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: FireShaderClass
+//
+// Draws with the frame and object buffers ShaderManagerClass has bound.  The
+// noise buffer of the vertex shader and the distortion buffer of the pixel
+// shader sit in the material slot of each stage.
 ////////////////////////////////////////////////////////////////////////////////
 class FireShaderClass
 {
 private:
-	struct MatrixBufferType
-	{
-		XMMATRIX  world;
-		XMMATRIX  view;
-		XMMATRIX  projection;
-	};
-
 	struct NoiseBufferType
 	{
 		float frameTime;
@@ -45,6 +51,10 @@ private:
 		XMFLOAT2 distortion3;
 		float distortionScale;
 		float distortionBias;
+		float fireSlice;
+		float noiseSlice;
+		float alphaSlice;
+		float padding;
 	};
 
 public:
@@ -52,32 +62,34 @@ public:
 	FireShaderClass(const FireShaderClass&);
 	~FireShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(ID3D11Device*, HWND, StateCacheClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*, ID3D11ShaderResourceView*,
-				ID3D11ShaderResourceView*, float, XMFLOAT3, XMFLOAT3, XMFLOAT2, XMFLOAT2, XMFLOAT2, float, float);
+	bool Render(ID3D11DeviceContext*, const DrawListType&, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int, float, XMFLOAT3, XMFLOAT3, XMFLOAT2, XMFLOAT2, XMFLOAT2, float, float);
+	void SetShader(ID3D11DeviceContext*);
 
 private:
 	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
 	void ShutdownShader();
 	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*,
-							 ID3D11ShaderResourceView*, ID3D11ShaderResourceView*, float, XMFLOAT3, XMFLOAT3, XMFLOAT2,
+	bool SetShaderParameters(ID3D11DeviceContext*, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int, float, XMFLOAT3, XMFLOAT3, XMFLOAT2,
 		XMFLOAT2, XMFLOAT2, float, float);
 
 
-	void RenderShader(ID3D11DeviceContext*, int);
+	void RenderShader(ID3D11DeviceContext*, const DrawListType&);
 
 private:
 	ID3D11VertexShader* m_vertexShader;
 	ID3D11PixelShader* m_pixelShader;
 	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
 	ID3D11Buffer* m_noiseBuffer;
 	ID3D11SamplerState* m_sampleState;
 	ID3D11SamplerState* m_sampleState2;
 	ID3D11Buffer* m_distortionBuffer;
+	NoiseBufferType m_noise;
+	DistortionBufferType m_distortion;
+	bool m_noiseWritten, m_distortionWritten;
+	StateCacheClass* m_StateCache;
 };
 
 #endif
\ No newline at end of file
@@ -10,17 +10,37 @@ GraphicsClass::GraphicsClass()
 	m_D3D = nullptr;
 	m_Timer = nullptr;
 	m_ShaderManager = nullptr;
+	m_RenderQueue = nullptr;
 	m_Light = nullptr;
 	m_Position = nullptr;
 	m_Camera = nullptr;
+	m_JobSystem = nullptr;
+	m_AssetArchive = nullptr;
+	m_MeshRegistry = nullptr;
+	m_TextureRegistry = nullptr;
 	m_FloorModel = nullptr;
 	m_SatelliteModel = nullptr;
 	m_RocketModel = nullptr;
 	m_TreeModel = nullptr;
+	m_TreeInstances = nullptr;
 	m_SaturnModel = nullptr;
 	m_SaturnRingModel = nullptr;
 	m_EarthModel = nullptr;
 	m_SunModel = nullptr;
+	m_firstFrame = true;
+	m_streaming = true;
+	m_streamingFrames = 0;
+	m_lastFrameTime = 0.0;
+	m_longestFrame = 0.0;
+	m_screenHeight = 0;
+	m_statisticsFrames = 0;
+	for(int i = 0; i < MESH_LOD_MAX_LEVELS; i++)
+	{
+		m_lodDraws[i] = 0;
+		m_lodTriangles[i] = 0;
+	}
+	memset(&m_clusterStatistics, 0, sizeof(m_clusterStatistics));
+	memset(&m_queueStatistics, 0, sizeof(m_queueStatistics));
 }
 
 
@@ -36,6 +56,7 @@ GraphicsClass::~GraphicsClass()
 
 bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth, int screenHeight)
 {
+	double startTime;
 	bool result;
 
 	// Create the input object.  The input object will be used to handle reading the keyboard and mouse input from the user.
@@ -53,6 +74,9 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
+	// Keep the screen height, the level of detail of each model depends on how many pixels it covers.
+	m_screenHeight = screenHeight;
+
 	// Create the Direct3D object.
 	m_D3D = new D3DClass;
 	if(!m_D3D)
@@ -76,13 +100,20 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 	}
 
 	// Initialize the shader manager object.
-	result = m_ShaderManager->Initialize(m_D3D->GetDevice(), hwnd);
+	result = m_ShaderManager->Initialize(m_D3D->GetDevice(), m_D3D->GetDeviceContext(), hwnd);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the shader manager object.", L"Error", MB_OK);
 		return false;
 	}
 
+	// Create the render queue object, every draw of a frame goes through it.
+	m_RenderQueue = new RenderQueueClass;
+	if(!m_RenderQueue)
+	{
+		return false;
+	}
+
 	// Create the timer object.
 	m_Timer = new TimerClass;
 	if (!m_Timer)
@@ -133,6 +164,70 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 	m_Light->SetSpecularColor(1.0f, 1.0f, 1.0f, 1.0f);
 	m_Light->SetSpecularPower(64.0f);
 
+	// Create the job system object.  The file reads and parsing of every asset run on it in parallel.
+	m_JobSystem = new JobSystemClass;
+	if(!m_JobSystem)
+	{
+		return false;
+	}
+
+	// Initialize the job system object with a worker for every core but this one.  Its injected delay is for the streaming tests.
+	result = m_JobSystem->Initialize(0, 0);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the job system object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the asset archive object.  The cooked meshes and textures are all mapped through its one file handle.
+	m_AssetArchive = new AssetArchiveClass;
+	if(!m_AssetArchive)
+	{
+		return false;
+	}
+
+	// Open the archive if it has been cooked, otherwise everything is loaded from the loose files.
+	result = m_AssetArchive->Initialize(ASSET_ARCHIVE_FILENAME);
+	if(!result)
+	{
+		LoadLogClass::Write("startup: no asset archive at %s, loading the loose files", ASSET_ARCHIVE_FILENAME);
+		delete m_AssetArchive;
+		m_AssetArchive = 0;
+	}
+
+	// Create the mesh registry object.  Models loading the same file share one copy of its buffers.
+	m_MeshRegistry = new MeshRegistryClass;
+	if(!m_MeshRegistry)
+	{
+		return false;
+	}
+
+	// Initialize the mesh registry object.
+	result = m_MeshRegistry->Initialize(m_D3D->GetDevice(), m_AssetArchive);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the mesh registry object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Create the texture registry object.  Models asking for the same texture, or for a copy of it under another name, share one.
+	m_TextureRegistry = new TextureRegistryClass;
+	if(!m_TextureRegistry)
+	{
+		return false;
+	}
+
+	// Initialize the texture registry object.
+	result = m_TextureRegistry->Initialize(m_D3D->GetDevice(), m_AssetArchive, TEXTURE_CONTENT_HASHING, TEXTURE_MEMORY_BUDGET,
+											TEXTURE_RESIDENT_MIPS);
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the texture registry object.", L"Error", MB_OK);
+		return false;
+	}
+
+	startTime = LoadLogClass::GetTime();
+
 	// Create the model object.
 	m_FloorModel = new ModelClass;
 	if(!m_FloorModel)
@@ -140,8 +235,8 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
-	// Initialize the model object.
-	result = m_FloorModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Floor.txt", L"../Engine/data/grass.dds");
+	// Queue the loading of its mesh and textures.
+	result = m_FloorModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Floor.txt", L"../Engine/data/grass.dds");
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the first model object.", L"Error", MB_OK);
@@ -155,8 +250,8 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
-	// Initialize the second model object.
-	result = m_SatelliteModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Satellite.txt", L"../Engine/data/Satellite.dds");
+	// Queue the loading of its mesh and textures.
+	result = m_SatelliteModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Satellite.txt", L"../Engine/data/Satellite.dds");
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the second model object.", L"Error", MB_OK);
@@ -170,8 +265,9 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
-	result = m_RocketModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Rocket.txt", L"../Engine/data/Rocket.dds");
-	if (!result)
+	// Queue the loading of its mesh and textures.
+	result = m_RocketModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Rocket.txt", L"../Engine/data/Rocket.dds");
+	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the rocket model object.", L"Error", MB_OK);
 		return false;
@@ -184,8 +280,9 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
-	result = m_TreeModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Tree.txt", L"../Engine/data/Tree.dds");
-	if (!result)
+	// Queue the loading of its mesh and textures.
+	result = m_TreeModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Tree.txt", L"../Engine/data/Tree.dds");
+	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the tree model object.", L"Error", MB_OK);
 		return false;
@@ -198,22 +295,24 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
-	result = m_SaturnModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Sphere.txt", L"../Engine/data/2k_saturn.dds");
-	if (!result)
+	// Queue the loading of its mesh and textures.
+	result = m_SaturnModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Sphere.txt", L"../Engine/data/2k_saturn.dds");
+	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the saturn object.", L"Error", MB_OK);
 		return false;
 	}
 
-	// Create the saturn model
+	// Create the saturn ring model
 	m_SaturnRingModel = new ModelClass;
-	if (!m_SaturnModel)
+	if(!m_SaturnRingModel)
 	{
 		return false;
 	}
 
-	result = m_SaturnRingModel->Initialize(m_D3D->GetDevice(), "../Engine/data/SaturnRing.txt", L"../Engine/data/SaturnRing.dds");
-	if (!result)
+	// Queue the loading of its mesh and textures.
+	result = m_SaturnRingModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/SaturnRing.txt", L"../Engine/data/SaturnRing.dds");
+	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the saturn ring object.", L"Error", MB_OK);
 		return false;
@@ -226,10 +325,9 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 		return false;
 	}
 
-	// Initialize the bump model object.
-	result = m_EarthModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Sphere.txt", L"../Engine/data/2k_earth_with_clouds.dds", 
+	// Queue the loading of its mesh and textures.
+	result = m_EarthModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Sphere.txt", L"../Engine/data/2k_earth_with_clouds.dds", 
 								  L"../Engine/data/2k_earth_normal_map.dds");
-
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the third model object.", L"Error", MB_OK);
@@ -238,26 +336,102 @@ bool GraphicsClass::Initialize(HINSTANCE hinstance, HWND hwnd, int screenWidth,
 
 	// Create the fourth fire model object.
 	m_SunModel = new FireModelClass;
-	if (!m_SunModel)
+	if(!m_SunModel)
 	{
 		return false;
 	}
 
-	result = m_SunModel->Initialize(m_D3D->GetDevice(), "../Engine/data/Sphere.txt", L"../Engine/data/fire01.dds", //square or cube
+	// Queue the loading of its mesh and textures.
+	result = m_SunModel->Prepare(m_JobSystem, m_MeshRegistry, m_TextureRegistry, "../Engine/data/Sphere.txt", L"../Engine/data/fire01.dds", //square or cube
 		L"../Engine/data/noise01.dds", L"../Engine/data/alpha01.dds");
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the fourth model object.", L"Error", MB_OK);
+		return false;
+	}
 
-	if (!result)
+	// Put the proxy meshes and placeholder textures in place so the first frame can go out while the loader jobs run.
+	result = m_FloorModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the first model object.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_SatelliteModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the second model object.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_RocketModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the rocket model object.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_TreeModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the tree model object.", L"Error", MB_OK);
+		return false;
+	}
+
+	// Place the trees, they are drawn instanced from one buffer.
+	result = InitializeTrees();
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the tree instances.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_SaturnModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the saturn object.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_SaturnRingModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the saturn ring object.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_EarthModel->Initialize(m_D3D->GetDevice());
+	if(!result)
+	{
+		MessageBox(hwnd, L"Could not initialize the third model object.", L"Error", MB_OK);
+		return false;
+	}
+
+	result = m_SunModel->Initialize(m_D3D->GetDevice());
+	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the fourth model object.", L"Error", MB_OK);
 		return false;
 	}
 
+	LoadLogClass::Write("startup: %d loader threads started on every asset, placeholders ready in %.3f ms", m_JobSystem->GetThreadCount(),
+						LoadLogClass::GetTime() - startTime);
+
 	return true;
 }
 
 
 void GraphicsClass::Shutdown()
 {
+	// Release the job system object, this waits for anything still loading.
+	if(m_JobSystem)
+	{
+		m_JobSystem->Shutdown();
+		delete m_JobSystem;
+		m_JobSystem = 0;
+	}
+
 	// Release the model objects.
 	if(m_FloorModel)
 	{
@@ -287,6 +461,66 @@ void GraphicsClass::Shutdown()
 		m_SunModel = 0;
 	}
 
+	if(m_RocketModel)
+	{
+		m_RocketModel->Shutdown();
+		delete m_RocketModel;
+		m_RocketModel = 0;
+	}
+
+	if(m_TreeModel)
+	{
+		m_TreeModel->Shutdown();
+		delete m_TreeModel;
+		m_TreeModel = 0;
+	}
+
+	// Release the tree instances.
+	if(m_TreeInstances)
+	{
+		m_TreeInstances->Shutdown();
+		delete m_TreeInstances;
+		m_TreeInstances = 0;
+	}
+
+	if(m_SaturnModel)
+	{
+		m_SaturnModel->Shutdown();
+		delete m_SaturnModel;
+		m_SaturnModel = 0;
+	}
+
+	if(m_SaturnRingModel)
+	{
+		m_SaturnRingModel->Shutdown();
+		delete m_SaturnRingModel;
+		m_SaturnRingModel = 0;
+	}
+
+	// Release the mesh registry object once every model has handed its meshes back.
+	if(m_MeshRegistry)
+	{
+		m_MeshRegistry->Shutdown();
+		delete m_MeshRegistry;
+		m_MeshRegistry = 0;
+	}
+
+	// Release the texture registry object the same way.
+	if(m_TextureRegistry)
+	{
+		m_TextureRegistry->Shutdown();
+		delete m_TextureRegistry;
+		m_TextureRegistry = 0;
+	}
+
+	// Release the asset archive object last, the meshes and textures above were using its mapping.
+	if(m_AssetArchive)
+	{
+		m_AssetArchive->Shutdown();
+		delete m_AssetArchive;
+		m_AssetArchive = 0;
+	}
+
 	// Release the light object.
 	if(m_Light)
 	{
@@ -308,6 +542,13 @@ void GraphicsClass::Shutdown()
 		m_Position = 0;
 	}
 
+	// Release the render queue object.
+	if(m_RenderQueue)
+	{
+		delete m_RenderQueue;
+		m_RenderQueue = 0;
+	}
+
 	// Release the shader manager object.
 	if(m_ShaderManager)
 	{
@@ -371,6 +612,13 @@ bool GraphicsClass::Frame()
 		return false;
 	}
 
+	// Swap in whatever finished loading since the last frame.
+	result = UpdateStreaming();
+	if (!result)
+	{
+		return false;
+	}
+
 	// Render the graphics.
 	result = Render(rocketTakeOff);
 	if (!result)
@@ -378,6 +626,27 @@ bool GraphicsClass::Frame()
 		return false;
 	}
 
+	// Stream texture mips in or out for what the models covered on screen this frame.
+	result = m_TextureRegistry->UpdateResidency();
+	if(!result)
+	{
+		return false;
+	}
+
+	// Report which levels of detail were drawn and how much the cluster culling saved every so often.
+	m_statisticsFrames++;
+	if(m_statisticsFrames == LOD_STATISTICS_FRAMES)
+	{
+		WriteStatistics();
+	}
+
+	// Close off the startup timeline in the load log.
+	if(m_firstFrame)
+	{
+		LoadLogClass::Write("startup: first frame rendered at %.3f ms", LoadLogClass::GetTime());
+		m_firstFrame = false;
+	}
+
 	return true;
 }
 
@@ -440,9 +709,337 @@ bool GraphicsClass::HandleMovementInput(float frameTime, bool* rocketTakeOff)
 	return true;
 }
 
+bool GraphicsClass::InitializeTrees()
+{
+	constexpr float treePosX[TREE_COUNT] = {-40, -152, -31, 190, -165, 164, 277, -197, -118, -150, 4, 35, -108, 298, -48, -30, -102, -273, 92, -237, -213, -78, -175, -157, 223, -150, -212, 98, -45, -76, 74, 24, 44, -171, 69, -56, -296, 249, 235, 280, 264, 32, 240, 101, 177, -269, 143, -102, 106, -106, 81, 60, -157, 227, 122, -298, 288, -287, -14, -124, 56, -264, -296, -3, 196, 142, 203, -248, -218, -5, 152, -297, -210, -288, 219, 201, 213, -12, -39, -94, 282, 108, 181, -254, 18, 288, 243, 17, 20, -62, 52, -26, -248, -177, 223, 165, 288, -40, 131, 270, -182, -126, 276, -211, 195, 10, -27, 236, -178, -262, -224, -83, 123, -70, -295, 106, -286, 220, 33, 13, 200, -212, -287, 83, 111, -202, -34, -212, 207, 236, 44, 156, -120, -78, 106, -193, -264, -245, 148, 38, -99, 194, -148, 222, -121, -130, 22, 96, -179, 74, -198, 114, -158, 131, -46, 146, -47, 185, -68, 297, -102, -47, -223, 280, 195, 179, -37, 253, 77, -259, 107, 255, -268, -261, 107, 104, -126, -267, 195, 13, -255, -151, 139, -168, 123, -49, 180, -171, 257, 14, -100, 269, 192, -177, -154, 221, -52, 176, 68, -153};
+	constexpr float treePosZ[TREE_COUNT] = {-63, 28, 67, 81, -220, 10, 109, 262, -187, -172, -240, -179, 279, 70, -51, -191, 224, -62, -210, -83, 213, 144, 77, 299, -285, -80, 153, -120, 145, -29, 122, 12, 134, -102, 233, 59, 149, -220, -245, 162, 116, -168, 120, -198, 137, 101, -238, 189, -283, -67, 214, -142, -237, 1, 201, 78, -134, 215, 60, -89, -222, 0, -150, 135, -297, -186, -47, -24, -143, -77, -286, 227, 7, -197, 187, 266, -182, -143, -111, -99, 63, -74, -3, -90, -8, 274, 57, -110, 283, 0, -173, 299, -83, 7, 259, -66, 202, 228, 103, 241, 125, -179, -66, -247, -294, -197, -154, 284, -188, 131, 50, -221, 133, 74, 79, 220, 206, 95, 192, 250, 78, 284, 217, -8, -225, -98, -98, 264, -208, 24, 192, -141, -113, 172, 238, 44, -283, -120, -27, 195, -164, 201, 126, 110, -278, -275, 271, -260, 52, -236, 211, 236, -254, -189, 87, 166, -48, -131, 56, -251, 32, 253, 0, 113, 278, 274, -119, -225, 202, 100, 140, 202, 39, -112, -146, 261, -43, -23, 30, -126, -250, -111, 104, -16, 214, -21, 248, -74, -171, -271, 111, -208, 42, -79, 78, -121, -92, -156, 161, 269};
+	InstanceBufferClass::InstanceType* instances;
+	bool result;
+
+
+	// The trees never move, so their world matrices are worked out once here rather than every frame.
+	instances = new InstanceBufferClass::InstanceType[TREE_COUNT];
+	if(!instances)
+	{
+		return false;
+	}
+
+	for(int i = 0; i < TREE_COUNT; i++)
+	{
+		XMStoreFloat4x4(&instances[i].world, XMMatrixMultiply(XMMatrixScaling(0.05f, 0.05f, 0.05f),
+															  XMMatrixTranslation(-150.f + treePosX[i], -202.f, 270.f + treePosZ[i])));
+	}
+
+	// Create the instance buffer, it sorts the trees into cells of the forest.
+	m_TreeInstances = new InstanceBufferClass;
+	if(!m_TreeInstances)
+	{
+		delete [] instances;
+		return false;
+	}
+
+	result = m_TreeInstances->Initialize(m_D3D->GetDevice(), instances, TREE_COUNT, TREE_CELL_SIZE);
+	delete [] instances;
+	if(!result)
+	{
+		return false;
+	}
+
+	LoadLogClass::Write("trees: %d instances in %d cells", m_TreeInstances->GetInstanceCount(), m_TreeInstances->GetCellCount());
+
+	return true;
+}
+
+
+bool GraphicsClass::UpdateStreaming()
+{
+	ID3D11Device* device;
+	double time;
+	bool result, resident;
+
+
+	if(!m_streaming)
+	{
+		return true;
+	}
+
+	// Keep track of the frame times while assets stream in, they should not depend on how long the loads take.
+	time = LoadLogClass::GetTime();
+	if(m_streamingFrames > 0 && time - m_lastFrameTime > m_longestFrame)
+	{
+		m_longestFrame = time - m_lastFrameTime;
+	}
+	m_lastFrameTime = time;
+	m_streamingFrames++;
+
+	// Give each model the chance to swap in a finished mesh or texture, none of this waits on a loader job.
+	device = m_D3D->GetDevice();
+
+	result = m_FloorModel->Update(device) && m_SatelliteModel->Update(device) && m_RocketModel->Update(device) &&
+			 m_TreeModel->Update(device) && m_SaturnModel->Update(device) && m_SaturnRingModel->Update(device) &&
+			 m_EarthModel->Update(device) && m_SunModel->Update(device);
+	if(!result)
+	{
+		return false;
+	}
+
+	resident = m_FloorModel->IsResident() && m_SatelliteModel->IsResident() && m_RocketModel->IsResident() &&
+			   m_TreeModel->IsResident() && m_SaturnModel->IsResident() && m_SaturnRingModel->IsResident() &&
+			   m_EarthModel->IsResident() && m_SunModel->IsResident();
+	if(resident)
+	{
+		LoadLogClass::Write("streaming: every asset resident at %.3f ms, %d frames rendered while loading, longest frame %.3f ms", time,
+							m_streamingFrames, m_longestFrame);
+		m_streaming = false;
+	}
+
+	return true;
+}
+
+
+template<class Model>
+void GraphicsClass::SubmitModel(RenderObjectType object, Model* model, ShaderType shader, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix,
+								const XMMATRIX& projectionMatrix, float lodScale, bool blended)
+{
+	RenderItemType item;
+	int i;
+
+
+	// Pick the level of detail and cull its clusters now, the draw list stays with the model until the queue draws it.
+	model->SelectLod(worldMatrix, viewMatrix, lodScale, model->GetLod());
+	model->Cull(worldMatrix, viewMatrix, projectionMatrix, m_clusterStatistics);
+
+	item.object = object;
+	XMStoreFloat4x4(&item.world, worldMatrix);
+	item.shaderObject = m_ShaderManager->AddObject(worldMatrix);
+	item.drawList = model->GetDrawList();
+	item.firstInstance = 0;
+	item.instanceCount = 1;
+	for(i=0; i<RENDER_ITEM_MAX_TEXTURES; i++)
+	{
+		item.textures[i] = i < model->GetTextureCount() ? model->GetTexture(i) : 0;
+		item.slices[i] = i < model->GetTextureCount() ? model->GetTextureSlice(i) : 0;
+	}
+	item.indexCount = model->GetIndexCount();
+	item.lod = model->GetLod();
+
+	SubmitDraw(item, shader, viewMatrix, blended);
+
+	return;
+}
+
+
+void GraphicsClass::SubmitDraw(const RenderItemType& item, ShaderType shader, const XMMATRIX& viewMatrix, bool blended)
+{
+	XMVECTOR position;
+	unsigned long long key;
+	float depth;
+	int material;
+
+
+	// Sort on the distance of the origin in front of the camera, as a fraction of the far plane, and the first texture.
+	position = XMVector3TransformCoord(XMVectorSet(item.world._41, item.world._42, item.world._43, 1.0f), viewMatrix);
+	depth = XMVectorGetZ(position) / SCREEN_DEPTH;
+	material = RenderQueueClass::GetMaterialId(item.textures[0]);
+
+	if(blended)
+	{
+		key = RenderQueueClass::MakeBlendedKey(shader, material, item.object, depth);
+	}
+	else
+	{
+		key = RenderQueueClass::MakeOpaqueKey(shader, material, item.object, depth);
+	}
+
+	m_RenderQueue->Submit(key, (int)m_renderItems.size());
+	m_renderItems.push_back(item);
+
+	return;
+}
+
+
+void GraphicsClass::RenderMesh(int object)
+{
+	StateCacheClass* stateCache;
+
+
+	// Put the vertex and index buffers of the object on the pipeline for the draws that follow, through the same state cache
+	// the shaders bind with.
+	stateCache = m_ShaderManager->GetStateCache();
+
+	switch(object)
+	{
+		case RENDER_OBJECT_FLOOR:
+		{
+			m_FloorModel->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_ROCKET:
+		{
+			m_RocketModel->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_TREES:
+		{
+			m_TreeModel->Render(stateCache);
+			m_TreeInstances->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_SATELLITE:
+		{
+			m_SatelliteModel->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_EARTH:
+		{
+			m_EarthModel->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_SATURN:
+		{
+			m_SaturnModel->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_SATURN_RING:
+		{
+			m_SaturnRingModel->Render(stateCache);
+			break;
+		}
+
+		case RENDER_OBJECT_SUN:
+		{
+			m_SunModel->Render(stateCache);
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+
+	return;
+}
+
+
+void GraphicsClass::CountDraw(int indexCount, int lod, int instanceCount)
+{
+	m_lodDraws[lod]++;
+	m_lodTriangles[lod] += (long long)(indexCount / 3) * instanceCount;
+
+	return;
+}
+
+
+void GraphicsClass::WriteStatistics()
+{
+	TextureResidencyClass::StatisticsType residencyStatistics;
+	StateCacheClass::StatisticsType stateStatistics;
+	ConstantRingBufferClass::StatisticsType ringStatistics;
+	long long triangles;
+	int draws, i;
+
+
+	// The totals first, then how the draws split across the levels of detail.
+	triangles = 0;
+	draws = 0;
+	for(i=0; i<MESH_LOD_MAX_LEVELS; i++)
+	{
+		triangles += m_lodTriangles[i];
+		draws += m_lodDraws[i];
+	}
+
+	LoadLogClass::Write("lod: %.0f triangles in %.1f draws per frame over %d frames", (double)triangles / m_statisticsFrames,
+						(double)draws / m_statisticsFrames, m_statisticsFrames);
+
+	for(i=0; i<MESH_LOD_MAX_LEVELS; i++)
+	{
+		if(m_lodDraws[i] > 0)
+		{
+			LoadLogClass::Write("lod %d: %.0f triangles in %.1f draws per frame", i, (double)m_lodTriangles[i] / m_statisticsFrames,
+								(double)m_lodDraws[i] / m_statisticsFrames);
+		}
+
+		m_lodTriangles[i] = 0;
+		m_lodDraws[i] = 0;
+	}
+
+	// Then what the clusters of those levels came to once the culling had been through them.
+	if(m_clusterStatistics.clusters > 0)
+	{
+		LoadLogClass::Write("clusters: %.0f of %.0f triangles drawn per frame, %.1f%% of clusters outside the frustum and %.1f%% facing away",
+							(double)m_clusterStatistics.drawnTriangles / m_statisticsFrames, (double)m_clusterStatistics.triangles / m_statisticsFrames,
+							100.0 * m_clusterStatistics.frustumCulled / m_clusterStatistics.clusters,
+							100.0 * m_clusterStatistics.coneCulled / m_clusterStatistics.clusters);
+	}
+
+	memset(&m_clusterStatistics, 0, sizeof(m_clusterStatistics));
+
+	// The state changes the render queue made, and how many it avoided against setting all of it for every draw.  The changes
+	// in the order the draws were submitted show what the sort itself is worth.
+	if(m_queueStatistics.packets > 0)
+	{
+		LoadLogClass::Write("queue: %.1f draws per frame with %.1f shader, %.1f material and %.1f mesh changes, %.1f, %.1f and %.1f avoided",
+							(double)m_queueStatistics.packets / m_statisticsFrames, (double)m_queueStatistics.sorted.shader / m_statisticsFrames,
+							(double)m_queueStatistics.sorted.material / m_statisticsFrames, (double)m_queueStatistics.sorted.mesh / m_statisticsFrames,
+							(double)(m_queueStatistics.packets - m_queueStatistics.sorted.shader) / m_statisticsFrames,
+							(double)(m_queueStatistics.packets - m_queueStatistics.sorted.material) / m_statisticsFrames,
+							(double)(m_queueStatistics.packets - m_queueStatistics.sorted.mesh) / m_statisticsFrames);
+		LoadLogClass::Write("queue: %.1f shader, %.1f material and %.1f mesh changes per frame in submission order",
+							(double)m_queueStatistics.submitted.shader / m_statisticsFrames, (double)m_queueStatistics.submitted.material / m_statisticsFrames,
+							(double)m_queueStatistics.submitted.mesh / m_statisticsFrames);
+	}
+
+	memset(&m_queueStatistics, 0, sizeof(m_queueStatistics));
+
+	// The binds the state cache passed on to the device context and the ones it dropped, only counted in debug builds.
+	m_ShaderManager->GetStateStatistics(stateStatistics);
+	if(stateStatistics.shaders.issued + stateStatistics.shaders.filtered > 0)
+	{
+		LoadLogClass::Write("state: issued/filtered per frame, %.1f/%.1f input layouts, %.1f/%.1f input buffers, %.1f/%.1f shaders, "
+							"%.1f/%.1f constant buffers, %.1f/%.1f samplers, %.1f/%.1f shader resources",
+							(double)stateStatistics.inputLayouts.issued / m_statisticsFrames, (double)stateStatistics.inputLayouts.filtered / m_statisticsFrames,
+							(double)stateStatistics.inputBuffers.issued / m_statisticsFrames, (double)stateStatistics.inputBuffers.filtered / m_statisticsFrames,
+							(double)stateStatistics.shaders.issued / m_statisticsFrames, (double)stateStatistics.shaders.filtered / m_statisticsFrames,
+							(double)stateStatistics.constantBuffers.issued / m_statisticsFrames,
+							(double)stateStatistics.constantBuffers.filtered / m_statisticsFrames,
+							(double)stateStatistics.samplers.issued / m_statisticsFrames, (double)stateStatistics.samplers.filtered / m_statisticsFrames,
+							(double)stateStatistics.shaderResources.issued / m_statisticsFrames,
+							(double)stateStatistics.shaderResources.filtered / m_statisticsFrames);
+	}
+
+	// How full the constant ring is and how often it had to grow.
+	if(m_ShaderManager->GetRingStatistics(ringStatistics))
+	{
+		LoadLogClass::Write("ring: %u of %u bytes in use over %d frames in flight, grown %d times", ringStatistics.used, ringStatistics.size,
+							ringStatistics.framesInFlight, ringStatistics.grows);
+	}
+
+	// And how much of the texture budget the streamed mips take.
+	if(m_TextureRegistry->GetResidencyStatistics(residencyStatistics))
+	{
+		LoadLogClass::Write("textures: %d resident in %.1f of %.1f MB, %d mips streamed in and %d evicted so far", residencyStatistics.textureCount,
+							residencyStatistics.residentBytes / 1048576.0, residencyStatistics.budget / 1048576.0, residencyStatistics.streamedMips,
+							residencyStatistics.evictedMips);
+	}
+
+	m_statisticsFrames = 0;
+
+	return;
+}
+
+
 bool GraphicsClass::Render(bool rocketTakeOff)
 {
 	XMMATRIX worldMatrix, viewMatrix, projectionMatrix, translateMatrix;
+	XMFLOAT4X4 projection;
+	float lodScale;
 	bool result;
 	
 	XMFLOAT3 scrollSpeeds, scales;
@@ -450,7 +1047,10 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 	float distortionScale, distortionBias;
 	static float frameTime = 0.0f;
 
-	int treeCount;
+	ID3D11DeviceContext* deviceContext;
+	RenderItemType treeItem;
+	DrawListType drawList;
+	int pass, shader, mesh;
 	
 	frameTime += 0.01f;
 	if (frameTime > 1000.0f)
@@ -490,19 +1090,24 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 	m_D3D->GetWorldMatrix(worldMatrix);
 	m_Camera->GetViewMatrix(viewMatrix);
 	m_D3D->GetProjectionMatrix(projectionMatrix);
+
+	// Pixels covered by one unit at a distance of one, each model picks its level of detail from this.
+	XMStoreFloat4x4(&projection, projectionMatrix);
+	lodScale = projection._22 * (float)m_screenHeight * 0.5f;
 	
+	// Start this frame's queue.  Each model below picks its level of detail and culls its clusters as it is submitted, and is
+	// drawn once they all are, in the order of their keys.
+	m_RenderQueue->Begin();
+	m_renderItems.clear();
+	m_ShaderManager->BeginFrame(m_D3D->GetDeviceContext());
+
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixScaling(3.0f, 1.0f, 3.0f));
 	translateMatrix = XMMatrixTranslation(0.0f, -200.0f, 0.0f);
 	worldMatrix = XMMatrixMultiply(worldMatrix, translateMatrix);
 	
 
-	// Render the first model using the texture shader.
-	m_FloorModel->Render(m_D3D->GetDeviceContext());
-	result = m_ShaderManager->RenderTextureShader(m_D3D->GetDeviceContext(), m_FloorModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix, m_FloorModel->GetTexture());
-	if(!result)
-	{
-		return false;
-	}
+	// Submit the first model using the texture shader.
+	SubmitModel(RENDER_OBJECT_FLOOR, m_FloorModel, SHADER_TEXTURE, worldMatrix, viewMatrix, projectionMatrix, lodScale, false);
 
 	// Setup the rotation and translation of the Rocket
 	m_D3D->GetWorldMatrix(worldMatrix);
@@ -510,26 +1115,40 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixScaling(0.05f, 0.05f, 0.05f));
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixTranslation(0.0f, -200.f + rocketHeight * 0.2f, 0.0f));
 
-	// render the rocket model
-	m_RocketModel->Render(m_D3D->GetDeviceContext());
-	result = m_ShaderManager->RenderLightShader(m_D3D->GetDeviceContext(), m_RocketModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix, m_RocketModel->GetTexture(), m_Light->GetDirection(), m_Light->GetAmbientColor(), m_Light->GetDiffuseColor(), m_Camera->GetPosition(), m_Light->GetSpecularColor(), m_Light->GetSpecularPower());
+	// submit the rocket model
+	SubmitModel(RENDER_OBJECT_ROCKET, m_RocketModel, SHADER_LIGHT, worldMatrix, viewMatrix, projectionMatrix, lodScale, false);
 
-	// Setup positions and render the trees
-	constexpr float treePosX[200] = {-40, -152, -31, 190, -165, 164, 277, -197, -118, -150, 4, 35, -108, 298, -48, -30, -102, -273, 92, -237, -213, -78, -175, -157, 223, -150, -212, 98, -45, -76, 74, 24, 44, -171, 69, -56, -296, 249, 235, 280, 264, 32, 240, 101, 177, -269, 143, -102, 106, -106, 81, 60, -157, 227, 122, -298, 288, -287, -14, -124, 56, -264, -296, -3, 196, 142, 203, -248, -218, -5, 152, -297, -210, -288, 219, 201, 213, -12, -39, -94, 282, 108, 181, -254, 18, 288, 243, 17, 20, -62, 52, -26, -248, -177, 223, 165, 288, -40, 131, 270, -182, -126, 276, -211, 195, 10, -27, 236, -178, -262, -224, -83, 123, -70, -295, 106, -286, 220, 33, 13, 200, -212, -287, 83, 111, -202, -34, -212, 207, 236, 44, 156, -120, -78, 106, -193, -264, -245, 148, 38, -99, 194, -148, 222, -121, -130, 22, 96, -179, 74, -198, 114, -158, 131, -46, 146, -47, 185, -68, 297, -102, -47, -223, 280, 195, 179, -37, 253, 77, -259, 107, 255, -268, -261, 107, 104, -126, -267, 195, 13, -255, -151, 139, -168, 123, -49, 180, -171, 257, 14, -100, 269, 192, -177, -154, 221, -52, 176, 68, -153};
-	constexpr float treePosZ[200] = {-63, 28, 67, 81, -220, 10, 109, 262, -187, -172, -240, -179, 279, 70, -51, -191, 224, -62, -210, -83, 213, 144, 77, 299, -285, -80, 153, -120, 145, -29, 122, 12, 134, -102, 233, 59, 149, -220, -245, 162, 116, -168, 120, -198, 137, 101, -238, 189, -283, -67, 214, -142, -237, 1, 201, 78, -134, 215, 60, -89, -222, 0, -150, 135, -297, -186, -47, -24, -143, -77, -286, 227, 7, -197, 187, 266, -182, -143, -111, -99, 63, -74, -3, -90, -8, 274, 57, -110, 283, 0, -173, 299, -83, 7, 259, -66, 202, 228, 103, 241, 125, -179, -66, -247, -294, -197, -154, 284, -188, 131, 50, -221, 133, 74, 79, 220, 206, 95, 192, 250, 78, 284, 217, -8, -225, -98, -98, 264, -208, 24, 192, -141, -113, 172, 238, 44, -283, -120, -27, 195, -164, 201, 126, 110, -278, -275, 271, -260, 52, -236, 211, 236, -254, -189, 87, 166, -48, -131, 56, -251, 32, 253, 0, 113, 278, 274, -119, -225, 202, 100, 140, 202, 39, -112, -146, 261, -43, -23, 30, -126, -250, -111, 104, -16, 214, -21, 248, -74, -171, -271, 111, -208, 42, -79, 78, -121, -92, -156, 161, 269};
+	// Submit the trees from their instance buffer, one draw for each cell of the forest in view.  The cells pick their own level
+	// of detail, for the closest tree they could hold, and the trees in a cell are drawn at it.
+	m_TreeInstances->Cull(viewMatrix, projectionMatrix, m_TreeModel->GetBoundingRadius());
 
-	for (int i = 0; i < 200; i++)
+	for(int i = 0; i < m_TreeInstances->GetCellCount(); i++)
 	{
-		m_D3D->GetWorldMatrix(worldMatrix);
-
-		worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixScaling(0.05f, 0.05f, 0.05f));
-		worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixTranslation(-150.f, 0.f, 270.f));
-		worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixTranslation(treePosX[i], -202.f, treePosZ[i]));
-
-		m_TreeModel->Render(m_D3D->GetDeviceContext());
-		result = m_ShaderManager->RenderLightShader(m_D3D->GetDeviceContext(), m_TreeModel->GetIndexCount(), worldMatrix,
-			viewMatrix, projectionMatrix, m_TreeModel->GetTexture(), m_Light->GetDirection(), m_Light->GetAmbientColor(), 
-			m_Light->GetDiffuseColor(), m_Camera->GetPosition(), m_Light->GetSpecularColor(), m_Light->GetSpecularPower());
+		InstanceBufferClass::CellType& cell = m_TreeInstances->GetCell(i);
+		if(!cell.visible)
+		{
+			continue;
+		}
+
+		worldMatrix = XMMatrixMultiply(XMMatrixScaling(m_TreeInstances->GetScale(), m_TreeInstances->GetScale(), m_TreeInstances->GetScale()),
+									   XMMatrixTranslation(cell.center.x, cell.center.y, cell.center.z));
+		cell.lod = m_TreeModel->SelectLod(worldMatrix, viewMatrix, lodScale, cell.lod, cell.radius);
+
+		// Without a cull the draw list is the one range of the level.
+		treeItem.object = RENDER_OBJECT_TREES;
+		XMStoreFloat4x4(&treeItem.world, worldMatrix);
+		treeItem.shaderObject = -1;
+		treeItem.range = m_TreeModel->GetDrawList().ranges[0];
+		treeItem.drawList.ranges = 0;
+		treeItem.drawList.rangeCount = 1;
+		treeItem.firstInstance = cell.firstInstance;
+		treeItem.instanceCount = cell.instanceCount;
+		treeItem.textures[0] = m_TreeModel->GetTexture(0);
+		treeItem.slices[0] = m_TreeModel->GetTextureSlice(0);
+		treeItem.indexCount = m_TreeModel->GetIndexCount();
+		treeItem.lod = cell.lod;
+
+		SubmitDraw(treeItem, SHADER_LIGHT_INSTANCED, viewMatrix, false);
 	}
 
 	// Setup the rotation and translation of the Satellite
@@ -551,15 +1170,8 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixRotationAxis(SatAxis2, rotation * 0.2f));
 	
 
-	// Render the second model using the light shader.
-	m_SatelliteModel->Render(m_D3D->GetDeviceContext());
-	result = m_ShaderManager->RenderLightShader(m_D3D->GetDeviceContext(), m_SatelliteModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix, 
-									   m_SatelliteModel->GetTexture(), m_Light->GetDirection(), m_Light->GetAmbientColor(), m_Light->GetDiffuseColor(), 
-									   m_Camera->GetPosition(), m_Light->GetSpecularColor(), m_Light->GetSpecularPower());
-	if(!result)
-	{
-		return false;
-	}
+	// Submit the second model using the light shader.
+	SubmitModel(RENDER_OBJECT_SATELLITE, m_SatelliteModel, SHADER_LIGHT, worldMatrix, viewMatrix, projectionMatrix, lodScale, false);
 
 	// Setup the rotation and translation of the earth model.
 	m_D3D->GetWorldMatrix(worldMatrix);
@@ -575,20 +1187,8 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixRotationAxis(earthAxis, rotation * 0.2f));
 	
 
-	// Render the earth model using the bump map shader.
-	m_EarthModel->Render(m_D3D->GetDeviceContext());
-	result = m_ShaderManager->RenderBumpMapShader(m_D3D->GetDeviceContext(), m_EarthModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix, 
-												  m_EarthModel->GetColorTexture(), m_EarthModel->GetNormalMapTexture(), m_Light->GetDirection(), 
-												  m_Light->GetDiffuseColor());
-	if(!result)
-	{
-		return false;
-	}
-
-	m_D3D->GetWorldMatrix(worldMatrix);
-	m_Camera->GetViewMatrix(viewMatrix);
-	m_D3D->GetProjectionMatrix(projectionMatrix);
-
+	// Submit the earth model using the bump map shader.
+	SubmitModel(RENDER_OBJECT_EARTH, m_EarthModel, SHADER_BUMP_MAP, worldMatrix, viewMatrix, projectionMatrix, lodScale, false);
 
 	// Setup the rotation and translation of saturn
 	m_D3D->GetWorldMatrix(worldMatrix);
@@ -604,11 +1204,8 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixRotationAxis(saturnAxis, rotation * 0.1f));
 
-	// Render saturn model
-	m_SaturnModel->Render(m_D3D->GetDeviceContext());
-	result = m_ShaderManager->RenderLightShader(m_D3D->GetDeviceContext(), m_SaturnModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix,
-		m_SaturnModel->GetTexture(), m_Light->GetDirection(), m_Light->GetAmbientColor(), m_Light->GetDiffuseColor(),
-		m_Camera->GetPosition(), m_Light->GetSpecularColor(), m_Light->GetSpecularPower());
+	// Submit saturn model
+	SubmitModel(RENDER_OBJECT_SATURN, m_SaturnModel, SHADER_LIGHT, worldMatrix, viewMatrix, projectionMatrix, lodScale, false);
 
 
 	// Setup the rotation and translation of saturn rings
@@ -621,11 +1218,8 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixRotationAxis(saturnAxis, rotation * 0.1f));
 
-	// Render rings model
-	m_SaturnRingModel->Render(m_D3D->GetDeviceContext());
-	result = m_ShaderManager->RenderLightShader(m_D3D->GetDeviceContext(), m_SaturnRingModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix,
-		m_SaturnRingModel->GetTexture(), m_Light->GetDirection(), m_Light->GetAmbientColor(), m_Light->GetDiffuseColor(),
-		m_Camera->GetPosition(), m_Light->GetSpecularColor(), m_Light->GetSpecularPower());
+	// Submit rings model
+	SubmitModel(RENDER_OBJECT_SATURN_RING, m_SaturnRingModel, SHADER_LIGHT, worldMatrix, viewMatrix, projectionMatrix, lodScale, false);
 
 
 	// Setup the rotation and translation of the sun.
@@ -635,23 +1229,131 @@ bool GraphicsClass::Render(bool rocketTakeOff)
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixRotationY(-rotation));
 	worldMatrix = XMMatrixMultiply(worldMatrix, XMMatrixTranslation(0.0f, 0.0f, 50.0f));
 
+	// Submit the sun using the fire shader, it is blended so it goes in the pass after everything else.
+	SubmitModel(RENDER_OBJECT_SUN, m_SunModel, SHADER_FIRE, worldMatrix, viewMatrix, projectionMatrix, lodScale, true);
 
-	// Turn on alpha blending.
-	m_D3D->TurnOnAlphaBlending();
-	
-	m_SunModel->Render(m_D3D->GetDeviceContext());
 
-	// Render the sun using the fire shader.
-	result = m_ShaderManager->RenderFireShader(m_D3D->GetDeviceContext(), m_SunModel->GetIndexCount(), worldMatrix, viewMatrix, projectionMatrix,
-		m_SunModel->GetTexture1(), m_SunModel->GetTexture2(), m_SunModel->GetTexture3(), frameTime, scrollSpeeds,
-		scales, distortion1, distortion2, distortion3, distortionScale, distortionBias);
-	if (!result)
+	// Sort the queue and draw it.  A field of a key that matches the packet before is state already on the pipeline, so the blend
+	// state, the shader and the mesh buffers are only set where they change.
+	m_RenderQueue->Sort(m_queueStatistics);
+
+	deviceContext = m_D3D->GetDeviceContext();
+
+	// The view, projection, light and camera are the same for every draw, they go in the frame buffer once before the queue.
+	result = m_ShaderManager->SetFrameParameters(deviceContext, viewMatrix, projectionMatrix, m_Camera->GetPosition(), m_Light->GetDirection(),
+												 m_Light->GetAmbientColor(), m_Light->GetDiffuseColor(), m_Light->GetSpecularColor(),
+												 m_Light->GetSpecularPower());
+	if(!result)
 	{
 		return false;
 	}
 
+	// And the world matrices of every draw that is not instanced go in the constant ring together, with one map.
+	result = m_ShaderManager->UploadObjects(deviceContext);
+	if(!result)
+	{
+		return false;
+	}
+
+	pass = RENDER_PASS_OPAQUE;
+	shader = -1;
+	mesh = -1;
+
+	for(int i = 0; i < m_RenderQueue->GetPacketCount(); i++)
+	{
+		const RenderQueueClass::PacketType& packet = m_RenderQueue->GetPacket(i);
+		const RenderItemType& item = m_renderItems[packet.item];
+
+		// Turn on alpha blending for the blended pass.
+		if(RenderQueueClass::GetPass(packet.key) != pass)
+		{
+			pass = RenderQueueClass::GetPass(packet.key);
+			if(pass == RENDER_PASS_BLENDED)
+			{
+				m_D3D->TurnOnAlphaBlending();
+			}
+			else
+			{
+				m_D3D->TurnOffAlphaBlending();
+			}
+		}
+
+		if(RenderQueueClass::GetShader(packet.key) != shader)
+		{
+			shader = RenderQueueClass::GetShader(packet.key);
+			m_ShaderManager->SetShader(deviceContext, (ShaderType)shader);
+		}
+
+		if(RenderQueueClass::GetMesh(packet.key) != mesh)
+		{
+			mesh = RenderQueueClass::GetMesh(packet.key);
+			RenderMesh(mesh);
+		}
+
+		drawList = item.drawList;
+		if(item.object == RENDER_OBJECT_TREES)
+		{
+			drawList.ranges = &item.range;
+		}
+
+		switch(shader)
+		{
+			case SHADER_TEXTURE:
+			{
+				result = m_ShaderManager->RenderTextureShader(deviceContext, drawList, item.shaderObject, item.textures[0], item.slices[0]);
+				break;
+			}
+
+			case SHADER_LIGHT:
+			{
+				result = m_ShaderManager->RenderLightShader(deviceContext, drawList, item.shaderObject, item.textures[0], item.slices[0]);
+				break;
+			}
+
+			case SHADER_LIGHT_INSTANCED:
+			{
+				result = m_ShaderManager->RenderLightShaderInstanced(deviceContext, drawList, item.instanceCount, item.firstInstance, item.textures[0],
+																	 item.slices[0]);
+				break;
+			}
+
+			case SHADER_BUMP_MAP:
+			{
+				result = m_ShaderManager->RenderBumpMapShader(deviceContext, drawList, item.shaderObject, item.textures[0], item.slices[0], item.textures[1],
+															  item.slices[1]);
+				break;
+			}
+
+			case SHADER_FIRE:
+			{
+				result = m_ShaderManager->RenderFireShader(deviceContext, drawList, item.shaderObject, item.textures[0],
+														   item.slices[0], item.textures[1], item.slices[1], item.textures[2], item.slices[2], frameTime,
+														   scrollSpeeds, scales, distortion1, distortion2, distortion3, distortionScale, distortionBias);
+				break;
+			}
+
+			default:
+			{
+				result = false;
+				break;
+			}
+		}
+
+		if(!result)
+		{
+			return false;
+		}
+		CountDraw(item.indexCount, item.lod, item.instanceCount);
+	}
+
 	// Turn off alpha blending.
-	m_D3D->TurnOffAlphaBlending();
+	if(pass == RENDER_PASS_BLENDED)
+	{
+		m_D3D->TurnOffAlphaBlending();
+	}
+
+	// Fence the frame's part of the constant ring.
+	m_ShaderManager->EndFrame(deviceContext);
 
 
 	// Present the rendered scene to the screen.
@@ -15,9 +15,16 @@
 #include "positionclass.h"
 #include "cameraclass.h"
 #include "lightclass.h"
+#include "loadlogclass.h"
+#include "jobsystemclass.h"
+#include "assetarchiveclass.h"
+#include "meshregistryclass.h"
+#include "textureregistryclass.h"
 #include "modelclass.h"
 #include "bumpmodelclass.h"
 #include "firemodelclass.h"
+#include "instancebufferclass.h"
+#include "renderqueueclass.h"
 
 
 
@@ -29,12 +36,64 @@ const bool VSYNC_ENABLED = true;
 const float SCREEN_DEPTH = 1000.0f;
 const float SCREEN_NEAR = 0.1f;
 
+// The archive written by the asset cooker.  If it is not there the loose files in the data folder are loaded instead.
+const char ASSET_ARCHIVE_FILENAME[] = "../Engine/data/assets.pak";
+
+// Hash every texture as it loads so copies of one under different names are only created once.
+const bool TEXTURE_CONTENT_HASHING = true;
+
+// Bytes of texture memory the streamed mips are held to, zero creates every texture with its whole chain.  The lowest mips of
+// each texture, up to 64 x 64, are always resident.
+const long long TEXTURE_MEMORY_BUDGET = 32 * 1024 * 1024;
+const int TEXTURE_RESIDENT_MIPS = 7;
+
+// Frames the level of detail and cluster culling statistics are gathered over before they go to the load log.
+const int LOD_STATISTICS_FRAMES = 600;
+
+const int TREE_COUNT = 200;
+
+// Width of the square cells the trees are grouped into on the ground, each visible cell is one instanced draw.
+const float TREE_CELL_SIZE = 100.0f;
+
+// The things drawn each frame, the render queue uses these as the mesh of a draw.
+enum RenderObjectType
+{
+	RENDER_OBJECT_FLOOR,
+	RENDER_OBJECT_ROCKET,
+	RENDER_OBJECT_TREES,
+	RENDER_OBJECT_SATELLITE,
+	RENDER_OBJECT_EARTH,
+	RENDER_OBJECT_SATURN,
+	RENDER_OBJECT_SATURN_RING,
+	RENDER_OBJECT_SUN
+};
+
+// Textures a draw can take, as many as the model with the most.
+const int RENDER_ITEM_MAX_TEXTURES = 3;
+
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: GraphicsClass
 ////////////////////////////////////////////////////////////////////////////////
 class GraphicsClass
 {
+private:
+	// One draw in the render queue, with what its shader needs from the model.  The draw list of a cell of trees is
+	// copied into the range, the model's own is overwritten by the next cell.  A draw that is not instanced has its world
+	// matrix with the shader manager too, shaderObject is its index there and -1 for a cell of trees.
+	struct RenderItemType
+	{
+		int object;
+		XMFLOAT4X4 world;
+		int shaderObject;
+		DrawListType drawList;
+		DrawRangeType range;
+		int firstInstance, instanceCount;
+		ID3D11ShaderResourceView* textures[RENDER_ITEM_MAX_TEXTURES];
+		int slices[RENDER_ITEM_MAX_TEXTURES];
+		int indexCount, lod;
+	};
+
 public:
 	GraphicsClass();
 	GraphicsClass(const GraphicsClass&);
@@ -48,24 +107,47 @@ private:
 	//bool Render(float);
 	//Xu
 	bool HandleMovementInput(float, bool*);
+	bool InitializeTrees();
+	bool UpdateStreaming();
 	bool Render(bool);
+	template<class Model>
+	void SubmitModel(RenderObjectType, Model*, ShaderType, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, float, bool);
+	void SubmitDraw(const RenderItemType&, ShaderType, const XMMATRIX&, bool);
+	void RenderMesh(int);
+	void CountDraw(int, int, int = 1);
+	void WriteStatistics();
 
 private:
 	InputClass* m_Input;
 	D3DClass* m_D3D;
 	TimerClass* m_Timer;
 	ShaderManagerClass* m_ShaderManager;
+	RenderQueueClass* m_RenderQueue;
 	PositionClass* m_Position;
 	CameraClass* m_Camera;
 	LightClass* m_Light;
+	JobSystemClass* m_JobSystem;
+	AssetArchiveClass* m_AssetArchive;
+	MeshRegistryClass* m_MeshRegistry;
+	TextureRegistryClass* m_TextureRegistry;
 	ModelClass* m_FloorModel;
 	ModelClass* m_SatelliteModel;
 	ModelClass* m_RocketModel;
 	ModelClass* m_TreeModel;
+	InstanceBufferClass* m_TreeInstances;
 	ModelClass* m_SaturnModel;
 	ModelClass* m_SaturnRingModel;
 	BumpModelClass* m_EarthModel;
 	FireModelClass* m_SunModel;
+	bool m_firstFrame, m_streaming;
+	int m_streamingFrames;
+	double m_lastFrameTime, m_longestFrame;
+	int m_screenHeight;
+	int m_statisticsFrames, m_lodDraws[MESH_LOD_MAX_LEVELS];
+	long long m_lodTriangles[MESH_LOD_MAX_LEVELS];
+	ClusterCullerClass::StatisticsType m_clusterStatistics;
+	vector<RenderItemType> m_renderItems;
+	RenderQueueClass::StatisticsType m_queueStatistics;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: instancebufferclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "instancebufferclass.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+InstanceBufferClass::InstanceBufferClass()
+{
+	m_instanceBuffer = 0;
+	m_instanceCount = 0;
+	m_scale = 0.0f;
+}
+
+
+InstanceBufferClass::InstanceBufferClass(const InstanceBufferClass& other)
+{
+}
+
+
+InstanceBufferClass::~InstanceBufferClass()
+{
+}
+
+
+bool InstanceBufferClass::Initialize(ID3D11Device* device, const InstanceType* instances, int instanceCount, float cellSize)
+{
+	vector<InstanceType> sorted;
+	vector<int> cellIndices, cellStarts, cellMap;
+	D3D11_BUFFER_DESC instanceBufferDesc;
+	D3D11_SUBRESOURCE_DATA instanceData;
+	HRESULT result;
+	CellType cell;
+	XMVECTOR scale;
+	float minX, maxX, minZ, maxZ;
+	float minimum[3], maximum[3];
+	int columns, rows, column, row, i, j;
+
+
+	if(instanceCount < 1 || cellSize <= 0.0f)
+	{
+		return false;
+	}
+
+	// Find the extent of the instance origins on the ground plane, and the largest scale of any of them for the culling bounds.
+	minX = maxX = instances[0].world._41;
+	minZ = maxZ = instances[0].world._43;
+	m_scale = 0.0f;
+	for(i=0; i<instanceCount; i++)
+	{
+		minX = min(minX, instances[i].world._41);
+		maxX = max(maxX, instances[i].world._41);
+		minZ = min(minZ, instances[i].world._43);
+		maxZ = max(maxZ, instances[i].world._43);
+
+		scale = XMVectorMax(XMVector3LengthSq(XMVectorSet(instances[i].world._11, instances[i].world._12, instances[i].world._13, 0.0f)),
+							XMVectorMax(XMVector3LengthSq(XMVectorSet(instances[i].world._21, instances[i].world._22, instances[i].world._23, 0.0f)),
+										XMVector3LengthSq(XMVectorSet(instances[i].world._31, instances[i].world._32, instances[i].world._33, 0.0f))));
+		m_scale = max(m_scale, sqrtf(XMVectorGetX(scale)));
+	}
+
+	columns = max((int)ceilf((maxX - minX) / cellSize), 1);
+	rows = max((int)ceilf((maxZ - minZ) / cellSize), 1);
+
+	// Count the instances in each cell, then sort them into the buffer cell by cell so each cell is one range of it.
+	cellIndices.resize(instanceCount);
+	cellStarts.assign(columns * rows + 1, 0);
+	for(i=0; i<instanceCount; i++)
+	{
+		column = min((int)((instances[i].world._41 - minX) / cellSize), columns - 1);
+		row = min((int)((instances[i].world._43 - minZ) / cellSize), rows - 1);
+
+		cellIndices[i] = row * columns + column;
+		cellStarts[cellIndices[i] + 1]++;
+	}
+
+	for(i=0; i<columns * rows; i++)
+	{
+		cellStarts[i + 1] += cellStarts[i];
+	}
+
+	// Only the cells with instances in them are kept.
+	m_cells.clear();
+	cellMap.assign(columns * rows, -1);
+	for(i=0; i<columns * rows; i++)
+	{
+		if(cellStarts[i + 1] == cellStarts[i])
+		{
+			continue;
+		}
+
+		cell.firstInstance = cellStarts[i];
+		cell.instanceCount = 0;
+		cell.visible = false;
+		cell.lod = 0;
+
+		cellMap[i] = (int)m_cells.size();
+		m_cells.push_back(cell);
+	}
+
+	// Place each instance in its cell, keeping the order they came in within it.
+	sorted.resize(instanceCount);
+	for(i=0; i<instanceCount; i++)
+	{
+		CellType& target = m_cells[cellMap[cellIndices[i]]];
+
+		sorted[target.firstInstance + target.instanceCount] = instances[i];
+		target.instanceCount++;
+	}
+
+	// Put a sphere around the origins in each cell.
+	for(i=0; i<(int)m_cells.size(); i++)
+	{
+		CellType& target = m_cells[i];
+
+		for(j=0; j<3; j++)
+		{
+			minimum[j] = FLT_MAX;
+			maximum[j] = -FLT_MAX;
+		}
+
+		for(j=target.firstInstance; j<target.firstInstance + target.instanceCount; j++)
+		{
+			minimum[0] = min(minimum[0], sorted[j].world._41);
+			minimum[1] = min(minimum[1], sorted[j].world._42);
+			minimum[2] = min(minimum[2], sorted[j].world._43);
+			maximum[0] = max(maximum[0], sorted[j].world._41);
+			maximum[1] = max(maximum[1], sorted[j].world._42);
+			maximum[2] = max(maximum[2], sorted[j].world._43);
+		}
+
+		target.center = XMFLOAT3((minimum[0] + maximum[0]) * 0.5f, (minimum[1] + maximum[1]) * 0.5f, (minimum[2] + maximum[2]) * 0.5f);
+		target.radius = 0.5f * sqrtf((maximum[0] - minimum[0]) * (maximum[0] - minimum[0]) + (maximum[1] - minimum[1]) * (maximum[1] - minimum[1]) +
+									 (maximum[2] - minimum[2]) * (maximum[2] - minimum[2]));
+	}
+
+	// Set up the description of the instance buffer, it never changes so it can live where the GPU reads it fastest.
+	instanceBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	instanceBufferDesc.ByteWidth = sizeof(InstanceType) * instanceCount;
+	instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	instanceBufferDesc.CPUAccessFlags = 0;
+	instanceBufferDesc.MiscFlags = 0;
+	instanceBufferDesc.StructureByteStride = 0;
+
+	// Give the subresource structure a pointer to the sorted instances.
+	instanceData.pSysMem = &sorted[0];
+	instanceData.SysMemPitch = 0;
+	instanceData.SysMemSlicePitch = 0;
+
+	// Create the instance buffer.
+	result = device->CreateBuffer(&instanceBufferDesc, &instanceData, &m_instanceBuffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	m_instanceCount = instanceCount;
+
+	return true;
+}
+
+
+void InstanceBufferClass::Shutdown()
+{
+	// Release the instance buffer.
+	if(m_instanceBuffer)
+	{
+		m_instanceBuffer->Release();
+		m_instanceBuffer = 0;
+	}
+
+	m_cells.clear();
+	m_instanceCount = 0;
+
+	return;
+}
+
+
+void InstanceBufferClass::Render(StateCacheClass* stateCache)
+{
+	// Put the instances next to the mesh vertices, the model has bound those to slot 0.
+	stateCache->SetVertexBuffer(INSTANCE_BUFFER_SLOT, m_instanceBuffer, sizeof(InstanceType), 0);
+
+	return;
+}
+
+
+int InstanceBufferClass::Cull(const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix, float boundsRadius)
+{
+	ClusterCullerClass::FrustumType frustum;
+	XMFLOAT4X4 viewProjection;
+	float distance, radius;
+	int visibleCount, i, j;
+
+
+	// The cells are in world space, so the frustum is built from the view and projection alone.  They have no normal cones, so
+	// there is no camera.
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(viewMatrix, projectionMatrix));
+
+	ClusterCullerClass::BuildFrustum(&viewProjection._11, NULL, frustum);
+
+	// Each instance reaches the bounds of the model, around its origin, past the sphere of the cell.
+	visibleCount = 0;
+	for(i=0; i<(int)m_cells.size(); i++)
+	{
+		CellType& cell = m_cells[i];
+
+		radius = cell.radius + boundsRadius * m_scale;
+
+		cell.visible = true;
+		for(j=0; j<6 && cell.visible; j++)
+		{
+			distance = frustum.planes[j][0] * cell.center.x + frustum.planes[j][1] * cell.center.y + frustum.planes[j][2] * cell.center.z +
+					   frustum.planes[j][3];
+			if(distance < -radius)
+			{
+				cell.visible = false;
+			}
+		}
+
+		if(cell.visible)
+		{
+			visibleCount += cell.instanceCount;
+		}
+	}
+
+	return visibleCount;
+}
+
+
+int InstanceBufferClass::GetInstanceCount()
+{
+	return m_instanceCount;
+}
+
+
+int InstanceBufferClass::GetCellCount()
+{
+	return (int)m_cells.size();
+}
+
+
+InstanceBufferClass::CellType& InstanceBufferClass::GetCell(int index)
+{
+	return m_cells[index];
+}
+
+
+float InstanceBufferClass::GetScale()
+{
+	return m_scale;
+}
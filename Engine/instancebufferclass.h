@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: instancebufferclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _INSTANCEBUFFERCLASS_H_
+#define _INSTANCEBUFFERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include <vector>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "clustercullerclass.h"
+#include "statecacheclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The vertex buffer slot the instances are bound to, the mesh has slot 0.
+const int INSTANCE_BUFFER_SLOT = 1;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: InstanceBufferClass
+//
+// The world matrices of many copies of one static model, in a vertex buffer
+// the instanced shaders read one matrix from per instance.  The buffer is
+// built once and never written again.
+//
+// The instances are sorted into a grid of cells on the ground plane so each
+// cell is a range of the buffer.  Cull tests the cells rather than the
+// instances against the frustum and the caller picks a level of detail per
+// cell, so the work done each frame depends on the number of cells and not
+// on how many instances they hold.
+////////////////////////////////////////////////////////////////////////////////
+class InstanceBufferClass
+{
+public:
+	struct InstanceType
+	{
+		XMFLOAT4X4 world;
+	};
+
+	// A range of the buffer and a sphere around the origins of its instances.  The level of detail is the caller's, kept here so
+	// each cell has its own from one frame to the next.
+	struct CellType
+	{
+		int firstInstance;
+		int instanceCount;
+		XMFLOAT3 center;
+		float radius;
+		bool visible;
+		int lod;
+	};
+
+public:
+	InstanceBufferClass();
+	InstanceBufferClass(const InstanceBufferClass&);
+	~InstanceBufferClass();
+
+	bool Initialize(ID3D11Device*, const InstanceType*, int, float);
+	void Shutdown();
+	void Render(StateCacheClass*);
+
+	int Cull(const XMMATRIX&, const XMMATRIX&, float);
+
+	int GetInstanceCount();
+	int GetCellCount();
+	CellType& GetCell(int);
+	float GetScale();
+
+private:
+	ID3D11Buffer* m_instanceBuffer;
+	int m_instanceCount;
+	vector<CellType> m_cells;
+	float m_scale;
+};
+
+#endif
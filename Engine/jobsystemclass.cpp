@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "jobsystemclass.h"
+#include "loadlogclass.h"
+
+
+thread_local bool JobSystemClass::m_inJob = false;
+
+
+JobSystemClass::JobSystemClass()
+{
+	m_activeCount = 0;
+	m_jobCount = 0;
+	m_jobDelay = 0;
+	m_busyTime = 0.0;
+	m_quit = false;
+}
+
+
+JobSystemClass::JobSystemClass(const JobSystemClass& other)
+{
+}
+
+
+JobSystemClass::~JobSystemClass()
+{
+}
+
+
+bool JobSystemClass::Initialize(int workerCount, int jobDelay)
+{
+	int i;
+
+
+	// By default use every core but the one the main thread runs on, the main thread joins in while it waits.
+	if(workerCount <= 0)
+	{
+		workerCount = (int)thread::hardware_concurrency() - 1;
+	}
+	if(workerCount < 1)
+	{
+		workerCount = 1;
+	}
+	if(workerCount > JOB_SYSTEM_MAX_WORKERS)
+	{
+		workerCount = JOB_SYSTEM_MAX_WORKERS;
+	}
+
+	m_quit = false;
+
+	// A delay in front of every job stands in for slow storage when testing streaming.
+	m_jobDelay = jobDelay;
+
+	// Start the worker threads, thread 0 in the log is always the main thread.
+	for(i=0; i<workerCount; i++)
+	{
+		m_workers.push_back(thread(WorkerThread, this, i + 1));
+	}
+
+	LoadLogClass::Write("jobs: started %d worker threads, %d ms injected delay per job", workerCount, m_jobDelay);
+
+	return true;
+}
+
+
+void JobSystemClass::Shutdown()
+{
+	size_t i;
+
+
+	// Finish anything still queued before the workers are stopped.
+	Wait();
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_jobAvailable.notify_all();
+
+	for(i=0; i<m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+
+	LoadLogClass::Write("jobs: %d jobs ran for %.3f ms of thread time", m_jobCount, m_busyTime);
+
+	return;
+}
+
+
+void JobSystemClass::Submit(const string& name, const function<void()>& work)
+{
+	JobType job;
+
+
+	job.work = work;
+	job.name = name;
+	job.queueTime = LoadLogClass::GetTime();
+
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_jobs.push_back(job);
+	}
+	m_jobAvailable.notify_one();
+
+	return;
+}
+
+
+void JobSystemClass::Wait()
+{
+	unique_lock<mutex> lock(m_mutex);
+
+
+	// Help out with the queued jobs, then wait for the ones still running on the workers, they may queue more.
+	while(!m_jobs.empty() || m_activeCount > 0)
+	{
+		if(!m_jobs.empty())
+		{
+			RunJob(lock, 0);
+		}
+		else
+		{
+			m_jobsDone.wait(lock);
+		}
+	}
+
+	return;
+}
+
+
+int JobSystemClass::GetThreadCount()
+{
+	// The workers plus the main thread while it waits.
+	return (int)m_workers.size() + 1;
+}
+
+
+bool JobSystemClass::InJob()
+{
+	return m_inJob;
+}
+
+
+void JobSystemClass::WorkerThread(JobSystemClass* jobSystem, int threadIndex)
+{
+	unique_lock<mutex> lock(jobSystem->m_mutex);
+
+
+	while(true)
+	{
+		jobSystem->m_jobAvailable.wait(lock, [jobSystem]() { return jobSystem->m_quit || !jobSystem->m_jobs.empty(); });
+		if(jobSystem->m_jobs.empty())
+		{
+			break;
+		}
+
+		jobSystem->RunJob(lock, threadIndex);
+	}
+
+	return;
+}
+
+
+void JobSystemClass::RunJob(unique_lock<mutex>& lock, int threadIndex)
+{
+	JobType job;
+	double startTime, endTime;
+
+
+	// Take the oldest job and run it without holding the lock.
+	job = m_jobs.front();
+	m_jobs.pop_front();
+	m_activeCount++;
+
+	lock.unlock();
+
+	if(m_jobDelay > 0)
+	{
+		this_thread::sleep_for(chrono::milliseconds(m_jobDelay));
+	}
+
+	// Mark the thread as inside a job while it runs, the main thread is too while Wait has it run one.
+	m_inJob = true;
+
+	startTime = LoadLogClass::GetTime();
+	job.work();
+	endTime = LoadLogClass::GetTime();
+
+	m_inJob = false;
+
+	// One line per job makes the load log a timeline of which asset loaded when and where.
+	LoadLogClass::Write("job %s: thread %d, queued %.3f ms, ran %.3f - %.3f ms", job.name.c_str(), threadIndex, job.queueTime,
+						startTime, endTime);
+
+	lock.lock();
+
+	m_activeCount--;
+	m_jobCount++;
+	m_busyTime += endTime - startTime;
+
+	if(m_jobs.empty() && m_activeCount == 0)
+	{
+		m_jobsDone.notify_all();
+	}
+
+	return;
+}
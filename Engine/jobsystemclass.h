@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _JOBSYSTEMCLASS_H_
+#define _JOBSYSTEMCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int JOB_SYSTEM_MAX_WORKERS = 63;
+
+// Where a streamed asset is, written by the loader job and read by the frame loop.
+enum LoadStateType
+{
+	LOAD_STATE_PENDING,		// queued or loading
+	LOAD_STATE_READY,		// CPU side done, waiting for its GPU resources
+	LOAD_STATE_RESIDENT,	// swapped in
+	LOAD_STATE_FAILED
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: JobSystemClass
+//
+// A pool of worker threads for the CPU side of asset loading.  Jobs may submit
+// further jobs, and Wait runs jobs on the calling thread until the queue has
+// drained, so the main thread works too instead of sitting idle.
+//
+// InJob tells code that may run either way whether it is inside a job, so it
+// can stay on its thread instead of starting threads of its own beside the
+// pool.
+////////////////////////////////////////////////////////////////////////////////
+class JobSystemClass
+{
+private:
+	struct JobType
+	{
+		function<void()> work;
+		string name;
+		double queueTime;
+	};
+
+public:
+	JobSystemClass();
+	JobSystemClass(const JobSystemClass&);
+	~JobSystemClass();
+
+	bool Initialize(int, int);
+	void Shutdown();
+
+	void Submit(const string&, const function<void()>&);
+	void Wait();
+
+	int GetThreadCount();
+
+	static bool InJob();
+
+private:
+	static void WorkerThread(JobSystemClass*, int);
+	void RunJob(unique_lock<mutex>&, int);
+
+private:
+	vector<thread> m_workers;
+	deque<JobType> m_jobs;
+	mutex m_mutex;
+	condition_variable m_jobAvailable, m_jobsDone;
+	int m_activeCount, m_jobCount, m_jobDelay;
+	double m_busyTime;
+	bool m_quit;
+
+	static thread_local bool m_inJob;
+};
+
+#endif
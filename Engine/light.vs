@@ -6,18 +6,11 @@
 /////////////
 // GLOBALS //
 /////////////
-cbuffer MatrixBuffer
-{
-	matrix worldMatrix;
-	matrix viewMatrix;
-	matrix projectionMatrix;
-};
+#include "constantbuffers.hlsli"
 
-cbuffer CameraBuffer
-{
-    float3 cameraPosition;
-	float padding;
-};
+#ifdef COMPRESSED_VERTICES
+#include "vertexcompression.hlsli"
+#endif
 
 
 //////////////
@@ -27,7 +20,17 @@ struct VertexInputType
 {
     float4 position : POSITION;
     float2 tex : TEXCOORD0;
+#ifdef COMPRESSED_VERTICES
+	float2 normal : NORMAL;
+#else
 	float3 normal : NORMAL;
+#endif
+#ifdef INSTANCED
+	float4 world0 : WORLD0;
+	float4 world1 : WORLD1;
+	float4 world2 : WORLD2;
+	float4 world3 : WORLD3;
+#endif
 };
 
 struct PixelInputType
@@ -46,27 +49,43 @@ PixelInputType LightVertexShader(VertexInputType input)
 {
     PixelInputType output;
 	float4 worldPosition;
+	float4x4 world;
+
 
+#ifdef COMPRESSED_VERTICES
+	// Expand the quantized position back out to model space.
+	input.position.xyz = DecodePosition(input.position);
+#endif
 
 	// Change the position vector to be 4 units for proper matrix calculations.
     input.position.w = 1.0f;
 
-	// Calculate the position of the vertex against the world, view, and projection matrices.
-    output.position = mul(input.position, worldMatrix);
-    output.position = mul(output.position, viewMatrix);
-    output.position = mul(output.position, projectionMatrix);
+#ifdef INSTANCED
+	// Each instance brings its own world matrix, the one in the object buffer is not used.
+	world = float4x4(input.world0, input.world1, input.world2, input.world3);
+#else
+	world = worldMatrix;
+#endif
+
+	// Calculate the position of the vertex against the world matrix and the view and projection matrices multiplied together.
+    output.position = mul(input.position, world);
+    output.position = mul(output.position, viewProjectionMatrix);
     
 	// Store the texture coordinates for the pixel shader.
 	output.tex = input.tex;
     
 	// Calculate the normal vector against the world matrix only.
-    output.normal = mul(input.normal, (float3x3)worldMatrix);
+#ifdef COMPRESSED_VERTICES
+    output.normal = mul(DecodeOctahedral(input.normal), (float3x3)world);
+#else
+    output.normal = mul(input.normal, (float3x3)world);
+#endif
 	
     // Normalize the normal vector.
     output.normal = normalize(output.normal);
 
 	// Calculate the position of the vertex in the world.
-    worldPosition = mul(input.position, worldMatrix);
+    worldPosition = mul(input.position, world);
 
     // Determine the viewing direction based on the position of the camera and the position of the vertex in the world.
     output.viewDirection = cameraPosition.xyz - worldPosition.xyz;
@@ -3,16 +3,20 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "lightshaderclass.h"
 
+#include <cstring>
+
 
 LightShaderClass::LightShaderClass()
 {
+	m_StateCache = 0;
 	m_vertexShader = 0;
 	m_pixelShader = 0;
 	m_layout = 0;
+	m_instancedVertexShader = 0;
+	m_instancedLayout = 0;
 	m_sampleState = 0;
-	m_matrixBuffer = 0;
-	m_cameraBuffer = 0;
-	m_lightBuffer = 0;
+	m_materialBuffer = 0;
+	m_materialWritten = false;
 }
 
 
@@ -26,11 +30,14 @@ LightShaderClass::~LightShaderClass()
 }
 
 
-bool LightShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool LightShaderClass::Initialize(ID3D11Device* device, HWND hwnd, StateCacheClass* stateCache)
 {
 	bool result;
 
 
+	// Everything the shader binds goes through the state cache, so what is bound already is not set again.
+	m_StateCache = stateCache;
+
 	// Initialize the vertex and pixel shaders.
 	result = InitializeShader(device, hwnd, L"../Engine/light.vs", L"../Engine/light.ps");
 	if(!result)
@@ -38,6 +45,13 @@ bool LightShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
 		return false;
 	}
 
+	// Initialize the vertex shader that reads the world matrices from an instance buffer.
+	result = InitializeInstancedShader(device, hwnd, L"../Engine/light.vs");
+	if(!result)
+	{
+		return false;
+	}
+
 	return true;
 }
 
@@ -51,23 +65,40 @@ void LightShaderClass::Shutdown()
 }
 
 
-bool LightShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix,
-	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, XMFLOAT3 lightDirection, XMFLOAT4 ambientColor,
-	XMFLOAT4 diffuseColor, XMFLOAT3 cameraPosition, XMFLOAT4 specularColor, float specularPower)
+bool LightShaderClass::Render(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, ID3D11ShaderResourceView* texture, int textureSlice)
 {
 	bool result;
 
 
 	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, texture, lightDirection, ambientColor, diffuseColor, 
-								 cameraPosition, specularColor, specularPower);
+	result = SetShaderParameters(deviceContext, texture, textureSlice);
 	if(!result)
 	{
 		return false;
 	}
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(deviceContext, drawList);
+
+	return true;
+}
+
+
+bool LightShaderClass::RenderInstanced(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int instanceCount, int firstInstance,
+	ID3D11ShaderResourceView* texture, int textureSlice)
+{
+	bool result;
+
+
+	// Set the shader parameters once for every instance, the world matrix in the object buffer is not used.
+	result = SetShaderParameters(deviceContext, texture, textureSlice);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Now render the range of instances with the shader.
+	RenderInstancedShader(deviceContext, drawList, instanceCount, firstInstance);
 
 	return true;
 }
@@ -80,11 +111,10 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	ID3D10Blob* vertexShaderBuffer;
 	ID3D10Blob* pixelShaderBuffer;
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[3];
+	D3D_SHADER_MACRO defines[2];
 	unsigned int numElements;
     D3D11_SAMPLER_DESC samplerDesc;
-	D3D11_BUFFER_DESC matrixBufferDesc;
-	D3D11_BUFFER_DESC cameraBufferDesc;
-	D3D11_BUFFER_DESC lightBufferDesc;
+	D3D11_BUFFER_DESC materialBufferDesc;
 
 
 	// Initialize the pointers this function will use to null.
@@ -92,9 +122,15 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	vertexShaderBuffer = 0;
 	pixelShaderBuffer = 0;
 
+	// Build the vertex shader for the packed vertex formats when vertex compression is on.
+	defines[0].Name = "COMPRESSED_VERTICES";
+	defines[0].Definition = "1";
+	defines[1].Name = NULL;
+	defines[1].Definition = NULL;
+
     // Compile the vertex shader code.
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "LightVertexShader", "vs_5_0",
-		D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
+	result = D3DCompileFromFile(vsFilename, VERTEX_COMPRESSION_ENABLED ? defines : NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 	if(FAILED(result))
 	{
 		// If the shader failed to compile it should have writen something to the error message.
@@ -112,7 +148,7 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	}
 
     // Compile the pixel shader code.
-	result = D3DCompileFromFile(psFilename, NULL, NULL, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
+	result = D3DCompileFromFile(psFilename, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "LightPixelShader", "ps_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &pixelShaderBuffer, &errorMessage);
 
 	if(FAILED(result))
 	{
@@ -145,10 +181,10 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 	}
 
 	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
+	// This setup needs to match the vertex layout in vertexlayouts.h and in the shader.
 	polygonLayout[0].SemanticName = "POSITION";
 	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[0].InputSlot = 0;
 	polygonLayout[0].AlignedByteOffset = 0;
 	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -156,7 +192,7 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 
 	polygonLayout[1].SemanticName = "TEXCOORD";
 	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
 	polygonLayout[1].InputSlot = 0;
 	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -164,7 +200,7 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 
 	polygonLayout[2].SemanticName = "NORMAL";
 	polygonLayout[2].SemanticIndex = 0;
-	polygonLayout[2].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[2].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[2].InputSlot = 0;
 	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -210,78 +246,147 @@ bool LightShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR*
 		return false;
 	}
 
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-    matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-    matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
+	// Setup the description of the dynamic material constant buffer that is in the pixel shader.
+	// Note that ByteWidth always needs to be a multiple of 16 if using D3D11_BIND_CONSTANT_BUFFER or CreateBuffer will fail.
+	materialBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	materialBufferDesc.ByteWidth = sizeof(MaterialBufferType);
+	materialBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	materialBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	materialBufferDesc.MiscFlags = 0;
+	materialBufferDesc.StructureByteStride = 0;
+
+	// Create the constant buffer pointer so we can access the pixel shader constant buffer from within this class.
+	result = device->CreateBuffer(&materialBufferDesc, NULL, &m_materialBuffer);
 	if(FAILED(result))
 	{
 		return false;
 	}
 
-	// Setup the description of the camera dynamic constant buffer that is in the vertex shader.
-	cameraBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	cameraBufferDesc.ByteWidth = sizeof(CameraBufferType);
-	cameraBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	cameraBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	cameraBufferDesc.MiscFlags = 0;
-	cameraBufferDesc.StructureByteStride = 0;
+	return true;
+}
+
+
+bool LightShaderClass::InitializeInstancedShader(ID3D11Device* device, HWND hwnd, WCHAR* vsFilename)
+{
+	HRESULT result;
+	ID3D10Blob* errorMessage;
+	ID3D10Blob* vertexShaderBuffer;
+	D3D11_INPUT_ELEMENT_DESC polygonLayout[7];
+	D3D_SHADER_MACRO defines[3];
+	unsigned int numElements;
+	int i;
+
 
-	// Create the camera constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&cameraBufferDesc, NULL, &m_cameraBuffer);
+	// Initialize the pointers this function will use to null.
+	errorMessage = 0;
+	vertexShaderBuffer = 0;
+
+	// Build the same vertex shader with the world matrix taken from the instance, and for the packed vertex formats when vertex
+	// compression is on.
+	i = 0;
+	defines[i].Name = "INSTANCED";
+	defines[i].Definition = "1";
+	i++;
+	if(VERTEX_COMPRESSION_ENABLED)
+	{
+		defines[i].Name = "COMPRESSED_VERTICES";
+		defines[i].Definition = "1";
+		i++;
+	}
+	defines[i].Name = NULL;
+	defines[i].Definition = NULL;
+
+    // Compile the vertex shader code.
+	result = D3DCompileFromFile(vsFilename, defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, "LightVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0,
+								&vertexShaderBuffer, &errorMessage);
 	if(FAILED(result))
 	{
+		// If the shader failed to compile it should have writen something to the error message.
+		if(errorMessage)
+		{
+			OutputShaderErrorMessage(errorMessage, hwnd, vsFilename);
+		}
+		// If there was nothing in the error message then it simply could not find the shader file itself.
+		else
+		{
+			MessageBox(hwnd, vsFilename, L"Missing Shader File", MB_OK);
+		}
+
 		return false;
 	}
 
-	// Setup the description of the light dynamic constant buffer that is in the pixel shader.
-	// Note that ByteWidth always needs to be a multiple of 16 if using D3D11_BIND_CONSTANT_BUFFER or CreateBuffer will fail.
-	lightBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	lightBufferDesc.ByteWidth = sizeof(LightBufferType);
-	lightBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	lightBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	lightBufferDesc.MiscFlags = 0;
-	lightBufferDesc.StructureByteStride = 0;
-
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&lightBufferDesc, NULL, &m_lightBuffer);
+    // Create the vertex shader from the buffer.
+    result = device->CreateVertexShader(vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(), NULL, &m_instancedVertexShader);
 	if(FAILED(result))
 	{
 		return false;
 	}
 
-	return true;
-}
+	// The vertex elements are the same as in the layout of the plain shader.
+	polygonLayout[0].SemanticName = "POSITION";
+	polygonLayout[0].SemanticIndex = 0;
+	polygonLayout[0].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].InputSlot = 0;
+	polygonLayout[0].AlignedByteOffset = 0;
+	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	polygonLayout[0].InstanceDataStepRate = 0;
 
+	polygonLayout[1].SemanticName = "TEXCOORD";
+	polygonLayout[1].SemanticIndex = 0;
+	polygonLayout[1].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].InputSlot = 0;
+	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	polygonLayout[1].InstanceDataStepRate = 0;
 
-void LightShaderClass::ShutdownShader()
-{
-	// Release the light constant buffer.
-	if(m_lightBuffer)
+	polygonLayout[2].SemanticName = "NORMAL";
+	polygonLayout[2].SemanticIndex = 0;
+	polygonLayout[2].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[2].InputSlot = 0;
+	polygonLayout[2].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
+	polygonLayout[2].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+	polygonLayout[2].InstanceDataStepRate = 0;
+
+	// The four rows of the world matrix step once per instance, from the instance buffer.
+	for(i=0; i<4; i++)
 	{
-		m_lightBuffer->Release();
-		m_lightBuffer = 0;
+		polygonLayout[3 + i].SemanticName = "WORLD";
+		polygonLayout[3 + i].SemanticIndex = i;
+		polygonLayout[3 + i].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+		polygonLayout[3 + i].InputSlot = INSTANCE_BUFFER_SLOT;
+		polygonLayout[3 + i].AlignedByteOffset = i * 16;
+		polygonLayout[3 + i].InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+		polygonLayout[3 + i].InstanceDataStepRate = 1;
 	}
 
-	// Release the camera constant buffer.
-	if(m_cameraBuffer)
+	// Get a count of the elements in the layout.
+    numElements = sizeof(polygonLayout) / sizeof(polygonLayout[0]);
+
+	// Create the instanced vertex input layout.
+	result = device->CreateInputLayout(polygonLayout, numElements, vertexShaderBuffer->GetBufferPointer(), vertexShaderBuffer->GetBufferSize(),
+		                               &m_instancedLayout);
+	if(FAILED(result))
 	{
-		m_cameraBuffer->Release();
-		m_cameraBuffer = 0;
+		return false;
 	}
 
-	// Release the matrix constant buffer.
-	if(m_matrixBuffer)
+	// Release the vertex shader buffer since it is no longer needed.
+	vertexShaderBuffer->Release();
+	vertexShaderBuffer = 0;
+
+	return true;
+}
+
+
+void LightShaderClass::ShutdownShader()
+{
+	// Release the material constant buffer.
+	if(m_materialBuffer)
 	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = 0;
+		m_materialBuffer->Release();
+		m_materialBuffer = 0;
 	}
+	m_materialWritten = false;
 
 	// Release the sampler state.
 	if(m_sampleState)
@@ -290,6 +395,19 @@ void LightShaderClass::ShutdownShader()
 		m_sampleState = 0;
 	}
 
+	// Release the instanced layout and vertex shader.
+	if(m_instancedLayout)
+	{
+		m_instancedLayout->Release();
+		m_instancedLayout = 0;
+	}
+
+	if(m_instancedVertexShader)
+	{
+		m_instancedVertexShader->Release();
+		m_instancedVertexShader = 0;
+	}
+
 	// Release the layout.
 	if(m_layout)
 	{
@@ -351,115 +469,105 @@ void LightShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND h
 }
 
 
-bool LightShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix,
-	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture, XMFLOAT3 lightDirection,
-	XMFLOAT4 ambientColor, XMFLOAT4 diffuseColor, XMFLOAT3 cameraPosition, XMFLOAT4 specularColor,
-										   float specularPower)
+bool LightShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* texture, int textureSlice)
 {
 	HRESULT result;
     D3D11_MAPPED_SUBRESOURCE mappedResource;
-	unsigned int bufferNumber;
-	MatrixBufferType* dataPtr;
-	LightBufferType* dataPtr2;
-	CameraBufferType* dataPtr3;
+	MaterialBufferType material;
 
 
-	// Transpose the matrices to prepare them for the shader.
+	// The matrices, light and camera are in the frame and object buffers, only the slice of the texture array to sample is left
+	// for this one.
+	material.textureSlice = (float)textureSlice;
+	material.padding = XMFLOAT3(0.0f, 0.0f, 0.0f);
 
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	// Only upload the material when it differs from the last one written, draws of the same texture keep what is there.
+	if(!m_materialWritten || memcmp(&material, &m_material, sizeof(material)) != 0)
 	{
-		return false;
+		// Lock the material constant buffer so it can be written to.
+		result = deviceContext->Map(m_materialBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		if(FAILED(result))
+		{
+			return false;
+		}
+
+		// Copy the material into the constant buffer.
+		memcpy(mappedResource.pData, &material, sizeof(material));
+
+		// Unlock the constant buffer.
+		deviceContext->Unmap(m_materialBuffer, 0);
+
+		m_material = material;
+		m_materialWritten = true;
 	}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
+	// Set the material constant buffer in the pixel shader.
+	m_StateCache->SetPixelConstantBuffers(MATERIAL_BUFFER_SLOT, 1, &m_materialBuffer);
 
-	// Copy the matrices into the constant buffer.
-	dataPtr->world = XMMatrixTranspose(worldMatrix);
-	dataPtr->view = XMMatrixTranspose(viewMatrix);
-	dataPtr->projection = XMMatrixTranspose(projectionMatrix);
+	// Set shader texture resource in the pixel shader.
+	m_StateCache->SetPixelShaderResources(0, 1, &texture);
 
-	// Unlock the constant buffer.
-    deviceContext->Unmap(m_matrixBuffer, 0);
+	return true;
+}
 
-	// Set the position of the constant buffer in the vertex shader.
-	bufferNumber = 0;
 
-	// Now set the constant buffer in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
+void LightShaderClass::SetShader(ID3D11DeviceContext* deviceContext)
+{
+	// Set the vertex input layout.
+	m_StateCache->SetInputLayout(m_layout);
 
-	// Lock the camera constant buffer so it can be written to.
-	result = deviceContext->Map(m_cameraBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
-	{
-		return false;
-	}
+    // Set the vertex and pixel shaders that will be used to render this triangle.
+    m_StateCache->SetVertexShader(m_vertexShader);
+    m_StateCache->SetPixelShader(m_pixelShader);
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr3 = (CameraBufferType*)mappedResource.pData;
+	// Set the sampler state in the pixel shader.
+	m_StateCache->SetPixelSamplers(0, 1, &m_sampleState);
 
-	// Copy the camera position into the constant buffer.
-	dataPtr3->cameraPosition = cameraPosition;
-	dataPtr3->padding = 0.0f;
+	return;
+}
 
-	// Unlock the camera constant buffer.
-	deviceContext->Unmap(m_cameraBuffer, 0);
 
-	// Set the position of the camera constant buffer in the vertex shader.
-	bufferNumber = 1;
+void LightShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList)
+{
+	int i;
 
-	// Now set the camera constant buffer in the vertex shader with the updated values.
-	deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_cameraBuffer);
-	
-	// Set shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
 
-	// Lock the light constant buffer so it can be written to.
-	result = deviceContext->Map(m_lightBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	// Render the triangles, one draw for each range of the model that survived culling.
+	for(i=0; i<drawList.rangeCount; i++)
 	{
-		return false;
+		deviceContext->DrawIndexed(drawList.ranges[i].indexCount, drawList.ranges[i].firstIndex, 0);
 	}
 
-	// Get a pointer to the data in the light constant buffer.
-	dataPtr2 = (LightBufferType*)mappedResource.pData;
+	return;
+}
 
-	// Copy the lighting variables into the light constant buffer.
-	dataPtr2->ambientColor = ambientColor;
-	dataPtr2->diffuseColor = diffuseColor;
-	dataPtr2->lightDirection = lightDirection;
-	dataPtr2->specularColor = specularColor;
-	dataPtr2->specularPower = specularPower;
-	
-	// Unlock the light constant buffer.
-	deviceContext->Unmap(m_lightBuffer, 0);
 
-	// Set the position of the light constant buffer in the pixel shader.
-	bufferNumber = 0;
+void LightShaderClass::SetInstancedShader(ID3D11DeviceContext* deviceContext)
+{
+	// Set the instanced vertex input layout.
+	m_StateCache->SetInputLayout(m_instancedLayout);
 
-	// Finally set the light constant buffer in the pixel shader with the updated values.
-	deviceContext->PSSetConstantBuffers(bufferNumber, 1, &m_lightBuffer);
+    // Set the instanced vertex shader and the same pixel shader.
+    m_StateCache->SetVertexShader(m_instancedVertexShader);
+    m_StateCache->SetPixelShader(m_pixelShader);
 
-	return true;
+	// Set the sampler state in the pixel shader.
+	m_StateCache->SetPixelSamplers(0, 1, &m_sampleState);
+
+	return;
 }
 
 
-void LightShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+void LightShaderClass::RenderInstancedShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int instanceCount, int firstInstance)
 {
-	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout);
-
-    // Set the vertex and pixel shaders that will be used to render this triangle.
-    deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-    deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+	int i;
 
-	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
 
-	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	// Render every instance in the range with one draw for each range of the model.
+	for(i=0; i<drawList.rangeCount; i++)
+	{
+		deviceContext->DrawIndexedInstanced(drawList.ranges[i].indexCount, instanceCount, drawList.ranges[i].firstIndex, 0, firstInstance);
+	}
 
 	return;
 }
\ No newline at end of file
@@ -17,32 +17,38 @@ using namespace DirectX;
 using namespace std;
 
 
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "vertexcompressionclass.h"
+#include "drawlist.h"
+#include "statecacheclass.h"
+#include "instancebufferclass.h"
+#include "constantbuffers.h"
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: LightShaderClass
+//
+// RenderInstanced draws a range of an instance buffer with one call per draw
+// range.  Its vertex shader is light.vs built with INSTANCED, which takes the
+// world matrix from the instance rather than the object buffer.
+//
+// The matrices, light and camera come from the frame and object buffers
+// ShaderManagerClass has bound, the texture slice is all the shader keeps in
+// its own material buffer.
+//
+// Neither draw puts the shaders on the pipeline, SetShader does that for
+// Render and SetInstancedShader for RenderInstanced, so a run of draws with
+// the same shader only sets it once.
 ////////////////////////////////////////////////////////////////////////////////
 class LightShaderClass
 {
 private:
-	struct MatrixBufferType
-	{
-		XMMATRIX  world;
-		XMMATRIX  view;
-		XMMATRIX  projection;
-	};
-
-	struct CameraBufferType
-	{
-		XMFLOAT3  cameraPosition;
-		float padding;
-	};
-
-	struct LightBufferType
+	struct MaterialBufferType
 	{
-		XMFLOAT4  ambientColor;
-		XMFLOAT4  diffuseColor;
-		XMFLOAT3  lightDirection;
-		float specularPower;
-		XMFLOAT4  specularColor;
+		float textureSlice;
+		XMFLOAT3 padding;
 	};
 
 public:
@@ -50,28 +56,34 @@ public:
 	LightShaderClass(const LightShaderClass&);
 	~LightShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(ID3D11Device*, HWND, StateCacheClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4, XMFLOAT4,
-		XMFLOAT3, XMFLOAT4, float);
+	bool Render(ID3D11DeviceContext*, const DrawListType&, ID3D11ShaderResourceView*, int);
+	bool RenderInstanced(ID3D11DeviceContext*, const DrawListType&, int, int, ID3D11ShaderResourceView*, int);
+	void SetShader(ID3D11DeviceContext*);
+	void SetInstancedShader(ID3D11DeviceContext*);
 
 private:
 	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
+	bool InitializeInstancedShader(ID3D11Device*, HWND, WCHAR*);
 	void ShutdownShader();
 	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4, XMFLOAT4,
-		XMFLOAT3, XMFLOAT4, float);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(ID3D11DeviceContext*, ID3D11ShaderResourceView*, int);
+	void RenderShader(ID3D11DeviceContext*, const DrawListType&);
+	void RenderInstancedShader(ID3D11DeviceContext*, const DrawListType&, int, int);
 
 private:
 	ID3D11VertexShader* m_vertexShader;
 	ID3D11PixelShader* m_pixelShader;
 	ID3D11InputLayout* m_layout;
+	ID3D11VertexShader* m_instancedVertexShader;
+	ID3D11InputLayout* m_instancedLayout;
 	ID3D11SamplerState* m_sampleState;
-	ID3D11Buffer* m_matrixBuffer;
-	ID3D11Buffer* m_cameraBuffer;
-	ID3D11Buffer* m_lightBuffer;
+	ID3D11Buffer* m_materialBuffer;
+	MaterialBufferType m_material;
+	bool m_materialWritten;
+	StateCacheClass* m_StateCache;
 };
 
 #endif
\ No newline at end of file
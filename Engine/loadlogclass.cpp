@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: loadlogclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "loadlogclass.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+
+mutex LoadLogClass::m_mutex;
+ofstream LoadLogClass::m_file;
+chrono::steady_clock::time_point LoadLogClass::m_startTime = chrono::steady_clock::now();
+
+
+void LoadLogClass::Write(const char* format, ...)
+{
+	char message[512];
+	va_list args;
+
+
+	// Format the message before taking the lock so the workers only contend on the file write.
+	va_start(args, format);
+	vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	lock_guard<mutex> lock(m_mutex);
+
+	// Open the log file the first time something is written to it this run.
+	if(!m_file.is_open())
+	{
+		m_file.open("load-log.txt");
+		if(m_file.fail())
+		{
+			return;
+		}
+	}
+
+	// Prefix each line with the time since startup so the log doubles as a load timeline.
+	m_file.setf(ios::fixed);
+	m_file.precision(3);
+	m_file << "[" << GetTime() << " ms] " << message << endl;
+
+	return;
+}
+
+
+double LoadLogClass::GetTime()
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - m_startTime).count();
+}
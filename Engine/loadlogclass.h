@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: loadlogclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _LOADLOGCLASS_H_
+#define _LOADLOGCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <chrono>
+#include <mutex>
+#include <fstream>
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: LoadLogClass
+////////////////////////////////////////////////////////////////////////////////
+class LoadLogClass
+{
+public:
+	static void Write(const char*, ...);
+
+	static double GetTime();
+
+private:
+	static mutex m_mutex;
+	static ofstream m_file;
+	static chrono::steady_clock::time_point m_startTime;
+};
+
+#endif
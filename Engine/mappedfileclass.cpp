@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "mappedfileclass.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <filesystem>
+#endif
+
+
+MappedFileClass::MappedFileClass()
+{
+	m_data = 0;
+	m_size = 0;
+#ifdef _WIN32
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = 0;
+#else
+	m_file = -1;
+#endif
+}
+
+
+MappedFileClass::MappedFileClass(const MappedFileClass& other)
+{
+}
+
+
+MappedFileClass::~MappedFileClass()
+{
+}
+
+
+bool MappedFileClass::Initialize(const char* filename)
+{
+#ifdef _WIN32
+	// Open the file for reading, hinting that it will be read front to back.
+	m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+#else
+	// Open the file for reading.
+	m_file = open(filename, O_RDONLY);
+	if(m_file < 0)
+	{
+		return false;
+	}
+#endif
+
+	return MapFile();
+}
+
+
+bool MappedFileClass::Initialize(const wchar_t* filename)
+{
+#ifdef _WIN32
+	// Open the file for reading, hinting that it will be read front to back.
+	m_file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(m_file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	return MapFile();
+#else
+	// Other systems take narrow file names.
+	return Initialize(std::filesystem::path(filename).string().c_str());
+#endif
+}
+
+
+void MappedFileClass::Shutdown()
+{
+#ifdef _WIN32
+	// Unmap the view, then close the mapping and the file.
+	if(m_data)
+	{
+		UnmapViewOfFile(m_data);
+		m_data = 0;
+	}
+
+	if(m_mapping)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = 0;
+	}
+
+	if(m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#else
+	// Unmap the file and then close it.
+	if(m_data)
+	{
+		munmap((void*)m_data, m_size);
+		m_data = 0;
+	}
+
+	if(m_file >= 0)
+	{
+		close(m_file);
+		m_file = -1;
+	}
+#endif
+
+	m_size = 0;
+
+	return;
+}
+
+
+const unsigned char* MappedFileClass::GetData()
+{
+	return m_data;
+}
+
+
+size_t MappedFileClass::GetSize()
+{
+	return m_size;
+}
+
+
+bool MappedFileClass::MapFile()
+{
+#ifdef _WIN32
+	LARGE_INTEGER fileSize;
+
+
+	// Get the size of the file, an empty file cannot be mapped.
+	if(!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Shutdown();
+		return false;
+	}
+	m_size = (size_t)fileSize.QuadPart;
+
+	// Create a read only mapping of the whole file and map a view of it.
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(!m_mapping)
+	{
+		Shutdown();
+		return false;
+	}
+
+	m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if(!m_data)
+	{
+		Shutdown();
+		return false;
+	}
+#else
+	struct stat fileInfo;
+	void* data;
+
+
+	// Get the size of the file, an empty file cannot be mapped.
+	if(fstat(m_file, &fileInfo) != 0 || fileInfo.st_size == 0)
+	{
+		Shutdown();
+		return false;
+	}
+	m_size = (size_t)fileInfo.st_size;
+
+	// Map the whole file read only and tell the kernel it will be read front to back.
+	data = mmap(0, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+	if(data == MAP_FAILED)
+	{
+		Shutdown();
+		return false;
+	}
+	madvise(data, m_size, MADV_SEQUENTIAL);
+
+	m_data = (const unsigned char*)data;
+#endif
+
+	return true;
+}
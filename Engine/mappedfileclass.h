@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: mappedfileclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MAPPEDFILECLASS_H_
+#define _MAPPEDFILECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MappedFileClass
+////////////////////////////////////////////////////////////////////////////////
+class MappedFileClass
+{
+public:
+	MappedFileClass();
+	MappedFileClass(const MappedFileClass&);
+	~MappedFileClass();
+
+	bool Initialize(const char*);
+	bool Initialize(const wchar_t*);
+	void Shutdown();
+
+	const unsigned char* GetData();
+	size_t GetSize();
+
+private:
+	bool MapFile();
+
+private:
+	const unsigned char* m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
+
+#endif
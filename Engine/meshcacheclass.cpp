@@ -0,0 +1,936 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshcacheclass.h"
+#include "loadlogclass.h"
+#include "meshparserclass.h"
+#include "meshwelderclass.h"
+#include "meshoptimizerclass.h"
+#include "meshsimplifierclass.h"
+#include "meshletbuilderclass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const float LOD_REDUCTION = 0.5f;			// each level aims for half the triangles of the one before
+const float LOD_MIN_REDUCTION = 0.85f;		// a level that keeps more than this of the one before is not worth its indices
+const float LOD_MAX_ERROR = 0.1f;				// relative to the largest side of the bounding box
+const int LOD_MIN_TRIANGLES = 16;
+const float LOD_TEXTURE_WEIGHT = 1.0f;
+const float LOD_NORMAL_WEIGHT = 0.05f;
+
+
+MeshCacheClass::MeshCacheClass()
+{
+	m_MappedFile = 0;
+	m_vertexArray = 0;
+	m_indexArray = 0;
+	m_blockArray = 0;
+	m_vertices = 0;
+	m_indices = 0;
+	m_blocks = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_blockCount = 0;
+	m_weldEpsilon = 0.0f;
+	m_lodCount = 0;
+	m_center[0] = 0.0f;
+	m_center[1] = 0.0f;
+	m_center[2] = 0.0f;
+	m_radius = 0.0f;
+}
+
+
+MeshCacheClass::MeshCacheClass(const MeshCacheClass& other)
+{
+}
+
+
+MeshCacheClass::~MeshCacheClass()
+{
+}
+
+
+bool MeshCacheClass::Initialize(char* filename, float weldEpsilon)
+{
+	string cacheFilename;
+	long long sourceSize, sourceTime;
+	bool hasSource, result;
+	double startTime;
+
+
+	startTime = LoadLogClass::GetTime();
+
+	// Vertices closer than this in every attribute are welded into one.
+	m_weldEpsilon = weldEpsilon;
+
+	// Stamp the text source so a stale cache is never used.  If only the cache was shipped then accept it as is.
+	hasSource = GetSourceStamp(filename, sourceSize, sourceTime);
+	if(!hasSource)
+	{
+		sourceSize = -1;
+		sourceTime = -1;
+	}
+
+	// Try the binary cache first, it is only a mapping of the file with no parsing at all.
+	cacheFilename = GetCacheFilename(filename);
+	result = LoadBinary(cacheFilename, sourceSize, sourceTime);
+	if(result)
+	{
+		LoadLogClass::Write("mesh %s: %d vertices, %d indices in %d LODs and %d cluster blocks from binary cache in %.3f ms", filename,
+							m_vertexCount, m_indexCount, m_lodCount, m_blockCount, LoadLogClass::GetTime() - startTime);
+		return true;
+	}
+
+	// Otherwise fall back to parsing the text file.
+	result = BuildFromText(filename, startTime);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Write the binary cache for the next run.  Failing to write it is not an error, the text data is still good.
+	if(hasSource)
+	{
+		result = WriteBinary(cacheFilename, sourceSize, sourceTime);
+		if(!result)
+		{
+			LoadLogClass::Write("mesh %s: could not write binary cache %s", filename, cacheFilename.c_str());
+		}
+	}
+
+	return true;
+}
+
+
+bool MeshCacheClass::InitializeFromText(char* filename, float weldEpsilon)
+{
+	// Build the mesh from the text file without looking for or writing a binary cache, the asset cooker stores it itself.
+	m_weldEpsilon = weldEpsilon;
+
+	return BuildFromText(filename, LoadLogClass::GetTime());
+}
+
+
+bool MeshCacheClass::InitializeFromMemory(const char* name, const unsigned char* data, size_t size, float weldEpsilon)
+{
+	double startTime;
+	bool result;
+
+
+	startTime = LoadLogClass::GetTime();
+
+	// The data is a binary cache held by someone else, the asset archive, and is used in place for as long as they keep it.
+	m_weldEpsilon = weldEpsilon;
+
+	result = ReadBinary(data, size, -1, -1);
+	if(!result)
+	{
+		return false;
+	}
+
+	LoadLogClass::Write("mesh %s: %d vertices, %d indices in %d LODs and %d cluster blocks from asset archive in %.3f ms", name,
+						m_vertexCount, m_indexCount, m_lodCount, m_blockCount, LoadLogClass::GetTime() - startTime);
+
+	return true;
+}
+
+
+bool MeshCacheClass::InitializeProxy()
+{
+	int i, x, y, z;
+	bool result;
+
+
+	// A unit octahedron, small enough to stand in for any mesh while the real one streams in.
+	m_vertexCount = 6;
+	m_indexCount = 24;
+
+	m_vertexArray = new VertexType[m_vertexCount];
+	if(!m_vertexArray)
+	{
+		return false;
+	}
+
+	m_indexArray = new unsigned int[m_indexCount];
+	if(!m_indexArray)
+	{
+		return false;
+	}
+
+	// One vertex on each end of each axis, the normal points straight out and the texture is projected down the z axis.
+	for(i=0; i<m_vertexCount; i++)
+	{
+		m_vertexArray[i].x = i == 0 ? 1.0f : (i == 1 ? -1.0f : 0.0f);
+		m_vertexArray[i].y = i == 2 ? 1.0f : (i == 3 ? -1.0f : 0.0f);
+		m_vertexArray[i].z = i == 4 ? 1.0f : (i == 5 ? -1.0f : 0.0f);
+		m_vertexArray[i].tu = (m_vertexArray[i].x + 1.0f) * 0.5f;
+		m_vertexArray[i].tv = (1.0f - m_vertexArray[i].y) * 0.5f;
+		m_vertexArray[i].nx = m_vertexArray[i].x;
+		m_vertexArray[i].ny = m_vertexArray[i].y;
+		m_vertexArray[i].nz = m_vertexArray[i].z;
+	}
+
+	// One face per octant, wound like the model files so the outside faces the camera.
+	for(i=0; i<8; i++)
+	{
+		x = (i & 1) ? 1 : 0;
+		y = (i & 2) ? 3 : 2;
+		z = (i & 4) ? 5 : 4;
+
+		m_indexArray[i * 3] = x;
+		if(((i & 1) + ((i >> 1) & 1) + ((i >> 2) & 1)) % 2 == 0)
+		{
+			m_indexArray[i * 3 + 1] = y;
+			m_indexArray[i * 3 + 2] = z;
+		}
+		else
+		{
+			m_indexArray[i * 3 + 1] = z;
+			m_indexArray[i * 3 + 2] = y;
+		}
+	}
+
+	m_vertices = m_vertexArray;
+	m_indices = m_indexArray;
+
+	// It is already as simple as a mesh gets, so there is only the one level.
+	m_lodCount = 1;
+	m_lods[0].firstIndex = 0;
+	m_lods[0].indexCount = (unsigned int)m_indexCount;
+	m_lods[0].error = 0.0f;
+
+	CalculateBounds();
+
+	result = BuildClusters("<proxy>");
+	if(!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+void MeshCacheClass::Shutdown()
+{
+	// Release the mapping of the binary cache.
+	if(m_MappedFile)
+	{
+		m_MappedFile->Shutdown();
+		delete m_MappedFile;
+		m_MappedFile = 0;
+	}
+
+	// Release the vertices and indices built from the text file.
+	if(m_vertexArray)
+	{
+		delete [] m_vertexArray;
+		m_vertexArray = 0;
+	}
+
+	if(m_indexArray)
+	{
+		delete [] m_indexArray;
+		m_indexArray = 0;
+	}
+
+	if(m_blockArray)
+	{
+		delete [] m_blockArray;
+		m_blockArray = 0;
+	}
+
+	m_vertices = 0;
+	m_indices = 0;
+	m_blocks = 0;
+	m_vertexCount = 0;
+	m_indexCount = 0;
+	m_blockCount = 0;
+	m_lodCount = 0;
+
+	return;
+}
+
+
+const MeshCacheClass::VertexType* MeshCacheClass::GetVertices()
+{
+	return m_vertices;
+}
+
+
+const unsigned int* MeshCacheClass::GetIndices()
+{
+	return m_indices;
+}
+
+
+const ClusterCullerClass::ClusterBlockType* MeshCacheClass::GetClusterBlocks()
+{
+	return m_blocks;
+}
+
+
+int MeshCacheClass::GetVertexCount()
+{
+	return m_vertexCount;
+}
+
+
+int MeshCacheClass::GetIndexCount()
+{
+	return m_indexCount;
+}
+
+
+int MeshCacheClass::GetClusterBlockCount()
+{
+	return m_blockCount;
+}
+
+
+int MeshCacheClass::GetLodCount()
+{
+	return m_lodCount;
+}
+
+
+const MeshCacheClass::LodType& MeshCacheClass::GetLod(int level)
+{
+	return m_lods[level];
+}
+
+
+void MeshCacheClass::GetBoundingSphere(float* center, float& radius)
+{
+	center[0] = m_center[0];
+	center[1] = m_center[1];
+	center[2] = m_center[2];
+	radius = m_radius;
+
+	return;
+}
+
+
+bool MeshCacheClass::LoadBinary(const string& filename, long long sourceSize, long long sourceTime)
+{
+	bool result;
+
+
+	// Create the mapped file object.
+	m_MappedFile = new MappedFileClass;
+	if(!m_MappedFile)
+	{
+		return false;
+	}
+
+	// Map the cache file, if there is none then the text file has to be parsed.
+	result = m_MappedFile->Initialize(filename.c_str());
+	if(!result)
+	{
+		delete m_MappedFile;
+		m_MappedFile = 0;
+		return false;
+	}
+
+	result = ReadBinary(m_MappedFile->GetData(), m_MappedFile->GetSize(), sourceSize, sourceTime);
+	if(!result)
+	{
+		m_MappedFile->Shutdown();
+		delete m_MappedFile;
+		m_MappedFile = 0;
+		return false;
+	}
+
+	return true;
+}
+
+
+bool MeshCacheClass::ReadBinary(const unsigned char* data, size_t size, long long sourceSize, long long sourceTime)
+{
+	const HeaderType* header;
+	bool result;
+	int i;
+
+
+	// Check the header matches this build of the format and the source it was made from.
+	header = (const HeaderType*)data;
+	result = size >= sizeof(HeaderType) &&
+			 header->magic == MESH_CACHE_MAGIC && header->version == MESH_CACHE_VERSION &&
+			 header->vertexStride == sizeof(VertexType) && header->weldEpsilon == m_weldEpsilon &&
+			 size >= sizeof(HeaderType) + (size_t)header->vertexCount * sizeof(VertexType) +
+					 (size_t)header->indexCount * sizeof(unsigned int) +
+					 (size_t)header->blockCount * sizeof(ClusterCullerClass::ClusterBlockType);
+	if(result && sourceSize >= 0)
+	{
+		result = header->sourceSize == sourceSize && header->sourceTime == sourceTime;
+	}
+	if(result)
+	{
+		result = header->lodCount >= 1 && header->lodCount <= MESH_LOD_MAX_LEVELS;
+	}
+	for(i=0; result && i<(int)header->lodCount; i++)
+	{
+		result = (unsigned long long)header->lods[i].firstIndex + header->lods[i].indexCount <= header->indexCount &&
+				 (unsigned long long)header->lods[i].firstBlock + header->lods[i].blockCount <= header->blockCount;
+	}
+
+	if(!result)
+	{
+		return false;
+	}
+
+	// The vertex block follows the header, then the index block and the cluster blocks, all used straight out of the data.
+	m_vertexCount = (int)header->vertexCount;
+	m_indexCount = (int)header->indexCount;
+	m_blockCount = (int)header->blockCount;
+	m_vertices = (const VertexType*)(data + sizeof(HeaderType));
+	m_indices = (const unsigned int*)(m_vertices + m_vertexCount);
+	m_blocks = (const ClusterCullerClass::ClusterBlockType*)(m_indices + m_indexCount);
+
+	// The levels of detail are ranges of that index block.
+	m_lodCount = (int)header->lodCount;
+	for(i=0; i<m_lodCount; i++)
+	{
+		m_lods[i] = header->lods[i];
+	}
+
+	m_center[0] = header->center[0];
+	m_center[1] = header->center[1];
+	m_center[2] = header->center[2];
+	m_radius = header->radius;
+
+	return true;
+}
+
+
+bool MeshCacheClass::BuildFromText(char* filename, double startTime)
+{
+	bool result;
+	float extent;
+
+
+	result = LoadText(filename);
+	if(!result)
+	{
+		return false;
+	}
+
+	LoadLogClass::Write("mesh %s: welded %d vertices down to %d (%.2fx) from text in %.3f ms", filename, m_indexCount, m_vertexCount,
+						(float)m_indexCount / (float)(m_vertexCount > 0 ? m_vertexCount : 1), LoadLogClass::GetTime() - startTime);
+
+	// Reorder the triangles and vertices for the GPU before they are cached.
+	result = OptimizeMesh(filename);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Simplify the optimized mesh into its levels of detail, they are appended to the index block.
+	extent = CalculateBounds();
+
+	result = BuildLods(filename, extent);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Split every level into clusters that can be culled on their own.
+	result = BuildClusters(filename);
+	if(!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool MeshCacheClass::LoadText(char* filename)
+{
+	MappedFileClass textFile;
+	VertexType* textVertices;
+	const char* text;
+	size_t dataOffset;
+	int textVertexCount;
+	bool result;
+
+
+	// Read the whole model file in one go.  If it could not open the file then exit.
+	result = textFile.Initialize(filename);
+	if(!result)
+	{
+		return false;
+	}
+	text = (const char*)textFile.GetData();
+
+	// Read in the vertex count and find the beginning of the data.
+	result = MeshParserClass::ParseHeader(text, textFile.GetSize(), textVertexCount, dataOffset);
+	if(!result)
+	{
+		textFile.Shutdown();
+		return false;
+	}
+
+	// Create the array for the unwelded vertices using the vertex count that was read in.
+	textVertices = new VertexType[textVertexCount];
+	if(!textVertices)
+	{
+		textFile.Shutdown();
+		return false;
+	}
+
+	// Parse the vertex data straight into the vertex array, which is just a run of floats.
+	static_assert(sizeof(VertexType) == 8 * sizeof(float), "VertexType must be tightly packed floats");
+	result = MeshParserClass::ParseData(text + dataOffset, textFile.GetSize() - dataOffset, (float*)textVertices, (size_t)textVertexCount * 8);
+
+	// Close the model file.
+	textFile.Shutdown();
+
+	// Weld the triangle list into unique vertices and a real index list.
+	if(result)
+	{
+		result = WeldVertices(textVertices, textVertexCount);
+	}
+
+	// Release the unwelded vertices.
+	delete [] textVertices;
+	textVertices = 0;
+
+	return result;
+}
+
+
+bool MeshCacheClass::WeldVertices(const VertexType* vertices, int vertexCount)
+{
+	VertexType* weldedVertices;
+	bool result;
+
+
+	// Create the index array, every input vertex becomes one index.
+	m_indexArray = new unsigned int[vertexCount > 0 ? vertexCount : 1];
+	if(!m_indexArray)
+	{
+		return false;
+	}
+
+	// Create a scratch array for the welded vertices, at worst every vertex is unique.
+	weldedVertices = new VertexType[vertexCount > 0 ? vertexCount : 1];
+	if(!weldedVertices)
+	{
+		return false;
+	}
+
+	// Weld the vertices that match in position, texture coordinates and normal.
+	result = MeshWelderClass::Weld((const float*)vertices, vertexCount, 8, m_weldEpsilon, (float*)weldedVertices, m_vertexCount, m_indexArray);
+
+	// Keep only as much vertex memory as the welded mesh needs.
+	if(result)
+	{
+		m_vertexArray = new VertexType[m_vertexCount > 0 ? m_vertexCount : 1];
+		result = m_vertexArray != 0;
+	}
+
+	if(result)
+	{
+		memcpy(m_vertexArray, weldedVertices, sizeof(VertexType) * m_vertexCount);
+	}
+
+	// Release the scratch array.
+	delete [] weldedVertices;
+	weldedVertices = 0;
+
+	if(!result)
+	{
+		return false;
+	}
+
+	m_indexCount = vertexCount;
+	m_vertices = m_vertexArray;
+	m_indices = m_indexArray;
+
+	return true;
+}
+
+
+bool MeshCacheClass::OptimizeMesh(char* filename)
+{
+	MeshOptimizerClass::StatisticsType before, after;
+	bool result;
+
+
+	before = MeshOptimizerClass::AnalyzeVertexCache(m_indexArray, m_indexCount, m_vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+
+	// Order the triangles for the post transform vertex cache.
+	result = MeshOptimizerClass::OptimizeVertexCache(m_indexArray, m_indexCount, m_vertexCount);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Then move whole clusters of triangles around to cut overdraw, as long as the cache order mostly survives.
+	result = MeshOptimizerClass::OptimizeOverdraw(m_indexArray, m_indexCount, (const float*)m_vertexArray, 8, m_vertexCount,
+												  MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Finally lay the vertices out in the order they are first used so vertex fetch walks memory forwards.
+	result = MeshOptimizerClass::OptimizeVertexFetch(m_vertexArray, m_vertexCount, sizeof(VertexType), m_indexArray, m_indexCount);
+	if(!result)
+	{
+		return false;
+	}
+
+	after = MeshOptimizerClass::AnalyzeVertexCache(m_indexArray, m_indexCount, m_vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+
+	LoadLogClass::Write("mesh %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", filename, before.acmr, after.acmr, before.atvr, after.atvr);
+
+	return true;
+}
+
+
+bool MeshCacheClass::BuildLods(char* filename, float extent)
+{
+	unsigned int* lodIndices;
+	float attributeWeights[5];
+	float error;
+	int targetCount, lodIndexCount, totalCount, level;
+	bool result;
+
+
+	// The whole mesh is the first level.
+	m_lodCount = 1;
+	m_lods[0].firstIndex = 0;
+	m_lods[0].indexCount = (unsigned int)m_indexCount;
+	m_lods[0].error = 0.0f;
+
+	// Weigh texture coordinate and normal seams as well as the shape so they survive the collapses.
+	attributeWeights[0] = LOD_TEXTURE_WEIGHT;
+	attributeWeights[1] = LOD_TEXTURE_WEIGHT;
+	attributeWeights[2] = LOD_NORMAL_WEIGHT;
+	attributeWeights[3] = LOD_NORMAL_WEIGHT;
+	attributeWeights[4] = LOD_NORMAL_WEIGHT;
+
+	// Create the index array for every level, none of them is bigger than the first.
+	lodIndices = new unsigned int[(size_t)m_indexCount * MESH_LOD_MAX_LEVELS];
+	if(!lodIndices)
+	{
+		return false;
+	}
+	memcpy(lodIndices, m_indexArray, sizeof(unsigned int) * m_indexCount);
+	totalCount = m_indexCount;
+
+	// Each level is simplified from the full mesh so its error is measured against the original surface rather than piling up along a chain.
+	targetCount = m_indexCount;
+	for(level=1; level<MESH_LOD_MAX_LEVELS; level++)
+	{
+		targetCount = (int)((float)targetCount * LOD_REDUCTION) / 3 * 3;
+		if(targetCount < LOD_MIN_TRIANGLES * 3)
+		{
+			break;
+		}
+
+		result = MeshSimplifierClass::Simplify((const float*)m_vertexArray, 8, m_vertexCount, attributeWeights, 5, m_indexArray, m_indexCount,
+											   targetCount, LOD_MAX_ERROR, &lodIndices[totalCount], lodIndexCount, error);
+		if(!result)
+		{
+			delete [] lodIndices;
+			return false;
+		}
+
+		// Stop once the error limit or the locked borders hold the simplifier back, a level that barely shrinks is not worth keeping.
+		if(lodIndexCount < 3 || (float)lodIndexCount > (float)m_lods[level - 1].indexCount * LOD_MIN_REDUCTION)
+		{
+			break;
+		}
+
+		// Every level is drawn on its own, so each gets its own vertex cache order.
+		result = MeshOptimizerClass::OptimizeVertexCache(&lodIndices[totalCount], lodIndexCount, m_vertexCount);
+		if(!result)
+		{
+			delete [] lodIndices;
+			return false;
+		}
+
+		m_lods[level].firstIndex = (unsigned int)totalCount;
+		m_lods[level].indexCount = (unsigned int)lodIndexCount;
+		// The simplifier measures its error relative to the largest side of the bounding box, store it in model units.
+		m_lods[level].error = error * extent;
+		m_lodCount++;
+
+		totalCount += lodIndexCount;
+
+		LoadLogClass::Write("mesh %s: LOD %d has %d triangles (%.1f%%), error %.5f", filename, level, lodIndexCount / 3,
+							100.0f * (float)lodIndexCount / (float)m_indexCount, m_lods[level].error);
+	}
+
+	// Keep only as much index memory as the levels need.
+	delete [] m_indexArray;
+	m_indexArray = new unsigned int[totalCount > 0 ? totalCount : 1];
+	if(!m_indexArray)
+	{
+		delete [] lodIndices;
+		return false;
+	}
+	memcpy(m_indexArray, lodIndices, sizeof(unsigned int) * totalCount);
+
+	delete [] lodIndices;
+	lodIndices = 0;
+
+	m_indexCount = totalCount;
+	m_indices = m_indexArray;
+
+	return true;
+}
+
+
+bool MeshCacheClass::BuildClusters(const char* filename)
+{
+	MeshOptimizerClass::StatisticsType before, after;
+	int maxBlockCount, lodBlockCount, clusterCount, level;
+	bool result;
+
+
+	// Create the cluster blocks for every level, each level starts a new block.
+	maxBlockCount = 0;
+	for(level=0; level<m_lodCount; level++)
+	{
+		maxBlockCount += MeshletBuilderClass::GetMaxBlockCount((int)m_lods[level].indexCount);
+	}
+
+	m_blockArray = new ClusterCullerClass::ClusterBlockType[maxBlockCount > 0 ? maxBlockCount : 1];
+	if(!m_blockArray)
+	{
+		return false;
+	}
+
+	m_blockCount = 0;
+
+	// The triangles of each level are put in cluster order in place, so each cluster is a range of the index block.
+	for(level=0; level<m_lodCount; level++)
+	{
+		before = MeshOptimizerClass::AnalyzeVertexCache(&m_indexArray[m_lods[level].firstIndex], (int)m_lods[level].indexCount, m_vertexCount,
+														 MESH_OPTIMIZER_FIFO_SIZE);
+
+		result = MeshletBuilderClass::Build((const float*)m_vertexArray, 8, m_vertexCount, &m_indexArray[m_lods[level].firstIndex],
+											(int)m_lods[level].indexCount, m_lods[level].firstIndex, &m_blockArray[m_blockCount], lodBlockCount,
+											clusterCount);
+		if(!result)
+		{
+			return false;
+		}
+
+		m_lods[level].firstBlock = (unsigned int)m_blockCount;
+		m_lods[level].blockCount = (unsigned int)lodBlockCount;
+		m_blockCount += lodBlockCount;
+
+		// The clusters reorder the triangles, the builder puts each cluster back in cache order so the cost should stay close.
+		after = MeshOptimizerClass::AnalyzeVertexCache(&m_indexArray[m_lods[level].firstIndex], (int)m_lods[level].indexCount, m_vertexCount,
+													   MESH_OPTIMIZER_FIFO_SIZE);
+
+		LoadLogClass::Write("mesh %s: LOD %d split into %d clusters of %.1f triangles on average, ACMR %.3f -> %.3f", filename, level,
+							clusterCount, (float)m_lods[level].indexCount / 3.0f / (float)(clusterCount > 0 ? clusterCount : 1), before.acmr,
+							after.acmr);
+	}
+
+	// Lay the vertices out again in the order the clustered triangles first use them, every level shares them so the levels
+	// after the first only add the vertices it does not use.
+	result = MeshOptimizerClass::OptimizeVertexFetch(m_vertexArray, m_vertexCount, sizeof(VertexType), m_indexArray, m_indexCount);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_blocks = m_blockArray;
+
+	return true;
+}
+
+
+float MeshCacheClass::CalculateBounds()
+{
+	float minimum[3], maximum[3], distance;
+	int i, k;
+
+
+	if(m_vertexCount == 0)
+	{
+		return 0.0f;
+	}
+
+	// Center the sphere on the bounding box and grow it to the furthest vertex.
+	for(k=0; k<3; k++)
+	{
+		minimum[k] = (&m_vertexArray[0].x)[k];
+		maximum[k] = minimum[k];
+	}
+	for(i=1; i<m_vertexCount; i++)
+	{
+		for(k=0; k<3; k++)
+		{
+			minimum[k] = min(minimum[k], (&m_vertexArray[i].x)[k]);
+			maximum[k] = max(maximum[k], (&m_vertexArray[i].x)[k]);
+		}
+	}
+
+	for(k=0; k<3; k++)
+	{
+		m_center[k] = (minimum[k] + maximum[k]) * 0.5f;
+	}
+
+	m_radius = 0.0f;
+	for(i=0; i<m_vertexCount; i++)
+	{
+		distance = (m_vertexArray[i].x - m_center[0]) * (m_vertexArray[i].x - m_center[0]) +
+				   (m_vertexArray[i].y - m_center[1]) * (m_vertexArray[i].y - m_center[1]) +
+				   (m_vertexArray[i].z - m_center[2]) * (m_vertexArray[i].z - m_center[2]);
+		m_radius = max(m_radius, distance);
+	}
+	m_radius = sqrtf(m_radius);
+
+	// Return the largest side of the box.
+	return max(maximum[0] - minimum[0], max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+}
+
+
+bool MeshCacheClass::Write(ostream& stream)
+{
+	// A cache with no source stamp is always accepted, the asset cooker tracks its sources with content hashes instead.
+	return WriteStream(stream, -1, -1);
+}
+
+
+bool MeshCacheClass::WriteBinary(const string& filename, long long sourceSize, long long sourceTime)
+{
+	ofstream fout;
+	bool result;
+
+
+	// Open the cache file for writing.
+	fout.open(filename.c_str(), ios::out | ios::binary | ios::trunc);
+	if(fout.fail())
+	{
+		return false;
+	}
+
+	result = WriteStream(fout, sourceSize, sourceTime);
+
+	// Close the cache file.
+	fout.close();
+	if(!result || fout.fail())
+	{
+		remove(filename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+
+bool MeshCacheClass::WriteStream(ostream& stream, long long sourceSize, long long sourceTime)
+{
+	HeaderType header;
+	int i;
+
+
+	// Clear the padding as well so the same mesh always writes the same bytes.
+	memset(&header, 0, sizeof(HeaderType));
+
+	// Fill in the header.
+	header.magic = MESH_CACHE_MAGIC;
+	header.version = MESH_CACHE_VERSION;
+	header.vertexStride = sizeof(VertexType);
+	header.vertexCount = (unsigned int)m_vertexCount;
+	header.indexCount = (unsigned int)m_indexCount;
+	header.weldEpsilon = m_weldEpsilon;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.lodCount = (unsigned int)m_lodCount;
+	header.blockCount = (unsigned int)m_blockCount;
+	for(i=0; i<MESH_LOD_MAX_LEVELS; i++)
+	{
+		if(i < m_lodCount)
+		{
+			header.lods[i] = m_lods[i];
+		}
+		else
+		{
+			header.lods[i].firstIndex = 0;
+			header.lods[i].indexCount = 0;
+			header.lods[i].firstBlock = 0;
+			header.lods[i].blockCount = 0;
+			header.lods[i].error = 0.0f;
+		}
+	}
+	header.center[0] = m_center[0];
+	header.center[1] = m_center[1];
+	header.center[2] = m_center[2];
+	header.radius = m_radius;
+	header.reserved[0] = 0;
+	header.reserved[1] = 0;
+
+	// Write the header followed by the vertex, index and cluster blocks.
+	stream.write((const char*)&header, sizeof(HeaderType));
+	stream.write((const char*)m_vertices, (streamsize)m_vertexCount * sizeof(VertexType));
+	stream.write((const char*)m_indices, (streamsize)m_indexCount * sizeof(unsigned int));
+	stream.write((const char*)m_blocks, (streamsize)m_blockCount * sizeof(ClusterCullerClass::ClusterBlockType));
+	if(stream.fail())
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+string MeshCacheClass::GetCacheFilename(const char* filename)
+{
+	string cacheFilename;
+	size_t extension;
+
+
+	// The cache sits next to the text file with the extension swapped for .mesh.
+	cacheFilename = filename;
+	extension = cacheFilename.find_last_of('.');
+	if(extension != string::npos && cacheFilename.find_first_of("/\\", extension) == string::npos)
+	{
+		cacheFilename.erase(extension);
+	}
+
+	return cacheFilename + ".mesh";
+}
+
+
+bool MeshCacheClass::GetSourceStamp(const char* filename, long long& size, long long& time)
+{
+#ifdef _WIN32
+	struct _stat64 fileInfo;
+
+	if(_stat64(filename, &fileInfo) != 0)
+	{
+		return false;
+	}
+#else
+	struct stat fileInfo;
+
+	if(stat(filename, &fileInfo) != 0)
+	{
+		return false;
+	}
+#endif
+
+	size = (long long)fileInfo.st_size;
+	time = (long long)fileInfo.st_mtime;
+
+	return true;
+}
@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHCACHECLASS_H_
+#define _MESHCACHECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <fstream>
+#include <string>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "mappedfileclass.h"
+#include "clustercullerclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int MESH_CACHE_MAGIC = 0x434D5452;	// "RTMC"
+const unsigned int MESH_CACHE_VERSION = 6;
+const int MESH_LOD_MAX_LEVELS = 5;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshCacheClass
+////////////////////////////////////////////////////////////////////////////////
+class MeshCacheClass
+{
+public:
+	// The vertex block of the binary cache, laid out exactly like the position/texture/normal
+	// VertexType the light and texture shaders read so it can be handed to CreateBuffer as is.
+	struct VertexType
+	{
+		float x, y, z;
+		float tu, tv;
+		float nx, ny, nz;
+	};
+
+	// One level of detail, a range of the index block drawn with the same vertices as every other level,
+	// and the blocks of clusters that range is split into.  The error is the furthest the surface or its
+	// attributes may have moved, in model units.
+	struct LodType
+	{
+		unsigned int firstIndex;
+		unsigned int indexCount;
+		unsigned int firstBlock;
+		unsigned int blockCount;
+		float error;
+	};
+
+private:
+	struct HeaderType
+	{
+		unsigned int magic;
+		unsigned int version;
+		unsigned int vertexStride;
+		unsigned int vertexCount;
+		unsigned int indexCount;
+		float weldEpsilon;
+		long long sourceSize;
+		long long sourceTime;
+		unsigned int lodCount;
+		LodType lods[MESH_LOD_MAX_LEVELS];
+		unsigned int blockCount;
+		float center[3];
+		float radius;
+		unsigned int reserved[2];
+	};
+
+public:
+	MeshCacheClass();
+	MeshCacheClass(const MeshCacheClass&);
+	~MeshCacheClass();
+
+	bool Initialize(char*, float);
+	bool InitializeFromText(char*, float);
+	bool InitializeFromMemory(const char*, const unsigned char*, size_t, float);
+	bool InitializeProxy();
+	void Shutdown();
+
+	const VertexType* GetVertices();
+	const unsigned int* GetIndices();
+	const ClusterCullerClass::ClusterBlockType* GetClusterBlocks();
+	int GetVertexCount();
+	int GetIndexCount();
+	int GetClusterBlockCount();
+	int GetLodCount();
+	const LodType& GetLod(int);
+	void GetBoundingSphere(float*, float&);
+
+	bool Write(ostream&);
+
+private:
+	bool LoadBinary(const string&, long long, long long);
+	bool ReadBinary(const unsigned char*, size_t, long long, long long);
+	bool BuildFromText(char*, double);
+	bool LoadText(char*);
+	bool WeldVertices(const VertexType*, int);
+	bool OptimizeMesh(char*);
+	bool BuildLods(char*, float);
+	bool BuildClusters(const char*);
+	float CalculateBounds();
+	bool WriteBinary(const string&, long long, long long);
+	bool WriteStream(ostream&, long long, long long);
+
+	static string GetCacheFilename(const char*);
+	static bool GetSourceStamp(const char*, long long&, long long&);
+
+private:
+	MappedFileClass* m_MappedFile;
+	VertexType* m_vertexArray;
+	unsigned int* m_indexArray;
+	ClusterCullerClass::ClusterBlockType* m_blockArray;
+	const VertexType* m_vertices;
+	const unsigned int* m_indices;
+	const ClusterCullerClass::ClusterBlockType* m_blocks;
+	int m_vertexCount, m_indexCount, m_blockCount;
+	float m_weldEpsilon;
+	LodType m_lods[MESH_LOD_MAX_LEVELS];
+	int m_lodCount;
+	float m_center[3], m_radius;
+};
+
+#endif
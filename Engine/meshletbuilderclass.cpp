@@ -0,0 +1,369 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshletbuilderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshletbuilderclass.h"
+#include "meshoptimizerclass.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+
+bool MeshletBuilderClass::Build(const float* vertices, int floatsPerVertex, int vertexCount, unsigned int* indices, int indexCount,
+								unsigned int baseIndex, ClusterCullerClass::ClusterBlockType* blocks, int& blockCount, int& clusterCount)
+{
+	float *normals, *clusterNormals;
+	int *adjacencyOffset, *adjacency, *vertexCluster, *vertexLocal, *clusterTriangles;
+	bool* used;
+	unsigned int* output;
+	float axis[3], direction[3], length, score, bestScore;
+	int triangleCount, outputCount, seed, clusterVertexCount, clusterTriangleCount, best, newVertices, triangle, vertex, i, j, k;
+
+
+	triangleCount = indexCount / 3;
+	blockCount = 0;
+	clusterCount = 0;
+	if(triangleCount == 0)
+	{
+		return true;
+	}
+
+	// Create the work arrays.
+	normals = new float[triangleCount * 3];
+	clusterNormals = new float[MESHLET_MAX_TRIANGLES * 3];
+	adjacencyOffset = new int[vertexCount + 1];
+	adjacency = new int[triangleCount * 3];
+	vertexCluster = new int[vertexCount];
+	vertexLocal = new int[vertexCount];
+	clusterTriangles = new int[MESHLET_MAX_TRIANGLES];
+	used = new bool[triangleCount];
+	output = new unsigned int[triangleCount * 3];
+	if(!normals || !clusterNormals || !adjacencyOffset || !adjacency || !vertexCluster || !vertexLocal || !clusterTriangles || !used || !output)
+	{
+		return false;
+	}
+
+	for(i=0; i<triangleCount; i++)
+	{
+		CalculateNormal(vertices, floatsPerVertex, &indices[i * 3], &normals[i * 3]);
+	}
+
+	// Build the vertex to triangle adjacency lists, the clusters grow along them.
+	memset(adjacencyOffset, 0, sizeof(int) * (vertexCount + 1));
+	for(i=0; i<triangleCount * 3; i++)
+	{
+		adjacencyOffset[indices[i] + 1]++;
+	}
+	for(i=0; i<vertexCount; i++)
+	{
+		adjacencyOffset[i + 1] += adjacencyOffset[i];
+	}
+	for(i=0; i<triangleCount * 3; i++)
+	{
+		adjacency[adjacencyOffset[indices[i]]] = i / 3;
+		adjacencyOffset[indices[i]]++;
+	}
+	for(i=vertexCount; i>0; i--)
+	{
+		adjacencyOffset[i] = adjacencyOffset[i - 1];
+	}
+	adjacencyOffset[0] = 0;
+
+	memset(used, 0, sizeof(bool) * triangleCount);
+	memset(vertexCluster, 0xff, sizeof(int) * vertexCount);
+	memset(vertexLocal, 0xff, sizeof(int) * vertexCount);
+
+	outputCount = 0;
+	seed = 0;
+
+	while(true)
+	{
+		// Seed each cluster with the first free triangle in the current order, which keeps the vertex cache order mostly intact.
+		while(seed < triangleCount && used[seed])
+		{
+			seed++;
+		}
+		if(seed == triangleCount)
+		{
+			break;
+		}
+
+		clusterTriangleCount = 0;
+		clusterVertexCount = 0;
+		axis[0] = 0.0f;
+		axis[1] = 0.0f;
+		axis[2] = 0.0f;
+		best = seed;
+
+		while(best >= 0)
+		{
+			// Add the triangle and any of its vertices the cluster does not have yet.
+			used[best] = true;
+			clusterTriangles[clusterTriangleCount] = best;
+			clusterTriangleCount++;
+
+			for(k=0; k<3; k++)
+			{
+				vertex = (int)indices[best * 3 + k];
+				if(vertexCluster[vertex] != clusterCount)
+				{
+					vertexCluster[vertex] = clusterCount;
+					clusterVertexCount++;
+				}
+				axis[k] += normals[best * 3 + k];
+			}
+
+			if(clusterTriangleCount == MESHLET_MAX_TRIANGLES)
+			{
+				break;
+			}
+
+			length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			for(k=0; k<3; k++)
+			{
+				direction[k] = length > 0.0f ? axis[k] / length : 0.0f;
+			}
+
+			// Pick the free triangle touching the cluster that adds the fewest vertices and bends the normal cone the least.
+			best = -1;
+			bestScore = FLT_MAX;
+			for(i=0; i<clusterTriangleCount; i++)
+			{
+				for(j=0; j<3; j++)
+				{
+					vertex = (int)indices[clusterTriangles[i] * 3 + j];
+					for(k=adjacencyOffset[vertex]; k<adjacencyOffset[vertex + 1]; k++)
+					{
+						triangle = adjacency[k];
+						if(used[triangle])
+						{
+							continue;
+						}
+
+						newVertices = (vertexCluster[indices[triangle * 3]] != clusterCount ? 1 : 0) +
+									  (vertexCluster[indices[triangle * 3 + 1]] != clusterCount ? 1 : 0) +
+									  (vertexCluster[indices[triangle * 3 + 2]] != clusterCount ? 1 : 0);
+						if(clusterVertexCount + newVertices > MESHLET_MAX_VERTICES)
+						{
+							continue;
+						}
+
+						score = (float)newVertices + (1.0f - (normals[triangle * 3] * direction[0] + normals[triangle * 3 + 1] * direction[1] +
+															  normals[triangle * 3 + 2] * direction[2])) * MESHLET_CONE_WEIGHT;
+						if(score < bestScore)
+						{
+							bestScore = score;
+							best = triangle;
+						}
+					}
+				}
+			}
+		}
+
+		// Write the cluster out as one range of the index list.
+		for(i=0; i<clusterTriangleCount; i++)
+		{
+			for(k=0; k<3; k++)
+			{
+				output[outputCount + i * 3 + k] = indices[clusterTriangles[i] * 3 + k];
+				clusterNormals[i * 3 + k] = normals[clusterTriangles[i] * 3 + k];
+			}
+		}
+
+		// Growing the cluster across shared vertices scrambled the order the triangles had, so order them for the vertex cache again.
+		if(!OptimizeCluster(&output[outputCount], clusterTriangleCount * 3, vertexLocal))
+		{
+			return false;
+		}
+
+		// Four clusters to a block, each starts out as padding.
+		if(clusterCount % 4 == 0)
+		{
+			memset(&blocks[clusterCount / 4], 0, sizeof(ClusterCullerClass::ClusterBlockType));
+		}
+
+		CalculateBounds(vertices, floatsPerVertex, &output[outputCount], clusterTriangleCount * 3, clusterNormals, blocks[clusterCount / 4],
+						clusterCount % 4);
+		blocks[clusterCount / 4].firstIndex[clusterCount % 4] = baseIndex + (unsigned int)outputCount;
+		blocks[clusterCount / 4].indexCount[clusterCount % 4] = (unsigned int)clusterTriangleCount * 3;
+
+		outputCount += clusterTriangleCount * 3;
+		clusterCount++;
+	}
+
+	blockCount = (clusterCount + 3) / 4;
+
+	// Replace the triangle order with the cluster order.
+	memcpy(indices, output, sizeof(unsigned int) * outputCount);
+
+	// Release the work arrays.
+	delete [] normals;
+	delete [] clusterNormals;
+	delete [] adjacencyOffset;
+	delete [] adjacency;
+	delete [] vertexCluster;
+	delete [] vertexLocal;
+	delete [] clusterTriangles;
+	delete [] used;
+	delete [] output;
+
+	return true;
+}
+
+
+int MeshletBuilderClass::GetMaxBlockCount(int indexCount)
+{
+	// At worst every triangle ends up in a cluster of its own.
+	return (indexCount / 3 + 3) / 4;
+}
+
+
+void MeshletBuilderClass::CalculateBounds(const float* vertices, int floatsPerVertex, const unsigned int* indices, int indexCount,
+										  const float* normals, ClusterCullerClass::ClusterBlockType& block, int lane)
+{
+	const float* position;
+	float minimum[3], maximum[3], center[3], axis[3], radius, distance, length, minimumDot, dot;
+	int i, k;
+
+
+	// Center the sphere on the bounding box of the cluster and grow it to the furthest vertex.
+	for(k=0; k<3; k++)
+	{
+		minimum[k] = FLT_MAX;
+		maximum[k] = -FLT_MAX;
+	}
+	for(i=0; i<indexCount; i++)
+	{
+		position = &vertices[indices[i] * floatsPerVertex];
+		for(k=0; k<3; k++)
+		{
+			minimum[k] = position[k] < minimum[k] ? position[k] : minimum[k];
+			maximum[k] = position[k] > maximum[k] ? position[k] : maximum[k];
+		}
+	}
+	for(k=0; k<3; k++)
+	{
+		center[k] = (minimum[k] + maximum[k]) * 0.5f;
+	}
+
+	radius = 0.0f;
+	for(i=0; i<indexCount; i++)
+	{
+		position = &vertices[indices[i] * floatsPerVertex];
+		distance = (position[0] - center[0]) * (position[0] - center[0]) + (position[1] - center[1]) * (position[1] - center[1]) +
+				   (position[2] - center[2]) * (position[2] - center[2]);
+		radius = distance > radius ? distance : radius;
+	}
+	radius = sqrtf(radius);
+
+	// The cone axis is the average of the triangle normals and its spread is set by the one that strays furthest.
+	axis[0] = 0.0f;
+	axis[1] = 0.0f;
+	axis[2] = 0.0f;
+	for(i=0; i<indexCount / 3; i++)
+	{
+		for(k=0; k<3; k++)
+		{
+			axis[k] += normals[i * 3 + k];
+		}
+	}
+	length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+	minimumDot = length > 0.0f ? 1.0f : -1.0f;
+	for(i=0; i<indexCount / 3 && length > 0.0f; i++)
+	{
+		// Triangles with no area have no normal and cannot be seen anyway.
+		if(normals[i * 3] == 0.0f && normals[i * 3 + 1] == 0.0f && normals[i * 3 + 2] == 0.0f)
+		{
+			continue;
+		}
+
+		dot = (normals[i * 3] * axis[0] + normals[i * 3 + 1] * axis[1] + normals[i * 3 + 2] * axis[2]) / length;
+		minimumDot = dot < minimumDot ? dot : minimumDot;
+	}
+
+	block.centerX[lane] = center[0];
+	block.centerY[lane] = center[1];
+	block.centerZ[lane] = center[2];
+	block.radius[lane] = radius;
+	block.axisX[lane] = length > 0.0f ? axis[0] / length : 0.0f;
+	block.axisY[lane] = length > 0.0f ? axis[1] / length : 0.0f;
+	block.axisZ[lane] = length > 0.0f ? axis[2] / length : 0.0f;
+
+	// The cutoff is the sine of the cone spread.  A cone wider than about 85 degrees can never be culled, so a cutoff of one turns the test off.
+	block.cutoff[lane] = minimumDot > 0.1f ? sqrtf(1.0f - minimumDot * minimumDot) : 1.0f;
+
+	return;
+}
+
+
+void MeshletBuilderClass::CalculateNormal(const float* vertices, int floatsPerVertex, const unsigned int* triangle, float* normal)
+{
+	const float *p0, *p1, *p2;
+	float e1[3], e2[3], length;
+	int k;
+
+
+	p0 = &vertices[triangle[0] * floatsPerVertex];
+	p1 = &vertices[triangle[1] * floatsPerVertex];
+	p2 = &vertices[triangle[2] * floatsPerVertex];
+
+	for(k=0; k<3; k++)
+	{
+		e1[k] = p1[k] - p0[k];
+		e2[k] = p2[k] - p0[k];
+	}
+
+	// The model files wind their triangles so this cross product points out of the surface.
+	normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+	length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+	for(k=0; k<3; k++)
+	{
+		normal[k] = length > 0.0f ? normal[k] / length : 0.0f;
+	}
+
+	return;
+}
+
+
+bool MeshletBuilderClass::OptimizeCluster(unsigned int* indices, int indexCount, int* vertexLocal)
+{
+	unsigned int localIndices[MESHLET_MAX_TRIANGLES * 3], clusterVertices[MESHLET_MAX_VERTICES];
+	int localCount, i;
+
+
+	// Number the vertices of the cluster from zero, so the optimizer only works on the few dozen the cluster uses rather than the
+	// whole mesh.
+	localCount = 0;
+	for(i=0; i<indexCount; i++)
+	{
+		if(vertexLocal[indices[i]] < 0)
+		{
+			vertexLocal[indices[i]] = localCount;
+			clusterVertices[localCount] = indices[i];
+			localCount++;
+		}
+		localIndices[i] = (unsigned int)vertexLocal[indices[i]];
+	}
+
+	if(!MeshOptimizerClass::OptimizeVertexCache(localIndices, indexCount, localCount))
+	{
+		return false;
+	}
+
+	for(i=0; i<indexCount; i++)
+	{
+		indices[i] = clusterVertices[localIndices[i]];
+	}
+
+	// Clear the numbering again for the next cluster.
+	for(i=0; i<localCount; i++)
+	{
+		vertexLocal[clusterVertices[i]] = -1;
+	}
+
+	return true;
+}
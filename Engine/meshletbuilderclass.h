@@ -0,0 +1,44 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshletbuilderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHLETBUILDERCLASS_H_
+#define _MESHLETBUILDERCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "clustercullerclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int MESHLET_MAX_VERTICES = 64;
+const int MESHLET_MAX_TRIANGLES = 124;
+const float MESHLET_CONE_WEIGHT = 2.0f;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshletBuilderClass
+//
+// Splits a triangle list into clusters of a few dozen triangles.  Each cluster
+// grows across shared vertices from a seed, favouring triangles that add few
+// vertices and face the same way, so its normal cone stays narrow.  The
+// triangles are rewritten in cluster order so every cluster is one range of
+// the index buffer, and the triangles inside each cluster are put back in
+// vertex cache order since growing it by shared vertices loses that order.
+////////////////////////////////////////////////////////////////////////////////
+class MeshletBuilderClass
+{
+public:
+	static bool Build(const float*, int, int, unsigned int*, int, unsigned int, ClusterCullerClass::ClusterBlockType*, int&, int&);
+	static int GetMaxBlockCount(int);
+
+private:
+	static void CalculateBounds(const float*, int, const unsigned int*, int, const float*, ClusterCullerClass::ClusterBlockType&, int);
+	static void CalculateNormal(const float*, int, const unsigned int*, float*);
+	static bool OptimizeCluster(unsigned int*, int, int*);
+};
+
+#endif
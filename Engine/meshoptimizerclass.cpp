@@ -0,0 +1,493 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshoptimizerclass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Vertex scoring constants from Forsyth's "Linear-Speed Vertex Cache Optimisation".
+const float CACHE_DECAY_POWER = 1.5f;
+const float LAST_TRIANGLE_SCORE = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+
+bool MeshOptimizerClass::OptimizeVertexCache(unsigned int* indices, int indexCount, int vertexCount)
+{
+	int *activeCount, *adjacencyOffset, *adjacency, *cachePosition;
+	float *vertexScore, *triangleScore;
+	bool* triangleAdded;
+	unsigned int* output;
+	int cache[MESH_OPTIMIZER_CACHE_SIZE + 3], newCache[MESH_OPTIMIZER_CACHE_SIZE + 3];
+	int triangleCount, cacheCount, newCacheCount, bestTriangle, scanStart, vertex, triangle, i, j, k, last;
+	float bestScore, score;
+
+
+	triangleCount = indexCount / 3;
+	if(triangleCount == 0)
+	{
+		return true;
+	}
+
+	// Create the per vertex and per triangle arrays.
+	activeCount = new int[vertexCount];
+	adjacencyOffset = new int[vertexCount + 1];
+	adjacency = new int[triangleCount * 3];
+	cachePosition = new int[vertexCount];
+	vertexScore = new float[vertexCount];
+	triangleScore = new float[triangleCount];
+	triangleAdded = new bool[triangleCount];
+	output = new unsigned int[triangleCount * 3];
+	if(!activeCount || !adjacencyOffset || !adjacency || !cachePosition || !vertexScore || !triangleScore || !triangleAdded || !output)
+	{
+		return false;
+	}
+
+	// Count how many triangles use each vertex.
+	memset(activeCount, 0, sizeof(int) * vertexCount);
+	for(i=0; i<triangleCount * 3; i++)
+	{
+		activeCount[indices[i]]++;
+	}
+
+	// Build the vertex to triangle adjacency lists.
+	adjacencyOffset[0] = 0;
+	for(i=0; i<vertexCount; i++)
+	{
+		adjacencyOffset[i+1] = adjacencyOffset[i] + activeCount[i];
+		cachePosition[i] = 0;
+	}
+
+	for(i=0; i<triangleCount * 3; i++)
+	{
+		vertex = indices[i];
+		adjacency[adjacencyOffset[vertex] + cachePosition[vertex]] = i / 3;
+		cachePosition[vertex]++;
+	}
+
+	// Score every vertex with nothing in the cache yet.
+	for(i=0; i<vertexCount; i++)
+	{
+		cachePosition[i] = -1;
+		vertexScore[i] = ScoreVertex(-1, activeCount[i]);
+	}
+
+	// Score every triangle and find the best one to start with.
+	bestTriangle = 0;
+	for(i=0; i<triangleCount; i++)
+	{
+		triangleAdded[i] = false;
+		triangleScore[i] = vertexScore[indices[i*3]] + vertexScore[indices[i*3+1]] + vertexScore[indices[i*3+2]];
+		if(triangleScore[i] > triangleScore[bestTriangle])
+		{
+			bestTriangle = i;
+		}
+	}
+
+	cacheCount = 0;
+	scanStart = 0;
+
+	for(i=0; i<triangleCount; i++)
+	{
+		// If nothing in the cache leads anywhere then fall back to the best remaining triangle.
+		if(bestTriangle < 0)
+		{
+			bestScore = -1.0f;
+			while(scanStart < triangleCount && triangleAdded[scanStart])
+			{
+				scanStart++;
+			}
+
+			for(j=scanStart; j<triangleCount; j++)
+			{
+				if(!triangleAdded[j] && triangleScore[j] > bestScore)
+				{
+					bestScore = triangleScore[j];
+					bestTriangle = j;
+				}
+			}
+		}
+
+		// Emit the triangle.
+		triangle = bestTriangle;
+		triangleAdded[triangle] = true;
+		output[i*3] = indices[triangle*3];
+		output[i*3+1] = indices[triangle*3+1];
+		output[i*3+2] = indices[triangle*3+2];
+
+		// Remove the triangle from the active lists of its vertices and push them to the front of the cache.
+		newCacheCount = 0;
+		for(j=0; j<3; j++)
+		{
+			vertex = indices[triangle*3+j];
+
+			last = adjacencyOffset[vertex] + activeCount[vertex] - 1;
+			for(k=adjacencyOffset[vertex]; k<=last; k++)
+			{
+				if(adjacency[k] == triangle)
+				{
+					adjacency[k] = adjacency[last];
+					adjacency[last] = triangle;
+					break;
+				}
+			}
+			activeCount[vertex]--;
+
+			newCache[newCacheCount] = vertex;
+			newCacheCount++;
+		}
+
+		// The rest of the old cache follows in order, minus the three vertices just used.
+		for(j=0; j<cacheCount; j++)
+		{
+			vertex = cache[j];
+			if(vertex != newCache[0] && vertex != newCache[1] && vertex != newCache[2])
+			{
+				newCache[newCacheCount] = vertex;
+				newCacheCount++;
+			}
+		}
+
+		// Rescore the vertices whose cache position changed and push the change into their triangles.
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for(j=0; j<newCacheCount; j++)
+		{
+			vertex = newCache[j];
+			cachePosition[vertex] = (j < MESH_OPTIMIZER_CACHE_SIZE) ? j : -1;
+
+			score = ScoreVertex(cachePosition[vertex], activeCount[vertex]);
+			for(k=adjacencyOffset[vertex]; k<adjacencyOffset[vertex] + activeCount[vertex]; k++)
+			{
+				triangle = adjacency[k];
+				triangleScore[triangle] += score - vertexScore[vertex];
+				if(triangleScore[triangle] > bestScore)
+				{
+					bestScore = triangleScore[triangle];
+					bestTriangle = triangle;
+				}
+			}
+			vertexScore[vertex] = score;
+		}
+
+		// Keep only the vertices that still fit in the cache.
+		cacheCount = min(newCacheCount, MESH_OPTIMIZER_CACHE_SIZE);
+		memcpy(cache, newCache, sizeof(int) * cacheCount);
+	}
+
+	// Copy the new triangle order back over the indices.
+	memcpy(indices, output, sizeof(unsigned int) * triangleCount * 3);
+
+	// Release the working arrays.
+	delete [] output;
+	delete [] triangleAdded;
+	delete [] triangleScore;
+	delete [] vertexScore;
+	delete [] cachePosition;
+	delete [] adjacency;
+	delete [] adjacencyOffset;
+	delete [] activeCount;
+
+	return true;
+}
+
+
+bool MeshOptimizerClass::OptimizeOverdraw(unsigned int* indices, int indexCount, const float* vertices, int floatsPerVertex, int vertexCount,
+										  float threshold)
+{
+	int *clusterStart, *clusterOrder, *cacheTime;
+	float *clusterSort;
+	unsigned int *output;
+	StatisticsType before, after;
+	int triangleCount, clusterCount, time, misses, i, j, k, cluster, first, end, out;
+	float meshCenter[3], center[3], normal[3], edge1[3], edge2[3], cross[3], area, totalArea, length;
+	const float *p0, *p1, *p2;
+
+
+	triangleCount = indexCount / 3;
+	if(triangleCount < 2)
+	{
+		return true;
+	}
+
+	before = AnalyzeVertexCache(indices, indexCount, vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+
+	clusterStart = new int[triangleCount + 1];
+	clusterOrder = new int[triangleCount];
+	clusterSort = new float[triangleCount];
+	cacheTime = new int[vertexCount];
+	output = new unsigned int[indexCount];
+	if(!clusterStart || !clusterOrder || !clusterSort || !cacheTime || !output)
+	{
+		return false;
+	}
+
+	// Split the cache optimized order into clusters wherever a triangle misses the cache on all three vertices.
+	// Reordering whole clusters keeps the cache behaviour inside each of them.
+	memset(cacheTime, 0xff, sizeof(int) * vertexCount);
+	time = MESH_OPTIMIZER_FIFO_SIZE + 1;
+	clusterCount = 0;
+	for(i=0; i<triangleCount; i++)
+	{
+		misses = 0;
+		for(j=0; j<3; j++)
+		{
+			k = indices[i*3+j];
+			if(cacheTime[k] < 0 || time - cacheTime[k] > MESH_OPTIMIZER_FIFO_SIZE)
+			{
+				cacheTime[k] = time;
+				time++;
+				misses++;
+			}
+		}
+
+		if(i == 0 || misses == 3)
+		{
+			clusterStart[clusterCount] = i;
+			clusterCount++;
+		}
+	}
+	clusterStart[clusterCount] = triangleCount;
+
+	// Find the area weighted centre of the whole mesh.
+	meshCenter[0] = meshCenter[1] = meshCenter[2] = 0.0f;
+	totalArea = 0.0f;
+	for(i=0; i<triangleCount; i++)
+	{
+		p0 = &vertices[indices[i*3] * floatsPerVertex];
+		p1 = &vertices[indices[i*3+1] * floatsPerVertex];
+		p2 = &vertices[indices[i*3+2] * floatsPerVertex];
+		for(j=0; j<3; j++)
+		{
+			edge1[j] = p1[j] - p0[j];
+			edge2[j] = p2[j] - p0[j];
+		}
+		cross[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+		cross[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+		cross[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+		area = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+		for(j=0; j<3; j++)
+		{
+			meshCenter[j] += (p0[j] + p1[j] + p2[j]) * area;
+		}
+		totalArea += area;
+	}
+	if(totalArea > 0.0f)
+	{
+		for(j=0; j<3; j++)
+		{
+			meshCenter[j] /= totalArea * 3.0f;
+		}
+	}
+
+	// Score each cluster by how far it faces away from the mesh centre.  Outward facing clusters on the hull
+	// are likely to occlude the rest, so they are drawn first.
+	for(cluster=0; cluster<clusterCount; cluster++)
+	{
+		center[0] = center[1] = center[2] = 0.0f;
+		normal[0] = normal[1] = normal[2] = 0.0f;
+		totalArea = 0.0f;
+
+		for(i=clusterStart[cluster]; i<clusterStart[cluster+1]; i++)
+		{
+			p0 = &vertices[indices[i*3] * floatsPerVertex];
+			p1 = &vertices[indices[i*3+1] * floatsPerVertex];
+			p2 = &vertices[indices[i*3+2] * floatsPerVertex];
+			for(j=0; j<3; j++)
+			{
+				edge1[j] = p1[j] - p0[j];
+				edge2[j] = p2[j] - p0[j];
+			}
+			cross[0] = edge1[1] * edge2[2] - edge1[2] * edge2[1];
+			cross[1] = edge1[2] * edge2[0] - edge1[0] * edge2[2];
+			cross[2] = edge1[0] * edge2[1] - edge1[1] * edge2[0];
+			area = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+			for(j=0; j<3; j++)
+			{
+				center[j] += (p0[j] + p1[j] + p2[j]) * area;
+				normal[j] += cross[j];
+			}
+			totalArea += area;
+		}
+
+		clusterSort[cluster] = 0.0f;
+		length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if(totalArea > 0.0f && length > 0.0f)
+		{
+			for(j=0; j<3; j++)
+			{
+				center[j] = center[j] / (totalArea * 3.0f) - meshCenter[j];
+			}
+			clusterSort[cluster] = (center[0] * normal[0] + center[1] * normal[1] + center[2] * normal[2]) / length;
+		}
+
+		clusterOrder[cluster] = cluster;
+	}
+
+	// Sort the clusters front to back by that score, keeping the cache order for ties.
+	stable_sort(clusterOrder, clusterOrder + clusterCount, [clusterSort](int a, int b) { return clusterSort[a] > clusterSort[b]; });
+
+	// Write the clusters out in their new order.
+	out = 0;
+	for(cluster=0; cluster<clusterCount; cluster++)
+	{
+		first = clusterStart[clusterOrder[cluster]];
+		end = clusterStart[clusterOrder[cluster] + 1];
+		for(i=first * 3; i<end * 3; i++)
+		{
+			output[out] = indices[i];
+			out++;
+		}
+	}
+
+	// Only keep the new order if it does not cost too much vertex cache efficiency.
+	after = AnalyzeVertexCache(output, triangleCount * 3, vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+	if(after.acmr <= before.acmr * threshold)
+	{
+		memcpy(indices, output, sizeof(unsigned int) * triangleCount * 3);
+	}
+
+	// Release the working arrays.
+	delete [] output;
+	delete [] cacheTime;
+	delete [] clusterSort;
+	delete [] clusterOrder;
+	delete [] clusterStart;
+
+	return true;
+}
+
+
+bool MeshOptimizerClass::OptimizeVertexFetch(void* vertices, int vertexCount, int vertexSize, unsigned int* indices, int indexCount)
+{
+	int* remap;
+	unsigned char *source, *output;
+	int nextVertex, i;
+
+
+	source = (unsigned char*)vertices;
+
+	remap = new int[vertexCount];
+	output = new unsigned char[(size_t)vertexCount * vertexSize];
+	if(!remap || !output)
+	{
+		return false;
+	}
+
+	// Number the vertices in the order the index list first touches them.
+	memset(remap, 0xff, sizeof(int) * vertexCount);
+	nextVertex = 0;
+	for(i=0; i<indexCount; i++)
+	{
+		if(remap[indices[i]] < 0)
+		{
+			remap[indices[i]] = nextVertex;
+			memcpy(&output[(size_t)nextVertex * vertexSize], &source[(size_t)indices[i] * vertexSize], vertexSize);
+			nextVertex++;
+		}
+
+		indices[i] = (unsigned int)remap[indices[i]];
+	}
+
+	// Unreferenced vertices go on the end so the vertex count does not change.
+	for(i=0; i<vertexCount; i++)
+	{
+		if(remap[i] < 0)
+		{
+			memcpy(&output[(size_t)nextVertex * vertexSize], &source[(size_t)i * vertexSize], vertexSize);
+			nextVertex++;
+		}
+	}
+
+	memcpy(source, output, (size_t)vertexCount * vertexSize);
+
+	// Release the working arrays.
+	delete [] output;
+	delete [] remap;
+
+	return true;
+}
+
+
+MeshOptimizerClass::StatisticsType MeshOptimizerClass::AnalyzeVertexCache(const unsigned int* indices, int indexCount, int vertexCount, int cacheSize)
+{
+	StatisticsType statistics;
+	int* cacheTime;
+	int time, misses, i;
+
+
+	statistics.acmr = 0.0f;
+	statistics.atvr = 0.0f;
+	if(indexCount < 3 || vertexCount == 0)
+	{
+		return statistics;
+	}
+
+	cacheTime = new int[vertexCount];
+	if(!cacheTime)
+	{
+		return statistics;
+	}
+
+	// Simulate a FIFO post transform cache, a vertex is still cached if fewer than cacheSize misses happened since it went in.
+	memset(cacheTime, 0xff, sizeof(int) * vertexCount);
+	time = cacheSize + 1;
+	misses = 0;
+	for(i=0; i<indexCount; i++)
+	{
+		if(cacheTime[indices[i]] < 0 || time - cacheTime[indices[i]] > cacheSize)
+		{
+			cacheTime[indices[i]] = time;
+			time++;
+			misses++;
+		}
+	}
+
+	delete [] cacheTime;
+
+	// Average transforms per triangle, and per vertex where 1.0 is ideal.
+	statistics.acmr = (float)misses / (float)(indexCount / 3);
+	statistics.atvr = (float)misses / (float)vertexCount;
+
+	return statistics;
+}
+
+
+float MeshOptimizerClass::ScoreVertex(int cachePosition, int activeTriangles)
+{
+	float score;
+
+
+	// A vertex with no triangles left to draw is worthless.
+	if(activeTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	score = 0.0f;
+	if(cachePosition >= 0)
+	{
+		// The three vertices of the last triangle get a fixed score so the next triangle does not just reuse the same edge,
+		// the rest decay the further back in the cache they are.
+		if(cachePosition < 3)
+		{
+			score = LAST_TRIANGLE_SCORE;
+		}
+		else
+		{
+			score = powf(1.0f - (float)(cachePosition - 3) / (float)(MESH_OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+		}
+	}
+
+	// Boost vertices with few triangles left so they get finished off rather than left as stragglers.
+	score += VALENCE_BOOST_SCALE * powf((float)activeTriangles, -VALENCE_BOOST_POWER);
+
+	return score;
+}
@@ -0,0 +1,39 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHOPTIMIZERCLASS_H_
+#define _MESHOPTIMIZERCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int MESH_OPTIMIZER_CACHE_SIZE = 32;
+const int MESH_OPTIMIZER_FIFO_SIZE = 16;
+const float MESH_OPTIMIZER_OVERDRAW_THRESHOLD = 1.05f;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshOptimizerClass
+////////////////////////////////////////////////////////////////////////////////
+class MeshOptimizerClass
+{
+public:
+	struct StatisticsType
+	{
+		float acmr;
+		float atvr;
+	};
+
+public:
+	static bool OptimizeVertexCache(unsigned int*, int, int);
+	static bool OptimizeOverdraw(unsigned int*, int, const float*, int, int, float);
+	static bool OptimizeVertexFetch(void*, int, int, unsigned int*, int);
+
+	static StatisticsType AnalyzeVertexCache(const unsigned int*, int, int, int);
+
+private:
+	static float ScoreVertex(int, int);
+};
+
+#endif
@@ -0,0 +1,246 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshparserclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshparserclass.h"
+#include "jobsystemclass.h"
+
+#include <charconv>
+#include <cstring>
+#include <thread>
+using namespace std;
+
+
+static inline bool IsSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+
+bool MeshParserClass::ParseHeader(const char* text, size_t length, int& vertexCount, size_t& dataOffset)
+{
+	const char *position, *end, *colon;
+	from_chars_result result;
+
+
+	end = text + length;
+
+	// Skip to the colon after "Vertex Count".
+	colon = (const char*)memchr(text, ':', length);
+	if(!colon)
+	{
+		return false;
+	}
+	position = colon + 1;
+
+	// Read in the vertex count.
+	while(position < end && IsSpace(*position))
+	{
+		position++;
+	}
+
+	result = from_chars(position, end, vertexCount);
+	if(result.ec != errc() || vertexCount < 0)
+	{
+		return false;
+	}
+	position = result.ptr;
+
+	// Skip to the colon after "Data", the vertex data starts straight after it.
+	colon = (const char*)memchr(position, ':', end - position);
+	if(!colon)
+	{
+		return false;
+	}
+
+	dataOffset = (colon + 1) - text;
+
+	return true;
+}
+
+
+bool MeshParserClass::ParseData(const char* text, size_t length, float* values, size_t valueCount)
+{
+	ChunkType chunks[MESH_PARSER_MAX_CHUNKS];
+	const char *end, *split;
+	size_t totalCount;
+	int chunkCount, threadCount, i;
+
+
+	end = text + length;
+
+	// Use one chunk per core, but never make chunks so small that starting a thread costs more than parsing them.  Inside a
+	// loader job the pool already keeps every core busy with the other loads, a thread per core for each of them would only
+	// oversubscribe the machine, so the whole file is parsed on the job's own thread.
+	threadCount = JobSystemClass::InJob() ? 1 : (int)thread::hardware_concurrency();
+	chunkCount = (int)(length / MESH_PARSER_MIN_CHUNK_SIZE);
+	if(chunkCount > threadCount)
+	{
+		chunkCount = threadCount;
+	}
+	if(chunkCount > MESH_PARSER_MAX_CHUNKS)
+	{
+		chunkCount = MESH_PARSER_MAX_CHUNKS;
+	}
+	if(chunkCount < 1)
+	{
+		chunkCount = 1;
+	}
+
+	// Split the data into even sized chunks and move each split forward to the start of the next line.
+	chunks[0].begin = text;
+	for(i=1; i<chunkCount; i++)
+	{
+		split = text + (length * i) / chunkCount;
+		if(split < chunks[i-1].begin)
+		{
+			split = chunks[i-1].begin;
+		}
+
+		split = (const char*)memchr(split, '\n', end - split);
+		split = split ? split + 1 : end;
+
+		chunks[i-1].end = split;
+		chunks[i].begin = split;
+	}
+	chunks[chunkCount-1].end = end;
+
+	// First pass counts the values in each chunk so every chunk knows where its values start in the output.
+	RunChunks(chunks, chunkCount, 0, 0);
+
+	totalCount = 0;
+	for(i=0; i<chunkCount; i++)
+	{
+		chunks[i].firstValue = totalCount;
+		totalCount += chunks[i].valueCount;
+	}
+
+	// The file has to hold at least as many values as its vertex count says.  Anything after them is ignored.
+	if(totalCount < valueCount)
+	{
+		return false;
+	}
+
+	// Second pass parses every chunk straight into its slice of the output.
+	RunChunks(chunks, chunkCount, values, valueCount);
+
+	for(i=0; i<chunkCount; i++)
+	{
+		if(chunks[i].failed)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+void MeshParserClass::CountValues(ChunkType* chunk)
+{
+	const char* position;
+	bool inValue;
+	size_t count;
+
+
+	// Count the starts of whitespace separated values.
+	count = 0;
+	inValue = false;
+	for(position=chunk->begin; position<chunk->end; position++)
+	{
+		if(IsSpace(*position))
+		{
+			inValue = false;
+		}
+		else if(!inValue)
+		{
+			inValue = true;
+			count++;
+		}
+	}
+
+	chunk->valueCount = count;
+	chunk->failed = false;
+
+	return;
+}
+
+
+void MeshParserClass::ParseValues(ChunkType* chunk, float* values, size_t valueCount)
+{
+	const char *position, *end;
+	from_chars_result result;
+	size_t index, last;
+
+
+	position = chunk->begin;
+	end = chunk->end;
+
+	// Only parse the part of this chunk that falls inside the vertex count.
+	index = chunk->firstValue;
+	last = chunk->firstValue + chunk->valueCount;
+	if(last > valueCount)
+	{
+		last = valueCount;
+	}
+
+	while(index < last)
+	{
+		// Skip the whitespace before the value.
+		while(position < end && IsSpace(*position))
+		{
+			position++;
+		}
+
+		// Parse the value, from_chars is locale independent and does not allocate.
+		result = from_chars(position, end, values[index]);
+		if(result.ec != errc() || (result.ptr < end && !IsSpace(*result.ptr)))
+		{
+			chunk->failed = true;
+			return;
+		}
+
+		position = result.ptr;
+		index++;
+	}
+
+	return;
+}
+
+
+void MeshParserClass::RunChunks(ChunkType* chunks, int chunkCount, float* values, size_t valueCount)
+{
+	thread workers[MESH_PARSER_MAX_CHUNKS];
+	int i;
+
+
+	// Hand every chunk but the first to a worker thread, a null output means this is the counting pass.
+	for(i=1; i<chunkCount; i++)
+	{
+		if(values)
+		{
+			workers[i] = thread(ParseValues, &chunks[i], values, valueCount);
+		}
+		else
+		{
+			workers[i] = thread(CountValues, &chunks[i]);
+		}
+	}
+
+	// The calling thread does the first chunk itself.
+	if(values)
+	{
+		ParseValues(&chunks[0], values, valueCount);
+	}
+	else
+	{
+		CountValues(&chunks[0]);
+	}
+
+	// Wait for the workers to finish.
+	for(i=1; i<chunkCount; i++)
+	{
+		workers[i].join();
+	}
+
+	return;
+}
@@ -0,0 +1,46 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshparserclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHPARSERCLASS_H_
+#define _MESHPARSERCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstddef>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int MESH_PARSER_MAX_CHUNKS = 64;
+const size_t MESH_PARSER_MIN_CHUNK_SIZE = 64 * 1024;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshParserClass
+////////////////////////////////////////////////////////////////////////////////
+class MeshParserClass
+{
+private:
+	struct ChunkType
+	{
+		const char* begin;
+		const char* end;
+		size_t firstValue;
+		size_t valueCount;
+		bool failed;
+	};
+
+public:
+	static bool ParseHeader(const char*, size_t, int&, size_t&);
+	static bool ParseData(const char*, size_t, float*, size_t);
+
+private:
+	static void CountValues(ChunkType*);
+	static void ParseValues(ChunkType*, float*, size_t);
+	static void RunChunks(ChunkType*, int, float*, size_t);
+};
+
+#endif
@@ -0,0 +1,592 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshregistryclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshregistryclass.h"
+#include "loadlogclass.h"
+
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+
+
+MeshRegistryClass::MeshRegistryClass()
+{
+	m_device = 0;
+	m_AssetArchive = 0;
+	m_loadCount = 0;
+	m_sharedCount = 0;
+	m_derivedCount = 0;
+	m_sharedBytes = 0;
+}
+
+
+MeshRegistryClass::MeshRegistryClass(const MeshRegistryClass& other)
+{
+}
+
+
+MeshRegistryClass::~MeshRegistryClass()
+{
+}
+
+
+bool MeshRegistryClass::Initialize(ID3D11Device* device, AssetArchiveClass* assetArchive)
+{
+	// Keep a pointer to the device the shared buffers are created on.
+	m_device = device;
+
+	// Meshes found in the asset archive are used from it in place of their files, it may be null.
+	m_AssetArchive = assetArchive;
+
+	return true;
+}
+
+
+void MeshRegistryClass::Shutdown()
+{
+	map<string, SourceType*>::iterator source;
+	int i;
+
+
+	LoadLogClass::Write("mesh registry: %d loads, %d shared, %d derived from a loaded file, %lld bytes deduplicated", m_loadCount,
+						m_sharedCount, m_derivedCount, m_sharedBytes);
+
+	// Release anything that was never handed back.
+	for(source=m_sources.begin(); source!=m_sources.end(); source++)
+	{
+		for(i=0; i<MESH_LAYOUT_COUNT; i++)
+		{
+			if(source->second->layouts[i])
+			{
+				ReleaseLayout(source->second->layouts[i]);
+				source->second->layouts[i] = 0;
+			}
+
+			ReleaseVertexData(source->second->vertexData[i]);
+		}
+
+		if(source->second->indexBuffer)
+		{
+			source->second->indexBuffer->Release();
+		}
+
+		if(source->second->meshCache)
+		{
+			source->second->meshCache->Shutdown();
+			delete source->second->meshCache;
+		}
+		delete source->second;
+	}
+
+	m_sources.clear();
+	m_device = 0;
+	m_AssetArchive = 0;
+
+	return;
+}
+
+
+MeshRegistryClass::SourceType* MeshRegistryClass::GetSource(const string& name)
+{
+	map<string, SourceType*>::iterator found;
+	SourceType* source;
+	int i;
+
+
+	lock_guard<mutex> lock(m_mutex);
+
+	found = m_sources.find(name);
+	if(found != m_sources.end())
+	{
+		return found->second;
+	}
+
+	// Create an empty entry, the file is loaded by whoever gets to it first.
+	source = new SourceType;
+	if(!source)
+	{
+		return 0;
+	}
+
+	source->meshCache = 0;
+	source->indexBuffer = 0;
+	source->cookedTangentVertices = 0;
+	for(i=0; i<MESH_LAYOUT_COUNT; i++)
+	{
+		source->layouts[i] = 0;
+		source->vertexData[i].vertices = 0;
+	}
+
+	m_sources[name] = source;
+
+	return source;
+}
+
+
+MeshRegistryClass::SourceType* MeshRegistryClass::FindSource(char* filename, string& name, bool& sourceLoaded)
+{
+	SourceType* source;
+	bool result;
+
+
+	m_loadCount++;
+
+	// The same file reached through different relative paths must map to the same entry.
+	name = GetCanonicalName(filename);
+
+	source = GetSource(name);
+	if(!source)
+	{
+		return 0;
+	}
+
+	// A file with an index buffer has been handed out before.
+	sourceLoaded = source->indexBuffer != 0;
+	if(sourceLoaded)
+	{
+		return source;
+	}
+
+	// Parse the file now unless a Prepare already did it on a loader thread.
+	result = true;
+	if(!source->meshCache)
+	{
+		lock_guard<mutex> lock(source->loadMutex);
+		result = LoadMeshData(source, filename);
+	}
+
+	if(result)
+	{
+		result = CreateIndexBuffer(source);
+	}
+
+	if(!result)
+	{
+		ReleaseSource(name);
+		return 0;
+	}
+
+	return source;
+}
+
+
+MeshRegistryClass::MeshType* MeshRegistryClass::ShareLayout(MeshType* mesh, char* filename)
+{
+	mesh->referenceCount++;
+
+	m_sharedCount++;
+	m_sharedBytes += (long long)mesh->vertexSize * mesh->vertexCount + (long long)sizeof(unsigned int) * mesh->indexCount;
+
+	LoadLogClass::Write("mesh registry %s: layout %d shared, %d references", filename, (int)mesh->layout, mesh->referenceCount);
+
+	return mesh;
+}
+
+
+MeshRegistryClass::MeshType* MeshRegistryClass::AddLayout(SourceType* source, MeshType* mesh, const string& name, bool sourceLoaded,
+														  char* filename)
+{
+	if(!mesh)
+	{
+		// Do not keep a source around that nothing uses.
+		if(!sourceLoaded)
+		{
+			ReleaseSource(name);
+		}
+		return 0;
+	}
+
+	// Loader jobs preparing other models read the layout slots.
+	{
+		lock_guard<mutex> lock(source->loadMutex);
+		source->layouts[mesh->layout] = mesh;
+	}
+
+	// A new layout of a file that was already loaded skips the parse and shares the index buffer.
+	if(sourceLoaded)
+	{
+		m_derivedCount++;
+		m_sharedBytes += (long long)sizeof(unsigned int) * mesh->indexCount;
+
+		LoadLogClass::Write("mesh registry %s: layout %d derived from the loaded file", filename, (int)mesh->layout);
+	}
+
+	return mesh;
+}
+
+
+void MeshRegistryClass::Release(MeshType* mesh)
+{
+	map<string, SourceType*>::iterator found;
+	SourceType* source;
+	string name;
+	int i;
+
+
+	if(!mesh)
+	{
+		return;
+	}
+
+	mesh->referenceCount--;
+	if(mesh->referenceCount > 0)
+	{
+		return;
+	}
+
+	found = m_sources.find(mesh->name);
+	if(found == m_sources.end())
+	{
+		return;
+	}
+	source = found->second;
+
+	// Release the layout now that nothing draws with it.
+	name = mesh->name;
+	{
+		lock_guard<mutex> lock(source->loadMutex);
+		source->layouts[mesh->layout] = 0;
+	}
+	ReleaseLayout(mesh);
+
+	// Release the parsed file once the last of its layouts is gone.
+	for(i=0; i<MESH_LAYOUT_COUNT; i++)
+	{
+		if(source->layouts[i])
+		{
+			return;
+		}
+	}
+
+	ReleaseSource(name);
+
+	return;
+}
+
+
+bool MeshRegistryClass::LoadMeshData(SourceType* source, char* filename)
+{
+	const AssetArchiveClass::EntryType* entry;
+	bool result;
+
+
+	// Create the mesh cache object.
+	source->meshCache = new MeshCacheClass;
+	if(!source->meshCache)
+	{
+		return false;
+	}
+
+	// Load the model data, from the binary cache if there is an up to date one.
+	entry = 0;
+	if(strcmp(filename, MESH_PROXY_NAME) == 0)
+	{
+		result = source->meshCache->InitializeProxy();
+	}
+	else
+	{
+		// Use the cooked mesh from the asset archive if it has one, otherwise go through the files like before.
+		if(m_AssetArchive)
+		{
+			entry = m_AssetArchive->Find(filename, ASSET_TYPE_MESH);
+		}
+		result = false;
+		if(entry)
+		{
+			result = source->meshCache->InitializeFromMemory(filename, m_AssetArchive->GetData(entry), (size_t)entry->size, MESH_WELD_EPSILON);
+		}
+		if(!result)
+		{
+			entry = 0;
+			result = source->meshCache->Initialize(filename, MESH_WELD_EPSILON);
+		}
+	}
+	if(!result)
+	{
+		source->meshCache->Shutdown();
+		delete source->meshCache;
+		source->meshCache = 0;
+		return false;
+	}
+
+	// The cooked tangent frames only go with the cooked mesh they were generated from.
+	if(entry)
+	{
+		entry = m_AssetArchive->Find(filename, ASSET_TYPE_TANGENT_VERTICES);
+	}
+	if(entry && entry->size == (unsigned long long)source->meshCache->GetVertexCount() * sizeof(TangentVertexLayout::VertexType))
+	{
+		source->cookedTangentVertices = (const TangentVertexLayout::VertexType*)m_AssetArchive->GetData(entry);
+	}
+
+	return true;
+}
+
+
+bool MeshRegistryClass::CreateIndexBuffer(SourceType* source)
+{
+	D3D11_BUFFER_DESC indexBufferDesc;
+	D3D11_SUBRESOURCE_DATA indexData;
+	HRESULT result;
+
+
+	// Set up the description of the static index buffer, every layout and level of detail of this file draws with it.
+    indexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    indexBufferDesc.ByteWidth = sizeof(unsigned int) * source->meshCache->GetIndexCount();
+    indexBufferDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+    indexBufferDesc.CPUAccessFlags = 0;
+    indexBufferDesc.MiscFlags = 0;
+	indexBufferDesc.StructureByteStride = 0;
+
+	// Give the subresource structure a pointer to the index data.
+    indexData.pSysMem = source->meshCache->GetIndices();
+	indexData.SysMemPitch = 0;
+	indexData.SysMemSlicePitch = 0;
+
+	// Create the index buffer.
+	result = m_device->CreateBuffer(&indexBufferDesc, &indexData, &source->indexBuffer);
+	if(FAILED(result))
+	{
+		source->indexBuffer = 0;
+		return false;
+	}
+
+	return true;
+}
+
+
+void MeshRegistryClass::ReleaseSource(const string& name)
+{
+	map<string, SourceType*>::iterator found;
+	int i;
+
+
+	lock_guard<mutex> lock(m_mutex);
+
+	found = m_sources.find(name);
+	if(found == m_sources.end())
+	{
+		return;
+	}
+
+	// Release the shared index buffer.
+	if(found->second->indexBuffer)
+	{
+		found->second->indexBuffer->Release();
+		found->second->indexBuffer = 0;
+	}
+
+	// Release vertex data that was prepared but never put in a buffer.
+	for(i=0; i<MESH_LAYOUT_COUNT; i++)
+	{
+		ReleaseVertexData(found->second->vertexData[i]);
+	}
+
+	// Release the mesh cache object which owns the model data.
+	if(found->second->meshCache)
+	{
+		found->second->meshCache->Shutdown();
+		delete found->second->meshCache;
+	}
+	delete found->second;
+
+	m_sources.erase(found);
+
+	return;
+}
+
+
+MeshRegistryClass::MeshType* MeshRegistryClass::CreateMesh(SourceType* source, MeshLayoutType layout, const string& name)
+{
+	MeshType* mesh;
+	int i;
+
+
+	// Create the mesh handle, the vertex buffer is filled in by the layout.
+	mesh = new MeshType;
+	if(!mesh)
+	{
+		return 0;
+	}
+
+	mesh->vertexBuffer = 0;
+	mesh->indexBuffer = source->indexBuffer;
+	mesh->quantizationBuffer = 0;
+	mesh->vertexCount = source->meshCache->GetVertexCount();
+	mesh->indexCount = source->meshCache->GetIndexCount();
+	mesh->vertexSize = 0;
+
+	// Every level of detail is a range of the one index buffer.
+	mesh->lodCount = source->meshCache->GetLodCount();
+	for(i=0; i<mesh->lodCount; i++)
+	{
+		mesh->lods[i] = source->meshCache->GetLod(i);
+	}
+	source->meshCache->GetBoundingSphere(mesh->center, mesh->radius);
+
+	// The clusters stay with the mesh cache, which lives as long as any layout of the mesh.
+	mesh->clusterBlocks = source->meshCache->GetClusterBlocks();
+	mesh->clusterBlockCount = source->meshCache->GetClusterBlockCount();
+
+	mesh->referenceCount = 1;
+	mesh->layout = layout;
+	mesh->name = name;
+
+	return mesh;
+}
+
+
+bool MeshRegistryClass::PackVertices(const float* vertices, int vertexCount, const VertexCompressionClass::FormatType& format,
+									 unsigned int stride, VertexDataType& vertexData)
+{
+	VertexCompressionClass::ErrorType error;
+	bool result;
+
+
+	vertexData.vertices = new unsigned char[stride * vertexCount];
+	if(!vertexData.vertices)
+	{
+		return false;
+	}
+
+	if constexpr(VERTEX_COMPRESSION_ENABLED)
+	{
+		// Pack the vertices down to 16 bit positions, half float texture coordinates and octahedral vectors.
+		result = VertexCompressionClass::Compress(vertices, vertexCount, format, vertexData.vertices, vertexData.bounds, error);
+		if(!result)
+		{
+			ReleaseVertexData(vertexData);
+			return false;
+		}
+	}
+	else
+	{
+		// The float layout is the buffer layout.
+		memcpy(vertexData.vertices, vertices, stride * vertexCount);
+	}
+
+	return true;
+}
+
+
+void MeshRegistryClass::ReleaseVertexData(VertexDataType& vertexData)
+{
+	if(vertexData.vertices)
+	{
+		delete [] vertexData.vertices;
+		vertexData.vertices = 0;
+	}
+
+	return;
+}
+
+
+bool MeshRegistryClass::CreateVertexBuffer(const VertexDataType& vertexData, int vertexCount, unsigned int stride, MeshType* mesh)
+{
+	D3D11_BUFFER_DESC vertexBufferDesc, quantizationBufferDesc;
+	D3D11_SUBRESOURCE_DATA vertexDataDesc, quantizationData;
+	HRESULT result;
+
+
+	mesh->vertexSize = stride;
+
+	if constexpr(VERTEX_COMPRESSION_ENABLED)
+	{
+		// The bounds go in a constant buffer of their own so the vertex shader can expand the positions again.
+		quantizationBufferDesc.Usage = D3D11_USAGE_IMMUTABLE;
+		quantizationBufferDesc.ByteWidth = sizeof(VertexCompressionClass::BoundsType);
+		quantizationBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		quantizationBufferDesc.CPUAccessFlags = 0;
+		quantizationBufferDesc.MiscFlags = 0;
+		quantizationBufferDesc.StructureByteStride = 0;
+
+		quantizationData.pSysMem = &vertexData.bounds;
+		quantizationData.SysMemPitch = 0;
+		quantizationData.SysMemSlicePitch = 0;
+
+		result = m_device->CreateBuffer(&quantizationBufferDesc, &quantizationData, &mesh->quantizationBuffer);
+		if(FAILED(result))
+		{
+			return false;
+		}
+	}
+
+	// Set up the description of the static vertex buffer.
+    vertexBufferDesc.Usage = D3D11_USAGE_DEFAULT;
+    vertexBufferDesc.ByteWidth = stride * vertexCount;
+    vertexBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    vertexBufferDesc.CPUAccessFlags = 0;
+    vertexBufferDesc.MiscFlags = 0;
+	vertexBufferDesc.StructureByteStride = 0;
+
+	// Give the subresource structure a pointer to the vertex data.
+	vertexDataDesc.pSysMem = vertexData.vertices;
+	vertexDataDesc.SysMemPitch = 0;
+	vertexDataDesc.SysMemSlicePitch = 0;
+
+	// Now create the vertex buffer.
+    result = m_device->CreateBuffer(&vertexBufferDesc, &vertexDataDesc, &mesh->vertexBuffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+void MeshRegistryClass::ReleaseLayout(MeshType* mesh)
+{
+	// Release the quantization constant buffer.
+	if(mesh->quantizationBuffer)
+	{
+		mesh->quantizationBuffer->Release();
+		mesh->quantizationBuffer = 0;
+	}
+
+	// Release the vertex buffer, the index buffer belongs to the source.
+	if(mesh->vertexBuffer)
+	{
+		mesh->vertexBuffer->Release();
+		mesh->vertexBuffer = 0;
+	}
+
+	delete mesh;
+
+	return;
+}
+
+
+string MeshRegistryClass::GetCanonicalName(const char* filename)
+{
+	filesystem::path path;
+	error_code error;
+	string name;
+	size_t i;
+
+
+	// The proxy has no file behind it.
+	if(strcmp(filename, MESH_PROXY_NAME) == 0)
+	{
+		return filename;
+	}
+
+	// Resolve the dots and links in the path, falling back to a plain absolute path if that fails.
+	path = filesystem::weakly_canonical(filesystem::path(filename), error);
+	if(error)
+	{
+		path = filesystem::absolute(filesystem::path(filename), error).lexically_normal();
+	}
+
+	name = path.generic_string();
+
+#ifdef _WIN32
+	// Windows paths are not case sensitive.
+	for(i=0; i<name.size(); i++)
+	{
+		name[i] = (char)tolower((unsigned char)name[i]);
+	}
+#endif
+
+	return name;
+}
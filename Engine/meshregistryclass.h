@@ -0,0 +1,324 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshregistryclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHREGISTRYCLASS_H_
+#define _MESHREGISTRYCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+#include <map>
+#include <mutex>
+#include <cstring>
+#include <string>
+#include <type_traits>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "assetarchiveclass.h"
+#include "meshcacheclass.h"
+#include "meshwelderclass.h"
+#include "tangentgeneratorclass.h"
+#include "vertexcompressionclass.h"
+#include "vertexlayouts.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char MESH_PROXY_NAME[] = "<proxy>";
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshRegistryClass
+////////////////////////////////////////////////////////////////////////////////
+class MeshRegistryClass
+{
+public:
+	// A shared mesh handle, the buffers belong to the registry and stay valid until the handle is released.
+	struct MeshType
+	{
+		ID3D11Buffer* vertexBuffer;
+		ID3D11Buffer* indexBuffer;
+		ID3D11Buffer* quantizationBuffer;
+		int vertexCount, indexCount, vertexSize;
+		int lodCount;
+		MeshCacheClass::LodType lods[MESH_LOD_MAX_LEVELS];
+		float center[3], radius;
+		const ClusterCullerClass::ClusterBlockType* clusterBlocks;
+		int clusterBlockCount;
+		int referenceCount;
+		MeshLayoutType layout;
+		string name;
+	};
+
+private:
+	// The packed vertices of one layout, built on the CPU and waiting to be put in a vertex buffer.
+	struct VertexDataType
+	{
+		unsigned char* vertices;
+		VertexCompressionClass::BoundsType bounds;
+	};
+
+	// One parsed mesh file, every layout built from it shares its index buffer.
+	struct SourceType
+	{
+		mutex loadMutex;
+		MeshCacheClass* meshCache;
+		ID3D11Buffer* indexBuffer;
+		const TangentVertexLayout::VertexType* cookedTangentVertices;
+		MeshType* layouts[MESH_LAYOUT_COUNT];
+		VertexDataType vertexData[MESH_LAYOUT_COUNT];
+	};
+
+public:
+	MeshRegistryClass();
+	MeshRegistryClass(const MeshRegistryClass&);
+	~MeshRegistryClass();
+
+	bool Initialize(ID3D11Device*, AssetArchiveClass*);
+	void Shutdown();
+
+	// Prepare can run on any thread, it does all the CPU work so Acquire only has to create the buffers.
+	template<class VertexLayout> bool Prepare(char*);
+	template<class VertexLayout> MeshType* Acquire(char*);
+	template<class VertexLayout> MeshType* AcquireProxy();
+	void Release(MeshType*);
+
+private:
+	SourceType* GetSource(const string&);
+	SourceType* FindSource(char*, string&, bool&);
+	bool LoadMeshData(SourceType*, char*);
+	bool CreateIndexBuffer(SourceType*);
+	void ReleaseSource(const string&);
+
+	template<class VertexLayout> bool BuildVertexData(SourceType*);
+	template<class VertexLayout> MeshType* CreateLayout(SourceType*, const string&);
+	bool PackVertices(const float*, int, const VertexCompressionClass::FormatType&, unsigned int, VertexDataType&);
+	void ReleaseVertexData(VertexDataType&);
+	MeshType* CreateMesh(SourceType*, MeshLayoutType, const string&);
+	bool CreateVertexBuffer(const VertexDataType&, int, unsigned int, MeshType*);
+	MeshType* ShareLayout(MeshType*, char*);
+	MeshType* AddLayout(SourceType*, MeshType*, const string&, bool, char*);
+	void ReleaseLayout(MeshType*);
+
+	static string GetCanonicalName(const char*);
+
+private:
+	ID3D11Device* m_device;
+	AssetArchiveClass* m_AssetArchive;
+	mutex m_mutex;
+	map<string, SourceType*> m_sources;
+	int m_loadCount, m_sharedCount, m_derivedCount;
+	long long m_sharedBytes;
+};
+
+
+template<class VertexLayout>
+bool MeshRegistryClass::Prepare(char* filename)
+{
+	SourceType* source;
+	bool result;
+
+
+	source = GetSource(GetCanonicalName(filename));
+	if(!source)
+	{
+		return false;
+	}
+
+	// Jobs preparing other layouts of the same file wait here while the first one parses it.
+	lock_guard<mutex> lock(source->loadMutex);
+
+	if(!source->meshCache)
+	{
+		result = LoadMeshData(source, filename);
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	// Nothing to do if the layout is already built or already waiting for its vertex buffer.
+	if(source->layouts[VertexLayout::meshLayout] || source->vertexData[VertexLayout::meshLayout].vertices)
+	{
+		return true;
+	}
+
+	return BuildVertexData<VertexLayout>(source);
+}
+
+
+template<class VertexLayout>
+MeshRegistryClass::MeshType* MeshRegistryClass::Acquire(char* filename)
+{
+	SourceType* source;
+	MeshType* mesh;
+	string name;
+	bool sourceLoaded;
+
+
+	// Find the parsed file or load it.
+	source = FindSource(filename, name, sourceLoaded);
+	if(!source)
+	{
+		return 0;
+	}
+
+	// If this layout has been built already just hand out another reference to it.
+	mesh = source->layouts[VertexLayout::meshLayout];
+	if(mesh)
+	{
+		return ShareLayout(mesh, filename);
+	}
+
+	// Otherwise build the layout from the parsed file.
+	mesh = CreateLayout<VertexLayout>(source, name);
+
+	return AddLayout(source, mesh, name, sourceLoaded, filename);
+}
+
+
+template<class VertexLayout>
+MeshRegistryClass::MeshType* MeshRegistryClass::AcquireProxy()
+{
+	char proxyName[sizeof(MESH_PROXY_NAME)];
+
+
+	memcpy(proxyName, MESH_PROXY_NAME, sizeof(MESH_PROXY_NAME));
+
+	// The proxy is built in memory rather than loaded so it is ready straight away, models draw it until their mesh streams in.
+	return Acquire<VertexLayout>(proxyName);
+}
+
+
+template<class VertexLayout>
+bool MeshRegistryClass::BuildVertexData(SourceType* source)
+{
+	typedef typename VertexLayout::VertexType VertexType;
+	const MeshCacheClass::VertexType* model;
+	const VertexType* vertices;
+	VertexType* layoutVertices;
+	TangentGeneratorClass::StatisticsType tangentStatistics;
+	bool result;
+	int vertexCount, indexCount, i;
+
+
+	static_assert(sizeof(VertexType) == sizeof(float) * VertexLayout::format.floatsPerVertex, "VertexType must match the layout format");
+
+	model = source->meshCache->GetVertices();
+	vertexCount = source->meshCache->GetVertexCount();
+	indexCount = (int)source->meshCache->GetLod(0).indexCount;
+
+	layoutVertices = 0;
+
+	if constexpr(is_same<VertexType, MeshCacheClass::VertexType>::value)
+	{
+		// The model data is already in this layout so it is used in place.
+		vertices = model;
+	}
+	else if(VertexLayout::meshLayout == MESH_LAYOUT_TANGENT && source->cookedTangentVertices)
+	{
+		// The asset cooker generated the tangent frames offline, they are used in place the same way.
+		vertices = (const VertexType*)source->cookedTangentVertices;
+	}
+	else
+	{
+		layoutVertices = new VertexType[vertexCount];
+		if(!layoutVertices)
+		{
+			return false;
+		}
+
+		// Copy the attributes this layout has out of the model data.
+		for(i=0; i<vertexCount; i++)
+		{
+			layoutVertices[i].x = model[i].x;
+			layoutVertices[i].y = model[i].y;
+			layoutVertices[i].z = model[i].z;
+			layoutVertices[i].tu = model[i].tu;
+			layoutVertices[i].tv = model[i].tv;
+
+			if constexpr(VertexLayout::format.normal >= 0)
+			{
+				layoutVertices[i].nx = model[i].nx;
+				layoutVertices[i].ny = model[i].ny;
+				layoutVertices[i].nz = model[i].nz;
+			}
+		}
+
+		// Derive the tangent frame for layouts that carry one, from the full mesh only since the other levels reuse its vertices.
+		if constexpr(VertexLayout::format.tangent >= 0)
+		{
+			result = TangentGeneratorClass::Generate(&layoutVertices[0].x, vertexCount, VertexLayout::format, source->meshCache->GetIndices(), indexCount,
+													 tangentStatistics);
+			if(!result)
+			{
+				delete [] layoutVertices;
+				return false;
+			}
+		}
+
+		vertices = layoutVertices;
+	}
+
+	// Pack the vertices into the form the vertex buffer takes.
+	result = PackVertices(&vertices[0].x, vertexCount, VertexLayout::format, VertexLayout::stride,
+						  source->vertexData[VertexLayout::meshLayout]);
+
+	// Release the layout vertices, the packed data is a copy.
+	if(layoutVertices)
+	{
+		delete [] layoutVertices;
+		layoutVertices = 0;
+	}
+
+	return result;
+}
+
+
+template<class VertexLayout>
+MeshRegistryClass::MeshType* MeshRegistryClass::CreateLayout(SourceType* source, const string& name)
+{
+	VertexDataType& vertexData = source->vertexData[VertexLayout::meshLayout];
+	MeshType* mesh;
+	bool result;
+
+
+	// Build the vertex data now unless a Prepare already did it on a loader thread.
+	if(!vertexData.vertices)
+	{
+		lock_guard<mutex> lock(source->loadMutex);
+
+		result = BuildVertexData<VertexLayout>(source);
+		if(!result)
+		{
+			ReleaseVertexData(vertexData);
+			return 0;
+		}
+	}
+
+	// Create the mesh handle and put the vertex data in a vertex buffer.
+	mesh = CreateMesh(source, VertexLayout::meshLayout, name);
+	if(mesh)
+	{
+		result = CreateVertexBuffer(vertexData, mesh->vertexCount, VertexLayout::stride, mesh);
+		if(!result)
+		{
+			ReleaseLayout(mesh);
+			mesh = 0;
+		}
+	}
+
+	// The vertex buffer has its own copy of the data.
+	ReleaseVertexData(vertexData);
+
+	return mesh;
+}
+
+#endif
@@ -0,0 +1,770 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshsimplifierclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshsimplifierclass.h"
+#include "meshwelderclass.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+const unsigned int NO_VERTEX = 0xffffffff;
+
+
+bool MeshSimplifierClass::Simplify(const float* vertices, int floatsPerVertex, int vertexCount, const float* attributeWeights,
+								   int attributeCount, const unsigned int* indices, int indexCount, int targetIndexCount, float targetError,
+								   unsigned int* output, int& outputCount, float& error)
+{
+	float *positions, *weldedPositions;
+	unsigned int *positionIds, *openNext, *openPrev, *seamPairs, *remap;
+	double *positionQuadrics, *attributeQuadrics;
+	unsigned char* kinds;
+	int *adjacencyOffset, *adjacency;
+	bool* touched;
+	CollapseType* collapses;
+	CollapseType candidate;
+	double u[3 + MESH_SIMPLIFIER_MAX_ATTRIBUTES], p[3][3], e1[3], e2[3], normal[3], edge[3], plane[3];
+	double length, area, d11, d12, d22, determinant, alpha, beta, d;
+	float minimum[3], maximum[3], extent, maximumCost;
+	unsigned int a, b, c, vertex;
+	int positionCount, positionSize, attributeDimension, attributeSize, triangleCount, collapseCount, collapseLimit, applied, pass;
+	int i, j, k, t;
+	bool result;
+
+
+	if(attributeCount < 0 || attributeCount > MESH_SIMPLIFIER_MAX_ATTRIBUTES || floatsPerVertex < 3 + attributeCount)
+	{
+		return false;
+	}
+
+	// Start from the full index list, every pass works on the output in place.
+	memcpy(output, indices, sizeof(unsigned int) * indexCount);
+	outputCount = indexCount;
+	error = 0.0f;
+
+	if(indexCount <= targetIndexCount || vertexCount == 0)
+	{
+		return true;
+	}
+
+	// Scale the positions into a unit box so the error is relative to the size of the mesh.
+	for(k=0; k<3; k++)
+	{
+		minimum[k] = FLT_MAX;
+		maximum[k] = -FLT_MAX;
+	}
+	for(i=0; i<vertexCount; i++)
+	{
+		for(k=0; k<3; k++)
+		{
+			minimum[k] = min(minimum[k], vertices[i * floatsPerVertex + k]);
+			maximum[k] = max(maximum[k], vertices[i * floatsPerVertex + k]);
+		}
+	}
+	extent = max(maximum[0] - minimum[0], max(maximum[1] - minimum[1], maximum[2] - minimum[2]));
+	extent = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+	positions = new float[vertexCount * 3];
+	weldedPositions = new float[vertexCount * 3];
+	positionIds = new unsigned int[vertexCount];
+	if(!positions || !weldedPositions || !positionIds)
+	{
+		return false;
+	}
+
+	for(i=0; i<vertexCount; i++)
+	{
+		for(k=0; k<3; k++)
+		{
+			positions[i * 3 + k] = (vertices[i * floatsPerVertex + k] - minimum[k]) * extent;
+		}
+	}
+
+	// Vertices that only differ in texture coordinates or normal share a position, the welder finds them.
+	result = MeshWelderClass::Weld(positions, vertexCount, 3, MESH_WELD_EPSILON, weldedPositions, positionCount, positionIds);
+
+	delete [] weldedPositions;
+	weldedPositions = 0;
+
+	if(!result)
+	{
+		return false;
+	}
+
+	// Create the quadrics, the shape error lives on the positions and the attribute error on the vertices.
+	positionSize = GetQuadricSize(3);
+	attributeDimension = 3 + attributeCount;
+	attributeSize = GetQuadricSize(attributeDimension);
+
+	positionQuadrics = new double[(size_t)positionCount * positionSize];
+	attributeQuadrics = new double[(size_t)vertexCount * attributeSize];
+	kinds = new unsigned char[vertexCount];
+	openNext = new unsigned int[vertexCount];
+	openPrev = new unsigned int[vertexCount];
+	seamPairs = new unsigned int[vertexCount];
+	remap = new unsigned int[vertexCount];
+	adjacencyOffset = new int[vertexCount + 1];
+	adjacency = new int[indexCount];
+	touched = new bool[positionCount];
+	collapses = new CollapseType[vertexCount];
+	if(!positionQuadrics || !attributeQuadrics || !kinds || !openNext || !openPrev || !seamPairs || !remap || !adjacencyOffset || !adjacency ||
+	   !touched || !collapses)
+	{
+		return false;
+	}
+
+	memset(positionQuadrics, 0, sizeof(double) * positionCount * positionSize);
+	memset(attributeQuadrics, 0, sizeof(double) * vertexCount * attributeSize);
+
+	triangleCount = indexCount / 3;
+
+	for(t=0; t<triangleCount; t++)
+	{
+		for(i=0; i<3; i++)
+		{
+			for(k=0; k<3; k++)
+			{
+				p[i][k] = positions[indices[t * 3 + i] * 3 + k];
+			}
+		}
+
+		for(k=0; k<3; k++)
+		{
+			e1[k] = p[1][k] - p[0][k];
+			e2[k] = p[2][k] - p[0][k];
+		}
+
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+		length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if(length == 0.0)
+		{
+			continue;
+		}
+
+		// Each corner gets the plane of the triangle weighted by its area, the squared distance to it is the shape error.
+		area = length * 0.5;
+		for(k=0; k<3; k++)
+		{
+			u[k] = normal[k] / length;
+		}
+		d = -(u[0] * p[0][0] + u[1] * p[0][1] + u[2] * p[0][2]);
+
+		for(i=0; i<3; i++)
+		{
+			AddTerm(&positionQuadrics[(size_t)positionIds[indices[t * 3 + i]] * positionSize], 3, u, d, area);
+			positionQuadrics[(size_t)(positionIds[indices[t * 3 + i]] + 1) * positionSize - 1] += area;
+		}
+
+		// Each attribute is linear across the triangle, the error is how far a vertex attribute is from that gradient at its position.
+		d11 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+		d12 = e1[0] * e2[0] + e1[1] * e2[1] + e1[2] * e2[2];
+		d22 = e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2];
+		determinant = d11 * d22 - d12 * d12;
+
+		for(j=0; j<attributeCount && determinant > 0.0; j++)
+		{
+			a = indices[t * 3];
+			b = indices[t * 3 + 1];
+			c = indices[t * 3 + 2];
+
+			alpha = ((vertices[b * floatsPerVertex + 3 + j] - vertices[a * floatsPerVertex + 3 + j]) * d22 -
+					 (vertices[c * floatsPerVertex + 3 + j] - vertices[a * floatsPerVertex + 3 + j]) * d12) / determinant;
+			beta = ((vertices[c * floatsPerVertex + 3 + j] - vertices[a * floatsPerVertex + 3 + j]) * d11 -
+					(vertices[b * floatsPerVertex + 3 + j] - vertices[a * floatsPerVertex + 3 + j]) * d12) / determinant;
+
+			memset(u, 0, sizeof(u));
+			for(k=0; k<3; k++)
+			{
+				u[k] = alpha * e1[k] + beta * e2[k];
+			}
+			u[3 + j] = -1.0;
+			d = vertices[a * floatsPerVertex + 3 + j] - (u[0] * p[0][0] + u[1] * p[0][1] + u[2] * p[0][2]);
+
+			for(i=0; i<3; i++)
+			{
+				AddTerm(&attributeQuadrics[(size_t)indices[t * 3 + i] * attributeSize], attributeDimension, u, d, area * attributeWeights[j]);
+			}
+		}
+
+		for(i=0; i<3; i++)
+		{
+			attributeQuadrics[(size_t)(indices[t * 3 + i] + 1) * attributeSize - 1] += area;
+		}
+	}
+
+	// Find the borders and seams of the original mesh and hold them in place with a plane through each open edge.
+	result = ClassifyVertices(indices, indexCount, positionIds, vertexCount, positionCount, kinds, openNext, openPrev, seamPairs);
+	if(!result)
+	{
+		return false;
+	}
+
+	for(t=0; t<triangleCount; t++)
+	{
+		for(i=0; i<3; i++)
+		{
+			a = indices[t * 3 + i];
+			b = indices[t * 3 + (i + 1) % 3];
+			c = indices[t * 3 + (i + 2) % 3];
+			if(openNext[a] != b)
+			{
+				continue;
+			}
+
+			for(k=0; k<3; k++)
+			{
+				edge[k] = positions[b * 3 + k] - positions[a * 3 + k];
+				e2[k] = positions[c * 3 + k] - positions[a * 3 + k];
+			}
+
+			normal[0] = edge[1] * e2[2] - edge[2] * e2[1];
+			normal[1] = edge[2] * e2[0] - edge[0] * e2[2];
+			normal[2] = edge[0] * e2[1] - edge[1] * e2[0];
+
+			// The constraint plane holds the edge and stands at right angles to the triangle.
+			plane[0] = edge[1] * normal[2] - edge[2] * normal[1];
+			plane[1] = edge[2] * normal[0] - edge[0] * normal[2];
+			plane[2] = edge[0] * normal[1] - edge[1] * normal[0];
+			length = sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+			if(length == 0.0)
+			{
+				continue;
+			}
+
+			for(k=0; k<3; k++)
+			{
+				u[k] = plane[k] / length;
+			}
+			d = -(u[0] * positions[a * 3] + u[1] * positions[a * 3 + 1] + u[2] * positions[a * 3 + 2]);
+			area = (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]) * MESH_SIMPLIFIER_EDGE_WEIGHT;
+
+			AddTerm(&positionQuadrics[(size_t)positionIds[a] * positionSize], 3, u, d, area);
+			AddTerm(&positionQuadrics[(size_t)positionIds[b] * positionSize], 3, u, d, area);
+		}
+	}
+
+	maximumCost = targetError * targetError;
+
+	for(pass=0; pass<MESH_SIMPLIFIER_MAX_PASSES && outputCount > targetIndexCount; pass++)
+	{
+		// The topology changes with every pass, so find the borders and seams again and rebuild the vertex to triangle lists.
+		result = ClassifyVertices(output, outputCount, positionIds, vertexCount, positionCount, kinds, openNext, openPrev, seamPairs);
+		if(!result)
+		{
+			return false;
+		}
+
+		BuildAdjacency(output, outputCount, vertexCount, adjacencyOffset, adjacency);
+
+		// Find the cheapest edge to collapse each vertex along.
+		for(i=0; i<vertexCount; i++)
+		{
+			collapses[i].cost = FLT_MAX;
+		}
+
+		for(i=0; i<outputCount; i++)
+		{
+			for(j=0; j<2; j++)
+			{
+				a = output[i];
+				b = output[i - i % 3 + (i + 1) % 3];
+				if(j == 1)
+				{
+					swap(a, b);
+				}
+
+				if(kinds[a] == VERTEX_LOCKED || positionIds[a] == positionIds[b])
+				{
+					continue;
+				}
+
+				candidate.source = a;
+				candidate.target = b;
+				candidate.seamSource = NO_VERTEX;
+				candidate.seamTarget = NO_VERTEX;
+
+				// Border and seam vertices only slide along their open edge so the outline keeps its shape.
+				if(kinds[a] == VERTEX_BORDER || kinds[a] == VERTEX_SEAM)
+				{
+					if(openNext[a] != b && openPrev[a] != b)
+					{
+						continue;
+					}
+				}
+
+				// A seam vertex takes its twin along the matching edge on the other side of the seam.
+				if(kinds[a] == VERTEX_SEAM)
+				{
+					candidate.seamSource = seamPairs[a];
+					candidate.seamTarget = openNext[a] == b ? openPrev[seamPairs[a]] : openNext[seamPairs[a]];
+					if(candidate.seamTarget == b || positionIds[candidate.seamTarget] != positionIds[b])
+					{
+						continue;
+					}
+				}
+
+				candidate.cost = GetCollapseCost(positions, vertices, floatsPerVertex, attributeCount, positionIds, positionQuadrics,
+												 attributeQuadrics, a, b);
+				if(candidate.seamSource != NO_VERTEX)
+				{
+					candidate.cost += GetCollapseCost(positions, vertices, floatsPerVertex, attributeCount, positionIds, positionQuadrics,
+													  attributeQuadrics, candidate.seamSource, candidate.seamTarget);
+				}
+
+				if(candidate.cost < collapses[a].cost)
+				{
+					collapses[a] = candidate;
+				}
+			}
+		}
+
+		// Cheapest collapses first.
+		collapseCount = 0;
+		for(i=0; i<vertexCount; i++)
+		{
+			if(collapses[i].cost < FLT_MAX)
+			{
+				collapses[collapseCount] = collapses[i];
+				collapseCount++;
+			}
+		}
+
+		stable_sort(collapses, collapses + collapseCount, [](const CollapseType& x, const CollapseType& y) { return x.cost < y.cost; });
+
+		// Each collapse takes out about two triangles, do not overshoot the target by much in one pass.
+		collapseLimit = (outputCount - targetIndexCount) / 6 + 1;
+
+		for(i=0; i<vertexCount; i++)
+		{
+			remap[i] = (unsigned int)i;
+		}
+		memset(touched, 0, sizeof(bool) * positionCount);
+
+		applied = 0;
+		for(i=0; i<collapseCount && applied<collapseLimit; i++)
+		{
+			candidate = collapses[i];
+			if(candidate.cost > maximumCost)
+			{
+				break;
+			}
+
+			// Only one collapse per neighbourhood in a pass so the adjacency lists stay true.
+			if(touched[positionIds[candidate.source]] || touched[positionIds[candidate.target]])
+			{
+				continue;
+			}
+
+			if(FlipsTriangle(positions, output, adjacencyOffset, adjacency, candidate.source, candidate.target))
+			{
+				continue;
+			}
+			if(candidate.seamSource != NO_VERTEX &&
+			   FlipsTriangle(positions, output, adjacencyOffset, adjacency, candidate.seamSource, candidate.seamTarget))
+			{
+				continue;
+			}
+
+			// Collapse the vertex and hand its error on to the vertex it became.
+			remap[candidate.source] = candidate.target;
+			AddQuadric(&positionQuadrics[(size_t)positionIds[candidate.target] * positionSize],
+					   &positionQuadrics[(size_t)positionIds[candidate.source] * positionSize], positionSize);
+			AddQuadric(&attributeQuadrics[(size_t)candidate.target * attributeSize], &attributeQuadrics[(size_t)candidate.source * attributeSize],
+					   attributeSize);
+
+			if(candidate.seamSource != NO_VERTEX)
+			{
+				remap[candidate.seamSource] = candidate.seamTarget;
+				AddQuadric(&attributeQuadrics[(size_t)candidate.seamTarget * attributeSize],
+						   &attributeQuadrics[(size_t)candidate.seamSource * attributeSize], attributeSize);
+			}
+
+			// Lock everything around the collapse until the next pass.
+			for(j=0; j<2; j++)
+			{
+				vertex = j == 0 ? candidate.source : candidate.seamSource;
+				if(vertex == NO_VERTEX)
+				{
+					continue;
+				}
+
+				for(k=adjacencyOffset[vertex]; k<adjacencyOffset[vertex + 1]; k++)
+				{
+					touched[positionIds[output[adjacency[k] * 3]]] = true;
+					touched[positionIds[output[adjacency[k] * 3 + 1]]] = true;
+					touched[positionIds[output[adjacency[k] * 3 + 2]]] = true;
+				}
+			}
+			touched[positionIds[candidate.source]] = true;
+			touched[positionIds[candidate.target]] = true;
+
+			error = max(error, candidate.cost);
+			applied++;
+		}
+
+		if(applied == 0)
+		{
+			break;
+		}
+
+		// Rewrite the triangles through the collapses and drop the ones that lost their area.
+		k = 0;
+		for(t=0; t<outputCount / 3; t++)
+		{
+			a = remap[output[t * 3]];
+			b = remap[output[t * 3 + 1]];
+			c = remap[output[t * 3 + 2]];
+
+			if(positionIds[a] == positionIds[b] || positionIds[b] == positionIds[c] || positionIds[c] == positionIds[a])
+			{
+				continue;
+			}
+
+			output[k] = a;
+			output[k + 1] = b;
+			output[k + 2] = c;
+			k += 3;
+		}
+		outputCount = k;
+	}
+
+	error = sqrt(error);
+
+	// Release the work arrays.
+	delete [] positions;
+	delete [] positionIds;
+	delete [] positionQuadrics;
+	delete [] attributeQuadrics;
+	delete [] kinds;
+	delete [] openNext;
+	delete [] openPrev;
+	delete [] seamPairs;
+	delete [] remap;
+	delete [] adjacencyOffset;
+	delete [] adjacency;
+	delete [] touched;
+	delete [] collapses;
+
+	return true;
+}
+
+
+bool MeshSimplifierClass::ClassifyVertices(const unsigned int* indices, int indexCount, const unsigned int* positionIds, int vertexCount,
+										   int positionCount, unsigned char* kinds, unsigned int* openNext, unsigned int* openPrev,
+										   unsigned int* seamPairs)
+{
+	unsigned long long* edges;
+	unsigned int *firstWedge, *secondWedge;
+	int *wedgeCount, *openCount;
+	unsigned long long twin;
+	unsigned int a, b, other, position;
+	int i;
+
+
+	edges = new unsigned long long[indexCount > 0 ? indexCount : 1];
+	firstWedge = new unsigned int[positionCount];
+	secondWedge = new unsigned int[positionCount];
+	wedgeCount = new int[positionCount];
+	openCount = new int[vertexCount];
+	if(!edges || !firstWedge || !secondWedge || !wedgeCount || !openCount)
+	{
+		return false;
+	}
+
+	// Sort every directed edge so the edge running the other way can be looked up.
+	for(i=0; i<indexCount; i++)
+	{
+		a = indices[i];
+		b = indices[i - i % 3 + (i + 1) % 3];
+		edges[i] = ((unsigned long long)a << 32) | b;
+	}
+	sort(edges, edges + indexCount);
+
+	// An edge without a twin is open, either the border of the mesh or one side of an attribute seam.
+	memset(openCount, 0, sizeof(int) * vertexCount);
+	for(i=0; i<vertexCount; i++)
+	{
+		openNext[i] = NO_VERTEX;
+		openPrev[i] = NO_VERTEX;
+		seamPairs[i] = NO_VERTEX;
+	}
+
+	for(i=0; i<indexCount; i++)
+	{
+		a = indices[i];
+		b = indices[i - i % 3 + (i + 1) % 3];
+		twin = ((unsigned long long)b << 32) | a;
+		if(!binary_search(edges, edges + indexCount, twin))
+		{
+			openNext[a] = b;
+			openPrev[b] = a;
+			openCount[a]++;
+			openCount[b]++;
+		}
+	}
+
+	// Count the vertices still in use at each position.
+	memset(wedgeCount, 0, sizeof(int) * positionCount);
+	for(i=0; i<indexCount; i++)
+	{
+		a = indices[i];
+		position = positionIds[a];
+		if(wedgeCount[position] > 0 && (firstWedge[position] == a || (wedgeCount[position] > 1 && secondWedge[position] == a)))
+		{
+			continue;
+		}
+
+		if(wedgeCount[position] == 0)
+		{
+			firstWedge[position] = a;
+		}
+		else if(wedgeCount[position] == 1)
+		{
+			secondWedge[position] = a;
+		}
+		wedgeCount[position]++;
+	}
+
+	for(i=0; i<vertexCount; i++)
+	{
+		kinds[i] = VERTEX_LOCKED;
+	}
+
+	for(i=0; i<indexCount; i++)
+	{
+		a = indices[i];
+		position = positionIds[a];
+
+		if(wedgeCount[position] == 1)
+		{
+			if(openCount[a] == 0)
+			{
+				kinds[a] = VERTEX_MANIFOLD;
+			}
+			else if(openCount[a] == 2 && openNext[a] != NO_VERTEX && openPrev[a] != NO_VERTEX)
+			{
+				kinds[a] = VERTEX_BORDER;
+			}
+		}
+		else if(wedgeCount[position] == 2)
+		{
+			// Two vertices on a seam each have one open edge in and one out, and the edges match up across the seam.
+			other = firstWedge[position] == a ? secondWedge[position] : firstWedge[position];
+			if(openCount[a] == 2 && openCount[other] == 2 && openNext[a] != NO_VERTEX && openPrev[a] != NO_VERTEX &&
+			   openNext[other] != NO_VERTEX && openPrev[other] != NO_VERTEX &&
+			   positionIds[openNext[a]] == positionIds[openPrev[other]] && positionIds[openPrev[a]] == positionIds[openNext[other]])
+			{
+				kinds[a] = VERTEX_SEAM;
+				seamPairs[a] = other;
+			}
+		}
+	}
+
+	delete [] edges;
+	delete [] firstWedge;
+	delete [] secondWedge;
+	delete [] wedgeCount;
+	delete [] openCount;
+
+	return true;
+}
+
+
+void MeshSimplifierClass::BuildAdjacency(const unsigned int* indices, int indexCount, int vertexCount, int* adjacencyOffset, int* adjacency)
+{
+	int i;
+
+
+	// Count the triangles on each vertex, turn the counts into offsets, then fill the lists.
+	memset(adjacencyOffset, 0, sizeof(int) * (vertexCount + 1));
+	for(i=0; i<indexCount; i++)
+	{
+		adjacencyOffset[indices[i] + 1]++;
+	}
+
+	for(i=0; i<vertexCount; i++)
+	{
+		adjacencyOffset[i + 1] += adjacencyOffset[i];
+	}
+
+	for(i=0; i<indexCount; i++)
+	{
+		adjacency[adjacencyOffset[indices[i]]] = i / 3;
+		adjacencyOffset[indices[i]]++;
+	}
+
+	for(i=vertexCount; i>0; i--)
+	{
+		adjacencyOffset[i] = adjacencyOffset[i - 1];
+	}
+	adjacencyOffset[0] = 0;
+
+	return;
+}
+
+
+bool MeshSimplifierClass::FlipsTriangle(const float* positions, const unsigned int* indices, const int* adjacencyOffset, const int* adjacency,
+										unsigned int source, unsigned int target)
+{
+	const float *p0, *p1, *p2, *moved[3];
+	float before[3], after[3], e1[3], e2[3];
+	unsigned int triangle[3];
+	int i, k;
+
+
+	for(i=adjacencyOffset[source]; i<adjacencyOffset[source + 1]; i++)
+	{
+		triangle[0] = indices[adjacency[i] * 3];
+		triangle[1] = indices[adjacency[i] * 3 + 1];
+		triangle[2] = indices[adjacency[i] * 3 + 2];
+
+		// The triangles on the collapsed edge disappear, they cannot flip.
+		if(triangle[0] == target || triangle[1] == target || triangle[2] == target)
+		{
+			continue;
+		}
+
+		p0 = &positions[triangle[0] * 3];
+		p1 = &positions[triangle[1] * 3];
+		p2 = &positions[triangle[2] * 3];
+
+		for(k=0; k<3; k++)
+		{
+			e1[k] = p1[k] - p0[k];
+			e2[k] = p2[k] - p0[k];
+		}
+		before[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		before[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		before[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+		for(k=0; k<3; k++)
+		{
+			moved[k] = triangle[k] == source ? &positions[target * 3] : &positions[triangle[k] * 3];
+		}
+
+		for(k=0; k<3; k++)
+		{
+			e1[k] = moved[1][k] - moved[0][k];
+			e2[k] = moved[2][k] - moved[0][k];
+		}
+		after[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		after[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		after[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+		// Turning a triangle over, or squashing it flat, folds the surface.
+		if(before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0f)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+float MeshSimplifierClass::GetCollapseCost(const float* positions, const float* vertices, int floatsPerVertex, int attributeCount,
+										   const unsigned int* positionIds, const double* positionQuadrics, const double* attributeQuadrics,
+										   unsigned int source, unsigned int target)
+{
+	double point[3 + MESH_SIMPLIFIER_MAX_ATTRIBUTES];
+	int k;
+
+
+	// The source takes on the position and attributes of the target.
+	for(k=0; k<3; k++)
+	{
+		point[k] = positions[target * 3 + k];
+	}
+	for(k=0; k<attributeCount; k++)
+	{
+		point[3 + k] = vertices[target * floatsPerVertex + 3 + k];
+	}
+
+	return (float)(EvaluateQuadric(&positionQuadrics[(size_t)positionIds[source] * GetQuadricSize(3)], 3, point) +
+				   EvaluateQuadric(&attributeQuadrics[(size_t)source * GetQuadricSize(3 + attributeCount)], 3 + attributeCount, point));
+}
+
+
+void MeshSimplifierClass::AddTerm(double* quadric, int dimension, const double* u, double d, double weight)
+{
+	int i, j, k;
+
+
+	// Adds weight * (u.x + d)^2, stored as the upper triangle of A, then b, then c, then the total area in the last slot.
+	k = 0;
+	for(i=0; i<dimension; i++)
+	{
+		for(j=i; j<dimension; j++)
+		{
+			quadric[k] += weight * u[i] * u[j];
+			k++;
+		}
+	}
+
+	for(i=0; i<dimension; i++)
+	{
+		quadric[k + i] += weight * d * u[i];
+	}
+
+	quadric[k + dimension] += weight * d * d;
+
+	return;
+}
+
+
+void MeshSimplifierClass::AddQuadric(double* quadric, const double* other, int size)
+{
+	int i;
+
+
+	for(i=0; i<size; i++)
+	{
+		quadric[i] += other[i];
+	}
+
+	return;
+}
+
+
+double MeshSimplifierClass::EvaluateQuadric(const double* quadric, int dimension, const double* point)
+{
+	double sum, weight;
+	int i, j, k;
+
+
+	sum = 0.0;
+	k = 0;
+	for(i=0; i<dimension; i++)
+	{
+		for(j=i; j<dimension; j++)
+		{
+			sum += quadric[k] * point[i] * point[j] * (i == j ? 1.0 : 2.0);
+			k++;
+		}
+	}
+
+	for(i=0; i<dimension; i++)
+	{
+		sum += 2.0 * quadric[k + i] * point[i];
+	}
+
+	sum += quadric[k + dimension];
+	weight = quadric[k + dimension + 1];
+
+	// Averaged over the area the error was gathered from, so big and small triangles compare fairly.
+	return weight > 0.0 ? fabs(sum) / weight : 0.0;
+}
+
+
+int MeshSimplifierClass::GetQuadricSize(int dimension)
+{
+	return dimension * (dimension + 1) / 2 + dimension + 2;
+}
@@ -0,0 +1,61 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshsimplifierclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHSIMPLIFIERCLASS_H_
+#define _MESHSIMPLIFIERCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int MESH_SIMPLIFIER_MAX_ATTRIBUTES = 8;
+const float MESH_SIMPLIFIER_EDGE_WEIGHT = 10.0f;
+const int MESH_SIMPLIFIER_MAX_PASSES = 64;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshSimplifierClass
+//
+// Quadric error simplification that only collapses vertices onto neighbouring
+// vertices, so every level of detail indexes the same vertex buffer.  The
+// geometric error is kept per position and the attribute error per vertex, so
+// UV and normal seams are weighed as well as the shape.  Border and seam edges
+// only collapse along themselves.
+////////////////////////////////////////////////////////////////////////////////
+class MeshSimplifierClass
+{
+private:
+	enum VertexKindType
+	{
+		VERTEX_MANIFOLD,	// one vertex at its position, surrounded by triangles
+		VERTEX_BORDER,		// one vertex at its position on an open edge
+		VERTEX_SEAM,		// two vertices at one position with an attribute seam between them
+		VERTEX_LOCKED		// anything else, never moved
+	};
+
+	// Moving source onto target, a seam vertex takes the vertex on the other side of the seam with it.
+	struct CollapseType
+	{
+		unsigned int source, target;
+		unsigned int seamSource, seamTarget;
+		float cost;
+	};
+
+public:
+	static bool Simplify(const float*, int, int, const float*, int, const unsigned int*, int, int, float, unsigned int*, int&, float&);
+
+private:
+	static bool ClassifyVertices(const unsigned int*, int, const unsigned int*, int, int, unsigned char*, unsigned int*, unsigned int*,
+								 unsigned int*);
+	static void BuildAdjacency(const unsigned int*, int, int, int*, int*);
+	static bool FlipsTriangle(const float*, const unsigned int*, const int*, const int*, unsigned int, unsigned int);
+	static float GetCollapseCost(const float*, const float*, int, int, const unsigned int*, const double*, const double*, unsigned int,
+								 unsigned int);
+
+	static void AddTerm(double*, int, const double*, double, double);
+	static void AddQuadric(double*, const double*, int);
+	static double EvaluateQuadric(const double*, int, const double*);
+	static int GetQuadricSize(int);
+};
+
+#endif
@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshwelderclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "meshwelderclass.h"
+
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int MESH_WELD_MAX_FLOATS = 32;
+
+
+bool MeshWelderClass::Weld(const float* vertices, int vertexCount, int floatsPerVertex, float epsilon, float* weldedVertices,
+						   int& weldedCount, unsigned int* indices)
+{
+	long long key[MESH_WELD_MAX_FLOATS], otherKey[MESH_WELD_MAX_FLOATS];
+	int* table;
+	unsigned long long slot;
+	unsigned int tableMask;
+	int tableSize, i, candidate;
+	bool found;
+
+
+	if(floatsPerVertex > MESH_WELD_MAX_FLOATS || vertexCount < 0)
+	{
+		return false;
+	}
+
+	// Size the hash table to at least twice the vertex count so the linear probes stay short.
+	tableSize = 16;
+	while(tableSize < vertexCount * 2)
+	{
+		tableSize *= 2;
+	}
+	tableMask = (unsigned int)(tableSize - 1);
+
+	// Create the hash table of welded vertex numbers, -1 marks an empty slot.
+	table = new int[tableSize];
+	if(!table)
+	{
+		return false;
+	}
+	memset(table, 0xff, sizeof(int) * tableSize);
+
+	weldedCount = 0;
+
+	for(i=0; i<vertexCount; i++)
+	{
+		// Snap every attribute of the vertex to the epsilon grid and hash the result.
+		QuantizeVertex(&vertices[i * floatsPerVertex], floatsPerVertex, epsilon, key);
+		slot = HashVertex(key, floatsPerVertex) & tableMask;
+
+		// Walk the probe sequence until either a matching vertex or an empty slot is found.
+		found = false;
+		while(table[slot] >= 0)
+		{
+			candidate = table[slot];
+			QuantizeVertex(&weldedVertices[candidate * floatsPerVertex], floatsPerVertex, epsilon, otherKey);
+			if(memcmp(key, otherKey, sizeof(long long) * floatsPerVertex) == 0)
+			{
+				found = true;
+				break;
+			}
+
+			slot = (slot + 1) & tableMask;
+		}
+
+		// A new vertex is appended to the welded array, the first copy seen is kept.
+		if(!found)
+		{
+			candidate = weldedCount;
+			memcpy(&weldedVertices[candidate * floatsPerVertex], &vertices[i * floatsPerVertex], sizeof(float) * floatsPerVertex);
+			table[slot] = candidate;
+			weldedCount++;
+		}
+
+		indices[i] = (unsigned int)candidate;
+	}
+
+	// Release the hash table.
+	delete [] table;
+	table = 0;
+
+	return true;
+}
+
+
+unsigned long long MeshWelderClass::HashVertex(const long long* key, int count)
+{
+	unsigned long long hash;
+	int i;
+
+
+	// FNV-1a over the quantized attributes followed by a final avalanche so nearby grid cells spread out.
+	hash = 14695981039346656037ULL;
+	for(i=0; i<count; i++)
+	{
+		hash ^= (unsigned long long)key[i];
+		hash *= 1099511628211ULL;
+	}
+
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+
+	return hash;
+}
+
+
+void MeshWelderClass::QuantizeVertex(const float* vertex, int count, float epsilon, long long* key)
+{
+	unsigned int bits;
+	int i;
+
+
+	// Rounding also folds -0 and 0 together, which the text exporter writes interchangeably.
+	for(i=0; i<count; i++)
+	{
+		if(epsilon > 0.0f)
+		{
+			key[i] = llround((double)vertex[i] / (double)epsilon);
+		}
+		else
+		{
+			memcpy(&bits, &vertex[i], sizeof(bits));
+			key[i] = (vertex[i] == 0.0f) ? 0 : (long long)bits;
+		}
+	}
+
+	return;
+}
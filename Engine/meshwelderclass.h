@@ -0,0 +1,27 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshwelderclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MESHWELDERCLASS_H_
+#define _MESHWELDERCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const float MESH_WELD_EPSILON = 0.0001f;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: MeshWelderClass
+////////////////////////////////////////////////////////////////////////////////
+class MeshWelderClass
+{
+public:
+	static bool Weld(const float*, int, int, float, float*, int&, unsigned int*);
+
+private:
+	static unsigned long long HashVertex(const long long*, int);
+	static void QuantizeVertex(const float*, int, float, long long*);
+};
+
+#endif
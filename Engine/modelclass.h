@@ -5,72 +5,17 @@
 #define _MODELCLASS_H_
 
 
-//////////////
-// INCLUDES //
-//////////////
-#include <d3d11_1.h>
-#include <DirectXMath.h> 
-using namespace DirectX;
-
-#include <fstream>
-using namespace std;
-
-
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
-#include "textureclass.h"
+#include "modeltemplateclass.h"
 
 
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: ModelClass
+//
+// Draws with the position, texture and normal layout and one texture.
 ////////////////////////////////////////////////////////////////////////////////
-class ModelClass
-{
-private:
-	struct VertexType
-	{
-		XMFLOAT3  position;
-		XMFLOAT2  texture;
-		XMFLOAT3  normal;
-	};
-
-	struct ModelType
-	{
-		float x, y, z;
-		float tu, tv;
-		float nx, ny, nz;
-	};
-
-public:
-	ModelClass();
-	ModelClass(const ModelClass&);
-	~ModelClass();
-
-	bool Initialize(ID3D11Device*, char*, WCHAR*);
-	void Shutdown();
-	void Render(ID3D11DeviceContext*);
-
-	int GetIndexCount();
-	ID3D11ShaderResourceView* GetTexture();
-
-
-private:
-	bool InitializeBuffers(ID3D11Device*);
-	void ShutdownBuffers();
-	void RenderBuffers(ID3D11DeviceContext*);
-
-	bool LoadTexture(ID3D11Device*, WCHAR*);
-	void ReleaseTexture();
-
-	bool LoadModel(char*);
-	void ReleaseModel();
-
-private:
-	ID3D11Buffer *m_vertexBuffer, *m_indexBuffer;
-	int m_vertexCount, m_indexCount;
-	TextureClass* m_Texture;
-	ModelType* m_model;
-};
+typedef ModelTemplateClass<NormalVertexLayout, 1> ModelClass;
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,669 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: modeltemplateclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _MODELTEMPLATECLASS_H_
+#define _MODELTEMPLATECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+#include <DirectXMath.h>
+using namespace DirectX;
+
+#include <filesystem>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "jobsystemclass.h"
+#include "streamedassetclass.h"
+#include "meshregistryclass.h"
+#include "textureregistryclass.h"
+#include "clustercullerclass.h"
+#include "statecacheclass.h"
+#include "drawlist.h"
+#include "vertexlayouts.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// A level of detail is used while its error covers less than this many pixels on screen.
+const float MODEL_LOD_PIXEL_ERROR = 1.0f;
+// How far past the threshold the error has to be before the level changes, so a model at the boundary does not flicker.
+const float MODEL_LOD_HYSTERESIS = 0.25f;
+// How far apart the squared scales of the world axes can be, relative to each other, and still count as a uniform scale.
+const float MODEL_CONE_SCALE_TOLERANCE = 0.001f;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: ModelTemplateClass
+//
+// A model drawn with one of the vertex layouts in vertexlayouts.h and a fixed
+// number of textures.  The layout decides at compile time which vertex buffer
+// the registry builds and the stride it is bound with.
+//
+// Loading is split in two.  Prepare queues the file reads, parsing and vertex
+// packing on the job system and Initialize puts a proxy mesh and one texel
+// placeholder textures in place straight away.  Update, called every frame on
+// the thread that owns the device, swaps in each resource whose job is done.
+// A mesh or texture that could not be loaded is logged once and its proxy or
+// placeholder stays in its place.
+// Meshes and textures come from the registries, so models using the same
+// files share them.
+//
+// SelectLod picks the level of detail of the next draw from the size of its
+// error on screen, and tells the texture registry how many pixels the model
+// covers so the mips that needs are streamed in.  All levels share the vertex
+// and index buffers, each level is a range of clusters.  Cull tests those
+// clusters against the frustum and their normal cones and leaves the
+// survivors in the draw list the shaders draw from.  Without a call to Cull
+// the whole level is drawn.
+//
+// Instances drawn with one call share a level.  SelectLod is given a matrix
+// for the group and how far its instances spread from it, and picks the level
+// the closest of them could need.
+////////////////////////////////////////////////////////////////////////////////
+template<class VertexLayout, int TextureCount>
+class ModelTemplateClass
+{
+	static_assert(TextureCount >= 1 && TextureCount <= 3, "A model takes between one and three textures");
+
+public:
+	ModelTemplateClass();
+	ModelTemplateClass(const ModelTemplateClass&);
+	~ModelTemplateClass();
+
+	bool Prepare(JobSystemClass*, MeshRegistryClass*, TextureRegistryClass*, char*, WCHAR*, WCHAR* = 0, WCHAR* = 0);
+	bool Initialize(ID3D11Device*);
+	bool Update(ID3D11Device*);
+	void Shutdown();
+	void Render(StateCacheClass*);
+
+	int SelectLod(const XMMATRIX&, const XMMATRIX&, float, int, float = 0.0f);
+	void Cull(const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ClusterCullerClass::StatisticsType&);
+
+	bool IsResident();
+	int GetIndexCount();
+	int GetLod();
+	int GetLodCount();
+	float GetBoundingRadius();
+	DrawListType GetDrawList();
+	int GetTextureCount();
+	ID3D11ShaderResourceView* GetTexture(int);
+	int GetTextureSlice(int);
+
+private:
+	void RenderBuffers(StateCacheClass*);
+	void RequestTextures(FXMVECTOR, float, float, float);
+
+	bool LoadTextures(ID3D11Device*);
+	void ReleaseTextures();
+
+	bool LoadModel();
+	bool SwapModel();
+	void ReleaseModel();
+
+	bool CreateDrawList();
+	void ResetDrawList();
+
+private:
+	TextureRegistryClass::TextureType* m_Textures[TextureCount];
+	TextureRegistryClass* m_TextureRegistry;
+	MeshRegistryClass* m_MeshRegistry;
+	char* m_modelFilename;
+	MeshRegistryClass::MeshType* m_Mesh;
+	StreamedAssetClass m_meshState;
+	int m_lod;
+	DrawRangeType* m_draws;
+	int m_drawCount;
+};
+
+
+template<class VertexLayout, int TextureCount>
+ModelTemplateClass<VertexLayout, TextureCount>::ModelTemplateClass()
+{
+	int i;
+
+
+	for(i=0; i<TextureCount; i++)
+	{
+		m_Textures[i] = 0;
+	}
+	m_TextureRegistry = 0;
+	m_MeshRegistry = 0;
+	m_modelFilename = 0;
+	m_Mesh = 0;
+	m_lod = 0;
+	m_draws = 0;
+	m_drawCount = 0;
+}
+
+
+template<class VertexLayout, int TextureCount>
+ModelTemplateClass<VertexLayout, TextureCount>::ModelTemplateClass(const ModelTemplateClass& other)
+{
+}
+
+
+template<class VertexLayout, int TextureCount>
+ModelTemplateClass<VertexLayout, TextureCount>::~ModelTemplateClass()
+{
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::Prepare(JobSystemClass* jobSystem, MeshRegistryClass* meshRegistry,
+															 TextureRegistryClass* textureRegistry, char* modelFilename, WCHAR* textureFilename1,
+															 WCHAR* textureFilename2, WCHAR* textureFilename3)
+{
+	WCHAR* textureFilenames[3];
+	int i;
+
+
+	// Keep the registries and the file name for Initialize.
+	m_MeshRegistry = meshRegistry;
+	m_TextureRegistry = textureRegistry;
+	m_modelFilename = modelFilename;
+
+	// Parse the mesh and build this layout of it on a loader thread, then let the frame loop know it can be swapped in.
+	jobSystem->Submit(filesystem::path(modelFilename).filename().string(), [this]()
+	{
+		m_meshState.SetLoaded(m_MeshRegistry->Prepare<VertexLayout>(m_modelFilename));
+	});
+
+	// Ask the registry for each texture, it reads the file in on a loader thread unless another model has already asked for it.
+	// Only the first TextureCount filenames are used.
+	textureFilenames[0] = textureFilename1;
+	textureFilenames[1] = textureFilename2;
+	textureFilenames[2] = textureFilename3;
+
+	for(i=0; i<TextureCount; i++)
+	{
+		m_Textures[i] = m_TextureRegistry->Acquire(jobSystem, textureFilenames[i]);
+		if(!m_Textures[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::Initialize(ID3D11Device* device)
+{
+	bool result;
+
+
+	// Draw the proxy mesh until the real one has streamed in.
+	result = LoadModel();
+	if(!result)
+	{
+		return false;
+	}
+
+	// Put the placeholder textures in place.
+	result = LoadTextures(device);
+	if(!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::Update(ID3D11Device* device)
+{
+	bool result;
+	int i;
+
+
+	// Swap in the mesh once its job has built the vertex data, creating the buffers does not wait on anything.
+	m_meshState.Update([this]() { return SwapModel(); });
+	if(m_meshState.TakeFailure())
+	{
+		LoadLogClass::Write("model %s: could not be loaded, drawing its proxy instead", m_modelFilename);
+	}
+
+	// Swap in the textures that have finished loading, the registry logs those that could not be loaded and keeps their placeholders.
+	for(i=0; i<TextureCount; i++)
+	{
+		result = m_TextureRegistry->Update(m_Textures[i]);
+		if(!result)
+		{
+			LoadLogClass::Write("model %s: could not set up the streaming of texture %d", m_modelFilename, i);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::Shutdown()
+{
+	// Release the model textures.
+	ReleaseTextures();
+
+	// Release the model data.
+	ReleaseModel();
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::Render(StateCacheClass* stateCache)
+{
+	// Put the vertex and index buffers on the graphics pipeline to prepare them for drawing.
+	RenderBuffers(stateCache);
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+int ModelTemplateClass<VertexLayout, TextureCount>::SelectLod(const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix, float pixelScale, int lod,
+															 float spread)
+{
+	XMVECTOR center, scale;
+	float distance, worldScale, threshold;
+
+
+	// Scale the bounding sphere with the largest axis of the world matrix and find how far its surface is from the camera.
+	scale = XMVectorMax(XMVector3LengthSq(worldMatrix.r[0]), XMVectorMax(XMVector3LengthSq(worldMatrix.r[1]), XMVector3LengthSq(worldMatrix.r[2])));
+	worldScale = sqrtf(XMVectorGetX(scale));
+
+	center = XMVector3TransformCoord(XMLoadFloat3((const XMFLOAT3*)m_Mesh->center), XMMatrixMultiply(worldMatrix, viewMatrix));
+	distance = XMVectorGetX(XMVector3Length(center)) - m_Mesh->radius * worldScale - spread;
+
+	// The same bounds decide the texture mips this draw needs.
+	RequestTextures(center, m_Mesh->radius * worldScale, spread, pixelScale);
+
+	// Close enough to touch the mesh, or nothing to choose from, so draw it in full.
+	if(distance <= 0.0f || m_Mesh->lodCount == 1)
+	{
+		m_lod = 0;
+		ResetDrawList();
+		return m_lod;
+	}
+
+	// Turn the pixels per unit at a distance of one into pixels per unit of model space error at this distance.
+	pixelScale = pixelScale * worldScale / distance;
+
+	if(lod < 0)
+	{
+		lod = 0;
+	}
+	if(lod >= m_Mesh->lodCount)
+	{
+		lod = m_Mesh->lodCount - 1;
+	}
+
+	// Go finer as soon as the current level is clearly over the threshold, but only go coarser once the next level is clearly under it.
+	threshold = MODEL_LOD_PIXEL_ERROR / pixelScale;
+	if(m_Mesh->lods[lod].error > threshold * (1.0f + MODEL_LOD_HYSTERESIS))
+	{
+		while(lod > 0 && m_Mesh->lods[lod].error > threshold)
+		{
+			lod--;
+		}
+	}
+	else
+	{
+		while(lod + 1 < m_Mesh->lodCount && m_Mesh->lods[lod + 1].error < threshold * (1.0f - MODEL_LOD_HYSTERESIS))
+		{
+			lod++;
+		}
+	}
+
+	m_lod = lod;
+	ResetDrawList();
+
+	return m_lod;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::Cull(const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix, const XMMATRIX& projectionMatrix,
+														  ClusterCullerClass::StatisticsType& statistics)
+{
+	ClusterCullerClass::FrustumType frustum;
+	XMMATRIX worldView;
+	XMFLOAT4X4 worldViewProjection;
+	XMFLOAT3 camera, scale;
+	bool uniform;
+
+
+	// A level without clusters keeps the full range SelectLod put in the draw list.
+	if(m_Mesh->lods[m_lod].blockCount == 0)
+	{
+		return;
+	}
+
+	// The clusters are in model space, so bring the frustum and the camera there rather than every cluster to the camera.
+	worldView = XMMatrixMultiply(worldMatrix, viewMatrix);
+	XMStoreFloat4x4(&worldViewProjection, XMMatrixMultiply(worldView, projectionMatrix));
+	XMStoreFloat3(&camera, XMVector3TransformCoord(XMVectorZero(), XMMatrixInverse(nullptr, worldView)));
+
+	// The normal cones were built for the mesh as it is, so they only hold under a world matrix that scales every axis the same
+	// and does not mirror.  Otherwise only the frustum is tested, which holds under any world matrix.
+	scale.x = XMVectorGetX(XMVector3LengthSq(worldMatrix.r[0]));
+	scale.y = XMVectorGetX(XMVector3LengthSq(worldMatrix.r[1]));
+	scale.z = XMVectorGetX(XMVector3LengthSq(worldMatrix.r[2]));
+	uniform = fabsf(scale.x - scale.y) <= scale.x * MODEL_CONE_SCALE_TOLERANCE &&
+			  fabsf(scale.x - scale.z) <= scale.x * MODEL_CONE_SCALE_TOLERANCE &&
+			  XMVectorGetX(XMMatrixDeterminant(worldMatrix)) > 0.0f;
+
+	ClusterCullerClass::BuildFrustum(&worldViewProjection._11, uniform ? &camera.x : NULL, frustum);
+
+	// Cull the clusters of the selected level, what is left replaces the full range SelectLod put in the draw list.
+	m_drawCount = ClusterCullerClass::Cull(&m_Mesh->clusterBlocks[m_Mesh->lods[m_lod].firstBlock], (int)m_Mesh->lods[m_lod].blockCount, frustum,
+										   m_draws, statistics);
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::IsResident()
+{
+	int i;
+
+
+	if(!m_meshState.IsResident())
+	{
+		return false;
+	}
+
+	for(i=0; i<TextureCount; i++)
+	{
+		if(!m_TextureRegistry->IsResident(m_Textures[i]))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+int ModelTemplateClass<VertexLayout, TextureCount>::GetIndexCount()
+{
+	return (int)m_Mesh->lods[m_lod].indexCount;
+}
+
+
+template<class VertexLayout, int TextureCount>
+int ModelTemplateClass<VertexLayout, TextureCount>::GetLod()
+{
+	return m_lod;
+}
+
+
+template<class VertexLayout, int TextureCount>
+int ModelTemplateClass<VertexLayout, TextureCount>::GetLodCount()
+{
+	return m_Mesh->lodCount;
+}
+
+
+template<class VertexLayout, int TextureCount>
+float ModelTemplateClass<VertexLayout, TextureCount>::GetBoundingRadius()
+{
+	// The bounding sphere grown to be centered on the model's origin, for anything that only knows where the model is placed.
+	return sqrtf(m_Mesh->center[0] * m_Mesh->center[0] + m_Mesh->center[1] * m_Mesh->center[1] + m_Mesh->center[2] * m_Mesh->center[2]) +
+		   m_Mesh->radius;
+}
+
+
+template<class VertexLayout, int TextureCount>
+DrawListType ModelTemplateClass<VertexLayout, TextureCount>::GetDrawList()
+{
+	DrawListType drawList;
+
+
+	drawList.ranges = m_draws;
+	drawList.rangeCount = m_drawCount;
+
+	return drawList;
+}
+
+
+template<class VertexLayout, int TextureCount>
+int ModelTemplateClass<VertexLayout, TextureCount>::GetTextureCount()
+{
+	return TextureCount;
+}
+
+
+template<class VertexLayout, int TextureCount>
+ID3D11ShaderResourceView* ModelTemplateClass<VertexLayout, TextureCount>::GetTexture(int index)
+{
+	return m_TextureRegistry->GetTexture(m_Textures[index]);
+}
+
+
+template<class VertexLayout, int TextureCount>
+int ModelTemplateClass<VertexLayout, TextureCount>::GetTextureSlice(int index)
+{
+	return m_TextureRegistry->GetSlice(m_Textures[index]);
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::RenderBuffers(StateCacheClass* stateCache)
+{
+	// Set the vertex buffer to active in the input assembler so it can be rendered, the stride comes from the layout rather than
+	// the mesh.  The binds go through the state cache, so drawing the same model again sets nothing.
+	stateCache->SetVertexBuffer(0, m_Mesh->vertexBuffer, VertexLayout::stride, 0);
+
+	// Give the vertex shader the bounds it needs to expand the compressed positions.
+	if constexpr(VERTEX_COMPRESSION_ENABLED)
+	{
+		stateCache->SetVertexConstantBuffers(VERTEX_COMPRESSION_BUFFER_SLOT, 1, &m_Mesh->quantizationBuffer);
+	}
+
+    // Set the index buffer to active in the input assembler so it can be rendered, the draw list holds absolute ranges of it.
+	stateCache->SetIndexBuffer(m_Mesh->indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+    // Set the type of primitive that should be rendered from this vertex buffer, in this case triangles.
+	stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::RequestTextures(FXMVECTOR center, float radius, float spread, float pixelScale)
+{
+	float pixels;
+	int i;
+
+
+	// Nothing is asked for when the bounds are behind the camera.
+	pixels = TextureResidencyClass::GetScreenSize(XMVectorGetZ(center), XMVectorGetX(XMVector3Length(center)), radius, spread, pixelScale);
+	if(pixels <= 0.0f)
+	{
+		return;
+	}
+
+	for(i=0; i<TextureCount; i++)
+	{
+		m_TextureRegistry->Request(m_Textures[i], pixels);
+	}
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::LoadTextures(ID3D11Device* device)
+{
+	bool result;
+	int i;
+
+
+	for(i=0; i<TextureCount; i++)
+	{
+		// A mid grey texel stands in for a color texture, the second texture of a tangent space model is its normal map and gets a flat normal.
+		if(VertexLayout::format.tangent >= 0 && i == 1)
+		{
+			result = m_TextureRegistry->CreatePlaceholder(m_Textures[i], 0xffff8080);
+		}
+		else
+		{
+			result = m_TextureRegistry->CreatePlaceholder(m_Textures[i], 0xff808080);
+		}
+		if(!result)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::ReleaseTextures()
+{
+	int i;
+
+
+	// Hand the textures back to the registry, it releases each one once nothing else uses it.
+	for(i=0; i<TextureCount; i++)
+	{
+		if(m_Textures[i])
+		{
+			m_TextureRegistry->Release(m_Textures[i]);
+			m_Textures[i] = 0;
+		}
+	}
+	m_TextureRegistry = 0;
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::LoadModel()
+{
+	// Start out with the proxy in this layout, it is built in memory so nothing waits on a file.
+	m_Mesh = m_MeshRegistry->AcquireProxy<VertexLayout>();
+	if(!m_Mesh)
+	{
+		return false;
+	}
+
+	return CreateDrawList();
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::SwapModel()
+{
+	MeshRegistryClass::MeshType* mesh;
+	MeshRegistryClass::MeshType* proxy;
+	int proxyLod;
+
+
+	// Ask the registry for this layout of the mesh, the file itself is only loaded once and the job has done the CPU work.
+	mesh = m_MeshRegistry->Acquire<VertexLayout>(m_modelFilename);
+	if(!mesh)
+	{
+		return false;
+	}
+
+	// Replace the proxy, the next draw uses the real mesh.  If that fails the proxy is kept and drawn as before.
+	proxy = m_Mesh;
+	proxyLod = m_lod;
+	m_Mesh = mesh;
+	m_lod = 0;
+
+	if(!CreateDrawList())
+	{
+		m_Mesh = proxy;
+		m_lod = proxyLod;
+		m_MeshRegistry->Release(mesh);
+		return false;
+	}
+
+	m_MeshRegistry->Release(proxy);
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::ReleaseModel()
+{
+	// Hand the mesh back to the registry, it releases the buffers once nothing else uses them.
+	if(m_Mesh)
+	{
+		m_MeshRegistry->Release(m_Mesh);
+		m_Mesh = 0;
+	}
+
+	// Release the draw list.
+	if(m_draws)
+	{
+		delete [] m_draws;
+		m_draws = 0;
+	}
+	m_drawCount = 0;
+
+	m_MeshRegistry = 0;
+
+	return;
+}
+
+
+template<class VertexLayout, int TextureCount>
+bool ModelTemplateClass<VertexLayout, TextureCount>::CreateDrawList()
+{
+	DrawRangeType* draws;
+
+
+	// Every cluster can end up a draw of its own, and a mesh without clusters still needs one for its full range.  The old list
+	// is only freed once the new one exists, so a failure leaves the model as it was.
+	draws = new DrawRangeType[m_Mesh->clusterBlockCount * 4 + 1];
+	if(!draws)
+	{
+		return false;
+	}
+
+	if(m_draws)
+	{
+		delete [] m_draws;
+	}
+	m_draws = draws;
+
+	ResetDrawList();
+
+	return true;
+}
+
+
+template<class VertexLayout, int TextureCount>
+void ModelTemplateClass<VertexLayout, TextureCount>::ResetDrawList()
+{
+	// Draw the whole of the selected level as one range.
+	m_draws[0].firstIndex = m_Mesh->lods[m_lod].firstIndex;
+	m_draws[0].indexCount = m_Mesh->lods[m_lod].indexCount;
+	m_drawCount = 1;
+
+	return;
+}
+
+#endif
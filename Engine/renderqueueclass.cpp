@@ -0,0 +1,274 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderqueueclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "renderqueueclass.h"
+
+#include <cstdint>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Where each field starts in the key, the pass has the top two bits and the rest follow it down in the order they sort by.
+const int RENDER_KEY_PASS_SHIFT = 62;
+
+const int RENDER_KEY_OPAQUE_SHADER_SHIFT = RENDER_KEY_PASS_SHIFT - RENDER_KEY_SHADER_BITS;
+const int RENDER_KEY_OPAQUE_MATERIAL_SHIFT = RENDER_KEY_OPAQUE_SHADER_SHIFT - RENDER_KEY_MATERIAL_BITS;
+const int RENDER_KEY_OPAQUE_MESH_SHIFT = RENDER_KEY_OPAQUE_MATERIAL_SHIFT - RENDER_KEY_MESH_BITS;
+const int RENDER_KEY_OPAQUE_DEPTH_SHIFT = RENDER_KEY_OPAQUE_MESH_SHIFT - RENDER_KEY_DEPTH_BITS;
+
+const int RENDER_KEY_BLENDED_DEPTH_SHIFT = RENDER_KEY_PASS_SHIFT - RENDER_KEY_DEPTH_BITS;
+const int RENDER_KEY_BLENDED_SHADER_SHIFT = RENDER_KEY_BLENDED_DEPTH_SHIFT - RENDER_KEY_SHADER_BITS;
+const int RENDER_KEY_BLENDED_MATERIAL_SHIFT = RENDER_KEY_BLENDED_SHADER_SHIFT - RENDER_KEY_MATERIAL_BITS;
+const int RENDER_KEY_BLENDED_MESH_SHIFT = RENDER_KEY_BLENDED_MATERIAL_SHIFT - RENDER_KEY_MESH_BITS;
+
+
+RenderQueueClass::RenderQueueClass()
+{
+}
+
+
+RenderQueueClass::RenderQueueClass(const RenderQueueClass& other)
+{
+}
+
+
+RenderQueueClass::~RenderQueueClass()
+{
+}
+
+
+void RenderQueueClass::Begin()
+{
+	// Keep the memory of the last frame, it will need about as much again.
+	m_packets.clear();
+
+	return;
+}
+
+
+void RenderQueueClass::Submit(unsigned long long key, int item)
+{
+	PacketType packet;
+
+
+	packet.key = key;
+	packet.item = item;
+	m_packets.push_back(packet);
+
+	return;
+}
+
+
+void RenderQueueClass::Sort(StatisticsType& statistics)
+{
+	ChangesType changes;
+	int counts[8][256];
+	int packetCount, offset, count, digit, i, j;
+
+
+	packetCount = (int)m_packets.size();
+
+	// Count the changes the packets would make in the order they came in, to see what sorting them saved.
+	CountChanges(m_packets, changes);
+	statistics.submitted.pass += changes.pass;
+	statistics.submitted.shader += changes.shader;
+	statistics.submitted.material += changes.material;
+	statistics.submitted.mesh += changes.mesh;
+
+	// Count the digits of every byte of the keys in one pass over them.
+	memset(counts, 0, sizeof(counts));
+	for(i=0; i<packetCount; i++)
+	{
+		for(j=0; j<8; j++)
+		{
+			counts[j][(m_packets[i].key >> (j * 8)) & 0xff]++;
+		}
+	}
+
+	// Sort on one byte at a time from the lowest, each pass keeping the order of the one before among equal digits.  A byte that
+	// is the same in every key would leave the order as it is, so it is skipped.
+	m_sortedPackets.resize(packetCount);
+	for(j=0; j<8 && packetCount > 1; j++)
+	{
+		if(counts[j][(m_packets[0].key >> (j * 8)) & 0xff] == packetCount)
+		{
+			continue;
+		}
+
+		offset = 0;
+		for(i=0; i<256; i++)
+		{
+			count = counts[j][i];
+			counts[j][i] = offset;
+			offset += count;
+		}
+
+		for(i=0; i<packetCount; i++)
+		{
+			digit = (int)((m_packets[i].key >> (j * 8)) & 0xff);
+			m_sortedPackets[counts[j][digit]] = m_packets[i];
+			counts[j][digit]++;
+		}
+
+		m_packets.swap(m_sortedPackets);
+	}
+
+	// And the changes they make now.
+	CountChanges(m_packets, changes);
+	statistics.sorted.pass += changes.pass;
+	statistics.sorted.shader += changes.shader;
+	statistics.sorted.material += changes.material;
+	statistics.sorted.mesh += changes.mesh;
+
+	statistics.packets += packetCount;
+
+	return;
+}
+
+
+int RenderQueueClass::GetPacketCount()
+{
+	return (int)m_packets.size();
+}
+
+
+const RenderQueueClass::PacketType& RenderQueueClass::GetPacket(int index)
+{
+	return m_packets[index];
+}
+
+
+unsigned long long RenderQueueClass::MakeOpaqueKey(int shader, int material, int mesh, float depth)
+{
+	unsigned long long key;
+
+
+	// The state first so draws sharing it are grouped, then the depth so each group is drawn front to back.
+	key = (unsigned long long)RENDER_PASS_OPAQUE << RENDER_KEY_PASS_SHIFT;
+	key |= ((unsigned long long)shader & ((1ull << RENDER_KEY_SHADER_BITS) - 1)) << RENDER_KEY_OPAQUE_SHADER_SHIFT;
+	key |= ((unsigned long long)material & ((1ull << RENDER_KEY_MATERIAL_BITS) - 1)) << RENDER_KEY_OPAQUE_MATERIAL_SHIFT;
+	key |= ((unsigned long long)mesh & ((1ull << RENDER_KEY_MESH_BITS) - 1)) << RENDER_KEY_OPAQUE_MESH_SHIFT;
+	key |= GetDepthBucket(depth) << RENDER_KEY_OPAQUE_DEPTH_SHIFT;
+
+	return key;
+}
+
+
+unsigned long long RenderQueueClass::MakeBlendedKey(int shader, int material, int mesh, float depth)
+{
+	unsigned long long key;
+
+
+	// The depth first and inverted, blending only comes out right drawn back to front.
+	key = (unsigned long long)RENDER_PASS_BLENDED << RENDER_KEY_PASS_SHIFT;
+	key |= (((1ull << RENDER_KEY_DEPTH_BITS) - 1) - GetDepthBucket(depth)) << RENDER_KEY_BLENDED_DEPTH_SHIFT;
+	key |= ((unsigned long long)shader & ((1ull << RENDER_KEY_SHADER_BITS) - 1)) << RENDER_KEY_BLENDED_SHADER_SHIFT;
+	key |= ((unsigned long long)material & ((1ull << RENDER_KEY_MATERIAL_BITS) - 1)) << RENDER_KEY_BLENDED_MATERIAL_SHIFT;
+	key |= ((unsigned long long)mesh & ((1ull << RENDER_KEY_MESH_BITS) - 1)) << RENDER_KEY_BLENDED_MESH_SHIFT;
+
+	return key;
+}
+
+
+int RenderQueueClass::GetMaterialId(const void* material)
+{
+	unsigned long long hash;
+
+
+	// Mix the address so materials allocated next to each other do not all land in the low bits, and keep the top of it.  Two
+	// materials sharing an id only sort together, the draws still set their own.
+	hash = (unsigned long long)(uintptr_t)material * 0x9e3779b97f4a7c15ull;
+
+	return (int)(hash >> (64 - RENDER_KEY_MATERIAL_BITS));
+}
+
+
+int RenderQueueClass::GetPass(unsigned long long key)
+{
+	return (int)(key >> RENDER_KEY_PASS_SHIFT);
+}
+
+
+int RenderQueueClass::GetShader(unsigned long long key)
+{
+	int shift;
+
+
+	shift = GetPass(key) == RENDER_PASS_OPAQUE ? RENDER_KEY_OPAQUE_SHADER_SHIFT : RENDER_KEY_BLENDED_SHADER_SHIFT;
+
+	return (int)((key >> shift) & ((1ull << RENDER_KEY_SHADER_BITS) - 1));
+}
+
+
+int RenderQueueClass::GetMaterial(unsigned long long key)
+{
+	int shift;
+
+
+	shift = GetPass(key) == RENDER_PASS_OPAQUE ? RENDER_KEY_OPAQUE_MATERIAL_SHIFT : RENDER_KEY_BLENDED_MATERIAL_SHIFT;
+
+	return (int)((key >> shift) & ((1ull << RENDER_KEY_MATERIAL_BITS) - 1));
+}
+
+
+int RenderQueueClass::GetMesh(unsigned long long key)
+{
+	int shift;
+
+
+	shift = GetPass(key) == RENDER_PASS_OPAQUE ? RENDER_KEY_OPAQUE_MESH_SHIFT : RENDER_KEY_BLENDED_MESH_SHIFT;
+
+	return (int)((key >> shift) & ((1ull << RENDER_KEY_MESH_BITS) - 1));
+}
+
+
+unsigned long long RenderQueueClass::GetDepthBucket(float depth)
+{
+	// The depth is a fraction of the far plane, anything outside it goes to the nearest end.
+	if(!(depth > 0.0f))
+	{
+		return 0;
+	}
+	if(depth >= 1.0f)
+	{
+		return (1ull << RENDER_KEY_DEPTH_BITS) - 1;
+	}
+
+	return (unsigned long long)(depth * (float)((1ull << RENDER_KEY_DEPTH_BITS) - 1));
+}
+
+
+void RenderQueueClass::CountChanges(const vector<PacketType>& packets, ChangesType& changes)
+{
+	int i;
+
+
+	changes.pass = 0;
+	changes.shader = 0;
+	changes.material = 0;
+	changes.mesh = 0;
+
+	for(i=0; i<(int)packets.size(); i++)
+	{
+		if(i == 0 || GetPass(packets[i].key) != GetPass(packets[i - 1].key))
+		{
+			changes.pass++;
+		}
+		if(i == 0 || GetShader(packets[i].key) != GetShader(packets[i - 1].key))
+		{
+			changes.shader++;
+		}
+		if(i == 0 || GetMaterial(packets[i].key) != GetMaterial(packets[i - 1].key))
+		{
+			changes.material++;
+		}
+		if(i == 0 || GetMesh(packets[i].key) != GetMesh(packets[i - 1].key))
+		{
+			changes.mesh++;
+		}
+	}
+
+	return;
+}
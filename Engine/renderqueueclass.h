@@ -0,0 +1,104 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: renderqueueclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RENDERQUEUECLASS_H_
+#define _RENDERQUEUECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The passes a frame is drawn in, in the order they are drawn.
+enum RenderPassType
+{
+	RENDER_PASS_OPAQUE,
+	RENDER_PASS_BLENDED
+};
+
+// Bits of the key each field gets below the two of the pass, a value too large for its field is cut down to fit.
+const int RENDER_KEY_SHADER_BITS = 4;
+const int RENDER_KEY_MATERIAL_BITS = 16;
+const int RENDER_KEY_MESH_BITS = 8;
+const int RENDER_KEY_DEPTH_BITS = 24;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RenderQueueClass
+//
+// The draws of a frame as packets of a 64 bit sort key and an item the caller
+// looks the draw up by.  Sort orders them by key with a radix sort, so the
+// cost is a few passes over the packets however they were submitted.
+//
+// The pass is the top of every key.  An opaque key goes on with the shader,
+// the material and the mesh, so draws that share state end up next to each
+// other, and the depth last so those are drawn front to back.  A blended key
+// goes on with the depth inverted so they are drawn back to front, the state
+// only orders draws at the same depth.
+//
+// The queue knows nothing of the device, whoever draws the packets compares
+// the fields of each key with the one before and only changes what differs.
+// Sort counts how many of those changes the order saves.
+////////////////////////////////////////////////////////////////////////////////
+class RenderQueueClass
+{
+public:
+	struct PacketType
+	{
+		unsigned long long key;
+		int item;
+	};
+
+	// Times a field of the key differs from the packet before, the first packet changes all of them.
+	struct ChangesType
+	{
+		int pass;
+		int shader;
+		int material;
+		int mesh;
+	};
+
+	struct StatisticsType
+	{
+		int packets;
+		ChangesType sorted;
+		ChangesType submitted;
+	};
+
+public:
+	RenderQueueClass();
+	RenderQueueClass(const RenderQueueClass&);
+	~RenderQueueClass();
+
+	void Begin();
+	void Submit(unsigned long long, int);
+	void Sort(StatisticsType&);
+
+	int GetPacketCount();
+	const PacketType& GetPacket(int);
+
+	static unsigned long long MakeOpaqueKey(int, int, int, float);
+	static unsigned long long MakeBlendedKey(int, int, int, float);
+	static int GetMaterialId(const void*);
+
+	static int GetPass(unsigned long long);
+	static int GetShader(unsigned long long);
+	static int GetMaterial(unsigned long long);
+	static int GetMesh(unsigned long long);
+
+private:
+	static unsigned long long GetDepthBucket(float);
+	static void CountChanges(const vector<PacketType>&, ChangesType&);
+
+private:
+	vector<PacketType> m_packets;
+	vector<PacketType> m_sortedPackets;
+};
+
+#endif
@@ -0,0 +1,227 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringallocatorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "ringallocatorclass.h"
+
+
+RingAllocatorClass::RingAllocatorClass()
+{
+	m_size = 0;
+	m_alignment = 1;
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+	m_frame = 0;
+	m_frameSize = 0;
+}
+
+
+RingAllocatorClass::RingAllocatorClass(const RingAllocatorClass& other)
+{
+}
+
+
+RingAllocatorClass::~RingAllocatorClass()
+{
+}
+
+
+bool RingAllocatorClass::Initialize(unsigned int size, unsigned int alignment)
+{
+	// The alignment has to be a power of two and the size a whole number of aligned blocks.
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+	{
+		return false;
+	}
+
+	m_alignment = alignment;
+	m_size = Align(size);
+	if(m_size == 0)
+	{
+		return false;
+	}
+
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+	m_frame = 0;
+	m_frameSize = 0;
+	m_frames.clear();
+
+	return true;
+}
+
+
+void RingAllocatorClass::Shutdown()
+{
+	m_frames.clear();
+	m_size = 0;
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+
+	return;
+}
+
+
+void RingAllocatorClass::BeginFrame(unsigned int frame)
+{
+	m_frame = frame;
+	m_frameSize = 0;
+
+	return;
+}
+
+
+void RingAllocatorClass::EndFrame()
+{
+	FrameType frame;
+
+
+	// Remember where the frame ended and how much of the ring it holds, skipped bytes at the end included.
+	if(m_frameSize == 0)
+	{
+		return;
+	}
+
+	frame.frame = m_frame;
+	frame.end = m_head;
+	frame.size = m_frameSize;
+	m_frames.push_back(frame);
+
+	m_frameSize = 0;
+
+	return;
+}
+
+
+void RingAllocatorClass::Retire(unsigned int completedFrame)
+{
+	unsigned int i;
+
+
+	// The frames are kept in the order they were made, so every frame up to the completed one is at the front.  The difference is
+	// taken as signed so a frame index that wrapped around still compares as later.
+	for(i=0; i<m_frames.size(); i++)
+	{
+		if((int)(completedFrame - m_frames[i].frame) < 0)
+		{
+			break;
+		}
+
+		m_tail = m_frames[i].end;
+		m_used -= m_frames[i].size;
+	}
+
+	m_frames.erase(m_frames.begin(), m_frames.begin() + i);
+
+	return;
+}
+
+
+bool RingAllocatorClass::Allocate(unsigned int size, unsigned int& offset)
+{
+	unsigned int alignedSize, skipped;
+
+
+	alignedSize = Align(size > 0 ? size : 1);
+	skipped = 0;
+
+	// With nothing in flight start again at the front, so the whole ring is in one piece.
+	if(m_used == 0)
+	{
+		m_head = 0;
+		m_tail = 0;
+	}
+
+	// When the head is past the tail, or the ring is empty, the free space is from the head to the end and from the front to the
+	// tail.  Otherwise it is only what is between the head and the tail.
+	if(m_used == 0 || m_head > m_tail)
+	{
+		if(m_size - m_head >= alignedSize)
+		{
+			offset = m_head;
+		}
+		else if(m_tail >= alignedSize)
+		{
+			skipped = m_size - m_head;
+			offset = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if(m_tail - m_head >= alignedSize)
+		{
+			offset = m_head;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	m_head = offset + alignedSize;
+	if(m_head == m_size)
+	{
+		m_head = 0;
+	}
+
+	m_used += skipped + alignedSize;
+	m_frameSize += skipped + alignedSize;
+
+	return true;
+}
+
+
+void RingAllocatorClass::Grow(unsigned int size)
+{
+	// The new ring starts out empty, what is in flight stays in the old buffer and the frame being made starts over.
+	m_size = GetGrowSize(size);
+	m_head = 0;
+	m_tail = 0;
+	m_used = 0;
+	m_frameSize = 0;
+	m_frames.clear();
+
+	return;
+}
+
+
+unsigned int RingAllocatorClass::GetGrowSize(unsigned int size)
+{
+	// At least double, so a ring that keeps overflowing does not grow again every frame.
+	if(size < m_size * 2)
+	{
+		size = m_size * 2;
+	}
+
+	return Align(size);
+}
+
+
+unsigned int RingAllocatorClass::GetSize()
+{
+	return m_size;
+}
+
+
+unsigned int RingAllocatorClass::GetUsed()
+{
+	return m_used;
+}
+
+
+int RingAllocatorClass::GetFramesInFlight()
+{
+	return (int)m_frames.size();
+}
+
+
+unsigned int RingAllocatorClass::Align(unsigned int size)
+{
+	return (size + m_alignment - 1) & ~(m_alignment - 1);
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringallocatorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _RINGALLOCATORCLASS_H_
+#define _RINGALLOCATORCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+using namespace std;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: RingAllocatorClass
+//
+// Hands out offsets into a buffer used as a ring, without touching a device
+// so any buffer the caller owns can be carved up with it.  Allocations are
+// made one after another from the head and rounded up to the alignment, an
+// allocation that does not fit before the end of the buffer starts again at
+// the front and the bytes it skipped stay used until its frame is retired.
+//
+// Everything allocated between BeginFrame and EndFrame belongs to that
+// frame.  Retire gives back the space of every frame up to the one the
+// caller knows the GPU has finished with, so data still being read is
+// never handed out again.  Frame indices may wrap around.
+//
+// Allocate fails rather than overwrite a frame in flight.  The caller then
+// calls Grow, which makes the ring larger and empty, and allocates the frame
+// again from the start of its new, larger buffer.  The frames in flight are
+// left in the old buffer, the caller keeps that alive until they finish.
+// GetGrowSize gives the size Grow would make, so the caller can make its
+// new buffer first and leave the ring as it is if that fails.
+////////////////////////////////////////////////////////////////////////////////
+class RingAllocatorClass
+{
+private:
+	struct FrameType
+	{
+		unsigned int frame;
+		unsigned int end;
+		unsigned int size;
+	};
+
+public:
+	RingAllocatorClass();
+	RingAllocatorClass(const RingAllocatorClass&);
+	~RingAllocatorClass();
+
+	bool Initialize(unsigned int, unsigned int);
+	void Shutdown();
+
+	void BeginFrame(unsigned int);
+	void EndFrame();
+	void Retire(unsigned int);
+
+	bool Allocate(unsigned int, unsigned int&);
+	void Grow(unsigned int);
+	unsigned int GetGrowSize(unsigned int);
+
+	unsigned int GetSize();
+	unsigned int GetUsed();
+	int GetFramesInFlight();
+
+private:
+	unsigned int Align(unsigned int);
+
+private:
+	unsigned int m_size, m_alignment;
+	unsigned int m_head, m_tail, m_used;
+	unsigned int m_frame, m_frameSize;
+	vector<FrameType> m_frames;
+};
+
+#endif
\ No newline at end of file
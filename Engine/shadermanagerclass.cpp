@@ -3,9 +3,16 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "shadermanagerclass.h"
 
+#include <cstring>
+
 
 ShaderManagerClass::ShaderManagerClass()
 {
+	m_StateCache = 0;
+	m_frameBuffer = 0;
+	m_objectBuffer = 0;
+	m_frameWritten = false;
+	m_ConstantRing = 0;
 	m_TextureShader = 0;
 	m_LightShader = 0;
 	m_BumpMapShader = 0;
@@ -23,11 +30,52 @@ ShaderManagerClass::~ShaderManagerClass()
 }
 
 
-bool ShaderManagerClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool ShaderManagerClass::Initialize(ID3D11Device* device, ID3D11DeviceContext* deviceContext, HWND hwnd)
 {
 	bool result;
 
 
+	// Create the state cache object, the shaders bind through it.
+	m_StateCache = new StateCacheClass;
+	if(!m_StateCache)
+	{
+		return false;
+	}
+
+	m_StateCache->Initialize(deviceContext);
+
+	// Create the frame and object constant buffers every shader shares.
+	result = CreateConstantBuffer(device, sizeof(FrameBufferType), &m_frameBuffer);
+	if(!result)
+	{
+		return false;
+	}
+
+	result = CreateConstantBuffer(device, sizeof(ObjectBufferType), &m_objectBuffer);
+	if(!result)
+	{
+		return false;
+	}
+
+	// Create the constant ring buffer the world matrices of a frame go in.  Without Direct3D 11.1 it is left out and the object
+	// buffer is mapped for each draw instead.
+	if(m_StateCache->SupportsConstantBufferOffsets())
+	{
+		m_ConstantRing = new ConstantRingBufferClass;
+		if(!m_ConstantRing)
+		{
+			return false;
+		}
+
+		result = m_ConstantRing->Initialize(device, CONSTANT_RING_SIZE);
+		if(!result)
+		{
+			m_ConstantRing->Shutdown();
+			delete m_ConstantRing;
+			m_ConstantRing = 0;
+		}
+	}
+
 	// Create the texture shader object.
 	m_TextureShader = new TextureShaderClass;
 	if(!m_TextureShader)
@@ -36,7 +84,7 @@ bool ShaderManagerClass::Initialize(ID3D11Device* device, HWND hwnd)
 	}
 
 	// Initialize the texture shader object.
-	result = m_TextureShader->Initialize(device, hwnd);
+	result = m_TextureShader->Initialize(device, hwnd, m_StateCache);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the texture shader object.", L"Error", MB_OK);
@@ -51,7 +99,7 @@ bool ShaderManagerClass::Initialize(ID3D11Device* device, HWND hwnd)
 	}
 
 	// Initialize the light shader object.
-	result = m_LightShader->Initialize(device, hwnd);
+	result = m_LightShader->Initialize(device, hwnd, m_StateCache);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the light shader object.", L"Error", MB_OK);
@@ -66,7 +114,7 @@ bool ShaderManagerClass::Initialize(ID3D11Device* device, HWND hwnd)
 	}
 
 	// Initialize the bump map shader object.
-	result = m_BumpMapShader->Initialize(device, hwnd);
+	result = m_BumpMapShader->Initialize(device, hwnd, m_StateCache);
 	if(!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the bump map shader object.", L"Error", MB_OK);
@@ -81,7 +129,7 @@ bool ShaderManagerClass::Initialize(ID3D11Device* device, HWND hwnd)
 	}
 
 	// Initialize the bump map shader object.
-	result = m_FireShader->Initialize(device, hwnd);
+	result = m_FireShader->Initialize(device, hwnd, m_StateCache);
 	if (!result)
 	{
 		MessageBox(hwnd, L"Could not initialize the Fire shader object.", L"Error", MB_OK);
@@ -126,18 +174,240 @@ void ShaderManagerClass::Shutdown()
 		m_TextureShader = 0;
 	}
 
+	// Release the constant ring buffer.
+	if(m_ConstantRing)
+	{
+		m_ConstantRing->Shutdown();
+		delete m_ConstantRing;
+		m_ConstantRing = 0;
+	}
+
+	// Release the object and frame constant buffers.
+	if(m_objectBuffer)
+	{
+		m_objectBuffer->Release();
+		m_objectBuffer = 0;
+	}
+
+	if(m_frameBuffer)
+	{
+		m_frameBuffer->Release();
+		m_frameBuffer = 0;
+	}
+	m_frameWritten = false;
+
+	// Release the state cache object.
+	if(m_StateCache)
+	{
+		m_StateCache->Shutdown();
+		delete m_StateCache;
+		m_StateCache = 0;
+	}
+
+	return;
+}
+
+
+StateCacheClass* ShaderManagerClass::GetStateCache()
+{
+	return m_StateCache;
+}
+
+
+void ShaderManagerClass::GetStateStatistics(StateCacheClass::StatisticsType& statistics)
+{
+	m_StateCache->GetStatistics(statistics);
+
 	return;
 }
 
 
-bool ShaderManagerClass::RenderTextureShader(ID3D11DeviceContext* device, int indexCount, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix,
-											 ID3D11ShaderResourceView* texture)
+bool ShaderManagerClass::GetRingStatistics(ConstantRingBufferClass::StatisticsType& statistics)
+{
+	// There are none when the ring could not be made.
+	if(!m_ConstantRing)
+	{
+		return false;
+	}
+
+	m_ConstantRing->GetStatistics(statistics);
+
+	return true;
+}
+
+
+void ShaderManagerClass::SetShader(ID3D11DeviceContext* deviceContext, ShaderType shader)
+{
+	// Put the layout, shaders and samplers of the shader on the pipeline for the draws that follow.
+	switch(shader)
+	{
+		case SHADER_TEXTURE:
+		{
+			m_TextureShader->SetShader(deviceContext);
+			break;
+		}
+
+		case SHADER_LIGHT:
+		{
+			m_LightShader->SetShader(deviceContext);
+			break;
+		}
+
+		case SHADER_LIGHT_INSTANCED:
+		{
+			m_LightShader->SetInstancedShader(deviceContext);
+			break;
+		}
+
+		case SHADER_BUMP_MAP:
+		{
+			m_BumpMapShader->SetShader(deviceContext);
+			break;
+		}
+
+		case SHADER_FIRE:
+		{
+			m_FireShader->SetShader(deviceContext);
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+
+	return;
+}
+
+
+void ShaderManagerClass::BeginFrame(ID3D11DeviceContext* deviceContext)
+{
+	// Start the frame with no objects, and let the ring take back what the GPU has finished with.
+	m_objects.clear();
+
+	if(m_ConstantRing)
+	{
+		m_ConstantRing->BeginFrame(deviceContext);
+	}
+
+	return;
+}
+
+
+bool ShaderManagerClass::SetFrameParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix,
+	XMFLOAT3 cameraPosition, XMFLOAT3 lightDirection, XMFLOAT4 ambient, XMFLOAT4 diffuse, XMFLOAT4 specular, float specularPower)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+	FrameBufferType frame;
+
+
+	// Multiply the view and projection once for the frame and transpose them for the shaders.
+	frame.viewProjection = XMMatrixTranspose(XMMatrixMultiply(viewMatrix, projectionMatrix));
+	frame.ambientColor = ambient;
+	frame.diffuseColor = diffuse;
+	frame.specularColor = specular;
+	frame.lightDirection = lightDirection;
+	frame.specularPower = specularPower;
+	frame.cameraPosition = cameraPosition;
+	frame.padding = 0.0f;
+
+	// A frame where neither the camera nor the light moved keeps what is in the buffer.
+	if(!m_frameWritten || memcmp(&frame, &m_frame, sizeof(frame)) != 0)
+	{
+		// Lock the frame constant buffer so it can be written to.
+		result = deviceContext->Map(m_frameBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		if(FAILED(result))
+		{
+			return false;
+		}
+
+		// Copy the frame into the constant buffer.
+		memcpy(mappedResource.pData, &frame, sizeof(frame));
+
+		// Unlock the constant buffer.
+		deviceContext->Unmap(m_frameBuffer, 0);
+
+		m_frame = frame;
+		m_frameWritten = true;
+	}
+
+	// The vertex shaders need the view and projection and the camera, the pixel shaders the light.
+	m_StateCache->SetVertexConstantBuffers(FRAME_BUFFER_SLOT, 1, &m_frameBuffer);
+	m_StateCache->SetPixelConstantBuffers(FRAME_BUFFER_SLOT, 1, &m_frameBuffer);
+
+	return true;
+}
+
+
+int ShaderManagerClass::AddObject(const XMMATRIX &worldMatrix)
+{
+	ObjectBufferType object;
+
+
+	// Keep the world matrix transposed for the shaders, the draw refers to it by the index returned.
+	object.world = XMMatrixTranspose(worldMatrix);
+	m_objects.push_back(object);
+
+	return (int)m_objects.size() - 1;
+}
+
+
+bool ShaderManagerClass::UploadObjects(ID3D11DeviceContext* deviceContext)
 {
 	bool result;
 
 
+	// Without the ring each draw maps its own object when it is made.
+	if(!m_ConstantRing || m_objects.empty())
+	{
+		return true;
+	}
+
+	// Write every object of the frame to the ring with one map, and keep where each one went.
+	m_objectOffsets.resize(m_objects.size());
+
+	result = m_ConstantRing->Write(deviceContext, &m_objects[0], sizeof(ObjectBufferType), (int)m_objects.size(), &m_objectOffsets[0]);
+	if(!result)
+	{
+		// The ring could not grow to take the frame, so drop it and map the object buffer for each draw from now on.
+		m_ConstantRing->Shutdown();
+		delete m_ConstantRing;
+		m_ConstantRing = 0;
+	}
+
+	return true;
+}
+
+
+void ShaderManagerClass::EndFrame(ID3D11DeviceContext* deviceContext)
+{
+	// Mark the end of the frame so the ring knows when its objects can be overwritten.
+	if(m_ConstantRing)
+	{
+		m_ConstantRing->EndFrame(deviceContext);
+	}
+
+	return;
+}
+
+
+bool ShaderManagerClass::RenderTextureShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int object,
+											 ID3D11ShaderResourceView* texture, int textureSlice)
+{
+	bool result;
+
+
+	// Set the world matrix of the model.
+	result = SetObjectParameters(deviceContext, object);
+	if(!result)
+	{
+		return false;
+	}
+
 	// Render the model using the texture shader.
-	result = m_TextureShader->Render(device, indexCount, worldMatrix, viewMatrix, projectionMatrix, texture);
+	result = m_TextureShader->Render(deviceContext, drawList, texture, textureSlice);
 	if(!result)
 	{
 		return false;
@@ -147,16 +417,39 @@ bool ShaderManagerClass::RenderTextureShader(ID3D11DeviceContext* device, int in
 }
 
 
-bool ShaderManagerClass::RenderLightShader(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix,
-	ID3D11ShaderResourceView* texture, XMFLOAT3 lightDirection, XMFLOAT4 ambient, XMFLOAT4 diffuse,
-	XMFLOAT3 cameraPosition, XMFLOAT4 specular, float specularPower)
+bool ShaderManagerClass::RenderLightShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int object,
+	ID3D11ShaderResourceView* texture, int textureSlice)
 {
 	bool result;
 
 
+	// Set the world matrix of the model.
+	result = SetObjectParameters(deviceContext, object);
+	if(!result)
+	{
+		return false;
+	}
+
 	// Render the model using the light shader.
-	result = m_LightShader->Render(deviceContext, indexCount, worldMatrix, viewMatrix, projectionMatrix, texture, lightDirection, ambient, diffuse, cameraPosition, 
-								   specular, specularPower);
+	result = m_LightShader->Render(deviceContext, drawList, texture, textureSlice);
+	if(!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool ShaderManagerClass::RenderLightShaderInstanced(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int instanceCount, int firstInstance,
+	ID3D11ShaderResourceView* texture, int textureSlice)
+{
+	bool result;
+
+
+	// Render the range of instances using the instanced light shader, the world matrices come from the instance buffer so the
+	// object buffer is left as it is.
+	result = m_LightShader->RenderInstanced(deviceContext, drawList, instanceCount, firstInstance, texture, textureSlice);
 	if(!result)
 	{
 		return false;
@@ -166,15 +459,21 @@ bool ShaderManagerClass::RenderLightShader(ID3D11DeviceContext* deviceContext, i
 }
 
 
-bool ShaderManagerClass::RenderBumpMapShader(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix, const XMMATRIX &projectionMatrix,
-	ID3D11ShaderResourceView* colorTexture, ID3D11ShaderResourceView* normalTexture, XMFLOAT3 lightDirection,
-											 XMFLOAT4 diffuse)
+bool ShaderManagerClass::RenderBumpMapShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int object,
+	ID3D11ShaderResourceView* colorTexture, int colorSlice, ID3D11ShaderResourceView* normalTexture, int normalSlice)
 {
 	bool result;
 
 
+	// Set the world matrix of the model.
+	result = SetObjectParameters(deviceContext, object);
+	if(!result)
+	{
+		return false;
+	}
+
 	// Render the model using the bump map shader.
-	result = m_BumpMapShader->Render(deviceContext, indexCount, worldMatrix, viewMatrix, projectionMatrix, colorTexture, normalTexture, lightDirection, diffuse);
+	result = m_BumpMapShader->Render(deviceContext, drawList, colorTexture, colorSlice, normalTexture, normalSlice);
 	if(!result)
 	{
 		return false;
@@ -183,23 +482,89 @@ bool ShaderManagerClass::RenderBumpMapShader(ID3D11DeviceContext* deviceContext,
 	return true;
 }
 
-bool ShaderManagerClass::RenderFireShader(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX& worldMatrix, const XMMATRIX& viewMatrix,
-	const XMMATRIX& projectionMatrix, ID3D11ShaderResourceView* fireTexture,
-	ID3D11ShaderResourceView* noiseTexture, ID3D11ShaderResourceView* alphaTexture, float frameTime,
+bool ShaderManagerClass::RenderFireShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, int object,
+	ID3D11ShaderResourceView* fireTexture, int fireSlice,
+	ID3D11ShaderResourceView* noiseTexture, int noiseSlice, ID3D11ShaderResourceView* alphaTexture, int alphaSlice, float frameTime,
 	XMFLOAT3 scrollSpeeds, XMFLOAT3 scales, XMFLOAT2 distortion1, XMFLOAT2 distortion2,
 	XMFLOAT2 distortion3, float distortionScale, float distortionBias)
 {
 	bool result;
 
 
+	// Set the world matrix of the model.
+	result = SetObjectParameters(deviceContext, object);
+	if(!result)
+	{
+		return false;
+	}
+
 	// Render the model using the fire shader.
-	result = m_FireShader->Render(deviceContext, indexCount, worldMatrix, viewMatrix, projectionMatrix, fireTexture, noiseTexture, alphaTexture, frameTime, scrollSpeeds, scales, distortion1, distortion2,
-		distortion3, distortionScale, distortionBias);
+	result = m_FireShader->Render(deviceContext, drawList, fireTexture, fireSlice, noiseTexture, noiseSlice, alphaTexture,
+		alphaSlice, frameTime, scrollSpeeds, scales, distortion1, distortion2, distortion3, distortionScale, distortionBias);
 
 	if (!result)
 	{
 		return false;
 	}
 
+	return true;
+}
+
+
+bool ShaderManagerClass::CreateConstantBuffer(ID3D11Device* device, unsigned int byteWidth, ID3D11Buffer** buffer)
+{
+	HRESULT result;
+	D3D11_BUFFER_DESC bufferDesc;
+
+
+	// Setup the description of a dynamic constant buffer the CPU rewrites.
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = byteWidth;
+	bufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = 0;
+	bufferDesc.StructureByteStride = 0;
+
+	// Create the constant buffer.
+	result = device->CreateBuffer(&bufferDesc, NULL, buffer);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool ShaderManagerClass::SetObjectParameters(ID3D11DeviceContext* deviceContext, int object)
+{
+	HRESULT result;
+	D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+
+	// The object is in the ring already, bind its part of it.  The offset and size are counted in constants of 16 bytes.
+	if(m_ConstantRing)
+	{
+		m_StateCache->SetVertexConstantBuffer1(OBJECT_BUFFER_SLOT, m_ConstantRing->GetBuffer(), m_objectOffsets[object] / 16,
+											   CONSTANT_RING_ALIGNMENT / 16);
+		return true;
+	}
+
+	// Lock the object constant buffer so it can be written to.
+	result = deviceContext->Map(m_objectBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	// Copy the world matrix, transposed already, into the constant buffer.
+	memcpy(mappedResource.pData, &m_objects[object], sizeof(ObjectBufferType));
+
+	// Unlock the constant buffer.
+	deviceContext->Unmap(m_objectBuffer, 0);
+
+	// Set the object constant buffer in the vertex shader.
+	m_StateCache->SetVertexConstantBuffers(OBJECT_BUFFER_SLOT, 1, &m_objectBuffer);
+
 	return true;
 }
\ No newline at end of file
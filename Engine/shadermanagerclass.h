@@ -5,18 +5,60 @@
 #define _SHADERMANAGERCLASS_H_
 
 
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+using namespace std;
+
+
 ///////////////////////
 // MY CLASS INCLUDES //
 ///////////////////////
 #include "d3dclass.h"
+#include "statecacheclass.h"
+#include "constantbuffers.h"
+#include "constantringbufferclass.h"
 #include "textureshaderclass.h"
 #include "lightshaderclass.h"
 #include "bumpmapshaderclass.h"
 #include "fireshaderclass.h"
 
 
+/////////////
+// GLOBALS //
+/////////////
+// The shaders a draw can be made with, the values are what the render queue sorts them by.
+enum ShaderType
+{
+	SHADER_TEXTURE,
+	SHADER_LIGHT,
+	SHADER_LIGHT_INSTANCED,
+	SHADER_BUMP_MAP,
+	SHADER_FIRE,
+	SHADER_COUNT
+};
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: ShaderManagerClass
+//
+// The Render functions only set the parameters of a draw and make it, the
+// shaders they draw with have to be put on the pipeline first with SetShader.
+// A run of draws with one shader only sets it once that way.
+//
+// Everything the shaders bind goes through one state cache, which drops the
+// calls that would bind what is bound already.
+//
+// The view, projection, light and camera go in the frame buffer once a frame
+// with SetFrameParameters, and the world matrix of each draw in the object
+// buffer.  Both are shared by every shader, which only keep a small material
+// buffer of their own.
+//
+// The world matrices of a frame are added with AddObject before anything is
+// drawn and UploadObjects writes them all to a constant ring buffer with one
+// map, each draw then binds its own part of the ring.  Without Direct3D 11.1
+// they are mapped into the object buffer one draw at a time instead.
 ////////////////////////////////////////////////////////////////////////////////
 class ShaderManagerClass
 {
@@ -25,21 +67,45 @@ public:
 	ShaderManagerClass(const ShaderManagerClass&);
 	~ShaderManagerClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(ID3D11Device*, ID3D11DeviceContext*, HWND);
 	void Shutdown();
 
-	bool RenderTextureShader(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*);
+	StateCacheClass* GetStateCache();
+	void GetStateStatistics(StateCacheClass::StatisticsType&);
+	bool GetRingStatistics(ConstantRingBufferClass::StatisticsType&);
 
-	bool RenderLightShader(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*,
-		XMFLOAT3, XMFLOAT4, XMFLOAT4, XMFLOAT3, XMFLOAT4, float);
+	void SetShader(ID3D11DeviceContext*, ShaderType);
 
-	bool RenderBumpMapShader(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*,
-		ID3D11ShaderResourceView*, XMFLOAT3, XMFLOAT4);
+	void BeginFrame(ID3D11DeviceContext*);
+	bool SetFrameParameters(ID3D11DeviceContext*, const XMMATRIX&, const XMMATRIX&, XMFLOAT3, XMFLOAT3, XMFLOAT4, XMFLOAT4, XMFLOAT4, float);
+	int AddObject(const XMMATRIX&);
+	bool UploadObjects(ID3D11DeviceContext*);
+	void EndFrame(ID3D11DeviceContext*);
 
-	bool RenderFireShader(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*, ID3D11ShaderResourceView*,
-		ID3D11ShaderResourceView*, float, XMFLOAT3, XMFLOAT3, XMFLOAT2, XMFLOAT2, XMFLOAT2, float, float);
+	bool RenderTextureShader(ID3D11DeviceContext*, const DrawListType&, int, ID3D11ShaderResourceView*, int);
+
+	bool RenderLightShader(ID3D11DeviceContext*, const DrawListType&, int, ID3D11ShaderResourceView*, int);
+
+	bool RenderLightShaderInstanced(ID3D11DeviceContext*, const DrawListType&, int, int, ID3D11ShaderResourceView*, int);
+
+	bool RenderBumpMapShader(ID3D11DeviceContext*, const DrawListType&, int, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int);
+
+	bool RenderFireShader(ID3D11DeviceContext*, const DrawListType&, int, ID3D11ShaderResourceView*, int, ID3D11ShaderResourceView*, int,
+		ID3D11ShaderResourceView*, int, float, XMFLOAT3, XMFLOAT3, XMFLOAT2, XMFLOAT2, XMFLOAT2, float, float);
+
+private:
+	bool CreateConstantBuffer(ID3D11Device*, unsigned int, ID3D11Buffer**);
+	bool SetObjectParameters(ID3D11DeviceContext*, int);
 
 private:
+	StateCacheClass* m_StateCache;
+	ID3D11Buffer* m_frameBuffer;
+	ID3D11Buffer* m_objectBuffer;
+	FrameBufferType m_frame;
+	bool m_frameWritten;
+	ConstantRingBufferClass* m_ConstantRing;
+	vector<ObjectBufferType> m_objects;
+	vector<unsigned int> m_objectOffsets;
 	TextureShaderClass* m_TextureShader;
 	LightShaderClass* m_LightShader;
 	BumpMapShaderClass* m_BumpMapShader;
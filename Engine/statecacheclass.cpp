@@ -0,0 +1,374 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statecacheclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "statecacheclass.h"
+
+#include <cstring>
+
+
+StateCacheClass::StateCacheClass()
+{
+	m_deviceContext = 0;
+	m_deviceContext1 = 0;
+	Reset();
+	memset(&m_statistics, 0, sizeof(m_statistics));
+}
+
+
+StateCacheClass::StateCacheClass(const StateCacheClass& other)
+{
+}
+
+
+StateCacheClass::~StateCacheClass()
+{
+}
+
+
+void StateCacheClass::Initialize(ID3D11DeviceContext* deviceContext)
+{
+	// Nothing is known of what the context has bound yet.
+	m_deviceContext = deviceContext;
+	Reset();
+
+	// Get the Direct3D 11.1 interface of the context for binding parts of constant buffers, it is left null on a runtime without it.
+	if(FAILED(m_deviceContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void**)&m_deviceContext1)))
+	{
+		m_deviceContext1 = 0;
+	}
+
+	return;
+}
+
+
+void StateCacheClass::Shutdown()
+{
+	// Release the Direct3D 11.1 interface of the context.
+	if(m_deviceContext1)
+	{
+		m_deviceContext1->Release();
+		m_deviceContext1 = 0;
+	}
+
+	m_deviceContext = 0;
+
+	return;
+}
+
+
+void StateCacheClass::Reset()
+{
+	m_inputLayout = 0;
+	m_vertexShader = 0;
+	m_pixelShader = 0;
+	m_inputLayoutKnown = false;
+	m_vertexShaderKnown = false;
+	m_pixelShaderKnown = false;
+
+	memset(&m_vertexBuffers, 0, sizeof(m_vertexBuffers));
+	memset(&m_vertexStrides, 0, sizeof(m_vertexStrides));
+	memset(&m_vertexOffsets, 0, sizeof(m_vertexOffsets));
+	m_indexBuffer = 0;
+	m_indexFormat = DXGI_FORMAT_UNKNOWN;
+	m_indexOffset = 0;
+	m_topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	m_indexBufferKnown = false;
+	m_topologyKnown = false;
+
+	memset(&m_vertexConstantBuffers, 0, sizeof(m_vertexConstantBuffers));
+	memset(&m_vertexFirstConstants, 0, sizeof(m_vertexFirstConstants));
+	memset(&m_vertexConstantCounts, 0, sizeof(m_vertexConstantCounts));
+	memset(&m_pixelConstantBuffers, 0, sizeof(m_pixelConstantBuffers));
+	memset(&m_pixelSamplers, 0, sizeof(m_pixelSamplers));
+	memset(&m_pixelShaderResources, 0, sizeof(m_pixelShaderResources));
+
+	return;
+}
+
+
+bool StateCacheClass::SupportsConstantBufferOffsets()
+{
+	return m_deviceContext1 != 0;
+}
+
+
+void StateCacheClass::SetInputLayout(ID3D11InputLayout* inputLayout)
+{
+	if(m_inputLayoutKnown && inputLayout == m_inputLayout)
+	{
+		Count(m_statistics.inputLayouts, false);
+		return;
+	}
+
+	m_deviceContext->IASetInputLayout(inputLayout);
+	m_inputLayout = inputLayout;
+	m_inputLayoutKnown = true;
+	Count(m_statistics.inputLayouts, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetVertexBuffer(unsigned int slot, ID3D11Buffer* buffer, unsigned int stride, unsigned int offset)
+{
+	// A slot past the ones kept goes straight to the context.
+	if(slot >= (unsigned int)STATE_CACHE_VERTEX_BUFFER_SLOTS)
+	{
+		m_deviceContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+		Count(m_statistics.inputBuffers, true);
+		return;
+	}
+
+	if(m_vertexBuffers.known[slot] && m_vertexBuffers.objects[slot] == buffer && m_vertexStrides[slot] == stride && m_vertexOffsets[slot] == offset)
+	{
+		Count(m_statistics.inputBuffers, false);
+		return;
+	}
+
+	m_deviceContext->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+	m_vertexBuffers.objects[slot] = buffer;
+	m_vertexBuffers.known[slot] = true;
+	m_vertexStrides[slot] = stride;
+	m_vertexOffsets[slot] = offset;
+	Count(m_statistics.inputBuffers, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, unsigned int offset)
+{
+	if(m_indexBufferKnown && buffer == m_indexBuffer && format == m_indexFormat && offset == m_indexOffset)
+	{
+		Count(m_statistics.inputBuffers, false);
+		return;
+	}
+
+	m_deviceContext->IASetIndexBuffer(buffer, format, offset);
+	m_indexBuffer = buffer;
+	m_indexFormat = format;
+	m_indexOffset = offset;
+	m_indexBufferKnown = true;
+	Count(m_statistics.inputBuffers, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	// Counted with the input layouts, both say how the vertices are read.
+	if(m_topologyKnown && topology == m_topology)
+	{
+		Count(m_statistics.inputLayouts, false);
+		return;
+	}
+
+	m_deviceContext->IASetPrimitiveTopology(topology);
+	m_topology = topology;
+	m_topologyKnown = true;
+	Count(m_statistics.inputLayouts, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetVertexShader(ID3D11VertexShader* vertexShader)
+{
+	if(m_vertexShaderKnown && vertexShader == m_vertexShader)
+	{
+		Count(m_statistics.shaders, false);
+		return;
+	}
+
+	m_deviceContext->VSSetShader(vertexShader, NULL, 0);
+	m_vertexShader = vertexShader;
+	m_vertexShaderKnown = true;
+	Count(m_statistics.shaders, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetPixelShader(ID3D11PixelShader* pixelShader)
+{
+	if(m_pixelShaderKnown && pixelShader == m_pixelShader)
+	{
+		Count(m_statistics.shaders, false);
+		return;
+	}
+
+	m_deviceContext->PSSetShader(pixelShader, NULL, 0);
+	m_pixelShader = pixelShader;
+	m_pixelShaderKnown = true;
+	Count(m_statistics.shaders, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetVertexConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	unsigned int i;
+
+
+	// A slot bound to part of a buffer is not what binding the whole buffer would leave, so it has to be set again.
+	for(i=startSlot; i<startSlot + count && i<(unsigned int)STATE_CACHE_CONSTANT_BUFFER_SLOTS; i++)
+	{
+		if(m_vertexConstantCounts[i] != 0)
+		{
+			m_vertexConstantBuffers.known[i] = false;
+			m_vertexFirstConstants[i] = 0;
+			m_vertexConstantCounts[i] = 0;
+		}
+	}
+
+	if(Filter(m_vertexConstantBuffers, startSlot, count, buffers, m_statistics.constantBuffers))
+	{
+		m_deviceContext->VSSetConstantBuffers(startSlot, count, buffers);
+	}
+
+	return;
+}
+
+
+void StateCacheClass::SetVertexConstantBuffer1(unsigned int slot, ID3D11Buffer* buffer, unsigned int firstConstant, unsigned int constantCount)
+{
+	// A slot past the ones kept goes straight to the context.
+	if(slot >= (unsigned int)STATE_CACHE_CONSTANT_BUFFER_SLOTS)
+	{
+		m_deviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+		Count(m_statistics.constantBuffers, true);
+		return;
+	}
+
+	if(m_vertexConstantBuffers.known[slot] && m_vertexConstantBuffers.objects[slot] == buffer && m_vertexFirstConstants[slot] == firstConstant &&
+	   m_vertexConstantCounts[slot] == constantCount)
+	{
+		Count(m_statistics.constantBuffers, false);
+		return;
+	}
+
+	m_deviceContext1->VSSetConstantBuffers1(slot, 1, &buffer, &firstConstant, &constantCount);
+	m_vertexConstantBuffers.objects[slot] = buffer;
+	m_vertexConstantBuffers.known[slot] = true;
+	m_vertexFirstConstants[slot] = firstConstant;
+	m_vertexConstantCounts[slot] = constantCount;
+	Count(m_statistics.constantBuffers, true);
+
+	return;
+}
+
+
+void StateCacheClass::SetPixelConstantBuffers(unsigned int startSlot, unsigned int count, ID3D11Buffer* const* buffers)
+{
+	if(Filter(m_pixelConstantBuffers, startSlot, count, buffers, m_statistics.constantBuffers))
+	{
+		m_deviceContext->PSSetConstantBuffers(startSlot, count, buffers);
+	}
+
+	return;
+}
+
+
+void StateCacheClass::SetPixelSamplers(unsigned int startSlot, unsigned int count, ID3D11SamplerState* const* samplers)
+{
+	if(Filter(m_pixelSamplers, startSlot, count, samplers, m_statistics.samplers))
+	{
+		m_deviceContext->PSSetSamplers(startSlot, count, samplers);
+	}
+
+	return;
+}
+
+
+void StateCacheClass::SetPixelShaderResources(unsigned int startSlot, unsigned int count, ID3D11ShaderResourceView* const* views)
+{
+	if(Filter(m_pixelShaderResources, startSlot, count, views, m_statistics.shaderResources))
+	{
+		m_deviceContext->PSSetShaderResources(startSlot, count, views);
+	}
+
+	return;
+}
+
+
+void StateCacheClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_statistics;
+	memset(&m_statistics, 0, sizeof(m_statistics));
+
+	return;
+}
+
+
+template<class Type, int SlotCount>
+bool StateCacheClass::Filter(SlotsType<Type, SlotCount>& slots, unsigned int& startSlot, unsigned int& count, Type* const*& objects, CallsType& calls)
+{
+	unsigned int first, last, i;
+
+
+	// A call reaching past the slots that are kept goes through whole, the kept slots it covers are still recorded.
+	if(startSlot + count > (unsigned int)SlotCount)
+	{
+		for(i=startSlot; i<(unsigned int)SlotCount; i++)
+		{
+			slots.objects[i] = objects[i - startSlot];
+			slots.known[i] = true;
+		}
+
+		Count(calls, true);
+		return true;
+	}
+
+	// Find the first and last slots the call changes.
+	first = count;
+	last = 0;
+	for(i=0; i<count; i++)
+	{
+		if(!slots.known[startSlot + i] || slots.objects[startSlot + i] != objects[i])
+		{
+			if(first == count)
+			{
+				first = i;
+			}
+			last = i;
+
+			slots.objects[startSlot + i] = objects[i];
+			slots.known[startSlot + i] = true;
+		}
+	}
+
+	// Everything it binds is bound already.
+	if(first == count)
+	{
+		Count(calls, false);
+		return false;
+	}
+
+	// Only bind from the first change to the last, the slots either side of them hold what they would be set to.
+	startSlot += first;
+	objects += first;
+	count = last - first + 1;
+
+	Count(calls, true);
+
+	return true;
+}
+
+
+void StateCacheClass::Count(CallsType& calls, bool issued)
+{
+#ifdef _DEBUG
+	if(issued)
+	{
+		calls.issued++;
+	}
+	else
+	{
+		calls.filtered++;
+	}
+#endif
+
+	return;
+}
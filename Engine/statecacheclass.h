@@ -0,0 +1,134 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: statecacheclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STATECACHECLASS_H_
+#define _STATECACHECLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Slots of each kind the cache remembers, a call reaching past them goes straight to the device context.
+const int STATE_CACHE_CONSTANT_BUFFER_SLOTS = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+const int STATE_CACHE_SAMPLER_SLOTS = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+const int STATE_CACHE_SHADER_RESOURCE_SLOTS = 16;
+const int STATE_CACHE_VERTEX_BUFFER_SLOTS = 2;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StateCacheClass
+//
+// A copy of what the shader classes and the models have bound on the device
+// context, so a call that binds what is already there is dropped before it
+// reaches the driver.  Drawing the same model again only sets what differs
+// from the draw before, and a call covering several slots is cut down to the
+// ones that changed.
+//
+// The shaders, their constant buffers, samplers and textures, and the input
+// assembler's layout, vertex and index buffers and topology all go through
+// here.  The output merger and rasterizer states and the viewport are left
+// to D3DClass, which sets them straight on the context.
+//
+// Comparing addresses is safe because the context holds a reference to
+// everything bound to it, so a released object stays alive, and its address
+// taken, until something else is bound in its place.  Anything that binds
+// the kinds above outside the cache has to call Reset, after which every
+// slot is bound again on its next call.
+//
+// SetVertexConstantBuffer1 binds part of a buffer, for the constants of a
+// draw in a ring of them.  The slot is only the same when both the buffer
+// and the range are, and a whole buffer bound over it later is always set.
+// It needs the Direct3D 11.1 context, SupportsConstantBufferOffsets says
+// whether there is one.
+//
+// Debug builds count the calls issued and dropped, GetStatistics hands over
+// the counts since it was last called.
+////////////////////////////////////////////////////////////////////////////////
+class StateCacheClass
+{
+public:
+	struct CallsType
+	{
+		int issued;
+		int filtered;
+	};
+
+	struct StatisticsType
+	{
+		CallsType inputLayouts;
+		CallsType inputBuffers;
+		CallsType shaders;
+		CallsType constantBuffers;
+		CallsType samplers;
+		CallsType shaderResources;
+	};
+
+private:
+	// The objects bound to one shader stage.
+	template<class Type, int SlotCount>
+	struct SlotsType
+	{
+		Type* objects[SlotCount];
+		bool known[SlotCount];
+	};
+
+public:
+	StateCacheClass();
+	StateCacheClass(const StateCacheClass&);
+	~StateCacheClass();
+
+	void Initialize(ID3D11DeviceContext*);
+	void Shutdown();
+	void Reset();
+	bool SupportsConstantBufferOffsets();
+
+	void SetInputLayout(ID3D11InputLayout*);
+	void SetVertexBuffer(unsigned int, ID3D11Buffer*, unsigned int, unsigned int);
+	void SetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, unsigned int);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY);
+	void SetVertexShader(ID3D11VertexShader*);
+	void SetPixelShader(ID3D11PixelShader*);
+	void SetVertexConstantBuffers(unsigned int, unsigned int, ID3D11Buffer* const*);
+	void SetVertexConstantBuffer1(unsigned int, ID3D11Buffer*, unsigned int, unsigned int);
+	void SetPixelConstantBuffers(unsigned int, unsigned int, ID3D11Buffer* const*);
+	void SetPixelSamplers(unsigned int, unsigned int, ID3D11SamplerState* const*);
+	void SetPixelShaderResources(unsigned int, unsigned int, ID3D11ShaderResourceView* const*);
+
+	void GetStatistics(StatisticsType&);
+
+private:
+	template<class Type, int SlotCount>
+	bool Filter(SlotsType<Type, SlotCount>&, unsigned int&, unsigned int&, Type* const*&, CallsType&);
+	void Count(CallsType&, bool);
+
+private:
+	ID3D11DeviceContext* m_deviceContext;
+	ID3D11DeviceContext1* m_deviceContext1;
+	ID3D11InputLayout* m_inputLayout;
+	ID3D11VertexShader* m_vertexShader;
+	ID3D11PixelShader* m_pixelShader;
+	bool m_inputLayoutKnown, m_vertexShaderKnown, m_pixelShaderKnown;
+	SlotsType<ID3D11Buffer, STATE_CACHE_VERTEX_BUFFER_SLOTS> m_vertexBuffers;
+	unsigned int m_vertexStrides[STATE_CACHE_VERTEX_BUFFER_SLOTS];
+	unsigned int m_vertexOffsets[STATE_CACHE_VERTEX_BUFFER_SLOTS];
+	ID3D11Buffer* m_indexBuffer;
+	DXGI_FORMAT m_indexFormat;
+	unsigned int m_indexOffset;
+	D3D11_PRIMITIVE_TOPOLOGY m_topology;
+	bool m_indexBufferKnown, m_topologyKnown;
+	SlotsType<ID3D11Buffer, STATE_CACHE_CONSTANT_BUFFER_SLOTS> m_vertexConstantBuffers;
+	unsigned int m_vertexFirstConstants[STATE_CACHE_CONSTANT_BUFFER_SLOTS];
+	unsigned int m_vertexConstantCounts[STATE_CACHE_CONSTANT_BUFFER_SLOTS];
+	SlotsType<ID3D11Buffer, STATE_CACHE_CONSTANT_BUFFER_SLOTS> m_pixelConstantBuffers;
+	SlotsType<ID3D11SamplerState, STATE_CACHE_SAMPLER_SLOTS> m_pixelSamplers;
+	SlotsType<ID3D11ShaderResourceView, STATE_CACHE_SHADER_RESOURCE_SLOTS> m_pixelShaderResources;
+	StatisticsType m_statistics;
+};
+
+#endif
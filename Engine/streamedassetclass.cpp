@@ -0,0 +1,79 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: streamedassetclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "streamedassetclass.h"
+
+
+StreamedAssetClass::StreamedAssetClass()
+{
+	m_state = LOAD_STATE_PENDING;
+	m_failureTaken = false;
+}
+
+
+StreamedAssetClass::StreamedAssetClass(const StreamedAssetClass& other)
+{
+}
+
+
+StreamedAssetClass::~StreamedAssetClass()
+{
+}
+
+
+void StreamedAssetClass::SetLoaded(bool result)
+{
+	// Called from the loader job, the frame loop picks the result up in its next Update.
+	m_state = result ? LOAD_STATE_READY : LOAD_STATE_FAILED;
+
+	return;
+}
+
+
+void StreamedAssetClass::Update(const function<bool()>& swap)
+{
+	// Only a finished job is swapped in, anything still pending keeps its placeholder for another frame.
+	if(m_state == LOAD_STATE_READY)
+	{
+		m_state = swap() ? LOAD_STATE_RESIDENT : LOAD_STATE_FAILED;
+	}
+
+	return;
+}
+
+
+LoadStateType StreamedAssetClass::GetState()
+{
+	return (LoadStateType)m_state.load();
+}
+
+
+bool StreamedAssetClass::IsReady()
+{
+	return m_state == LOAD_STATE_READY;
+}
+
+
+bool StreamedAssetClass::IsResident()
+{
+	return m_state == LOAD_STATE_RESIDENT;
+}
+
+
+bool StreamedAssetClass::IsFailed()
+{
+	return m_state == LOAD_STATE_FAILED;
+}
+
+
+bool StreamedAssetClass::TakeFailure()
+{
+	if(m_state != LOAD_STATE_FAILED || m_failureTaken)
+	{
+		return false;
+	}
+
+	m_failureTaken = true;
+
+	return true;
+}
@@ -0,0 +1,56 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: streamedassetclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _STREAMEDASSETCLASS_H_
+#define _STREAMEDASSETCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <atomic>
+#include <functional>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "jobsystemclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: StreamedAssetClass
+//
+// Where a streamed mesh or texture is between its loader job and the frame
+// loop, and the swap from its placeholder to the real thing.  The loader job
+// calls SetLoaded when the CPU side is done.  Update, called every frame on
+// the thread that owns the device, runs the swap it is given once the job
+// has finished and never waits on one that has not.
+//
+// An asset whose job or swap fails stays failed and the caller keeps drawing
+// its placeholder.  TakeFailure is true just once after that, so the caller
+// logs the failure a single time instead of every frame.
+////////////////////////////////////////////////////////////////////////////////
+class StreamedAssetClass
+{
+public:
+	StreamedAssetClass();
+	StreamedAssetClass(const StreamedAssetClass&);
+	~StreamedAssetClass();
+
+	void SetLoaded(bool);
+	void Update(const function<bool()>&);
+
+	LoadStateType GetState();
+	bool IsReady();
+	bool IsResident();
+	bool IsFailed();
+	bool TakeFailure();
+
+private:
+	atomic<int> m_state;
+	bool m_failureTaken;
+};
+
+#endif
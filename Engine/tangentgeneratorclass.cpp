@@ -0,0 +1,295 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: tangentgeneratorclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "tangentgeneratorclass.h"
+#include "loadlogclass.h"
+
+#include <cmath>
+#include <cstring>
+#include <xmmintrin.h>
+
+
+bool TangentGeneratorClass::Generate(float* vertices, int vertexCount, const VertexCompressionClass::FormatType& format, const unsigned int* indices,
+									 int indexCount, StatisticsType& statistics)
+{
+	double startTime;
+	int i;
+
+
+	// The batches load four floats at a time from the position and the normal, and the sums need the binormal straight after the tangent.
+	if(format.position < 0 || format.texture < 0 || format.normal < 0 || format.tangent < 0 || format.binormal != format.tangent + 3 ||
+	   format.position + 4 > format.floatsPerVertex || format.normal + 4 > format.floatsPerVertex)
+	{
+		return false;
+	}
+
+	startTime = LoadLogClass::GetTime();
+
+	// The sums go straight into the tangent and binormal of each vertex, which saves a work array as large as the mesh.
+	for(i=0; i<vertexCount; i++)
+	{
+		memset(&vertices[i * format.floatsPerVertex + format.tangent], 0, sizeof(float) * 6);
+	}
+
+	statistics.degenerateTriangles = 0;
+	statistics.fallbackVertices = 0;
+
+	AccumulateTriangles(vertices, format, indices, indexCount / 3, statistics.degenerateTriangles);
+	OrthonormalizeVertices(vertices, vertexCount, format, statistics.fallbackVertices);
+
+	LoadLogClass::Write("tangents: %d vertices from %d triangles in %.3f ms, %d triangles with degenerate texture coordinates, %d fallback frames",
+						vertexCount, indexCount / 3, LoadLogClass::GetTime() - startTime, statistics.degenerateTriangles, statistics.fallbackVertices);
+
+	return true;
+}
+
+
+void TangentGeneratorClass::AccumulateTriangles(float* vertices, const VertexCompressionClass::FormatType& format, const unsigned int* indices,
+												int triangleCount, int& degenerateTriangles)
+{
+	const float* corner[3][4];
+	float* sum;
+	__m128 position[3][4], u[3], v[3], tangent[3], binormal[3], first[4], second[4];
+	__m128 du1, dv1, du2, dv2, determinant, valid, sign, signMask, one, zero;
+	int triangle, laneCount, validMask, lane, k;
+
+
+	signMask = _mm_set1_ps(-0.0f);
+	one = _mm_set1_ps(1.0f);
+	zero = _mm_setzero_ps();
+
+	for(triangle=0; triangle<triangleCount; triangle+=4)
+	{
+		laneCount = triangleCount - triangle < 4 ? triangleCount - triangle : 4;
+
+		// Find the corners of four triangles, a short last batch repeats its first triangle and never adds the copies in.
+		for(lane=0; lane<4; lane++)
+		{
+			for(k=0; k<3; k++)
+			{
+				corner[k][lane] = &vertices[indices[(triangle + (lane < laneCount ? lane : 0)) * 3 + k] * format.floatsPerVertex];
+			}
+		}
+
+		// Load each position whole and transpose, so every register holds one component of the same corner of all four triangles.
+		for(k=0; k<3; k++)
+		{
+			for(lane=0; lane<4; lane++)
+			{
+				position[k][lane] = _mm_loadu_ps(&corner[k][lane][format.position]);
+			}
+			_MM_TRANSPOSE4_PS(position[k][0], position[k][1], position[k][2], position[k][3]);
+
+			u[k] = _mm_setr_ps(corner[k][0][format.texture], corner[k][1][format.texture], corner[k][2][format.texture], corner[k][3][format.texture]);
+			v[k] = _mm_setr_ps(corner[k][0][format.texture + 1], corner[k][1][format.texture + 1], corner[k][2][format.texture + 1],
+							   corner[k][3][format.texture + 1]);
+		}
+
+		du1 = _mm_sub_ps(u[1], u[0]);
+		dv1 = _mm_sub_ps(v[1], v[0]);
+		du2 = _mm_sub_ps(u[2], u[0]);
+		dv2 = _mm_sub_ps(v[2], v[0]);
+
+		// The texture space directions are the edges over the determinant.  Multiplying by its sign instead leaves them weighted
+		// by the texture area of the triangle, and a triangle with no texture area gets a sign of zero rather than a division by it.
+		determinant = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+		valid = _mm_cmpgt_ps(_mm_andnot_ps(signMask, determinant), _mm_set1_ps(TANGENT_GENERATOR_UV_EPSILON));
+		sign = _mm_and_ps(_mm_or_ps(_mm_and_ps(determinant, signMask), one), valid);
+
+		for(k=0; k<3; k++)
+		{
+			tangent[k] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_sub_ps(position[1][k], position[0][k]), dv2),
+											   _mm_mul_ps(_mm_sub_ps(position[2][k], position[0][k]), dv1)), sign);
+			binormal[k] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_sub_ps(position[2][k], position[0][k]), du1),
+												_mm_mul_ps(_mm_sub_ps(position[1][k], position[0][k]), du2)), sign);
+		}
+
+		// Transpose back to one triangle to a pair of registers, the tangent with the first binormal component and the rest of the binormal.
+		first[0] = tangent[0];
+		first[1] = tangent[1];
+		first[2] = tangent[2];
+		first[3] = binormal[0];
+		_MM_TRANSPOSE4_PS(first[0], first[1], first[2], first[3]);
+
+		second[0] = binormal[1];
+		second[1] = binormal[2];
+		second[2] = zero;
+		second[3] = zero;
+		_MM_TRANSPOSE4_PS(second[0], second[1], second[2], second[3]);
+
+		validMask = _mm_movemask_ps(valid);
+
+		// Add each triangle into its corners one at a time, two triangles in a batch often share a vertex.  The corners are still in
+		// the cache from the loads above.
+		for(lane=0; lane<laneCount; lane++)
+		{
+			if(!(validMask & (1 << lane)))
+			{
+				degenerateTriangles++;
+				continue;
+			}
+
+			for(k=0; k<3; k++)
+			{
+				sum = &vertices[indices[(triangle + lane) * 3 + k] * format.floatsPerVertex + format.tangent];
+				_mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), first[lane]));
+				_mm_storel_pi((__m64*)&sum[4], _mm_add_ps(_mm_loadl_pi(zero, (const __m64*)&sum[4]), second[lane]));
+			}
+		}
+	}
+
+	return;
+}
+
+
+void TangentGeneratorClass::OrthonormalizeVertices(float* vertices, int vertexCount, const VertexCompressionClass::FormatType& format,
+												   int& fallbackVertices)
+{
+	float tangents[3][4], binormals[3][4], normals[3][4], binormalSums[3][4], normal[3], binormalSum[3];
+	__m128 n[4], t[4], b[4], c[3], length, dot, handedness, degenerate, epsilon, signMask, one, zero;
+	float* vertex;
+	int first, laneCount, degenerateMask, lane, k;
+
+
+	epsilon = _mm_set1_ps(TANGENT_GENERATOR_LENGTH_EPSILON);
+	signMask = _mm_set1_ps(-0.0f);
+	one = _mm_set1_ps(1.0f);
+	zero = _mm_setzero_ps();
+
+	for(first=0; first<vertexCount; first+=4)
+	{
+		laneCount = vertexCount - first < 4 ? vertexCount - first : 4;
+
+		// Transpose four vertices into one component to a register, the padding lanes of the last batch are all zero.
+		for(lane=0; lane<4; lane++)
+		{
+			vertex = &vertices[(first + lane) * format.floatsPerVertex];
+			n[lane] = lane < laneCount ? _mm_loadu_ps(&vertex[format.normal]) : zero;
+			t[lane] = lane < laneCount ? _mm_loadu_ps(&vertex[format.tangent]) : zero;
+			b[lane] = lane < laneCount ? _mm_loadl_pi(zero, (const __m64*)&vertex[format.binormal + 1]) : zero;
+		}
+		_MM_TRANSPOSE4_PS(n[0], n[1], n[2], n[3]);
+		_MM_TRANSPOSE4_PS(t[0], t[1], t[2], t[3]);
+		_MM_TRANSPOSE4_PS(b[0], b[1], b[2], b[3]);
+
+		// The first binormal component rides along with the tangent.
+		b[2] = b[1];
+		b[1] = b[0];
+		b[0] = t[3];
+
+		// The normal from the file is kept as it is, a unit copy of it is enough to build the frame around.
+		length = _mm_sqrt_ps(_mm_max_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], n[0]), _mm_mul_ps(n[1], n[1])), _mm_mul_ps(n[2], n[2])), epsilon));
+		for(k=0; k<3; k++)
+		{
+			n[k] = _mm_div_ps(n[k], length);
+		}
+
+		// Gram-Schmidt, take the part of the tangent along the normal out and make what is left unit length.
+		dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(n[0], t[0]), _mm_mul_ps(n[1], t[1])), _mm_mul_ps(n[2], t[2]));
+		for(k=0; k<3; k++)
+		{
+			t[k] = _mm_sub_ps(t[k], _mm_mul_ps(n[k], dot));
+		}
+
+		length = _mm_add_ps(_mm_add_ps(_mm_mul_ps(t[0], t[0]), _mm_mul_ps(t[1], t[1])), _mm_mul_ps(t[2], t[2]));
+		degenerate = _mm_cmple_ps(length, epsilon);
+		length = _mm_sqrt_ps(_mm_max_ps(length, epsilon));
+		for(k=0; k<3; k++)
+		{
+			t[k] = _mm_div_ps(t[k], length);
+		}
+
+		// The binormal is rebuilt from the normal and tangent so the frame is exactly orthonormal, the summed binormal only decides
+		// which way it points.
+		c[0] = _mm_sub_ps(_mm_mul_ps(n[1], t[2]), _mm_mul_ps(n[2], t[1]));
+		c[1] = _mm_sub_ps(_mm_mul_ps(n[2], t[0]), _mm_mul_ps(n[0], t[2]));
+		c[2] = _mm_sub_ps(_mm_mul_ps(n[0], t[1]), _mm_mul_ps(n[1], t[0]));
+
+		dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c[0], b[0]), _mm_mul_ps(c[1], b[1])), _mm_mul_ps(c[2], b[2]));
+		handedness = _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(dot, zero), signMask), one);
+
+		for(k=0; k<3; k++)
+		{
+			_mm_storeu_ps(tangents[k], t[k]);
+			_mm_storeu_ps(binormals[k], _mm_mul_ps(c[k], handedness));
+			_mm_storeu_ps(normals[k], n[k]);
+			_mm_storeu_ps(binormalSums[k], b[k]);
+		}
+
+		degenerateMask = _mm_movemask_ps(degenerate);
+
+		for(lane=0; lane<laneCount; lane++)
+		{
+			vertex = &vertices[(first + lane) * format.floatsPerVertex];
+
+			// A vertex that only touches triangles without texture space directions still needs some frame around its normal.
+			if(degenerateMask & (1 << lane))
+			{
+				for(k=0; k<3; k++)
+				{
+					normal[k] = normals[k][lane];
+					binormalSum[k] = binormalSums[k][lane];
+				}
+
+				FallbackFrame(normal, binormalSum, &vertex[format.tangent], &vertex[format.binormal]);
+				fallbackVertices++;
+				continue;
+			}
+
+			for(k=0; k<3; k++)
+			{
+				vertex[format.tangent + k] = tangents[k][lane];
+				vertex[format.binormal + k] = binormals[k][lane];
+			}
+		}
+	}
+
+	return;
+}
+
+
+void TangentGeneratorClass::FallbackFrame(const float* normal, const float* binormalSum, float* tangent, float* binormal)
+{
+	float axis[3], cross[3], dot, length, handedness;
+	int k;
+
+
+	// Turn the summed binormal into the tangent of a right handed frame if there is one, otherwise pick the axis furthest from the normal.
+	tangent[0] = binormalSum[1] * normal[2] - binormalSum[2] * normal[1];
+	tangent[1] = binormalSum[2] * normal[0] - binormalSum[0] * normal[2];
+	tangent[2] = binormalSum[0] * normal[1] - binormalSum[1] * normal[0];
+
+	length = tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2];
+	if(length <= TANGENT_GENERATOR_LENGTH_EPSILON)
+	{
+		axis[0] = fabsf(normal[0]) < 0.9f ? 1.0f : 0.0f;
+		axis[1] = fabsf(normal[0]) < 0.9f ? 0.0f : 1.0f;
+		axis[2] = 0.0f;
+
+		dot = normal[0] * axis[0] + normal[1] * axis[1] + normal[2] * axis[2];
+		for(k=0; k<3; k++)
+		{
+			tangent[k] = axis[k] - normal[k] * dot;
+		}
+
+		length = tangent[0] * tangent[0] + tangent[1] * tangent[1] + tangent[2] * tangent[2];
+	}
+
+	length = sqrtf(length);
+	for(k=0; k<3; k++)
+	{
+		tangent[k] = tangent[k] / length;
+	}
+
+	cross[0] = normal[1] * tangent[2] - normal[2] * tangent[1];
+	cross[1] = normal[2] * tangent[0] - normal[0] * tangent[2];
+	cross[2] = normal[0] * tangent[1] - normal[1] * tangent[0];
+
+	handedness = (cross[0] * binormalSum[0] + cross[1] * binormalSum[1] + cross[2] * binormalSum[2]) < 0.0f ? -1.0f : 1.0f;
+	for(k=0; k<3; k++)
+	{
+		binormal[k] = cross[k] * handedness;
+	}
+
+	return;
+}
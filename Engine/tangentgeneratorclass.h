@@ -0,0 +1,55 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: tangentgeneratorclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TANGENTGENERATORCLASS_H_
+#define _TANGENTGENERATORCLASS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "vertexcompressionclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Triangles whose texture coordinates span less than this area have no usable texture direction and add nothing.
+const float TANGENT_GENERATOR_UV_EPSILON = 1.0e-12f;
+// Squared length under which an accumulated vector counts as no direction at all.
+const float TANGENT_GENERATOR_LENGTH_EPSILON = 1.0e-20f;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TangentGeneratorClass
+//
+// Builds a smooth tangent frame for every vertex of an indexed mesh.  Each
+// triangle adds its texture space directions to its three vertices, weighted
+// by its area in texture space, and each vertex then has its sum made
+// orthonormal to its normal.  The handedness of the frame goes into the
+// direction of the binormal, which is always the cross product of the normal
+// and the tangent times plus or minus one.
+//
+// Triangles go through four at a time and vertices four at a time with SSE.
+// The sums are built up in the tangent and binormal of the vertices, so the
+// binormal has to follow straight after the tangent.
+////////////////////////////////////////////////////////////////////////////////
+class TangentGeneratorClass
+{
+public:
+	struct StatisticsType
+	{
+		int degenerateTriangles;
+		int fallbackVertices;
+	};
+
+public:
+	static bool Generate(float*, int, const VertexCompressionClass::FormatType&, const unsigned int*, int, StatisticsType&);
+
+private:
+	static void AccumulateTriangles(float*, const VertexCompressionClass::FormatType&, const unsigned int*, int, int&);
+	static void OrthonormalizeVertices(float*, int, const VertexCompressionClass::FormatType&, int&);
+	static void FallbackFrame(const float*, const float*, float*, float*);
+};
+
+#endif
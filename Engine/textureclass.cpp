@@ -3,10 +3,26 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "textureclass.h"
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+using namespace std;
+
 
 TextureClass::TextureClass()
 {
 	m_texture = 0;
+	m_placeholder = 0;
+	m_MappedFile = 0;
+	m_fileData = 0;
+	m_fileSize = 0;
+	m_contentHash = 0;
+	m_contentSize = 0;
+	m_width = 0;
+	m_height = 0;
+	m_mipCount = 0;
+	m_topMip = 0;
+	m_streamed = false;
 }
 
 
@@ -22,17 +38,273 @@ TextureClass::~TextureClass()
 
 bool TextureClass::Initialize(ID3D11Device* device, WCHAR* filename)
 {
+	bool result;
+
+
+	// Read the file in and then create the texture from it.
+	result = Load(filename);
+	if(!result)
+	{
+		return false;
+	}
+
+	m_loadState.Update([this, device]() { return Create(device); });
+	if(!m_loadState.IsResident())
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool TextureClass::Load(WCHAR* filename, AssetArchiveClass* assetArchive, bool hashContent)
+{
+	bool result;
+
+
+	// This only touches the file so it is safe to run on a loader thread, the device is not needed until Create.
+	result = ReadDdsFile(filename, assetArchive, hashContent);
+
+	// Publish the file data to the frame loop, it picks it up in Update.
+	m_loadState.SetLoaded(result);
+
+	return result;
+}
+
+
+bool TextureClass::ReadDdsFile(WCHAR* filename, AssetArchiveClass* assetArchive, bool hashContent)
+{
+	const AssetArchiveClass::EntryType* entry;
+	DdsHeaderType header;
+	double startTime;
+	bool result;
+
+
+	startTime = LoadLogClass::GetTime();
+
+	ReleaseFileData();
+
+	// A texture in the asset archive is used straight out of its mapping, the archive outlives the texture.
+	entry = assetArchive ? assetArchive->Find(filesystem::path(filename).filename().string().c_str(), ASSET_TYPE_TEXTURE) : 0;
+	if(entry)
+	{
+		m_fileData = assetArchive->GetData(entry);
+		m_fileSize = (size_t)entry->size;
+	}
+	else
+	{
+		// Otherwise map the loose file.  Create hands the mapping to the device as it is, so the file is never copied onto the heap.
+		m_MappedFile = new MappedFileClass;
+		if(!m_MappedFile)
+		{
+			return false;
+		}
+
+		result = m_MappedFile->Initialize(filename);
+		if(!result)
+		{
+			delete m_MappedFile;
+			m_MappedFile = 0;
+			return false;
+		}
+
+		m_fileData = m_MappedFile->GetData();
+		m_fileSize = m_MappedFile->GetSize();
+	}
+
+	// Check the magic number and the header size before anything else is done with the data.
+	if(m_fileSize < sizeof(unsigned int) + 124)
+	{
+		ReleaseFileData();
+		return false;
+	}
+
+	memcpy(&header, m_fileData, sizeof(header));
+	if(header.magic != 0x20534444 || header.size != 124)
+	{
+		ReleaseFileData();
+		return false;
+	}
+
+	// Hash the file the same way the archive hashes its blobs so a texture can be matched against another with the same data,
+	// an archive entry has its hash already.
+	m_contentSize = m_fileSize;
+	m_width = (int)header.width;
+	m_height = (int)header.height;
+	m_mipCount = header.mipMapCount ? (int)header.mipMapCount : 1;
+	if(hashContent)
+	{
+		m_contentHash = entry ? entry->contentHash : AssetArchiveClass::Hash(m_fileData, m_fileSize, ASSET_ARCHIVE_HASH_SEED);
+	}
+
+	LoadLogClass::Write("texture %ls: %u x %u, %u mips, %u bytes %s in %.3f ms", filename, header.width, header.height,
+						header.mipMapCount ? header.mipMapCount : 1, (unsigned int)m_fileSize, entry ? "from asset archive" : "mapped",
+						LoadLogClass::GetTime() - startTime);
+
+	return true;
+}
+
+
+bool TextureClass::Create(ID3D11Device* device)
+{
+	ID3D11Resource* resource;
 	HRESULT result;
+	bool created;
+
 
+	if(!m_fileData)
+	{
+		return false;
+	}
+
+	// Create the texture from the file data found by Load.  The loader points each subresource straight into that data,
+	// so the only copy made is the device's own.  A streamed texture skips the mips above its top mip.
+	result = CreateDDSTextureFromMemory(device, m_fileData, m_fileSize, &resource, NULL, GetMaxSize());
+
+	// The texture has its own copy now, unless it is streamed and will be created again with other mips.
+	if(!m_streamed)
+	{
+		ReleaseFileData();
+	}
+
+	created = false;
+	if(SUCCEEDED(result))
+	{
+		created = CreateView(device, resource, &m_texture);
+		resource->Release();
+	}
+
+	if(!created)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+bool TextureClass::CreatePlaceholder(ID3D11Device* device, unsigned int color)
+{
+	D3D11_TEXTURE2D_DESC textureDesc;
+	D3D11_SUBRESOURCE_DATA textureData;
+	ID3D11Texture2D* texture;
+	HRESULT result;
+	bool created;
 
-	// Load the texture in.
-	result = CreateDDSTextureFromFile(device, filename, NULL, &m_texture, NULL);
 
+	// A shared texture only needs the one placeholder, and none once the real texture is there.
+	if(m_placeholder || m_loadState.IsResident())
+	{
+		return true;
+	}
+
+	// A single RGBA texel the shaders sample until the real texture has streamed in.
+	textureDesc.Width = 1;
+	textureDesc.Height = 1;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.SampleDesc.Quality = 0;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	textureDesc.CPUAccessFlags = 0;
+	textureDesc.MiscFlags = 0;
+
+	textureData.pSysMem = &color;
+	textureData.SysMemPitch = sizeof(color);
+	textureData.SysMemSlicePitch = 0;
+
+	result = device->CreateTexture2D(&textureDesc, &textureData, &texture);
 	if(FAILED(result))
 	{
 		return false;
 	}
 
+	// The view keeps the texture alive.
+	created = CreateView(device, texture, &m_placeholder);
+	texture->Release();
+	if(!created)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+void TextureClass::Update(ID3D11Device* device)
+{
+	// Never waits, a texture still loading or that could not be loaded just keeps its placeholder.
+	m_loadState.Update([this, device]() { return Create(device); });
+
+	// The real texture replaces the placeholder from the next draw on.
+	if(m_loadState.IsResident() && m_placeholder)
+	{
+		m_placeholder->Release();
+		m_placeholder = 0;
+	}
+
+	return;
+}
+
+
+bool TextureClass::SetTopMip(ID3D11Device* device, int topMip)
+{
+	ID3D11Resource* resource;
+	ID3D11ShaderResourceView* texture;
+	HRESULT result;
+	int oldTopMip;
+	bool created;
+
+
+	// From here on the file data is kept so the texture can be created again with more or fewer mips.
+	m_streamed = true;
+
+	if(topMip < 0)
+	{
+		topMip = 0;
+	}
+	if(topMip > m_mipCount - 1)
+	{
+		topMip = m_mipCount - 1;
+	}
+
+	// Before the texture exists this only sets the mips Create starts from.
+	if(!m_loadState.IsResident() || topMip == m_topMip)
+	{
+		m_topMip = topMip;
+		return true;
+	}
+
+	if(!m_fileData)
+	{
+		return false;
+	}
+
+	// Create the texture again from the file data with the new top mip, the old one is only released once the new one is there
+	// so the shaders always have something to sample.
+	oldTopMip = m_topMip;
+	m_topMip = topMip;
+	result = CreateDDSTextureFromMemory(device, m_fileData, m_fileSize, &resource, NULL, GetMaxSize());
+
+	created = false;
+	if(SUCCEEDED(result))
+	{
+		created = CreateView(device, resource, &texture);
+		resource->Release();
+	}
+
+	if(!created)
+	{
+		m_topMip = oldTopMip;
+		return false;
+	}
+
+	m_texture->Release();
+	m_texture = texture;
+
 	return true;
 }
 
@@ -46,11 +318,139 @@ void TextureClass::Shutdown()
 		m_texture = 0;
 	}
 
+	// Release the placeholder if the texture never finished streaming in.
+	if(m_placeholder)
+	{
+		m_placeholder->Release();
+		m_placeholder = 0;
+	}
+
+	// Release file data that was loaded but never turned into a texture.
+	ReleaseFileData();
+
 	return;
 }
 
 
+bool TextureClass::IsReady()
+{
+	return m_loadState.IsReady();
+}
+
+
+bool TextureClass::IsResident()
+{
+	return m_loadState.IsResident();
+}
+
+
+bool TextureClass::TakeFailure()
+{
+	return m_loadState.TakeFailure();
+}
+
+
 ID3D11ShaderResourceView* TextureClass::GetTexture()
 {
+	// Hand out the placeholder until the texture itself exists.
+	if(!m_texture)
+	{
+		return m_placeholder;
+	}
+
 	return m_texture;
+}
+
+
+unsigned long long TextureClass::GetContentHash()
+{
+	return m_contentHash;
+}
+
+
+size_t TextureClass::GetContentSize()
+{
+	return m_contentSize;
+}
+
+
+int TextureClass::GetWidth()
+{
+	return m_width;
+}
+
+
+int TextureClass::GetHeight()
+{
+	return m_height;
+}
+
+
+int TextureClass::GetMipCount()
+{
+	return m_mipCount;
+}
+
+
+bool TextureClass::CreateView(ID3D11Device* device, ID3D11Resource* resource, ID3D11ShaderResourceView** view)
+{
+	ID3D11Texture2D* texture;
+	D3D11_TEXTURE2D_DESC textureDesc;
+	D3D11_SHADER_RESOURCE_VIEW_DESC viewDesc;
+	HRESULT result;
+
+
+	// Only 2D textures can be viewed as an array, a volume texture is turned down.
+	result = resource->QueryInterface(__uuidof(ID3D11Texture2D), (void**)&texture);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	texture->GetDesc(&textureDesc);
+	texture->Release();
+
+	// View every mip and every slice the texture was created with.
+	viewDesc.Format = textureDesc.Format;
+	viewDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	viewDesc.Texture2DArray.MostDetailedMip = 0;
+	viewDesc.Texture2DArray.MipLevels = textureDesc.MipLevels;
+	viewDesc.Texture2DArray.FirstArraySlice = 0;
+	viewDesc.Texture2DArray.ArraySize = textureDesc.ArraySize;
+
+	result = device->CreateShaderResourceView(resource, &viewDesc, view);
+	if(FAILED(result))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+size_t TextureClass::GetMaxSize()
+{
+	// The loader skips every mip larger than this on either side, no limit at all keeps the whole chain.
+	if(m_topMip == 0)
+	{
+		return 0;
+	}
+
+	return (size_t)max(max(m_width >> m_topMip, m_height >> m_topMip), 1);
+}
+
+
+void TextureClass::ReleaseFileData()
+{
+	// Only the mapping of a loose file is owned, data from the asset archive belongs to the archive.
+	if(m_MappedFile)
+	{
+		m_MappedFile->Shutdown();
+		delete m_MappedFile;
+		m_MappedFile = 0;
+	}
+	m_fileData = 0;
+	m_fileSize = 0;
+
+	return;
 }
\ No newline at end of file
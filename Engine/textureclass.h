@@ -14,23 +14,79 @@
 using namespace DirectX;
 
 
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "loadlogclass.h"
+#include "streamedassetclass.h"
+#include "mappedfileclass.h"
+#include "assetarchiveclass.h"
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: TextureClass
+//
+// Every texture, the placeholder too, is viewed as a texture array, a plain
+// texture as an array of one.  The shaders sample them all the same way and a
+// texture the asset cooker packed into an array only needs its slice.
 ////////////////////////////////////////////////////////////////////////////////
 class TextureClass
 {
+private:
+	// The start of a DDS file, enough to check it and log what is in it before the device sees it.
+	struct DdsHeaderType
+	{
+		unsigned int magic;
+		unsigned int size;
+		unsigned int flags;
+		unsigned int height;
+		unsigned int width;
+		unsigned int pitchOrLinearSize;
+		unsigned int depth;
+		unsigned int mipMapCount;
+	};
+
 public:
 	TextureClass();
 	TextureClass(const TextureClass&);
 	~TextureClass();
 
 	bool Initialize(ID3D11Device*, WCHAR*);
+	bool Load(WCHAR*, AssetArchiveClass* = 0, bool = false);
+	bool Create(ID3D11Device*);
+	bool CreatePlaceholder(ID3D11Device*, unsigned int);
+	void Update(ID3D11Device*);
+	bool SetTopMip(ID3D11Device*, int);
 	void Shutdown();
 
+	bool IsReady();
+	bool IsResident();
+	bool TakeFailure();
 	ID3D11ShaderResourceView* GetTexture();
+	unsigned long long GetContentHash();
+	size_t GetContentSize();
+	int GetWidth();
+	int GetHeight();
+	int GetMipCount();
+
+private:
+	bool ReadDdsFile(WCHAR*, AssetArchiveClass*, bool);
+	bool CreateView(ID3D11Device*, ID3D11Resource*, ID3D11ShaderResourceView**);
+	size_t GetMaxSize();
+	void ReleaseFileData();
 
 private:
 	ID3D11ShaderResourceView* m_texture;
+	ID3D11ShaderResourceView* m_placeholder;
+	StreamedAssetClass m_loadState;
+	MappedFileClass* m_MappedFile;
+	const unsigned char* m_fileData;
+	size_t m_fileSize;
+	unsigned long long m_contentHash;
+	size_t m_contentSize;
+	int m_width, m_height, m_mipCount;
+	int m_topMip;
+	bool m_streamed;
 };
 
 #endif
\ No newline at end of file
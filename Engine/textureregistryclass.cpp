@@ -0,0 +1,589 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureregistryclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "textureregistryclass.h"
+#include "loadlogclass.h"
+
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+
+
+TextureRegistryClass::TextureRegistryClass()
+{
+	m_device = 0;
+	m_AssetArchive = 0;
+	m_hashContent = false;
+	m_statistics.loadCount = 0;
+	m_statistics.sharedCount = 0;
+	m_statistics.contentSharedCount = 0;
+	m_statistics.packedCount = 0;
+	m_statistics.sharedBytes = 0;
+	m_Residency = 0;
+}
+
+
+TextureRegistryClass::TextureRegistryClass(const TextureRegistryClass& other)
+{
+}
+
+
+TextureRegistryClass::~TextureRegistryClass()
+{
+}
+
+
+bool TextureRegistryClass::Initialize(ID3D11Device* device, AssetArchiveClass* assetArchive, bool hashContent, long long budget,
+									  int residentMips)
+{
+	bool result;
+
+
+	// Keep a pointer to the device the shared textures are created on.
+	m_device = device;
+
+	// Textures found in the asset archive are used from it in place of their files, it may be null.
+	m_AssetArchive = assetArchive;
+
+	// Hashing costs a pass over every loose file on the loader threads, it finds copies of a texture under another name.
+	m_hashContent = hashContent;
+
+	// Without a budget every texture is created with its whole chain, as it is in the file.
+	if(budget <= 0)
+	{
+		return true;
+	}
+
+	// Create the residency object that decides the mips each texture keeps.
+	m_Residency = new TextureResidencyClass;
+	if(!m_Residency)
+	{
+		return false;
+	}
+
+	// Initialize the residency object.
+	result = m_Residency->Initialize(budget, residentMips);
+	if(!result)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+
+void TextureRegistryClass::Shutdown()
+{
+	map<wstring, TextureType*>::iterator texture;
+	TextureResidencyClass::StatisticsType residencyStatistics;
+
+
+	LoadLogClass::Write("texture registry: %d loads, %d shared by name, %d shared by content, %d drawn from texture arrays, %lld bytes deduplicated",
+						m_statistics.loadCount, m_statistics.sharedCount, m_statistics.contentSharedCount, m_statistics.packedCount,
+						m_statistics.sharedBytes);
+
+	if(GetResidencyStatistics(residencyStatistics))
+	{
+		LoadLogClass::Write("texture residency: %d mips streamed in, %lld bytes, %d mips evicted", residencyStatistics.streamedMips,
+							residencyStatistics.streamedBytes, residencyStatistics.evictedMips);
+	}
+
+	// Release anything that was never handed back.
+	for(texture=m_textures.begin(); texture!=m_textures.end(); texture++)
+	{
+		ReleaseTexture(texture->second);
+	}
+
+	m_textures.clear();
+	m_contents.clear();
+
+	// Release the residency object, the textures it knew about are gone.
+	if(m_Residency)
+	{
+		m_Residency->Shutdown();
+		delete m_Residency;
+		m_Residency = 0;
+	}
+	m_residentTextures.clear();
+
+	m_device = 0;
+	m_AssetArchive = 0;
+
+	return;
+}
+
+
+TextureRegistryClass::TextureType* TextureRegistryClass::Acquire(JobSystemClass* jobSystem, WCHAR* filename)
+{
+	map<wstring, TextureType*>::iterator found;
+	const AssetArchiveClass::SliceType* slice;
+	TextureType* handle;
+	TextureType* array;
+	size_t arraySize;
+	wstring name, arrayName;
+
+
+	// The same file reached through different relative paths must map to the same entry.
+	name = GetCanonicalName(filename);
+
+	// If the file is loaded or loading already just hand out another reference to it.
+	found = m_textures.find(name);
+	if(found != m_textures.end())
+	{
+		handle = found->second;
+		handle->referenceCount++;
+
+		// The size is only known once the file has been read, until then the share is counted when it is.
+		m_statistics.sharedCount++;
+		if(handle->size)
+		{
+			m_statistics.sharedBytes += (long long)handle->size;
+		}
+		else
+		{
+			handle->pendingShares++;
+		}
+
+		LoadLogClass::Write("texture registry %ls: shared, %d references", filename, handle->referenceCount);
+
+		return handle;
+	}
+
+	// A texture the cooker packed into an array is drawn from the array, loaded under the name of its archive entry the first time
+	// one of its textures is asked for.
+	slice = FindSlice(filename, arraySize);
+	if(!slice)
+	{
+		return Load(jobSystem, name, filename);
+	}
+
+	arrayName = filesystem::path(slice->array).wstring();
+
+	found = m_textures.find(arrayName);
+	if(found != m_textures.end())
+	{
+		array = found->second;
+		array->referenceCount++;
+	}
+	else
+	{
+		array = Load(jobSystem, arrayName, 0);
+		if(!array)
+		{
+			return 0;
+		}
+		array->array = true;
+	}
+
+	// The handle has no texture of its own, it holds a reference on the array like a texture shared by content.
+	handle = new TextureType;
+	if(!handle)
+	{
+		Release(array);
+		return 0;
+	}
+
+	handle->texture = 0;
+	handle->content = array;
+	handle->size = arraySize / slice->sliceCount;
+	handle->pendingShares = 0;
+	handle->referenceCount = 1;
+	handle->residency = -1;
+	handle->slice = (int)slice->slice;
+	handle->array = false;
+	handle->name = name;
+
+	m_textures[name] = handle;
+	m_statistics.packedCount++;
+
+	LoadLogClass::Write("texture registry %ls: slice %u of %s", filename, slice->slice, slice->array);
+
+	return handle;
+}
+
+
+bool TextureRegistryClass::CreatePlaceholder(TextureType* handle, unsigned int color)
+{
+	// A texture that is shared keeps the placeholder of whoever asked for it first.
+	return handle->content->texture->CreatePlaceholder(m_device, color);
+}
+
+
+bool TextureRegistryClass::Update(TextureType* handle)
+{
+	TextureType* owner;
+
+
+	// A texture in an array is updated through the array, whichever of its textures gets there first.
+	owner = handle->content;
+
+	// The first update to see the file read counts the shares made while it loaded and looks for a copy of its data.  An array
+	// is only ever loaded from the archive, which has no two entries with the same data.
+	if(owner->content == owner && owner->texture->IsReady() && !owner->size)
+	{
+		owner->size = owner->texture->GetContentSize();
+		m_statistics.sharedBytes += (long long)owner->size * owner->pendingShares;
+		owner->pendingShares = 0;
+
+		if(m_hashContent && !owner->array)
+		{
+			ShareContent(owner);
+		}
+
+		// A streamed texture is created with only its lowest mips.
+		if(owner->content == owner && m_Residency)
+		{
+			if(!AddResidency(owner))
+			{
+				return false;
+			}
+		}
+	}
+
+	// Never waits, a texture still loading just keeps its placeholder for another frame, as does one that could not be loaded.
+	owner->texture->Update(m_device);
+	if(owner->texture->TakeFailure())
+	{
+		LoadLogClass::Write("texture registry %ls: could not be loaded, drawing its placeholder instead", owner->name.c_str());
+	}
+
+	return true;
+}
+
+
+void TextureRegistryClass::Release(TextureType* handle)
+{
+	TextureType* content;
+
+
+	if(!handle)
+	{
+		return;
+	}
+
+	handle->referenceCount--;
+	if(handle->referenceCount > 0)
+	{
+		return;
+	}
+
+	// Release the texture now that nothing draws with it, then the reference it held on the texture it shared by content.
+	content = handle->content;
+	m_textures.erase(handle->name);
+	ReleaseTexture(handle);
+
+	if(content != handle)
+	{
+		Release(content);
+	}
+
+	return;
+}
+
+
+void TextureRegistryClass::Request(TextureType* handle, float pixels)
+{
+	// Requests go to the texture actually drawn, which may be one shared by content.
+	if(handle->content->residency >= 0)
+	{
+		m_Residency->Request(handle->content->residency, pixels);
+	}
+
+	return;
+}
+
+
+bool TextureRegistryClass::UpdateResidency()
+{
+	TextureType* handle;
+	bool result;
+	int i;
+
+
+	if(!m_Residency)
+	{
+		return true;
+	}
+
+	// Decide the mips every texture keeps from this frame's requests, then create the textures that changed again to match.
+	m_Residency->Update(m_residencyChanges);
+
+	for(i=0; i<(int)m_residencyChanges.size(); i++)
+	{
+		handle = m_residentTextures[m_residencyChanges[i].texture];
+
+		result = handle->texture->SetTopMip(m_device, m_residencyChanges[i].topMip);
+		if(!result)
+		{
+			LoadLogClass::Write("texture registry %ls: could not be created from mip %d", handle->name.c_str(), m_residencyChanges[i].topMip);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+bool TextureRegistryClass::IsResident(TextureType* handle)
+{
+	return handle->content->texture->IsResident();
+}
+
+
+ID3D11ShaderResourceView* TextureRegistryClass::GetTexture(TextureType* handle)
+{
+	return handle->content->texture->GetTexture();
+}
+
+
+int TextureRegistryClass::GetSlice(TextureType* handle)
+{
+	// The placeholder is a single slice, the slice only counts once the array itself is there.
+	if(!handle->content->texture->IsResident())
+	{
+		return 0;
+	}
+
+	return handle->slice;
+}
+
+
+void TextureRegistryClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_statistics;
+
+	return;
+}
+
+
+bool TextureRegistryClass::GetResidencyStatistics(TextureResidencyClass::StatisticsType& statistics)
+{
+	if(!m_Residency)
+	{
+		return false;
+	}
+
+	m_Residency->GetStatistics(statistics);
+
+	return true;
+}
+
+
+TextureRegistryClass::TextureType* TextureRegistryClass::Load(JobSystemClass* jobSystem, const wstring& name, WCHAR* filename)
+{
+	TextureType* handle;
+	TextureClass* texture;
+	AssetArchiveClass* assetArchive;
+	bool hashContent;
+
+
+	// Create the texture object and the handle for it.
+	texture = new TextureClass;
+	if(!texture)
+	{
+		return 0;
+	}
+
+	handle = new TextureType;
+	if(!handle)
+	{
+		delete texture;
+		return 0;
+	}
+
+	handle->texture = texture;
+	handle->content = handle;
+	handle->size = 0;
+	handle->pendingShares = 0;
+	handle->referenceCount = 1;
+	handle->residency = -1;
+	handle->slice = 0;
+	handle->array = false;
+	handle->name = name;
+
+	m_textures[name] = handle;
+	m_statistics.loadCount++;
+
+	// Without a file name the texture is the archive entry the handle is named after, the handle outlives the job.
+	if(!filename)
+	{
+		filename = &handle->name[0];
+	}
+
+	// Read the file in on a loader thread, or find it in the asset archive if there is one.
+	assetArchive = m_AssetArchive;
+	hashContent = m_hashContent;
+	jobSystem->Submit(filesystem::path(filename).filename().string(), [texture, filename, assetArchive, hashContent]()
+	{
+		texture->Load(filename, assetArchive, hashContent);
+	});
+
+	return handle;
+}
+
+
+const AssetArchiveClass::SliceType* TextureRegistryClass::FindSlice(WCHAR* filename, size_t& arraySize)
+{
+	const AssetArchiveClass::EntryType* entry;
+	const AssetArchiveClass::EntryType* arrayEntry;
+	const AssetArchiveClass::SliceType* slice;
+
+
+	if(!m_AssetArchive)
+	{
+		return 0;
+	}
+
+	entry = m_AssetArchive->Find(filesystem::path(filename).filename().string().c_str(), ASSET_TYPE_TEXTURE_SLICE);
+	if(!entry || entry->size < sizeof(AssetArchiveClass::SliceType))
+	{
+		return 0;
+	}
+
+	// The array has to be in the archive too, anything else is loaded on its own as before.
+	slice = (const AssetArchiveClass::SliceType*)m_AssetArchive->GetData(entry);
+	if(memchr(slice->array, 0, ASSET_ARCHIVE_NAME_LENGTH) == NULL || slice->slice >= slice->sliceCount)
+	{
+		return 0;
+	}
+
+	arrayEntry = m_AssetArchive->Find(slice->array, ASSET_TYPE_TEXTURE);
+	if(!arrayEntry)
+	{
+		return 0;
+	}
+
+	arraySize = (size_t)arrayEntry->size;
+
+	return slice;
+}
+
+
+void TextureRegistryClass::ShareContent(TextureType* handle)
+{
+	multimap<unsigned long long, TextureType*>::iterator found;
+	pair<multimap<unsigned long long, TextureType*>::iterator, multimap<unsigned long long, TextureType*>::iterator> range;
+	unsigned long long hash;
+
+
+	hash = handle->texture->GetContentHash();
+
+	// A texture loaded earlier with the same hash and size holds the same data.
+	range = m_contents.equal_range(hash);
+	for(found=range.first; found!=range.second; found++)
+	{
+		if(found->second->size == handle->size)
+		{
+			break;
+		}
+	}
+
+	// Nothing to share, so other textures can share this one from now on.
+	if(found == range.second)
+	{
+		m_contents.insert(make_pair(hash, handle));
+		return;
+	}
+
+	// Draw with the earlier texture and drop the copy before it reaches the device.  The placeholder goes with it, the earlier
+	// texture has its own.
+	handle->content = found->second;
+	handle->content->referenceCount++;
+
+	handle->texture->Shutdown();
+	delete handle->texture;
+	handle->texture = 0;
+
+	m_statistics.contentSharedCount++;
+	m_statistics.sharedBytes += (long long)handle->size;
+
+	LoadLogClass::Write("texture registry %ls: same content as %ls, shared", handle->name.c_str(), handle->content->name.c_str());
+
+	return;
+}
+
+
+bool TextureRegistryClass::AddResidency(TextureType* handle)
+{
+	TextureClass* texture;
+
+
+	texture = handle->texture;
+
+	// Keep the handle by its residency number, that is how the changes refer to it.
+	handle->residency = m_Residency->Add(texture->GetWidth(), texture->GetHeight(), texture->GetMipCount(), (long long)handle->size);
+	if(handle->residency >= (int)m_residentTextures.size())
+	{
+		m_residentTextures.resize(handle->residency + 1, 0);
+	}
+	m_residentTextures[handle->residency] = handle;
+
+	// The texture is not created yet, this only sets the mips it is created with.
+	return texture->SetTopMip(m_device, m_Residency->GetTopMip(handle->residency));
+}
+
+
+void TextureRegistryClass::ReleaseTexture(TextureType* handle)
+{
+	multimap<unsigned long long, TextureType*>::iterator found;
+	pair<multimap<unsigned long long, TextureType*>::iterator, multimap<unsigned long long, TextureType*>::iterator> range;
+
+
+	// Nothing can share the content of a released texture, and its memory no longer counts against the budget.
+	if(handle->residency >= 0 && m_Residency)
+	{
+		m_Residency->Remove(handle->residency);
+		m_residentTextures[handle->residency] = 0;
+		handle->residency = -1;
+	}
+
+	if(handle->texture)
+	{
+		range = m_contents.equal_range(handle->texture->GetContentHash());
+		for(found=range.first; found!=range.second; found++)
+		{
+			if(found->second == handle)
+			{
+				m_contents.erase(found);
+				break;
+			}
+		}
+
+		handle->texture->Shutdown();
+		delete handle->texture;
+		handle->texture = 0;
+	}
+
+	delete handle;
+
+	return;
+}
+
+
+wstring TextureRegistryClass::GetCanonicalName(const WCHAR* filename)
+{
+	filesystem::path path;
+	error_code error;
+	wstring name;
+	size_t i;
+
+
+	// Resolve the dots and links in the path, falling back to a plain absolute path if that fails.
+	path = filesystem::weakly_canonical(filesystem::path(filename), error);
+	if(error)
+	{
+		path = filesystem::absolute(filesystem::path(filename), error).lexically_normal();
+	}
+
+	name = path.generic_wstring();
+
+#ifdef _WIN32
+	// Windows paths are not case sensitive.
+	for(i=0; i<name.size(); i++)
+	{
+		name[i] = (wchar_t)towlower(name[i]);
+	}
+#endif
+
+	return name;
+}
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureregistryclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEXTUREREGISTRYCLASS_H_
+#define _TEXTUREREGISTRYCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <d3d11_1.h>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "textureclass.h"
+#include "jobsystemclass.h"
+#include "assetarchiveclass.h"
+#include "textureresidencyclass.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TextureRegistryClass
+//
+// Hands out shared textures.  A file asked for again through any relative path
+// gets another reference to the texture already loaded or loading for it, and
+// the texture is released with the last reference.
+//
+// With content hashing on, each loader job also hashes the file it read, the
+// asset archive already holds that hash for its entries.  When Update finds a
+// texture that has finished loading with the same data as one loaded before,
+// under another name, the handle is pointed at the earlier texture and the
+// duplicate never reaches the device.
+//
+// With a memory budget the textures are streamed.  Each is created with only
+// its lowest mips, models report the size they cover on screen with Request
+// and UpdateResidency, once a frame, has TextureResidencyClass decide the mips
+// to keep and creates the textures again to match.
+//
+// A texture the asset cooker packed into a texture array is drawn from the
+// array, which is loaded and streamed once for every texture in it.  Its
+// handle shares the array like a texture shared by content and GetSlice gives
+// the slice to sample.
+//
+// Acquire, Update and Release are called on the thread that owns the device,
+// the loader jobs only touch their own TextureClass.
+////////////////////////////////////////////////////////////////////////////////
+class TextureRegistryClass
+{
+public:
+	// A shared texture handle, the texture belongs to the registry and stays valid until the handle is released.
+	struct TextureType
+	{
+		TextureClass* texture;
+		TextureType* content;
+		size_t size;
+		int pendingShares;
+		int referenceCount;
+		int residency;
+		int slice;
+		bool array;
+		wstring name;
+	};
+
+	struct StatisticsType
+	{
+		int loadCount;
+		int sharedCount;
+		int contentSharedCount;
+		int packedCount;
+		long long sharedBytes;
+	};
+
+public:
+	TextureRegistryClass();
+	TextureRegistryClass(const TextureRegistryClass&);
+	~TextureRegistryClass();
+
+	bool Initialize(ID3D11Device*, AssetArchiveClass*, bool, long long, int);
+	void Shutdown();
+
+	TextureType* Acquire(JobSystemClass*, WCHAR*);
+	bool CreatePlaceholder(TextureType*, unsigned int);
+	bool Update(TextureType*);
+	void Release(TextureType*);
+	void Request(TextureType*, float);
+	bool UpdateResidency();
+
+	bool IsResident(TextureType*);
+	ID3D11ShaderResourceView* GetTexture(TextureType*);
+	int GetSlice(TextureType*);
+	void GetStatistics(StatisticsType&);
+	bool GetResidencyStatistics(TextureResidencyClass::StatisticsType&);
+
+private:
+	TextureType* Load(JobSystemClass*, const wstring&, WCHAR*);
+	const AssetArchiveClass::SliceType* FindSlice(WCHAR*, size_t&);
+	void ShareContent(TextureType*);
+	bool AddResidency(TextureType*);
+	void ReleaseTexture(TextureType*);
+
+	static wstring GetCanonicalName(const WCHAR*);
+
+private:
+	ID3D11Device* m_device;
+	AssetArchiveClass* m_AssetArchive;
+	bool m_hashContent;
+	map<wstring, TextureType*> m_textures;
+	multimap<unsigned long long, TextureType*> m_contents;
+	StatisticsType m_statistics;
+	TextureResidencyClass* m_Residency;
+	vector<TextureType*> m_residentTextures;
+	vector<TextureResidencyClass::ChangeType> m_residencyChanges;
+};
+
+#endif
@@ -0,0 +1,415 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureresidencyclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "textureresidencyclass.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+TextureResidencyClass::TextureResidencyClass()
+{
+	m_budget = 0;
+	m_residentMips = 0;
+	m_frame = 0;
+	m_statistics.textureCount = 0;
+	m_statistics.residentBytes = 0;
+	m_statistics.budget = 0;
+	m_statistics.streamedBytes = 0;
+	m_statistics.streamedMips = 0;
+	m_statistics.evictedMips = 0;
+}
+
+
+TextureResidencyClass::TextureResidencyClass(const TextureResidencyClass& other)
+{
+}
+
+
+TextureResidencyClass::~TextureResidencyClass()
+{
+}
+
+
+bool TextureResidencyClass::Initialize(long long budget, int residentMips)
+{
+	// The budget covers every resident mip of every texture, the lowest mips included.
+	if(budget <= 0 || residentMips < 1)
+	{
+		return false;
+	}
+
+	m_budget = budget;
+	m_residentMips = residentMips;
+	m_statistics.budget = budget;
+
+	return true;
+}
+
+
+void TextureResidencyClass::Shutdown()
+{
+	m_textures.clear();
+	m_freeTextures.clear();
+	m_order.clear();
+	m_statistics.textureCount = 0;
+	m_statistics.residentBytes = 0;
+
+	return;
+}
+
+
+int TextureResidencyClass::Add(int width, int height, int mipCount, long long size)
+{
+	TextureType texture;
+	long long texels[TEXTURE_RESIDENCY_MAX_MIPS];
+	long long totalTexels;
+	int index, i;
+
+
+	if(mipCount < 1)
+	{
+		mipCount = 1;
+	}
+	if(mipCount > TEXTURE_RESIDENCY_MAX_MIPS)
+	{
+		mipCount = TEXTURE_RESIDENCY_MAX_MIPS;
+	}
+
+	texture.used = true;
+	texture.width = width;
+	texture.height = height;
+	texture.mipCount = mipCount;
+
+	// Share the size of the whole chain out over the levels by their texel counts.
+	totalTexels = 0;
+	for(i=0; i<mipCount; i++)
+	{
+		texels[i] = (long long)max(width >> i, 1) * max(height >> i, 1);
+		totalTexels += texels[i];
+	}
+
+	// Keep the size of the chain from each level down, that is what has to be resident for it to be the top mip.
+	texture.chainSizes[mipCount] = 0;
+	for(i=mipCount-1; i>=0; i--)
+	{
+		texture.chainSizes[i] = texture.chainSizes[i + 1] + size * texels[i] / totalTexels;
+	}
+
+	// Start out with only the lowest mips, the rest come in once something on screen needs them.
+	texture.lowestTopMip = max(mipCount - m_residentMips, 0);
+	texture.topMip = texture.lowestTopMip;
+	texture.targetMip = texture.topMip;
+	texture.floorMip = texture.lowestTopMip;
+	texture.demand = 0.0f;
+	texture.lastFrame = m_frame;
+
+	// Reuse the slot of a removed texture so the numbers handed out stay small.
+	if(!m_freeTextures.empty())
+	{
+		index = m_freeTextures.back();
+		m_freeTextures.pop_back();
+		m_textures[index] = texture;
+	}
+	else
+	{
+		index = (int)m_textures.size();
+		m_textures.push_back(texture);
+	}
+
+	m_statistics.textureCount++;
+	m_statistics.residentBytes += texture.chainSizes[texture.topMip];
+
+	return index;
+}
+
+
+void TextureResidencyClass::Remove(int index)
+{
+	TextureType& texture = m_textures[index];
+
+
+	m_statistics.textureCount--;
+	m_statistics.residentBytes -= texture.chainSizes[texture.topMip];
+
+	texture.used = false;
+	m_freeTextures.push_back(index);
+
+	return;
+}
+
+
+void TextureResidencyClass::Request(int index, float pixels)
+{
+	// A texture drawn more than once in a frame gets what the largest of its draws needs.
+	if(pixels > m_textures[index].demand)
+	{
+		m_textures[index].demand = pixels;
+	}
+
+	return;
+}
+
+
+void TextureResidencyClass::Update(vector<ChangeType>& changes)
+{
+	ChangeType change;
+	long long total, upload;
+	int i;
+
+
+	changes.clear();
+	m_frame++;
+
+	// Work out the mips each texture should have.  One drawn this frame gets what it asked for and keeps any extra mips it has
+	// until the budget needs them, one that was not keeps what it has and can lose all but its lowest mips.
+	m_order.clear();
+	for(i=0; i<(int)m_textures.size(); i++)
+	{
+		TextureType& texture = m_textures[i];
+		if(!texture.used)
+		{
+			continue;
+		}
+
+		if(texture.demand > 0.0f)
+		{
+			texture.lastFrame = m_frame;
+			texture.floorMip = GetWantedMip(texture);
+			texture.targetMip = min(texture.floorMip, texture.topMip);
+		}
+		else
+		{
+			texture.floorMip = texture.lowestTopMip;
+			texture.targetMip = texture.topMip;
+		}
+
+		if(texture.targetMip < texture.topMip)
+		{
+			m_order.push_back(i);
+		}
+	}
+
+	// Making a texture resident uploads its whole chain, so only the textures furthest from what they asked for stream in this
+	// frame, the ones covering the most of the screen first among those, and the rest wait for the next one.  They are left out
+	// before the budget is fitted, so nothing is evicted to make room for an upload that does not happen.
+	sort(m_order.begin(), m_order.end(), [this](int a, int b)
+	{
+		const TextureType& textureA = m_textures[a];
+		const TextureType& textureB = m_textures[b];
+
+		if(textureA.topMip - textureA.targetMip != textureB.topMip - textureB.targetMip)
+		{
+			return textureA.topMip - textureA.targetMip > textureB.topMip - textureB.targetMip;
+		}
+
+		return textureA.demand > textureB.demand;
+	});
+
+	upload = 0;
+	for(i=0; i<(int)m_order.size(); i++)
+	{
+		TextureType& texture = m_textures[m_order[i]];
+
+		if(upload > 0 && upload + texture.chainSizes[texture.targetMip] > TEXTURE_RESIDENCY_UPLOAD_LIMIT)
+		{
+			texture.targetMip = texture.topMip;
+			continue;
+		}
+		upload += texture.chainSizes[texture.targetMip];
+	}
+
+	// Take mips away until it all fits.
+	total = 0;
+	for(i=0; i<(int)m_textures.size(); i++)
+	{
+		if(m_textures[i].used)
+		{
+			total += m_textures[i].chainSizes[m_textures[i].targetMip];
+		}
+	}
+
+	FitBudget(total);
+
+	// Hand out a change for every texture whose mips moved.
+	for(i=0; i<(int)m_textures.size(); i++)
+	{
+		TextureType& texture = m_textures[i];
+		if(!texture.used || texture.targetMip == texture.topMip)
+		{
+			continue;
+		}
+
+		if(texture.targetMip > texture.topMip)
+		{
+			m_statistics.evictedMips += texture.targetMip - texture.topMip;
+		}
+		else
+		{
+			m_statistics.streamedMips += texture.topMip - texture.targetMip;
+			m_statistics.streamedBytes += texture.chainSizes[texture.targetMip];
+		}
+
+		change.texture = i;
+		change.topMip = texture.targetMip;
+		changes.push_back(change);
+
+		texture.topMip = texture.targetMip;
+	}
+
+	// Count what is resident now and start the next frame's requests from nothing.
+	m_statistics.residentBytes = 0;
+	for(i=0; i<(int)m_textures.size(); i++)
+	{
+		if(m_textures[i].used)
+		{
+			m_statistics.residentBytes += m_textures[i].chainSizes[m_textures[i].topMip];
+			m_textures[i].demand = 0.0f;
+		}
+	}
+
+	return;
+}
+
+
+int TextureResidencyClass::GetTopMip(int index)
+{
+	return m_textures[index].topMip;
+}
+
+
+void TextureResidencyClass::GetStatistics(StatisticsType& statistics)
+{
+	statistics = m_statistics;
+
+	return;
+}
+
+
+float TextureResidencyClass::GetScreenSize(float depth, float distance, float radius, float spread, float pixelScale)
+{
+	// Nothing behind the camera needs its textures, they can give up their mips to what is in front.
+	if(depth < -radius - spread)
+	{
+		return 0.0f;
+	}
+
+	// Ask for the diameter of the bounding sphere on screen, or everything with the camera inside it.  A group of instances asks
+	// for what its closest one could cover.
+	distance -= spread;
+	if(distance <= radius)
+	{
+		return FLT_MAX;
+	}
+
+	return 2.0f * radius * pixelScale / distance;
+}
+
+
+int TextureResidencyClass::GetWantedMip(const TextureType& texture)
+{
+	float texels;
+	int size, mip;
+
+
+	// Go down the chain while the next level still has the texels the request needs across the larger side.
+	texels = texture.demand * TEXTURE_RESIDENCY_TEXELS_PER_PIXEL;
+	size = max(texture.width, texture.height);
+
+	mip = 0;
+	while(mip < texture.lowestTopMip && (float)(size >> (mip + 1)) >= texels)
+	{
+		mip++;
+	}
+
+	return mip;
+}
+
+
+void TextureResidencyClass::FitBudget(long long total)
+{
+	int i;
+
+
+	if(total <= m_budget)
+	{
+		return;
+	}
+
+	// Drop the mips nothing asked for this frame, from the textures drawn longest ago first and the larger top mips first among those.
+	m_order.clear();
+	for(i=0; i<(int)m_textures.size(); i++)
+	{
+		if(m_textures[i].used && m_textures[i].targetMip < m_textures[i].floorMip)
+		{
+			m_order.push_back(i);
+		}
+	}
+
+	sort(m_order.begin(), m_order.end(), [this](int a, int b)
+	{
+		const TextureType& textureA = m_textures[a];
+		const TextureType& textureB = m_textures[b];
+
+		if(textureA.lastFrame != textureB.lastFrame)
+		{
+			return textureA.lastFrame < textureB.lastFrame;
+		}
+
+		return textureA.chainSizes[textureA.targetMip] > textureB.chainSizes[textureB.targetMip];
+	});
+
+	for(i=0; i<(int)m_order.size() && total > m_budget; i++)
+	{
+		TextureType& texture = m_textures[m_order[i]];
+
+		while(texture.targetMip < texture.floorMip && total > m_budget)
+		{
+			total -= texture.chainSizes[texture.targetMip] - texture.chainSizes[texture.targetMip + 1];
+			texture.targetMip++;
+		}
+	}
+
+	// Still over, so the textures in view give up some of what they asked for, a mip at a time from whichever has the largest top mip.
+	// They are kept in a heap on the size of that mip so each one taken costs a log of the texture count rather than a pass over them.
+	m_order.clear();
+	for(i=0; i<(int)m_textures.size(); i++)
+	{
+		if(m_textures[i].used && m_textures[i].targetMip < m_textures[i].lowestTopMip)
+		{
+			m_order.push_back(i);
+		}
+	}
+
+	auto smallerTopMip = [this](int a, int b)
+	{
+		const TextureType& textureA = m_textures[a];
+		const TextureType& textureB = m_textures[b];
+
+		return textureA.chainSizes[textureA.targetMip] - textureA.chainSizes[textureA.targetMip + 1] <
+			   textureB.chainSizes[textureB.targetMip] - textureB.chainSizes[textureB.targetMip + 1];
+	};
+
+	make_heap(m_order.begin(), m_order.end(), smallerTopMip);
+
+	// Only the lowest mips are left once the heap is empty, those stay whatever the budget.
+	while(total > m_budget && !m_order.empty())
+	{
+		pop_heap(m_order.begin(), m_order.end(), smallerTopMip);
+		TextureType& texture = m_textures[m_order.back()];
+
+		total -= texture.chainSizes[texture.targetMip] - texture.chainSizes[texture.targetMip + 1];
+		texture.targetMip++;
+
+		if(texture.targetMip < texture.lowestTopMip)
+		{
+			push_heap(m_order.begin(), m_order.end(), smallerTopMip);
+		}
+		else
+		{
+			m_order.pop_back();
+		}
+	}
+
+	return;
+}
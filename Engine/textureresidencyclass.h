@@ -0,0 +1,111 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureresidencyclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEXTURERESIDENCYCLASS_H_
+#define _TEXTURERESIDENCYCLASS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <vector>
+using namespace std;
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int TEXTURE_RESIDENCY_MAX_MIPS = 16;
+
+// Texels wanted across each pixel an object covers on screen, more than one since a texture wraps around the object.
+const float TEXTURE_RESIDENCY_TEXELS_PER_PIXEL = 2.0f;
+
+// Bytes of texture streamed in per frame at most, a texture that would go over it waits for the next frame.
+const long long TEXTURE_RESIDENCY_UPLOAD_LIMIT = 8 * 1024 * 1024;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: TextureResidencyClass
+//
+// Decides how many mips of each texture are resident, without touching a
+// device so it can be driven by anything that applies its changes.  The
+// lowest mips of every texture are always resident, the ones above them are
+// streamed in when the screen size an object asks for needs them.
+//
+// Update runs once a frame.  A texture drawn that frame gets the mips its
+// largest request needs, a texture that was not keeps what it has.  If that
+// is over the budget the least recently drawn textures lose their top mips
+// first, then the extra mips of the ones in view, and last, if it is still
+// over, the largest of what the textures in view asked for.
+//
+// Mip sizes are estimated from the texel count of each level and the size of
+// the whole chain, the small block compressed levels are a little larger.
+//
+// GetScreenSize turns the bounds of a draw in view space into the size it
+// asks for, it is what the models pass to Request when they pick a level.
+////////////////////////////////////////////////////////////////////////////////
+class TextureResidencyClass
+{
+public:
+	// A new most detailed mip for a texture, for the caller to make resident.
+	struct ChangeType
+	{
+		int texture;
+		int topMip;
+	};
+
+	struct StatisticsType
+	{
+		int textureCount;
+		long long residentBytes;
+		long long budget;
+		long long streamedBytes;
+		int streamedMips;
+		int evictedMips;
+	};
+
+private:
+	struct TextureType
+	{
+		bool used;
+		int width, height, mipCount;
+		long long chainSizes[TEXTURE_RESIDENCY_MAX_MIPS + 1];
+		int topMip, lowestTopMip;
+		int targetMip, floorMip;
+		float demand;
+		unsigned int lastFrame;
+	};
+
+public:
+	TextureResidencyClass();
+	TextureResidencyClass(const TextureResidencyClass&);
+	~TextureResidencyClass();
+
+	bool Initialize(long long, int);
+	void Shutdown();
+
+	int Add(int, int, int, long long);
+	void Remove(int);
+	void Request(int, float);
+	void Update(vector<ChangeType>&);
+
+	int GetTopMip(int);
+	void GetStatistics(StatisticsType&);
+
+	static float GetScreenSize(float, float, float, float, float);
+
+private:
+	int GetWantedMip(const TextureType&);
+	void FitBudget(long long);
+
+private:
+	long long m_budget;
+	int m_residentMips;
+	unsigned int m_frame;
+	vector<TextureType> m_textures;
+	vector<int> m_freeTextures;
+	vector<int> m_order;
+	StatisticsType m_statistics;
+};
+
+#endif
@@ -3,13 +3,17 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "textureshaderclass.h"
 
+#include <cstring>
+
 
 TextureShaderClass::TextureShaderClass()
 {
+	m_StateCache = 0;
 	m_vertexShader = 0;
 	m_pixelShader = 0;
 	m_layout = 0;
-	m_matrixBuffer = 0;
+	m_materialBuffer = 0;
+	m_materialWritten = false;
 	m_sampleState = 0;
 }
 
@@ -24,11 +28,14 @@ TextureShaderClass::~TextureShaderClass()
 }
 
 
-bool TextureShaderClass::Initialize(ID3D11Device* device, HWND hwnd)
+bool TextureShaderClass::Initialize(ID3D11Device* device, HWND hwnd, StateCacheClass* stateCache)
 {
 	bool result;
 
 
+	// Everything the shader binds goes through the state cache, so what is bound already is not set again.
+	m_StateCache = stateCache;
+
 	// Initialize the vertex and pixel shaders.
 	//result = InitializeShader(device, hwnd, L"../Engine/EM-step1.vs", L"../Engine/EM-step1.ps");
 	result = InitializeShader(device, hwnd, L"../Engine/texture.vs", L"../Engine/texture.ps");
@@ -50,21 +57,20 @@ void TextureShaderClass::Shutdown()
 }
 
 
-bool TextureShaderClass::Render(ID3D11DeviceContext* deviceContext, int indexCount, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix,
-	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture)
+bool TextureShaderClass::Render(ID3D11DeviceContext* deviceContext, const DrawListType& drawList, ID3D11ShaderResourceView* texture, int textureSlice)
 {
 	bool result;
 
 
 	// Set the shader parameters that it will use for rendering.
-	result = SetShaderParameters(deviceContext, worldMatrix, viewMatrix, projectionMatrix, texture);
+	result = SetShaderParameters(deviceContext, texture, textureSlice);
 	if(!result)
 	{
 		return false;
 	}
 
 	// Now render the prepared buffers with the shader.
-	RenderShader(deviceContext, indexCount);
+	RenderShader(deviceContext, drawList);
 
 	return true;
 }
@@ -77,8 +83,9 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	ID3D10Blob* vertexShaderBuffer;
 	ID3D10Blob* pixelShaderBuffer;
 	D3D11_INPUT_ELEMENT_DESC polygonLayout[2];
+	D3D_SHADER_MACRO defines[2];
 	unsigned int numElements;
-	D3D11_BUFFER_DESC matrixBufferDesc;
+	D3D11_BUFFER_DESC materialBufferDesc;
     D3D11_SAMPLER_DESC samplerDesc;
 
 
@@ -87,9 +94,15 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	vertexShaderBuffer = 0;
 	pixelShaderBuffer = 0;
 
+	// Build the vertex shader for the packed vertex formats when vertex compression is on.
+	defines[0].Name = "COMPRESSED_VERTICES";
+	defines[0].Definition = "1";
+	defines[1].Name = NULL;
+	defines[1].Definition = NULL;
+
     // Compile the vertex shader code. // EM-step1-VS
-	result = D3DCompileFromFile(vsFilename, NULL, NULL, "TextureVertexShader", "vs_5_0",
-		D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
+	result = D3DCompileFromFile(vsFilename, VERTEX_COMPRESSION_ENABLED ? defines : NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		"TextureVertexShader", "vs_5_0", D3D10_SHADER_ENABLE_STRICTNESS, 0, &vertexShaderBuffer, &errorMessage);
 
 	if(FAILED(result))
 	{
@@ -141,10 +154,10 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	}
 
 	// Create the vertex input layout description.
-	// This setup needs to match the VertexType stucture in the ModelClass and in the shader.
+	// This setup needs to match the vertex layout in vertexlayouts.h and in the shader.
 	polygonLayout[0].SemanticName = "POSITION";
 	polygonLayout[0].SemanticIndex = 0;
-	polygonLayout[0].Format = DXGI_FORMAT_R32G32B32_FLOAT;
+	polygonLayout[0].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16B16A16_UNORM : DXGI_FORMAT_R32G32B32_FLOAT;
 	polygonLayout[0].InputSlot = 0;
 	polygonLayout[0].AlignedByteOffset = 0;
 	polygonLayout[0].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -152,7 +165,7 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 
 	polygonLayout[1].SemanticName = "TEXCOORD";
 	polygonLayout[1].SemanticIndex = 0;
-	polygonLayout[1].Format = DXGI_FORMAT_R32G32_FLOAT;
+	polygonLayout[1].Format = VERTEX_COMPRESSION_ENABLED ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
 	polygonLayout[1].InputSlot = 0;
 	polygonLayout[1].AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
 	polygonLayout[1].InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
@@ -176,16 +189,16 @@ bool TextureShaderClass::InitializeShader(ID3D11Device* device, HWND hwnd, WCHAR
 	pixelShaderBuffer->Release();
 	pixelShaderBuffer = 0;
 
-	// Setup the description of the dynamic matrix constant buffer that is in the vertex shader.
-    matrixBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	matrixBufferDesc.ByteWidth = sizeof(MatrixBufferType);
-    matrixBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-    matrixBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    matrixBufferDesc.MiscFlags = 0;
-	matrixBufferDesc.StructureByteStride = 0;
+	// Setup the description of the dynamic material constant buffer that is in the pixel shader.
+	materialBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	materialBufferDesc.ByteWidth = sizeof(MaterialBufferType);
+	materialBufferDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	materialBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	materialBufferDesc.MiscFlags = 0;
+	materialBufferDesc.StructureByteStride = 0;
 
-	// Create the constant buffer pointer so we can access the vertex shader constant buffer from within this class.
-	result = device->CreateBuffer(&matrixBufferDesc, NULL, &m_matrixBuffer);
+	// Create the constant buffer pointer so we can access the pixel shader constant buffer from within this class.
+	result = device->CreateBuffer(&materialBufferDesc, NULL, &m_materialBuffer);
 	if(FAILED(result))
 	{
 		return false;
@@ -226,12 +239,13 @@ void TextureShaderClass::ShutdownShader()
 		m_sampleState = 0;
 	}
 
-	// Release the matrix constant buffer.
-	if(m_matrixBuffer)
+	// Release the material constant buffer.
+	if(m_materialBuffer)
 	{
-		m_matrixBuffer->Release();
-		m_matrixBuffer = 0;
+		m_materialBuffer->Release();
+		m_materialBuffer = 0;
 	}
+	m_materialWritten = false;
 
 	// Release the layout.
 	if(m_layout)
@@ -294,61 +308,73 @@ void TextureShaderClass::OutputShaderErrorMessage(ID3D10Blob* errorMessage, HWND
 }
 
 
-bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, const XMMATRIX &worldMatrix, const XMMATRIX &viewMatrix,
-	const XMMATRIX &projectionMatrix, ID3D11ShaderResourceView* texture)
+bool TextureShaderClass::SetShaderParameters(ID3D11DeviceContext* deviceContext, ID3D11ShaderResourceView* texture, int textureSlice)
 {
 	HRESULT result;
     D3D11_MAPPED_SUBRESOURCE mappedResource;
-	MatrixBufferType* dataPtr;
-	unsigned int bufferNumber;
+	MaterialBufferType material;
 
 
-	// Transpose the matrices to prepare them for the shader.
+	// The matrices are in the frame and object buffers, only the slice of the texture array to sample is left for this one.
+	material.textureSlice = (float)textureSlice;
+	material.padding = XMFLOAT3(0.0f, 0.0f, 0.0f);
 
-	// Lock the constant buffer so it can be written to.
-	result = deviceContext->Map(m_matrixBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
-	if(FAILED(result))
+	// Only upload the material when it differs from the last one written, draws of the same texture keep what is there.
+	if(!m_materialWritten || memcmp(&material, &m_material, sizeof(material)) != 0)
 	{
-		return false;
-	}
+		// Lock the material constant buffer so it can be written to.
+		result = deviceContext->Map(m_materialBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource);
+		if(FAILED(result))
+		{
+			return false;
+		}
 
-	// Get a pointer to the data in the constant buffer.
-	dataPtr = (MatrixBufferType*)mappedResource.pData;
+		// Copy the material into the constant buffer.
+		memcpy(mappedResource.pData, &material, sizeof(material));
 
-	// Copy the matrices into the constant buffer.
-	dataPtr->world = XMMatrixTranspose(worldMatrix);
-	dataPtr->view = XMMatrixTranspose(viewMatrix);
-	dataPtr->projection = XMMatrixTranspose(projectionMatrix);
-	// Unlock the constant buffer.
-    deviceContext->Unmap(m_matrixBuffer, 0);
+		// Unlock the constant buffer.
+		deviceContext->Unmap(m_materialBuffer, 0);
 
-	// Set the position of the constant buffer in the vertex shader.
-	bufferNumber = 0;
+		m_material = material;
+		m_materialWritten = true;
+	}
 
-	// Now set the constant buffer in the vertex shader with the updated values.
-    deviceContext->VSSetConstantBuffers(bufferNumber, 1, &m_matrixBuffer);
+	// Set the material constant buffer in the pixel shader.
+	m_StateCache->SetPixelConstantBuffers(MATERIAL_BUFFER_SLOT, 1, &m_materialBuffer);
 
 	// Set shader texture resource in the pixel shader.
-	deviceContext->PSSetShaderResources(0, 1, &texture);
+	m_StateCache->SetPixelShaderResources(0, 1, &texture);
 
 	return true;
 }
 
 
-void TextureShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, int indexCount)
+void TextureShaderClass::SetShader(ID3D11DeviceContext* deviceContext)
 {
 	// Set the vertex input layout.
-	deviceContext->IASetInputLayout(m_layout);
+	m_StateCache->SetInputLayout(m_layout);
 
     // Set the vertex and pixel shaders that will be used to render this triangle.
-    deviceContext->VSSetShader(m_vertexShader, NULL, 0);
-    deviceContext->PSSetShader(m_pixelShader, NULL, 0);
+    m_StateCache->SetVertexShader(m_vertexShader);
+    m_StateCache->SetPixelShader(m_pixelShader);
 
 	// Set the sampler state in the pixel shader.
-	deviceContext->PSSetSamplers(0, 1, &m_sampleState);
+	m_StateCache->SetPixelSamplers(0, 1, &m_sampleState);
 
-	// Render the triangle.
-	deviceContext->DrawIndexed(indexCount, 0, 0);
+	return;
+}
+
+
+void TextureShaderClass::RenderShader(ID3D11DeviceContext* deviceContext, const DrawListType& drawList)
+{
+	int i;
+
+
+	// Render the triangles, one draw for each range of the model that survived culling.
+	for(i=0; i<drawList.rangeCount; i++)
+	{
+		deviceContext->DrawIndexed(drawList.ranges[i].indexCount, drawList.ranges[i].firstIndex, 0);
+	}
 
 	return;
 }
\ No newline at end of file
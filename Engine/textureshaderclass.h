@@ -17,17 +17,28 @@ using namespace DirectX;
 using namespace std;
 
 
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "vertexcompressionclass.h"
+#include "drawlist.h"
+#include "statecacheclass.h"
+#include "constantbuffers.h"
+
+
 ////////////////////////////////////////////////////////////////////////////////
 // Class name: TextureShaderClass
+//
+// Draws with the frame and object buffers ShaderManagerClass has bound, the
+// texture slice is all the shader keeps in its own material buffer.
 ////////////////////////////////////////////////////////////////////////////////
 class TextureShaderClass
 {
 private:
-	struct MatrixBufferType
+	struct MaterialBufferType
 	{
-		XMMATRIX world;
-		XMMATRIX view;
-		XMMATRIX projection;
+		float textureSlice;
+		XMFLOAT3 padding;
 	};
 
 public:
@@ -35,24 +46,28 @@ public:
 	TextureShaderClass(const TextureShaderClass&);
 	~TextureShaderClass();
 
-	bool Initialize(ID3D11Device*, HWND);
+	bool Initialize(ID3D11Device*, HWND, StateCacheClass*);
 	void Shutdown();
-	bool Render(ID3D11DeviceContext*, int, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*);
+	bool Render(ID3D11DeviceContext*, const DrawListType&, ID3D11ShaderResourceView*, int);
+	void SetShader(ID3D11DeviceContext*);
 
 private:
 	bool InitializeShader(ID3D11Device*, HWND, WCHAR*, WCHAR*);
 	void ShutdownShader();
 	void OutputShaderErrorMessage(ID3D10Blob*, HWND, WCHAR*);
 
-	bool SetShaderParameters(ID3D11DeviceContext*, const XMMATRIX&, const XMMATRIX&, const XMMATRIX&, ID3D11ShaderResourceView*);
-	void RenderShader(ID3D11DeviceContext*, int);
+	bool SetShaderParameters(ID3D11DeviceContext*, ID3D11ShaderResourceView*, int);
+	void RenderShader(ID3D11DeviceContext*, const DrawListType&);
 
 private:
 	ID3D11VertexShader* m_vertexShader;
 	ID3D11PixelShader* m_pixelShader;
 	ID3D11InputLayout* m_layout;
-	ID3D11Buffer* m_matrixBuffer;
+	ID3D11Buffer* m_materialBuffer;
+	MaterialBufferType m_material;
+	bool m_materialWritten;
 	ID3D11SamplerState* m_sampleState;
+	StateCacheClass* m_StateCache;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexcompression.hlsli
+////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////
+// GLOBALS //
+/////////////
+cbuffer QuantizationBuffer : register(b2)
+{
+	float3 positionScale;
+	float padding0;
+	float3 positionBias;
+	float padding1;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Decode Functions
+////////////////////////////////////////////////////////////////////////////////
+float3 DecodePosition(float4 position)
+{
+	// The position arrives as unorms relative to the bounding box of the mesh.
+	return position.xyz * positionScale + positionBias;
+}
+
+float3 DecodeOctahedral(float2 encoded)
+{
+	float3 vector;
+	float fold;
+
+
+	// Lift the point off the octahedron and unfold the lower hemisphere back from the corners.
+	vector = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	fold = saturate(-vector.z);
+	vector.xy += (vector.xy >= 0.0f) ? -fold : fold;
+
+	return normalize(vector);
+}
+
+float DecodeBinormalSign(float4 position)
+{
+	// The spare fourth position component is 1 for a right handed tangent frame and 0 for a mirrored one.
+	return position.w * 2.0f - 1.0f;
+}
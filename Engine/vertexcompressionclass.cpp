@@ -0,0 +1,360 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexcompressionclass.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "vertexcompressionclass.h"
+#include "loadlogclass.h"
+
+#include <cmath>
+#include <cstring>
+
+
+bool VertexCompressionClass::Compress(const float* vertices, int vertexCount, const FormatType& format, unsigned char* output,
+									  BoundsType& bounds, ErrorType& error)
+{
+	const float* vertex;
+	unsigned short position[4], texture[2];
+	short normal[2], tangent[2];
+	float decoded[3], decodedNormal[3], decodedTangent[3], binormal[3], difference, sign;
+	double startTime;
+	int vertexSize, i, j;
+
+
+	if(format.position < 0 || (format.tangent >= 0 && (format.normal < 0 || format.binormal < 0)))
+	{
+		return false;
+	}
+
+	startTime = LoadLogClass::GetTime();
+
+	vertexSize = GetVertexSize(format);
+
+	// The positions are quantized against the bounding box of the whole mesh.
+	ComputeBounds(vertices, vertexCount, format, bounds);
+
+	memset(&error, 0, sizeof(error));
+
+	for(i=0; i<vertexCount; i++)
+	{
+		vertex = &vertices[i * format.floatsPerVertex];
+
+		EncodePosition(&vertex[format.position], bounds, position);
+		position[3] = 65535;
+
+		// Decode everything again straight away so the error is measured against what the shader will see.
+		DecodePosition(position, bounds, decoded);
+		for(j=0; j<3; j++)
+		{
+			difference = fabsf(decoded[j] - vertex[format.position + j]);
+			if(difference > error.position)
+			{
+				error.position = difference;
+			}
+		}
+
+		if(format.texture >= 0)
+		{
+			for(j=0; j<2; j++)
+			{
+				texture[j] = EncodeHalf(vertex[format.texture + j]);
+
+				difference = fabsf(DecodeHalf(texture[j]) - vertex[format.texture + j]);
+				if(difference > error.texture)
+				{
+					error.texture = difference;
+				}
+			}
+		}
+
+		if(format.normal >= 0)
+		{
+			EncodeOctahedral(&vertex[format.normal], normal);
+			DecodeOctahedral(normal, decodedNormal);
+
+			difference = AngleBetween(decodedNormal, &vertex[format.normal]);
+			if(difference > error.normal)
+			{
+				error.normal = difference;
+			}
+		}
+
+		// The binormal is dropped and rebuilt in the shader as cross(normal, tangent) times the sign kept in position.w.
+		if(format.tangent >= 0)
+		{
+			EncodeOctahedral(&vertex[format.tangent], tangent);
+			DecodeOctahedral(tangent, decodedTangent);
+
+			difference = AngleBetween(decodedTangent, &vertex[format.tangent]);
+			if(difference > error.tangent)
+			{
+				error.tangent = difference;
+			}
+
+			binormal[0] = decodedNormal[1] * decodedTangent[2] - decodedNormal[2] * decodedTangent[1];
+			binormal[1] = decodedNormal[2] * decodedTangent[0] - decodedNormal[0] * decodedTangent[2];
+			binormal[2] = decodedNormal[0] * decodedTangent[1] - decodedNormal[1] * decodedTangent[0];
+
+			sign = (binormal[0] * vertex[format.binormal] + binormal[1] * vertex[format.binormal + 1] +
+					binormal[2] * vertex[format.binormal + 2]) < 0.0f ? -1.0f : 1.0f;
+			if(sign < 0.0f)
+			{
+				position[3] = 0;
+			}
+
+			for(j=0; j<3; j++)
+			{
+				binormal[j] *= sign;
+			}
+
+			difference = AngleBetween(binormal, &vertex[format.binormal]);
+			if(difference > error.binormal)
+			{
+				error.binormal = difference;
+			}
+		}
+
+		// Write the packed attributes out in the order the input layouts expect them.
+		memcpy(output, position, sizeof(position));
+		output += sizeof(position);
+
+		if(format.texture >= 0)
+		{
+			memcpy(output, texture, sizeof(texture));
+			output += sizeof(texture);
+		}
+
+		if(format.normal >= 0)
+		{
+			memcpy(output, normal, sizeof(normal));
+			output += sizeof(normal);
+		}
+
+		if(format.tangent >= 0)
+		{
+			memcpy(output, tangent, sizeof(tangent));
+			output += sizeof(tangent);
+		}
+	}
+
+	LoadLogClass::Write("vertices: compressed %d vertices from %d to %d bytes (%d bytes saved) in %.3f ms", vertexCount,
+						(int)sizeof(float) * format.floatsPerVertex, vertexSize,
+						((int)sizeof(float) * format.floatsPerVertex - vertexSize) * vertexCount, LoadLogClass::GetTime() - startTime);
+	LoadLogClass::Write("vertices: max error position %.6f, texture %.6f, normal %.4f deg, tangent %.4f deg, binormal %.4f deg",
+						error.position, error.texture, error.normal, error.tangent, error.binormal);
+
+	return true;
+}
+
+
+void VertexCompressionClass::ComputeBounds(const float* vertices, int vertexCount, const FormatType& format, BoundsType& bounds)
+{
+	float minimum[3], maximum[3], value;
+	int i, j;
+
+
+	for(j=0; j<3; j++)
+	{
+		minimum[j] = vertexCount > 0 ? vertices[format.position + j] : 0.0f;
+		maximum[j] = minimum[j];
+	}
+
+	for(i=1; i<vertexCount; i++)
+	{
+		for(j=0; j<3; j++)
+		{
+			value = vertices[i * format.floatsPerVertex + format.position + j];
+			minimum[j] = value < minimum[j] ? value : minimum[j];
+			maximum[j] = value > maximum[j] ? value : maximum[j];
+		}
+	}
+
+	// The shader rebuilds a position as unorm * scale + bias.
+	for(j=0; j<3; j++)
+	{
+		bounds.scale[j] = maximum[j] - minimum[j];
+		bounds.bias[j] = minimum[j];
+	}
+	bounds.padding0 = 0.0f;
+	bounds.padding1 = 0.0f;
+
+	return;
+}
+
+
+void VertexCompressionClass::EncodePosition(const float* position, const BoundsType& bounds, unsigned short* output)
+{
+	float value;
+	int i;
+
+
+	for(i=0; i<3; i++)
+	{
+		// A flat axis has no extent to spread the range over, everything on it sits at the bias.
+		value = bounds.scale[i] > 0.0f ? (position[i] - bounds.bias[i]) / bounds.scale[i] : 0.0f;
+		value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+
+		output[i] = (unsigned short)lrintf(value * 65535.0f);
+	}
+
+	return;
+}
+
+
+void VertexCompressionClass::DecodePosition(const unsigned short* position, const BoundsType& bounds, float* output)
+{
+	int i;
+
+
+	for(i=0; i<3; i++)
+	{
+		output[i] = ((float)position[i] / 65535.0f) * bounds.scale[i] + bounds.bias[i];
+	}
+
+	return;
+}
+
+
+void VertexCompressionClass::EncodeOctahedral(const float* vector, short* output)
+{
+	float length, u, v, foldedU, foldedV;
+
+
+	// Project the vector onto the octahedron |x| + |y| + |z| = 1.
+	length = fabsf(vector[0]) + fabsf(vector[1]) + fabsf(vector[2]);
+	if(length <= 0.0f)
+	{
+		output[0] = 0;
+		output[1] = 0;
+		return;
+	}
+
+	u = vector[0] / length;
+	v = vector[1] / length;
+
+	// Fold the lower hemisphere out over the corners of the square.
+	if(vector[2] < 0.0f)
+	{
+		foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+		foldedV = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = foldedU;
+		v = foldedV;
+	}
+
+	u = u < -1.0f ? -1.0f : (u > 1.0f ? 1.0f : u);
+	v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+
+	output[0] = (short)lrintf(u * 32767.0f);
+	output[1] = (short)lrintf(v * 32767.0f);
+
+	return;
+}
+
+
+void VertexCompressionClass::DecodeOctahedral(const short* vector, float* output)
+{
+	float u, v, fold, length;
+
+
+	// Snorm decode, -32768 and -32767 both map to -1.
+	u = (float)vector[0] / 32767.0f;
+	v = (float)vector[1] / 32767.0f;
+	u = u < -1.0f ? -1.0f : u;
+	v = v < -1.0f ? -1.0f : v;
+
+	// Same unfold as DecodeOctahedral in vertexcompression.hlsli.
+	output[2] = 1.0f - fabsf(u) - fabsf(v);
+	fold = output[2] < 0.0f ? -output[2] : 0.0f;
+	output[0] = u + (u >= 0.0f ? -fold : fold);
+	output[1] = v + (v >= 0.0f ? -fold : fold);
+
+	length = sqrtf(output[0] * output[0] + output[1] * output[1] + output[2] * output[2]);
+	output[0] /= length;
+	output[1] /= length;
+	output[2] /= length;
+
+	return;
+}
+
+
+unsigned short VertexCompressionClass::EncodeHalf(float value)
+{
+	const unsigned int infinity = 255 << 23;
+	const unsigned int halfMaximum = (127 + 16) << 23;
+	const unsigned int denormalMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+	unsigned int bits, sign, odd, result;
+	float denormal, magic;
+
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	sign = bits & 0x80000000;
+	bits ^= sign;
+
+	if(bits >= halfMaximum)
+	{
+		// Too large for a half becomes infinity, NaN stays NaN.
+		result = bits > infinity ? 0x7e00 : 0x7c00;
+	}
+	else if(bits < (113 << 23))
+	{
+		// Too small for a normal half, adding the magic number lets the FPU do the round to nearest even.
+		memcpy(&denormal, &bits, sizeof(denormal));
+		memcpy(&magic, &denormalMagic, sizeof(magic));
+		denormal += magic;
+		memcpy(&bits, &denormal, sizeof(bits));
+		result = bits - denormalMagic;
+	}
+	else
+	{
+		// Rebias the exponent and round the mantissa to nearest even.
+		odd = (bits >> 13) & 1;
+		bits += ((unsigned int)(15 - 127) << 23) + 0xfff;
+		bits += odd;
+		result = bits >> 13;
+	}
+
+	return (unsigned short)(result | (sign >> 16));
+}
+
+
+float VertexCompressionClass::DecodeHalf(unsigned short value)
+{
+	int exponent, mantissa;
+	float result;
+
+
+	exponent = (value >> 10) & 0x1f;
+	mantissa = value & 0x3ff;
+
+	if(exponent == 0)
+	{
+		result = ldexpf((float)mantissa, -24);
+	}
+	else if(exponent == 31)
+	{
+		result = mantissa ? NAN : INFINITY;
+	}
+	else
+	{
+		result = ldexpf((float)(mantissa | 0x400), exponent - 25);
+	}
+
+	return (value & 0x8000) ? -result : result;
+}
+
+
+float VertexCompressionClass::AngleBetween(const float* a, const float* b)
+{
+	float cross[3], sine, cosine;
+
+
+	// The arc cosine of the dot product loses every angle under a few hundredths of a degree to float rounding near one, the
+	// arc tangent of the cross and dot products keeps them and needs no lengths, a zero vector just gives zero.
+	cross[0] = a[1] * b[2] - a[2] * b[1];
+	cross[1] = a[2] * b[0] - a[0] * b[2];
+	cross[2] = a[0] * b[1] - a[1] * b[0];
+
+	sine = sqrtf(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+	cosine = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+
+	return atan2f(sine, cosine) * 57.2957795f;
+}
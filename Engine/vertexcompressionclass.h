@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexcompressionclass.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _VERTEXCOMPRESSIONCLASS_H_
+#define _VERTEXCOMPRESSIONCLASS_H_
+
+
+/////////////
+// GLOBALS //
+/////////////
+const bool VERTEX_COMPRESSION_ENABLED = true;
+const int VERTEX_COMPRESSION_BUFFER_SLOT = 2;
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Class name: VertexCompressionClass
+////////////////////////////////////////////////////////////////////////////////
+class VertexCompressionClass
+{
+public:
+	// Float offsets of each attribute in the source vertex, -1 if the vertex does not have it.
+	struct FormatType
+	{
+		int floatsPerVertex;
+		int position;
+		int texture;
+		int normal;
+		int tangent;
+		int binormal;
+	};
+
+	// Matches the QuantizationBuffer in vertexcompression.hlsli.
+	struct BoundsType
+	{
+		float scale[3];
+		float padding0;
+		float bias[3];
+		float padding1;
+	};
+
+	// Largest position and texture coordinate error in units, largest vector errors in degrees.
+	struct ErrorType
+	{
+		float position;
+		float texture;
+		float normal;
+		float tangent;
+		float binormal;
+	};
+
+public:
+	static constexpr int GetVertexSize(const FormatType& format)
+	{
+		// Four 16 bit unorm position components, the fourth holds the binormal sign, then half float texture coordinates and
+		// two 16 bit snorms for each octahedral vector.
+		return 8 + (format.texture >= 0 ? 4 : 0) + (format.normal >= 0 ? 4 : 0) + (format.tangent >= 0 ? 4 : 0);
+	}
+
+	static bool Compress(const float*, int, const FormatType&, unsigned char*, BoundsType&, ErrorType&);
+
+	static void ComputeBounds(const float*, int, const FormatType&, BoundsType&);
+	static void EncodePosition(const float*, const BoundsType&, unsigned short*);
+	static void DecodePosition(const unsigned short*, const BoundsType&, float*);
+	static void EncodeOctahedral(const float*, short*);
+	static void DecodeOctahedral(const short*, float*);
+	static unsigned short EncodeHalf(float);
+	static float DecodeHalf(unsigned short);
+
+private:
+	static float AngleBetween(const float*, const float*);
+};
+
+#endif
@@ -0,0 +1,74 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexlayouts.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _VERTEXLAYOUTS_H_
+#define _VERTEXLAYOUTS_H_
+
+
+///////////////////////
+// MY CLASS INCLUDES //
+///////////////////////
+#include "meshcacheclass.h"
+#include "vertexcompressionclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+enum MeshLayoutType
+{
+	MESH_LAYOUT_TEXTURE,
+	MESH_LAYOUT_NORMAL,
+	MESH_LAYOUT_TANGENT,
+	MESH_LAYOUT_COUNT
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Vertex layouts
+//
+// Each layout gives the float vertex it is built from, where every attribute
+// sits in that vertex and the stride of the vertex buffer it ends up in.  The
+// mesh registry and the model template generate their load, upload and bind
+// code from these at compile time.
+////////////////////////////////////////////////////////////////////////////////
+struct TextureVertexLayout
+{
+	struct VertexType
+	{
+		float x, y, z;
+		float tu, tv;
+	};
+
+	static constexpr MeshLayoutType meshLayout = MESH_LAYOUT_TEXTURE;
+	static constexpr VertexCompressionClass::FormatType format = { 5, 0, 3, -1, -1, -1 };
+	static constexpr unsigned int stride = VERTEX_COMPRESSION_ENABLED ? VertexCompressionClass::GetVertexSize(format) : sizeof(VertexType);
+};
+
+struct NormalVertexLayout
+{
+	// The mesh cache already holds this layout so it is used in place.
+	typedef MeshCacheClass::VertexType VertexType;
+
+	static constexpr MeshLayoutType meshLayout = MESH_LAYOUT_NORMAL;
+	static constexpr VertexCompressionClass::FormatType format = { 8, 0, 3, 5, -1, -1 };
+	static constexpr unsigned int stride = VERTEX_COMPRESSION_ENABLED ? VertexCompressionClass::GetVertexSize(format) : sizeof(VertexType);
+};
+
+struct TangentVertexLayout
+{
+	struct VertexType
+	{
+		float x, y, z;
+		float tu, tv;
+		float nx, ny, nz;
+		float tx, ty, tz;
+		float bx, by, bz;
+	};
+
+	static constexpr MeshLayoutType meshLayout = MESH_LAYOUT_TANGENT;
+	static constexpr VertexCompressionClass::FormatType format = { 14, 0, 3, 5, 8, 11 };
+	static constexpr unsigned int stride = VERTEX_COMPRESSION_ENABLED ? VertexCompressionClass::GetVertexSize(format) : sizeof(VertexType);
+};
+
+#endif
@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: benchmeshes.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+
+#include <cmath>
+
+
+void BuildSphereMesh(float radius, int rings, int segments, vector<float>& vertices, vector<unsigned int>& indices)
+{
+	float theta, phi, normal[3];
+	unsigned int a, b, c, d;
+	int ring, segment;
+
+
+	vertices.clear();
+	indices.clear();
+
+	// One row of vertices per ring from pole to pole, the first and last vertex of a row meet at the seam.
+	for(ring=0; ring<=rings; ring++)
+	{
+		theta = 3.14159265f * (float)ring / (float)rings;
+		for(segment=0; segment<=segments; segment++)
+		{
+			phi = 2.0f * 3.14159265f * (float)segment / (float)segments;
+
+			normal[0] = sinf(theta) * cosf(phi);
+			normal[1] = cosf(theta);
+			normal[2] = sinf(theta) * sinf(phi);
+
+			vertices.push_back(normal[0] * radius);
+			vertices.push_back(normal[1] * radius);
+			vertices.push_back(normal[2] * radius);
+			vertices.push_back((float)segment / (float)segments);
+			vertices.push_back((float)ring / (float)rings);
+			vertices.push_back(normal[0]);
+			vertices.push_back(normal[1]);
+			vertices.push_back(normal[2]);
+		}
+	}
+
+	// Two triangles per quad, wound so the cross product of their edges points out like the model files.
+	for(ring=0; ring<rings; ring++)
+	{
+		for(segment=0; segment<segments; segment++)
+		{
+			a = (unsigned int)(ring * (segments + 1) + segment);
+			b = a + 1;
+			c = a + (unsigned int)(segments + 1);
+			d = c + 1;
+
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+
+			indices.push_back(b);
+			indices.push_back(d);
+			indices.push_back(c);
+		}
+	}
+
+	return;
+}
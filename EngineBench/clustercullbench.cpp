@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: clustercullbench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/clustercullerclass.h"
+#include "../Engine/meshletbuilderclass.h"
+#include "../Engine/meshoptimizerclass.h"
+#include "../Engine/loadlogclass.h"
+
+#include <cmath>
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// A sphere of about 260,000 triangles, about 3,500 clusters, seen from cameras spread around it.
+const float CULL_SPHERE_RADIUS = 10.0f;
+const int CULL_SPHERE_RINGS = 256;
+const int CULL_SPHERE_SEGMENTS = 512;
+const int CULL_CAMERA_COUNT = 64;
+const int CULL_REPEAT_COUNT = 20;
+
+
+static void Normalize(float* vector)
+{
+	float length;
+
+
+	length = sqrtf(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+	vector[0] /= length;
+	vector[1] /= length;
+	vector[2] /= length;
+
+	return;
+}
+
+
+static void Cross(const float* a, const float* b, float* result)
+{
+	result[0] = a[1] * b[2] - a[2] * b[1];
+	result[1] = a[2] * b[0] - a[0] * b[2];
+	result[2] = a[0] * b[1] - a[1] * b[0];
+
+	return;
+}
+
+
+// The view matrix times a 60 degree perspective projection, both left handed and for row vectors like the engine's.
+static void BuildViewProjection(const float* eye, const float* target, float* viewProjection)
+{
+	float view[16], projection[16], xAxis[3], yAxis[3], zAxis[3], up[3], yScale, nearPlane, farPlane;
+	int i, j, k;
+
+
+	up[0] = 0.0f;
+	up[1] = 1.0f;
+	up[2] = 0.0f;
+
+	for(k=0; k<3; k++)
+	{
+		zAxis[k] = target[k] - eye[k];
+	}
+	Normalize(zAxis);
+	Cross(up, zAxis, xAxis);
+	Normalize(xAxis);
+	Cross(zAxis, xAxis, yAxis);
+
+	memset(view, 0, sizeof(view));
+	for(k=0; k<3; k++)
+	{
+		view[k * 4 + 0] = xAxis[k];
+		view[k * 4 + 1] = yAxis[k];
+		view[k * 4 + 2] = zAxis[k];
+	}
+	view[12] = -(xAxis[0] * eye[0] + xAxis[1] * eye[1] + xAxis[2] * eye[2]);
+	view[13] = -(yAxis[0] * eye[0] + yAxis[1] * eye[1] + yAxis[2] * eye[2]);
+	view[14] = -(zAxis[0] * eye[0] + zAxis[1] * eye[1] + zAxis[2] * eye[2]);
+	view[15] = 1.0f;
+
+	yScale = 1.0f / tanf(3.14159265f / 6.0f);
+	nearPlane = 0.1f;
+	farPlane = 1000.0f;
+
+	memset(projection, 0, sizeof(projection));
+	projection[0] = yScale / (16.0f / 9.0f);
+	projection[5] = yScale;
+	projection[10] = farPlane / (farPlane - nearPlane);
+	projection[11] = 1.0f;
+	projection[14] = -nearPlane * farPlane / (farPlane - nearPlane);
+
+	for(i=0; i<4; i++)
+	{
+		for(j=0; j<4; j++)
+		{
+			viewProjection[i * 4 + j] = 0.0f;
+			for(k=0; k<4; k++)
+			{
+				viewProjection[i * 4 + j] += view[i * 4 + k] * projection[k * 4 + j];
+			}
+		}
+	}
+
+	return;
+}
+
+
+// Culls the sphere from every camera, first with the normal cones and then with the frustum alone, and prints what was culled
+// and how long a cluster took.
+static bool RunCullBenchmark(const char* name, float distance, float lookAhead)
+{
+	vector<float> vertices;
+	vector<unsigned int> indices;
+	vector<ClusterCullerClass::ClusterBlockType> blocks;
+	vector<DrawRangeType> draws;
+	ClusterCullerClass::FrustumType frustum;
+	ClusterCullerClass::StatisticsType statistics, frustumStatistics;
+	float viewProjection[16], eye[3], target[3], angle;
+	double startTime, coneTime, frustumTime;
+	int blockCount, clusterCount, camera, repeat, drawCount;
+
+
+	BuildSphereMesh(CULL_SPHERE_RADIUS, CULL_SPHERE_RINGS, CULL_SPHERE_SEGMENTS, vertices, indices);
+
+	// Cluster the mesh the way the mesh cache does.
+	if(!MeshOptimizerClass::OptimizeVertexCache(&indices[0], (int)indices.size(), (int)vertices.size() / 8))
+	{
+		return false;
+	}
+
+	blocks.resize(MeshletBuilderClass::GetMaxBlockCount((int)indices.size()));
+	if(!MeshletBuilderClass::Build(&vertices[0], 8, (int)vertices.size() / 8, &indices[0], (int)indices.size(), 0, &blocks[0], blockCount,
+								   clusterCount))
+	{
+		return false;
+	}
+
+	draws.resize(clusterCount);
+
+	memset(&statistics, 0, sizeof(statistics));
+	memset(&frustumStatistics, 0, sizeof(frustumStatistics));
+	coneTime = 0.0;
+	frustumTime = 0.0;
+	drawCount = 0;
+
+	for(camera=0; camera<CULL_CAMERA_COUNT; camera++)
+	{
+		// Circle the sphere, looking at its center or, with a look ahead, along the way round it.
+		angle = 2.0f * 3.14159265f * (float)camera / (float)CULL_CAMERA_COUNT;
+		eye[0] = cosf(angle) * distance;
+		eye[1] = CULL_SPHERE_RADIUS * 0.25f;
+		eye[2] = sinf(angle) * distance;
+		target[0] = cosf(angle + lookAhead) * distance * (lookAhead > 0.0f ? 1.0f : 0.0f);
+		target[1] = 0.0f;
+		target[2] = sinf(angle + lookAhead) * distance * (lookAhead > 0.0f ? 1.0f : 0.0f);
+
+		BuildViewProjection(eye, target, viewProjection);
+
+		ClusterCullerClass::BuildFrustum(viewProjection, eye, frustum);
+		startTime = LoadLogClass::GetTime();
+		for(repeat=0; repeat<CULL_REPEAT_COUNT; repeat++)
+		{
+			drawCount += ClusterCullerClass::Cull(&blocks[0], blockCount, frustum, &draws[0], statistics);
+		}
+		coneTime += LoadLogClass::GetTime() - startTime;
+
+		ClusterCullerClass::BuildFrustum(viewProjection, NULL, frustum);
+		startTime = LoadLogClass::GetTime();
+		for(repeat=0; repeat<CULL_REPEAT_COUNT; repeat++)
+		{
+			ClusterCullerClass::Cull(&blocks[0], blockCount, frustum, &draws[0], frustumStatistics);
+		}
+		frustumTime += LoadLogClass::GetTime() - startTime;
+	}
+
+	printf("  %s: %d triangles in %d clusters, %d cameras\n", name, (int)indices.size() / 3, clusterCount, CULL_CAMERA_COUNT);
+	printf("    frustum and cones: %.1f%% frustum culled, %.1f%% cone culled, %.1f%% of triangles drawn in %.1f draws, %.2f ns per cluster\n",
+		   100.0 * statistics.frustumCulled / statistics.clusters, 100.0 * statistics.coneCulled / statistics.clusters,
+		   100.0 * (double)statistics.drawnTriangles / (double)statistics.triangles,
+		   (double)drawCount / (double)(CULL_CAMERA_COUNT * CULL_REPEAT_COUNT), coneTime * 1.0e6 / statistics.clusters);
+	printf("    frustum only:      %.1f%% frustum culled, %.1f%% of triangles drawn, %.2f ns per cluster\n",
+		   100.0 * frustumStatistics.frustumCulled / frustumStatistics.clusters,
+		   100.0 * (double)frustumStatistics.drawnTriangles / (double)frustumStatistics.triangles,
+		   frustumTime * 1.0e6 / frustumStatistics.clusters);
+
+	return true;
+}
+
+
+static bool BenchmarkCullOrbit()
+{
+	// Far enough out that the whole sphere is in view, so the cones do all the culling.
+	return RunCullBenchmark("orbit", CULL_SPHERE_RADIUS * 4.0f, 0.0f);
+}
+
+
+static bool BenchmarkCullClose()
+{
+	// Just above the surface looking along it, so most of the sphere is outside the frustum.
+	return RunCullBenchmark("close", CULL_SPHERE_RADIUS * 1.3f, 0.5f);
+}
+
+
+const BenchmarkType CLUSTER_CULL_BENCHMARKS[] =
+{
+	{ "ClusterCuller orbit", BenchmarkCullOrbit },
+	{ "ClusterCuller close", BenchmarkCullClose },
+};
+
+
+int GetClusterCullBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = CLUSTER_CULL_BENCHMARKS;
+
+	return sizeof(CLUSTER_CULL_BENCHMARKS) / sizeof(CLUSTER_CULL_BENCHMARKS[0]);
+}
@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: enginebench.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _ENGINEBENCH_H_
+#define _ENGINEBENCH_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdio>
+#include <vector>
+using namespace std;
+
+
+/////////////////////////
+// FUNCTION PROTOTYPES //
+/////////////////////////
+// Every benchmark prints its own results and returns false only if it could not run.  The benchmarks of one part of the engine
+// are listed in its own file and run by main.
+typedef bool (*BenchmarkFunctionType)();
+
+struct BenchmarkType
+{
+	const char* name;
+	BenchmarkFunctionType function;
+};
+
+int GetClusterCullBenchmarks(const BenchmarkType**);
+int GetMeshCacheBenchmarks(const BenchmarkType**);
+int GetMeshOptimizerBenchmarks(const BenchmarkType**);
+int GetMeshParserBenchmarks(const BenchmarkType**);
+int GetTextureEncodeBenchmarks(const BenchmarkType**);
+int GetTextureLoadBenchmarks(const BenchmarkType**);
+int GetVertexCompressionBenchmarks(const BenchmarkType**);
+
+// A sphere of the given radius as a triangle list with the vertex format of the model files, position, texture coordinate and
+// normal, wound so the faces point out.
+void BuildSphereMesh(float, int, int, vector<float>&, vector<unsigned int>&);
+
+#endif
@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: main.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The benchmarks only use engine and cooker classes that do not touch a device or a window, so besides the project they build
+// with any C++17 compiler, for example on Linux with
+//   g++ -std=c++17 -O2 -pthread -I../Engine *.cpp ../Engine/clustercullerclass.cpp ../Engine/meshletbuilderclass.cpp
+//       ../Engine/meshoptimizerclass.cpp ../Engine/meshparserclass.cpp ../Engine/meshcacheclass.cpp ../Engine/meshwelderclass.cpp
+//       ../Engine/meshsimplifierclass.cpp ../Engine/mappedfileclass.cpp ../Engine/jobsystemclass.cpp ../Engine/loadlogclass.cpp
+//       ../Engine/vertexcompressionclass.cpp ../Engine/tangentgeneratorclass.cpp
+//       ../AssetCook/bcencoderclass.cpp ../AssetCook/bcdecoderclass.cpp ../AssetCook/ddsreaderclass.cpp
+//       ../AssetCook/ddsformatclass.cpp -o enginebench
+// Build them optimized, the numbers from a debug build say little.
+typedef int (*GetBenchmarksFunctionType)(const BenchmarkType**);
+
+const GetBenchmarksFunctionType BENCHMARK_LISTS[] =
+{
+	GetClusterCullBenchmarks,
+	GetMeshCacheBenchmarks,
+	GetMeshOptimizerBenchmarks,
+	GetMeshParserBenchmarks,
+	GetTextureEncodeBenchmarks,
+	GetTextureLoadBenchmarks,
+	GetVertexCompressionBenchmarks,
+};
+
+
+int main(int argc, char** argv)
+{
+	const BenchmarkType* benchmarks;
+	const char* filter;
+	int list, count, i, failed;
+
+
+	// enginebench [name], runs only the benchmarks whose name has the given text in it.
+	filter = argc > 1 ? argv[1] : 0;
+
+	failed = 0;
+	for(list=0; list<(int)(sizeof(BENCHMARK_LISTS) / sizeof(BENCHMARK_LISTS[0])); list++)
+	{
+		count = BENCHMARK_LISTS[list](&benchmarks);
+		for(i=0; i<count; i++)
+		{
+			if(filter && !strstr(benchmarks[i].name, filter))
+			{
+				continue;
+			}
+
+			printf("%s\n", benchmarks[i].name);
+			fflush(stdout);
+			if(!benchmarks[i].function())
+			{
+				printf("  FAILED\n");
+				failed++;
+			}
+		}
+	}
+
+	return failed == 0 ? 0 : 1;
+}
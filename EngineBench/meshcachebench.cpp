@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshcachebench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/meshcacheclass.h"
+#include "../Engine/meshwelderclass.h"
+#include "../Engine/loadlogclass.h"
+
+#include <fstream>
+#include <string>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Load every model often enough that the times are not lost in the timer's resolution.
+const double MESH_LOAD_MIN_TIME = 200.0;
+
+
+// The way a model was loaded before the cache, the file read one character at a time to the colons and then one float at a time.
+static bool LoadWithStream(const char* filename)
+{
+	ifstream fin;
+	vector<float> values;
+	char input;
+	int vertexCount;
+	size_t i;
+
+
+	fin.open(filename);
+	if(fin.fail())
+	{
+		return false;
+	}
+
+	fin.get(input);
+	while(fin && input != ':')
+	{
+		fin.get(input);
+	}
+
+	fin >> vertexCount;
+	if(!fin)
+	{
+		return false;
+	}
+
+	fin.get(input);
+	while(fin && input != ':')
+	{
+		fin.get(input);
+	}
+
+	values.resize((size_t)vertexCount * 8);
+	for(i=0; i<values.size(); i++)
+	{
+		fin >> values[i];
+	}
+
+	fin.close();
+
+	return !fin.fail();
+}
+
+
+// Builds the mesh from the text as the engine does without a cache, parsing, welding, optimizing and making the LODs and clusters.
+static bool LoadFromText(const char* filename)
+{
+	MeshCacheClass mesh;
+	string name;
+	bool result;
+
+
+	name = filename;
+	result = mesh.InitializeFromText(&name[0], MESH_WELD_EPSILON);
+	mesh.Shutdown();
+
+	return result;
+}
+
+
+// Loads the mesh as the engine does at startup, from the binary cache next to the text once it has been written.
+static bool LoadFromCache(const char* filename)
+{
+	MeshCacheClass mesh;
+	string name;
+	bool result;
+
+
+	name = filename;
+	result = mesh.Initialize(&name[0], MESH_WELD_EPSILON);
+	mesh.Shutdown();
+
+	return result;
+}
+
+
+// Loads the model until enough time has passed and returns the time of one load in milliseconds, or a negative time if it failed.
+static double TimeLoad(bool (*load)(const char*), const char* filename)
+{
+	double startTime, time;
+	int count;
+
+
+	count = 0;
+	startTime = LoadLogClass::GetTime();
+	do
+	{
+		if(!load(filename))
+		{
+			return -1.0;
+		}
+		count++;
+		time = LoadLogClass::GetTime() - startTime;
+	}
+	while(time < MESH_LOAD_MIN_TIME);
+
+	return time / count;
+}
+
+
+static bool RunMeshLoadBenchmark(const char* filename)
+{
+	MeshCacheClass mesh;
+	string name;
+	double streamTime, textTime, cacheTime;
+	int vertexCount, indexCount;
+	bool result;
+
+
+	// The first load writes the cache if it is missing or older than the text, every load after that maps it.
+	name = filename;
+	result = mesh.Initialize(&name[0], MESH_WELD_EPSILON);
+	if(!result)
+	{
+		printf("  could not load %s\n", filename);
+		return false;
+	}
+
+	vertexCount = mesh.GetVertexCount();
+	indexCount = mesh.GetIndexCount();
+	mesh.Shutdown();
+
+	streamTime = TimeLoad(LoadWithStream, filename);
+	textTime = TimeLoad(LoadFromText, filename);
+	cacheTime = TimeLoad(LoadFromCache, filename);
+	if(streamTime < 0.0 || textTime < 0.0 || cacheTime < 0.0)
+	{
+		return false;
+	}
+
+	printf("  %d vertices, %d indices after welding\n", vertexCount, indexCount);
+	printf("    stream, values only:   %8.3f ms\n", streamTime);
+	printf("    text, whole mesh:      %8.3f ms\n", textTime);
+	printf("    binary cache:          %8.3f ms, %.0fx the stream, %.0fx the text\n", cacheTime, streamTime / cacheTime, textTime / cacheTime);
+
+	return true;
+}
+
+
+static bool BenchmarkLoadSphere()
+{
+	return RunMeshLoadBenchmark("../Engine/data/Sphere.txt");
+}
+
+
+static bool BenchmarkLoadSaturnRing()
+{
+	return RunMeshLoadBenchmark("../Engine/data/SaturnRing.txt");
+}
+
+
+static bool BenchmarkLoadFloor()
+{
+	return RunMeshLoadBenchmark("../Engine/data/Floor.txt");
+}
+
+
+const BenchmarkType MESH_CACHE_BENCHMARKS[] =
+{
+	{ "MeshCache Sphere.txt", BenchmarkLoadSphere },
+	{ "MeshCache SaturnRing.txt", BenchmarkLoadSaturnRing },
+	{ "MeshCache Floor.txt", BenchmarkLoadFloor },
+};
+
+
+int GetMeshCacheBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = MESH_CACHE_BENCHMARKS;
+
+	return sizeof(MESH_CACHE_BENCHMARKS) / sizeof(MESH_CACHE_BENCHMARKS[0]);
+}
@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshoptimizerbench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/meshoptimizerclass.h"
+#include "../Engine/loadlogclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// How often the tree mesh is drawn each frame, what one saved vertex shader run per tree is worth.
+const int OPTIMIZE_TREE_INSTANCES = 200;
+
+
+// Puts the triangles in a random order that is the same every run, like a mesh exported with no thought for the cache.
+static void ShuffleTriangles(vector<unsigned int>& indices)
+{
+	unsigned int seed, swap;
+	int triangleCount, i, j, k;
+
+
+	seed = 12345;
+	triangleCount = (int)indices.size() / 3;
+	for(i=triangleCount-1; i>0; i--)
+	{
+		seed = seed * 1664525 + 1013904223;
+		j = (int)((seed >> 8) % (unsigned int)(i + 1));
+		for(k=0; k<3; k++)
+		{
+			swap = indices[i * 3 + k];
+			indices[i * 3 + k] = indices[j * 3 + k];
+			indices[j * 3 + k] = swap;
+		}
+	}
+
+	return;
+}
+
+
+static void PrintStep(const char* name, const vector<unsigned int>& indices, int vertexCount, double time)
+{
+	MeshOptimizerClass::StatisticsType fifo, lru;
+
+
+	fifo = MeshOptimizerClass::AnalyzeVertexCache(&indices[0], (int)indices.size(), vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+	lru = MeshOptimizerClass::AnalyzeVertexCache(&indices[0], (int)indices.size(), vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+	printf("    %-14s ACMR %.3f, ATVR %.3f with %d entries, ACMR %.3f with %d, %8.3f ms\n", name, fifo.acmr, fifo.atvr, MESH_OPTIMIZER_FIFO_SIZE,
+		   lru.acmr, MESH_OPTIMIZER_CACHE_SIZE, time);
+
+	return;
+}
+
+
+static bool RunOptimizeBenchmark(int rings, int segments, bool shuffle)
+{
+	vector<float> vertices;
+	vector<unsigned int> indices;
+	MeshOptimizerClass::StatisticsType before, after;
+	double startTime, cacheTime, overdrawTime, fetchTime;
+	int vertexCount, triangleCount;
+
+
+	BuildSphereMesh(1.0f, rings, segments, vertices, indices);
+	if(shuffle)
+	{
+		ShuffleTriangles(indices);
+	}
+
+	vertexCount = (int)vertices.size() / 8;
+	triangleCount = (int)indices.size() / 3;
+
+	printf("  %d vertices, %d triangles, %s\n", vertexCount, triangleCount, shuffle ? "triangles shuffled" : "triangles in ring order");
+	PrintStep("as built:", indices, vertexCount, 0.0);
+	before = MeshOptimizerClass::AnalyzeVertexCache(&indices[0], (int)indices.size(), vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+
+	// The same passes in the same order as the mesh cache runs them.
+	startTime = LoadLogClass::GetTime();
+	if(!MeshOptimizerClass::OptimizeVertexCache(&indices[0], (int)indices.size(), vertexCount))
+	{
+		return false;
+	}
+	cacheTime = LoadLogClass::GetTime() - startTime;
+	PrintStep("vertex cache:", indices, vertexCount, cacheTime);
+
+	startTime = LoadLogClass::GetTime();
+	if(!MeshOptimizerClass::OptimizeOverdraw(&indices[0], (int)indices.size(), &vertices[0], 8, vertexCount, MESH_OPTIMIZER_OVERDRAW_THRESHOLD))
+	{
+		return false;
+	}
+	overdrawTime = LoadLogClass::GetTime() - startTime;
+	PrintStep("overdraw:", indices, vertexCount, overdrawTime);
+
+	startTime = LoadLogClass::GetTime();
+	if(!MeshOptimizerClass::OptimizeVertexFetch(&vertices[0], vertexCount, 8 * sizeof(float), &indices[0], (int)indices.size()))
+	{
+		return false;
+	}
+	fetchTime = LoadLogClass::GetTime() - startTime;
+	PrintStep("vertex fetch:", indices, vertexCount, fetchTime);
+
+	after = MeshOptimizerClass::AnalyzeVertexCache(&indices[0], (int)indices.size(), vertexCount, MESH_OPTIMIZER_FIFO_SIZE);
+
+	printf("    %.2f million triangles per second, %.0f vertex shader runs saved per frame if drawn %d times like the trees\n",
+		   (double)triangleCount / ((cacheTime + overdrawTime + fetchTime) * 1000.0), (before.acmr - after.acmr) * triangleCount * OPTIMIZE_TREE_INSTANCES,
+		   OPTIMIZE_TREE_INSTANCES);
+
+	return true;
+}
+
+
+static bool BenchmarkOptimizeSmall()
+{
+	// A few thousand triangles, a small prop of the kind drawn many times over.
+	return RunOptimizeBenchmark(32, 64, true);
+}
+
+
+static bool BenchmarkOptimizeLarge()
+{
+	return RunOptimizeBenchmark(256, 512, true);
+}
+
+
+static bool BenchmarkOptimizeOrdered()
+{
+	return RunOptimizeBenchmark(256, 512, false);
+}
+
+
+const BenchmarkType MESH_OPTIMIZER_BENCHMARKS[] =
+{
+	{ "MeshOptimizer small shuffled", BenchmarkOptimizeSmall },
+	{ "MeshOptimizer large shuffled", BenchmarkOptimizeLarge },
+	{ "MeshOptimizer large ordered", BenchmarkOptimizeOrdered },
+};
+
+
+int GetMeshOptimizerBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = MESH_OPTIMIZER_BENCHMARKS;
+
+	return sizeof(MESH_OPTIMIZER_BENCHMARKS) / sizeof(MESH_OPTIMIZER_BENCHMARKS[0]);
+}
@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: meshparserbench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/meshparserclass.h"
+#include "../Engine/jobsystemclass.h"
+#include "../Engine/loadlogclass.h"
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The model files are read from the engine's data folder, the benchmarks run from the EngineBench folder.
+const char* PARSE_SPHERE_FILENAME = "../Engine/data/Sphere.txt";
+const char* PARSE_SATURN_RING_FILENAME = "../Engine/data/SaturnRing.txt";
+
+// A made up file far larger than any the engine ships, written to memory rather than to disk.
+const int PARSE_LARGE_VERTEX_COUNT = 10000000;
+
+// Parse the small files often enough that the times are not lost in the timer's resolution.
+const double PARSE_MIN_TIME = 200.0;
+
+
+static bool ReadText(const char* filename, string& text)
+{
+	ifstream fin;
+	stringstream buffer;
+
+
+	fin.open(filename, ios::in | ios::binary);
+	if(fin.fail())
+	{
+		return false;
+	}
+
+	buffer << fin.rdbuf();
+	text = buffer.str();
+
+	fin.close();
+
+	return true;
+}
+
+
+static double GetMegabytesPerSecond(size_t size, double time)
+{
+	return ((double)size / (1024.0 * 1024.0)) / (time / 1000.0);
+}
+
+
+// The way the model was read before the parser, a scan for the colons and locale aware extraction of every value.
+static bool ParseWithStream(const string& text, vector<float>& values)
+{
+	istringstream fin(text);
+	char input;
+	int vertexCount;
+	size_t i;
+
+
+	fin.get(input);
+	while(fin && input != ':')
+	{
+		fin.get(input);
+	}
+
+	fin >> vertexCount;
+	if(!fin)
+	{
+		return false;
+	}
+
+	fin.get(input);
+	while(fin && input != ':')
+	{
+		fin.get(input);
+	}
+
+	values.resize((size_t)vertexCount * 8);
+	for(i=0; i<values.size(); i++)
+	{
+		fin >> values[i];
+	}
+
+	return !fin.fail();
+}
+
+
+static bool ParseWithParser(const string& text, vector<float>& values)
+{
+	int vertexCount;
+	size_t dataOffset;
+
+
+	if(!MeshParserClass::ParseHeader(text.data(), text.size(), vertexCount, dataOffset))
+	{
+		return false;
+	}
+
+	values.resize((size_t)vertexCount * 8);
+
+	return MeshParserClass::ParseData(text.data() + dataOffset, text.size() - dataOffset, values.data(), values.size());
+}
+
+
+// Runs a parse until enough time has passed and returns the time of one parse in milliseconds, or a negative time if it failed.
+static double TimeParse(bool (*parse)(const string&, vector<float>&), const string& text, vector<float>& values)
+{
+	double startTime, time;
+	int count;
+
+
+	count = 0;
+	startTime = LoadLogClass::GetTime();
+	do
+	{
+		if(!parse(text, values))
+		{
+			return -1.0;
+		}
+		count++;
+		time = LoadLogClass::GetTime() - startTime;
+	}
+	while(time < PARSE_MIN_TIME);
+
+	return time / count;
+}
+
+
+// The same parse as a loader job would make it, on a pool thread where the parser keeps to that thread.
+static double TimeParseInJob(JobSystemClass* jobSystem, const string& text, vector<float>& values)
+{
+	double time;
+
+
+	time = -1.0;
+	jobSystem->Submit("parse", [&text, &values, &time]() { time = TimeParse(ParseWithParser, text, values); });
+	jobSystem->Wait();
+
+	return time;
+}
+
+
+static bool RunParseBenchmark(const string& text, bool withStream)
+{
+	JobSystemClass jobSystem;
+	vector<float> values, streamValues;
+	double streamTime, chunkedTime, jobTime;
+	size_t i;
+	bool result;
+
+
+	result = jobSystem.Initialize(1, 0);
+	if(!result)
+	{
+		return false;
+	}
+
+	chunkedTime = TimeParse(ParseWithParser, text, values);
+	jobTime = TimeParseInJob(&jobSystem, text, values);
+
+	jobSystem.Shutdown();
+
+	if(chunkedTime < 0.0 || jobTime < 0.0)
+	{
+		return false;
+	}
+
+	printf("  %.1f MB, %d vertices\n", (double)text.size() / (1024.0 * 1024.0), (int)(values.size() / 8));
+
+	// The stream takes seconds on the large file, it is only timed on the files the engine ships.
+	if(withStream)
+	{
+		streamTime = TimeParse(ParseWithStream, text, streamValues);
+		if(streamTime < 0.0)
+		{
+			return false;
+		}
+
+		// from_chars rounds correctly, the stream may be a last bit off, so compare with a tolerance.
+		for(i=0; i<values.size(); i++)
+		{
+			if(fabsf(values[i] - streamValues[i]) > 1e-5f * (1.0f + fabsf(values[i])))
+			{
+				printf("  value %d is %g, the stream read %g\n", (int)i, values[i], streamValues[i]);
+				return false;
+			}
+		}
+
+		printf("    stream:            %8.3f ms, %6.1f MB/s\n", streamTime, GetMegabytesPerSecond(text.size(), streamTime));
+	}
+
+	printf("    parser, chunked:   %8.3f ms, %6.1f MB/s, %d cores\n", chunkedTime, GetMegabytesPerSecond(text.size(), chunkedTime),
+		   (int)thread::hardware_concurrency());
+	printf("    parser, in a job:  %8.3f ms, %6.1f MB/s\n", jobTime, GetMegabytesPerSecond(text.size(), jobTime));
+
+	return true;
+}
+
+
+static bool BenchmarkParseSphere()
+{
+	string text;
+
+
+	if(!ReadText(PARSE_SPHERE_FILENAME, text))
+	{
+		printf("  could not open %s\n", PARSE_SPHERE_FILENAME);
+		return false;
+	}
+
+	return RunParseBenchmark(text, true);
+}
+
+
+static bool BenchmarkParseSaturnRing()
+{
+	string text;
+
+
+	if(!ReadText(PARSE_SATURN_RING_FILENAME, text))
+	{
+		printf("  could not open %s\n", PARSE_SATURN_RING_FILENAME);
+		return false;
+	}
+
+	return RunParseBenchmark(text, true);
+}
+
+
+static bool BenchmarkParseLarge()
+{
+	vector<float> vertices;
+	vector<unsigned int> indices;
+	string text;
+	char line[160];
+	int length, rings, i;
+	size_t vertex;
+
+
+	// Build the file from a sphere, so the values look like those of a real model, repeated up to the vertex count.
+	rings = 256;
+	BuildSphereMesh(10.0f, rings, rings * 2, vertices, indices);
+
+	text.reserve((size_t)PARSE_LARGE_VERTEX_COUNT * 64);
+	length = snprintf(line, sizeof(line), "Vertex Count: %d\n\nData:\n\n", PARSE_LARGE_VERTEX_COUNT);
+	text.append(line, length);
+
+	vertex = 0;
+	for(i=0; i<PARSE_LARGE_VERTEX_COUNT; i++)
+	{
+		length = snprintf(line, sizeof(line), "%.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f\n", vertices[vertex * 8 + 0], vertices[vertex * 8 + 1],
+						  vertices[vertex * 8 + 2], vertices[vertex * 8 + 3], vertices[vertex * 8 + 4], vertices[vertex * 8 + 5],
+						  vertices[vertex * 8 + 6], vertices[vertex * 8 + 7]);
+		text.append(line, length);
+
+		vertex++;
+		if(vertex * 8 == vertices.size())
+		{
+			vertex = 0;
+		}
+	}
+
+	return RunParseBenchmark(text, false);
+}
+
+
+const BenchmarkType MESH_PARSER_BENCHMARKS[] =
+{
+	{ "MeshParser Sphere.txt", BenchmarkParseSphere },
+	{ "MeshParser SaturnRing.txt", BenchmarkParseSaturnRing },
+	{ "MeshParser 10M vertices", BenchmarkParseLarge },
+};
+
+
+int GetMeshParserBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = MESH_PARSER_BENCHMARKS;
+
+	return sizeof(MESH_PARSER_BENCHMARKS) / sizeof(MESH_PARSER_BENCHMARKS[0]);
+}
@@ -0,0 +1,181 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureencodebench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/mappedfileclass.h"
+#include "../Engine/jobsystemclass.h"
+#include "../Engine/loadlogclass.h"
+#include "../AssetCook/bcencoderclass.h"
+#include "../AssetCook/bcdecoderclass.h"
+#include "../AssetCook/ddsreaderclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* ENCODE_COLOR_FILENAME = "../Engine/data/2k_earth_with_clouds.dds";
+const char* ENCODE_NORMAL_FILENAME = "../Engine/data/2k_earth_normal_map.dds";
+
+
+// Expands a texture of the data folder to the 32 bit BGRA chain the encoder takes, the way the cooker does with a BC1 normal map.
+static bool LoadLevels(const char* filename, vector<unsigned char>& levels, int& width, int& height, int& mipCount)
+{
+	MappedFileClass file;
+	DdsReaderClass reader;
+	bool result;
+
+
+	if(!file.Initialize(filename))
+	{
+		printf("  could not open %s\n", filename);
+		return false;
+	}
+
+	result = reader.Initialize(file.GetData(), file.GetSize());
+	if(result)
+	{
+		result = reader.GetFormat() == DDS_FORMAT_BC1;
+	}
+	if(!result)
+	{
+		printf("  %s is not the BC1 texture expected\n", filename);
+		reader.Shutdown();
+		file.Shutdown();
+		return false;
+	}
+
+	width = reader.GetWidth();
+	height = reader.GetHeight();
+	mipCount = reader.GetMipCount();
+
+	levels.resize(DdsFormatClass::GetChainSize(DDS_FORMAT_BGRA8, width, height, mipCount));
+	result = BcDecoderClass::Decode(reader.GetLevelData(0, 0), width, height, mipCount, DDS_FORMAT_BC1, levels.data());
+
+	reader.Shutdown();
+	file.Shutdown();
+
+	return result;
+}
+
+
+// Compresses the chain on one thread and then on the job system and prints the speed of both and what the blocks lost.
+static bool RunEncodeBenchmark(const vector<unsigned char>& levels, int width, int height, int mipCount, DdsFormatType format,
+							   JobSystemClass* jobSystem)
+{
+	vector<unsigned char> blocks, decoded;
+	double startTime, singleTime, jobTime, megabytes;
+
+
+	blocks.resize(DdsFormatClass::GetChainSize(format, width, height, mipCount));
+	decoded.resize(levels.size());
+
+	startTime = LoadLogClass::GetTime();
+	if(!BcEncoderClass::Encode(levels.data(), width, height, mipCount, format, 0, blocks.data()))
+	{
+		return false;
+	}
+	singleTime = LoadLogClass::GetTime() - startTime;
+
+	startTime = LoadLogClass::GetTime();
+	if(!BcEncoderClass::Encode(levels.data(), width, height, mipCount, format, jobSystem, blocks.data()))
+	{
+		return false;
+	}
+	jobTime = LoadLogClass::GetTime() - startTime;
+
+	if(!BcDecoderClass::Decode(blocks.data(), width, height, mipCount, format, decoded.data()))
+	{
+		return false;
+	}
+
+	megabytes = (double)levels.size() / (1024.0 * 1024.0);
+
+	printf("    %-4s %6.2f dB PSNR, %5.1f MB/s on one thread, %5.1f MB/s on %d threads, %.1fx smaller\n", DdsFormatClass::GetName(format),
+		   BcDecoderClass::GetPsnr(levels.data(), decoded.data(), levels.size() / 4, format), megabytes / (singleTime / 1000.0),
+		   megabytes / (jobTime / 1000.0), jobSystem->GetThreadCount(), (double)levels.size() / (double)blocks.size());
+
+	return true;
+}
+
+
+static bool BenchmarkEncodeColor()
+{
+	JobSystemClass jobSystem;
+	vector<unsigned char> levels;
+	int width, height, mipCount;
+	bool result;
+
+
+	if(!LoadLevels(ENCODE_COLOR_FILENAME, levels, width, height, mipCount))
+	{
+		return false;
+	}
+
+	result = jobSystem.Initialize(0, 0);
+	if(!result)
+	{
+		return false;
+	}
+
+	printf("  %dx%d with %d mips, %.1f MB of BGRA decoded from BC1, the PSNR is against that\n", width, height, mipCount,
+		   (double)levels.size() / (1024.0 * 1024.0));
+
+	result = RunEncodeBenchmark(levels, width, height, mipCount, DDS_FORMAT_BC1, &jobSystem);
+	if(result)
+	{
+		result = RunEncodeBenchmark(levels, width, height, mipCount, DDS_FORMAT_BC3, &jobSystem);
+	}
+	if(result)
+	{
+		result = RunEncodeBenchmark(levels, width, height, mipCount, DDS_FORMAT_BC7, &jobSystem);
+	}
+
+	jobSystem.Shutdown();
+
+	return result;
+}
+
+
+static bool BenchmarkEncodeNormal()
+{
+	JobSystemClass jobSystem;
+	vector<unsigned char> levels;
+	int width, height, mipCount;
+	bool result;
+
+
+	if(!LoadLevels(ENCODE_NORMAL_FILENAME, levels, width, height, mipCount))
+	{
+		return false;
+	}
+
+	result = jobSystem.Initialize(0, 0);
+	if(!result)
+	{
+		return false;
+	}
+
+	printf("  %dx%d with %d mips, %.1f MB of BGRA decoded from BC1, the PSNR is against that\n", width, height, mipCount,
+		   (double)levels.size() / (1024.0 * 1024.0));
+
+	result = RunEncodeBenchmark(levels, width, height, mipCount, DDS_FORMAT_BC5, &jobSystem);
+
+	jobSystem.Shutdown();
+
+	return result;
+}
+
+
+const BenchmarkType TEXTURE_ENCODE_BENCHMARKS[] =
+{
+	{ "TextureEncode earth color", BenchmarkEncodeColor },
+	{ "TextureEncode earth normals", BenchmarkEncodeNormal },
+};
+
+
+int GetTextureEncodeBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = TEXTURE_ENCODE_BENCHMARKS;
+
+	return sizeof(TEXTURE_ENCODE_BENCHMARKS) / sizeof(TEXTURE_ENCODE_BENCHMARKS[0]);
+}
@@ -0,0 +1,255 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureloadbench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/mappedfileclass.h"
+#include "../Engine/loadlogclass.h"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The large textures of the planets, all loaded and waiting for their GPU resources at once as they are at startup.
+const char* TEXTURE_LOAD_FILENAMES[] =
+{
+	"../Engine/data/2k_earth_with_clouds.dds",
+	"../Engine/data/2k_earth_normal_map.dds",
+	"../Engine/data/2k_saturn.dds",
+};
+const int TEXTURE_LOAD_FILE_COUNT = sizeof(TEXTURE_LOAD_FILENAMES) / sizeof(TEXTURE_LOAD_FILENAMES[0]);
+
+// Load the set often enough that the times are not lost in the timer's resolution.
+const double TEXTURE_LOAD_MIN_TIME = 500.0;
+
+
+// Reads every byte of a texture's data the way the device does when it creates the texture from it.
+static unsigned int Upload(const unsigned char* data, size_t size)
+{
+	unsigned int sum;
+	size_t i;
+
+
+	sum = 0;
+	for(i=0; i<size; i++)
+	{
+		sum = sum * 31 + data[i];
+	}
+
+	return sum;
+}
+
+
+// Memory the process holds that is backed by no file, which is where a heap copy of a texture lives.  Other systems report none.
+// Freed blocks the allocator keeps count as held, so it only shows what a load adds the first time.
+static long long GetAnonymousMemory()
+{
+#ifdef _WIN32
+	return -1;
+#else
+	ifstream fin;
+	long long size, resident, shared;
+
+
+	fin.open("/proc/self/statm");
+	fin >> size >> resident >> shared;
+	if(fin.fail())
+	{
+		return -1;
+	}
+
+	return (resident - shared) * sysconf(_SC_PAGESIZE);
+#endif
+}
+
+
+// The way TextureClass loaded a loose file before, read into a buffer on the heap that the device then copies from.
+static bool LoadWithCopy(unsigned int& sum, long long& pendingMemory, size_t& heapSize)
+{
+	ifstream fin;
+	unsigned char* data[TEXTURE_LOAD_FILE_COUNT];
+	size_t sizes[TEXTURE_LOAD_FILE_COUNT];
+	long long startMemory;
+	bool result;
+	int i;
+
+
+	startMemory = GetAnonymousMemory();
+
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT; i++)
+	{
+		data[i] = 0;
+	}
+
+	result = true;
+	heapSize = 0;
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT && result; i++)
+	{
+		fin.open(TEXTURE_LOAD_FILENAMES[i], ios::in | ios::binary | ios::ate);
+		if(fin.fail())
+		{
+			result = false;
+			break;
+		}
+
+		sizes[i] = (size_t)fin.tellg();
+		fin.seekg(0, ios::beg);
+
+		data[i] = new unsigned char[sizes[i]];
+		heapSize += sizes[i];
+		fin.read((char*)data[i], sizes[i]);
+		result = !fin.fail();
+		fin.close();
+	}
+
+	pendingMemory = startMemory >= 0 ? GetAnonymousMemory() - startMemory : -1;
+
+	sum = 0;
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT && result; i++)
+	{
+		sum += Upload(data[i], sizes[i]);
+	}
+
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT; i++)
+	{
+		delete [] data[i];
+	}
+
+	return result;
+}
+
+
+// The way TextureClass loads a loose file now, mapped and handed to the device as it is.
+static bool LoadWithMapping(unsigned int& sum, long long& pendingMemory, size_t& heapSize)
+{
+	MappedFileClass files[TEXTURE_LOAD_FILE_COUNT];
+	long long startMemory;
+	bool result;
+	int i;
+
+
+	startMemory = GetAnonymousMemory();
+
+	result = true;
+	heapSize = 0;
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT && result; i++)
+	{
+		result = files[i].Initialize(TEXTURE_LOAD_FILENAMES[i]);
+	}
+
+	pendingMemory = startMemory >= 0 ? GetAnonymousMemory() - startMemory : -1;
+
+	sum = 0;
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT && result; i++)
+	{
+		sum += Upload(files[i].GetData(), files[i].GetSize());
+	}
+
+	for(i=0; i<TEXTURE_LOAD_FILE_COUNT; i++)
+	{
+		files[i].Shutdown();
+	}
+
+	return result;
+}
+
+
+// Loads the set until enough time has passed and returns the time of one load in milliseconds, or a negative time if it failed.
+// The memory is that of the first load, before the allocator holds any freed buffers of earlier ones, and the sum and heap size
+// are the same for every load.
+static double TimeLoad(bool (*load)(unsigned int&, long long&, size_t&), unsigned int& sum, long long& pendingMemory, size_t& heapSize)
+{
+	double startTime, time;
+	long long warmMemory;
+	int count;
+
+
+	if(!load(sum, pendingMemory, heapSize))
+	{
+		return -1.0;
+	}
+
+	count = 0;
+	startTime = LoadLogClass::GetTime();
+	do
+	{
+		if(!load(sum, warmMemory, heapSize))
+		{
+			return -1.0;
+		}
+		count++;
+		time = LoadLogClass::GetTime() - startTime;
+	}
+	while(time < TEXTURE_LOAD_MIN_TIME);
+
+	return time / count;
+}
+
+
+static bool BenchmarkTextureLoad()
+{
+	unsigned int copySum, mappedSum;
+	long long copyMemory, mappedMemory;
+	size_t copyHeapSize, mappedHeapSize;
+	double copyTime, mappedTime;
+
+
+	// The times are warm, the first load of each brings the files into the page cache and is the one the memory is taken from.
+	copyTime = TimeLoad(LoadWithCopy, copySum, copyMemory, copyHeapSize);
+	mappedTime = TimeLoad(LoadWithMapping, mappedSum, mappedMemory, mappedHeapSize);
+	if(copyTime < 0.0 || mappedTime < 0.0)
+	{
+		printf("  could not open the planet textures\n");
+		return false;
+	}
+
+	// Both have to hand the device the same bytes.
+	if(copySum != mappedSum)
+	{
+		printf("  the mapped textures differ from the copies\n");
+		return false;
+	}
+
+	// The copy has to cost memory the mapping does not, or the benchmark measures nothing.
+	if(copyHeapSize == 0 || mappedHeapSize != 0 || copyMemory == 0)
+	{
+		printf("  the heap copy shows no extra memory\n");
+		return false;
+	}
+
+	printf("  %d textures loaded and waiting at once, the upload reads every byte\n", TEXTURE_LOAD_FILE_COUNT);
+	printf("    heap copy: %8.3f ms per load, %.1f MB allocated", copyTime, (double)copyHeapSize / (1024.0 * 1024.0));
+	if(copyMemory >= 0)
+	{
+		printf(", %+.1f MB anonymous memory on the first load", (double)copyMemory / (1024.0 * 1024.0));
+	}
+	printf("\n");
+
+	printf("    mapped:    %8.3f ms per load, %.1f MB allocated", mappedTime, (double)mappedHeapSize / (1024.0 * 1024.0));
+	if(mappedMemory >= 0)
+	{
+		printf(", %+.1f MB anonymous memory on the first load", (double)mappedMemory / (1024.0 * 1024.0));
+	}
+	printf("\n");
+
+	return true;
+}
+
+
+const BenchmarkType TEXTURE_LOAD_BENCHMARKS[] =
+{
+	{ "TextureLoad planets", BenchmarkTextureLoad },
+};
+
+
+int GetTextureLoadBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = TEXTURE_LOAD_BENCHMARKS;
+
+	return sizeof(TEXTURE_LOAD_BENCHMARKS) / sizeof(TEXTURE_LOAD_BENCHMARKS[0]);
+}
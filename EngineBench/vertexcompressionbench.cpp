@@ -0,0 +1,476 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: vertexcompressionbench.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginebench.h"
+#include "../Engine/vertexlayouts.h"
+#include "../Engine/tangentgeneratorclass.h"
+#include "../Engine/meshwelderclass.h"
+#include "../Engine/loadlogclass.h"
+
+#include <cfloat>
+#include <cmath>
+#include <string>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const char* COMPRESS_SPHERE_FILENAME = "../Engine/data/Sphere.txt";
+const char* COMPRESS_SATURN_RING_FILENAME = "../Engine/data/SaturnRing.txt";
+
+// Compress and decompress often enough that the times are not lost in the timer's resolution.
+const double COMPRESS_MIN_TIME = 200.0;
+
+// The attributes the error is reported for, positions and texture coordinates per component in units, the vectors in degrees.
+enum CompressAttributeType
+{
+	COMPRESS_POSITION,
+	COMPRESS_TEXTURE,
+	COMPRESS_NORMAL,
+	COMPRESS_TANGENT,
+	COMPRESS_BINORMAL,
+	COMPRESS_ATTRIBUTE_COUNT
+};
+
+const char* COMPRESS_ATTRIBUTE_NAMES[COMPRESS_ATTRIBUTE_COUNT] = { "position:", "texture:", "normal:", "tangent:", "binormal:" };
+
+// What a timed step of one mesh reads and writes.
+struct CompressRunType
+{
+	const float* vertices;
+	int vertexCount;
+	VertexCompressionClass::FormatType format;
+	VertexCompressionClass::BoundsType bounds;
+	VertexCompressionClass::ErrorType error;
+	unsigned char* packed;
+	float* decoded;
+};
+
+
+// Builds the float vertices of a layout from a model the way the mesh registry does, tangent frames included where it has them.
+static bool BuildVertices(const char* filename, const VertexCompressionClass::FormatType& format, vector<float>& vertices)
+{
+	MeshCacheClass mesh;
+	TangentGeneratorClass::StatisticsType statistics;
+	const MeshCacheClass::VertexType* model;
+	string name;
+	float* vertex;
+	int vertexCount, i;
+	bool result;
+
+
+	name = filename;
+	result = mesh.Initialize(&name[0], MESH_WELD_EPSILON);
+	if(!result)
+	{
+		printf("  could not load %s\n", filename);
+		return false;
+	}
+
+	model = mesh.GetVertices();
+	vertexCount = mesh.GetVertexCount();
+
+	vertices.assign((size_t)vertexCount * format.floatsPerVertex, 0.0f);
+	for(i=0; i<vertexCount; i++)
+	{
+		vertex = &vertices[(size_t)i * format.floatsPerVertex];
+
+		vertex[format.position + 0] = model[i].x;
+		vertex[format.position + 1] = model[i].y;
+		vertex[format.position + 2] = model[i].z;
+		vertex[format.texture + 0] = model[i].tu;
+		vertex[format.texture + 1] = model[i].tv;
+
+		if(format.normal >= 0)
+		{
+			vertex[format.normal + 0] = model[i].nx;
+			vertex[format.normal + 1] = model[i].ny;
+			vertex[format.normal + 2] = model[i].nz;
+		}
+	}
+
+	if(format.tangent >= 0)
+	{
+		result = TangentGeneratorClass::Generate(&vertices[0], vertexCount, format, mesh.GetIndices(), mesh.GetIndexCount(), statistics);
+	}
+
+	mesh.Shutdown();
+
+	return result;
+}
+
+
+// Packs the vertices with the engine's encoders alone, the same bytes Compress writes without its error check and its log.
+static void Pack(const float* vertices, int vertexCount, const VertexCompressionClass::FormatType& format,
+				 const VertexCompressionClass::BoundsType& bounds, unsigned char* data)
+{
+	const float* vertex;
+	unsigned short* position;
+	unsigned short* texture;
+	const short* packedNormal;
+	float normal[3], tangent[3], binormal[3];
+	int i;
+
+
+	for(i=0; i<vertexCount; i++)
+	{
+		vertex = &vertices[(size_t)i * format.floatsPerVertex];
+
+		position = (unsigned short*)data;
+		VertexCompressionClass::EncodePosition(&vertex[format.position], bounds, position);
+		position[3] = 65535;
+		data += 4 * sizeof(unsigned short);
+
+		if(format.texture >= 0)
+		{
+			texture = (unsigned short*)data;
+			texture[0] = VertexCompressionClass::EncodeHalf(vertex[format.texture + 0]);
+			texture[1] = VertexCompressionClass::EncodeHalf(vertex[format.texture + 1]);
+			data += 2 * sizeof(unsigned short);
+		}
+
+		packedNormal = (const short*)data;
+		if(format.normal >= 0)
+		{
+			VertexCompressionClass::EncodeOctahedral(&vertex[format.normal], (short*)data);
+			data += 2 * sizeof(short);
+		}
+
+		// The sign of the binormal is taken against the frame as the shader decodes it, not against the source.
+		if(format.tangent >= 0)
+		{
+			VertexCompressionClass::EncodeOctahedral(&vertex[format.tangent], (short*)data);
+			VertexCompressionClass::DecodeOctahedral(packedNormal, normal);
+			VertexCompressionClass::DecodeOctahedral((const short*)data, tangent);
+			data += 2 * sizeof(short);
+
+			binormal[0] = normal[1] * tangent[2] - normal[2] * tangent[1];
+			binormal[1] = normal[2] * tangent[0] - normal[0] * tangent[2];
+			binormal[2] = normal[0] * tangent[1] - normal[1] * tangent[0];
+
+			if(binormal[0] * vertex[format.binormal] + binormal[1] * vertex[format.binormal + 1] + binormal[2] * vertex[format.binormal + 2] < 0.0f)
+			{
+				position[3] = 0;
+			}
+		}
+	}
+
+	return;
+}
+
+
+// Unpacks the vertices back to floats the way vertexcompression.hlsli does in the vertex shader.
+static void Unpack(const unsigned char* data, int vertexCount, const VertexCompressionClass::FormatType& format,
+				   const VertexCompressionClass::BoundsType& bounds, float* vertices)
+{
+	const unsigned short* position;
+	const unsigned short* texture;
+	float* vertex;
+	float* normal;
+	float* tangent;
+	float sign;
+	int i;
+
+
+	for(i=0; i<vertexCount; i++)
+	{
+		vertex = &vertices[(size_t)i * format.floatsPerVertex];
+
+		position = (const unsigned short*)data;
+		VertexCompressionClass::DecodePosition(position, bounds, &vertex[format.position]);
+		data += 4 * sizeof(unsigned short);
+
+		if(format.texture >= 0)
+		{
+			texture = (const unsigned short*)data;
+			vertex[format.texture + 0] = VertexCompressionClass::DecodeHalf(texture[0]);
+			vertex[format.texture + 1] = VertexCompressionClass::DecodeHalf(texture[1]);
+			data += 2 * sizeof(unsigned short);
+		}
+
+		if(format.normal >= 0)
+		{
+			VertexCompressionClass::DecodeOctahedral((const short*)data, &vertex[format.normal]);
+			data += 2 * sizeof(short);
+		}
+
+		// The binormal is rebuilt from the normal and the tangent with the sign kept in the fourth position component.
+		if(format.tangent >= 0)
+		{
+			VertexCompressionClass::DecodeOctahedral((const short*)data, &vertex[format.tangent]);
+			data += 2 * sizeof(short);
+
+			normal = &vertex[format.normal];
+			tangent = &vertex[format.tangent];
+			sign = position[3] == 0 ? -1.0f : 1.0f;
+
+			vertex[format.binormal + 0] = (normal[1] * tangent[2] - normal[2] * tangent[1]) * sign;
+			vertex[format.binormal + 1] = (normal[2] * tangent[0] - normal[0] * tangent[2]) * sign;
+			vertex[format.binormal + 2] = (normal[0] * tangent[1] - normal[1] * tangent[0]) * sign;
+		}
+	}
+
+	return;
+}
+
+
+static double GetAngle(const float* a, const float* b)
+{
+	double lengthA, lengthB, cosine;
+
+
+	lengthA = sqrt((double)a[0] * a[0] + (double)a[1] * a[1] + (double)a[2] * a[2]);
+	lengthB = sqrt((double)b[0] * b[0] + (double)b[1] * b[1] + (double)b[2] * b[2]);
+	if(lengthA <= 0.0 || lengthB <= 0.0)
+	{
+		return 0.0;
+	}
+
+	cosine = ((double)a[0] * b[0] + (double)a[1] * b[1] + (double)a[2] * b[2]) / (lengthA * lengthB);
+	cosine = cosine < -1.0 ? -1.0 : (cosine > 1.0 ? 1.0 : cosine);
+
+	return acos(cosine) * 57.29577951308232;
+}
+
+
+// Adds one error to the largest and to the sum of squares of its attribute.
+static void AddError(CompressAttributeType attribute, double error, double* maximum, double* squareSum, int* count)
+{
+	maximum[attribute] = error > maximum[attribute] ? error : maximum[attribute];
+	squareSum[attribute] += error * error;
+	count[attribute]++;
+
+	return;
+}
+
+
+// Compares the decompressed vertices with the source and returns the largest and the RMS error of every attribute, -1 for those
+// the layout does not have.
+static void MeasureError(const float* source, const float* decoded, int vertexCount, const VertexCompressionClass::FormatType& format,
+						 double* maximum, double* rms)
+{
+	const int offsets[COMPRESS_ATTRIBUTE_COUNT] = { format.position, format.texture, format.normal, format.tangent, format.binormal };
+	double squareSum[COMPRESS_ATTRIBUTE_COUNT];
+	int count[COMPRESS_ATTRIBUTE_COUNT];
+	const float* a;
+	const float* b;
+	int i, j;
+
+
+	for(j=0; j<COMPRESS_ATTRIBUTE_COUNT; j++)
+	{
+		maximum[j] = 0.0;
+		squareSum[j] = 0.0;
+		count[j] = 0;
+	}
+
+	for(i=0; i<vertexCount; i++)
+	{
+		a = &source[(size_t)i * format.floatsPerVertex];
+		b = &decoded[(size_t)i * format.floatsPerVertex];
+
+		for(j=0; j<3; j++)
+		{
+			AddError(COMPRESS_POSITION, fabs((double)a[format.position + j] - b[format.position + j]), maximum, squareSum, count);
+		}
+
+		if(format.texture >= 0)
+		{
+			for(j=0; j<2; j++)
+			{
+				AddError(COMPRESS_TEXTURE, fabs((double)a[format.texture + j] - b[format.texture + j]), maximum, squareSum, count);
+			}
+		}
+
+		for(j=COMPRESS_NORMAL; j<COMPRESS_ATTRIBUTE_COUNT; j++)
+		{
+			if(offsets[j] >= 0)
+			{
+				AddError((CompressAttributeType)j, GetAngle(&a[offsets[j]], &b[offsets[j]]), maximum, squareSum, count);
+			}
+		}
+	}
+
+	for(j=0; j<COMPRESS_ATTRIBUTE_COUNT; j++)
+	{
+		rms[j] = count[j] > 0 ? sqrt(squareSum[j] / count[j]) : -1.0;
+		maximum[j] = count[j] > 0 ? maximum[j] : -1.0;
+	}
+
+	return;
+}
+
+
+// Compresses as the mesh registry does at load, with the engine's error check on every vertex and its log line.
+static bool CompressAtLoad(CompressRunType& run)
+{
+	return VertexCompressionClass::Compress(run.vertices, run.vertexCount, run.format, run.packed, run.bounds, run.error);
+}
+
+
+static bool CompressOnly(CompressRunType& run)
+{
+	VertexCompressionClass::ComputeBounds(run.vertices, run.vertexCount, run.format, run.bounds);
+	Pack(run.vertices, run.vertexCount, run.format, run.bounds, run.packed);
+
+	return true;
+}
+
+
+static bool Decompress(CompressRunType& run)
+{
+	Unpack(run.packed, run.vertexCount, run.format, run.bounds, run.decoded);
+
+	return true;
+}
+
+
+// Runs a step until enough time has passed and returns the time of one run in milliseconds, or a negative time if it failed.
+static double TimeStep(bool (*step)(CompressRunType&), CompressRunType& run)
+{
+	double startTime, time;
+	int count;
+
+
+	count = 0;
+	startTime = LoadLogClass::GetTime();
+	do
+	{
+		if(!step(run))
+		{
+			return -1.0;
+		}
+		count++;
+		time = LoadLogClass::GetTime() - startTime;
+	}
+	while(time < COMPRESS_MIN_TIME);
+
+	return time / count;
+}
+
+
+static bool RunCompressBenchmark(const char* filename, const char* layoutName, const VertexCompressionClass::FormatType& format)
+{
+	vector<float> vertices, decoded;
+	vector<unsigned char> packed, loadPacked;
+	CompressRunType run;
+	double maximum[COMPRESS_ATTRIBUTE_COUNT], rms[COMPRESS_ATTRIBUTE_COUNT];
+	double loadTime, compressTime, decompressTime, magnitude, slack;
+	int sourceSize, packedSize, i;
+
+
+	if(!BuildVertices(filename, format, vertices))
+	{
+		return false;
+	}
+
+	sourceSize = (int)sizeof(float) * format.floatsPerVertex;
+	packedSize = VertexCompressionClass::GetVertexSize(format);
+
+	run.vertices = &vertices[0];
+	run.vertexCount = (int)(vertices.size() / format.floatsPerVertex);
+	run.format = format;
+
+	packed.resize((size_t)run.vertexCount * packedSize);
+	loadPacked.resize(packed.size());
+	decoded.resize(vertices.size());
+
+	run.packed = &loadPacked[0];
+	run.decoded = &decoded[0];
+	loadTime = TimeStep(CompressAtLoad, run);
+
+	run.packed = &packed[0];
+	compressTime = TimeStep(CompressOnly, run);
+	decompressTime = TimeStep(Decompress, run);
+	if(loadTime < 0.0 || compressTime < 0.0 || decompressTime < 0.0)
+	{
+		return false;
+	}
+
+	// The encoders alone have to write what the engine uploads.
+	if(packed != loadPacked)
+	{
+		printf("  the packed vertices differ from those the engine compresses\n");
+		return false;
+	}
+
+	MeasureError(&vertices[0], &decoded[0], run.vertexCount, format, maximum, rms);
+
+	// A position may be off by half a 16 bit step over its side of the bounds and a float rounding at the size of the mesh, and the
+	// decode here has to agree with the largest errors the engine measured while compressing.
+	slack = 0.0;
+	for(i=0; i<3; i++)
+	{
+		magnitude = fabs(run.bounds.bias[i]) > fabs(run.bounds.bias[i] + run.bounds.scale[i]) ? fabs(run.bounds.bias[i]) :
+					fabs(run.bounds.bias[i] + run.bounds.scale[i]);
+		magnitude = run.bounds.scale[i] / 65535.0 * 0.5 + magnitude * 4.0 * FLT_EPSILON;
+		slack = magnitude > slack ? magnitude : slack;
+	}
+
+	if(maximum[COMPRESS_POSITION] > slack || fabs(maximum[COMPRESS_POSITION] - run.error.position) > 1e-6 ||
+	   (format.texture >= 0 && fabs(maximum[COMPRESS_TEXTURE] - run.error.texture) > 1e-6) ||
+	   (format.normal >= 0 && fabs(maximum[COMPRESS_NORMAL] - run.error.normal) > 1e-3) ||
+	   (format.tangent >= 0 && (fabs(maximum[COMPRESS_TANGENT] - run.error.tangent) > 1e-3 || fabs(maximum[COMPRESS_BINORMAL] - run.error.binormal) > 1e-3)))
+	{
+		printf("  the decoded vertices do not match the error the compression measured\n");
+		return false;
+	}
+
+	if(packedSize >= sourceSize)
+	{
+		printf("  the packed vertex is no smaller than the source\n");
+		return false;
+	}
+
+	printf("  %d vertices after welding, %s layout\n", run.vertexCount, layoutName);
+	printf("    %d bytes per vertex before, %d after, %.1fx smaller\n", sourceSize, packedSize, (double)sourceSize / (double)packedSize);
+	printf("    at load:    %8.3f ms, %6.1f million vertices/s, with the error check and the log\n", loadTime,
+		   (double)run.vertexCount / (loadTime * 1000.0));
+	printf("    encode:     %8.3f ms, %6.1f million vertices/s\n", compressTime, (double)run.vertexCount / (compressTime * 1000.0));
+	printf("    decode:     %8.3f ms, %6.1f million vertices/s\n", decompressTime, (double)run.vertexCount / (decompressTime * 1000.0));
+
+	for(i=0; i<COMPRESS_ATTRIBUTE_COUNT; i++)
+	{
+		if(maximum[i] >= 0.0)
+		{
+			printf("    %-10s  max %.6f, RMS %.6f %s\n", COMPRESS_ATTRIBUTE_NAMES[i], maximum[i], rms[i], i < COMPRESS_NORMAL ? "units" : "degrees");
+		}
+	}
+
+	return true;
+}
+
+
+static bool BenchmarkCompressSphere()
+{
+	return RunCompressBenchmark(COMPRESS_SPHERE_FILENAME, "normal", NormalVertexLayout::format);
+}
+
+
+static bool BenchmarkCompressSaturnRing()
+{
+	return RunCompressBenchmark(COMPRESS_SATURN_RING_FILENAME, "normal", NormalVertexLayout::format);
+}
+
+
+// The earth is the sphere drawn with the bump map shader, so its vertices carry the generated tangent frame.
+static bool BenchmarkCompressBump()
+{
+	return RunCompressBenchmark(COMPRESS_SPHERE_FILENAME, "tangent", TangentVertexLayout::format);
+}
+
+
+const BenchmarkType VERTEX_COMPRESSION_BENCHMARKS[] =
+{
+	{ "VertexCompression Sphere.txt", BenchmarkCompressSphere },
+	{ "VertexCompression SaturnRing.txt", BenchmarkCompressSaturnRing },
+	{ "VertexCompression bump Sphere.txt", BenchmarkCompressBump },
+};
+
+
+int GetVertexCompressionBenchmarks(const BenchmarkType** benchmarks)
+{
+	*benchmarks = VERTEX_COMPRESSION_BENCHMARKS;
+
+	return sizeof(VERTEX_COMPRESSION_BENCHMARKS) / sizeof(VERTEX_COMPRESSION_BENCHMARKS[0]);
+}
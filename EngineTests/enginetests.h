@@ -0,0 +1,43 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: enginetests.h
+////////////////////////////////////////////////////////////////////////////////
+#ifndef _ENGINETESTS_H_
+#define _ENGINETESTS_H_
+
+
+//////////////
+// INCLUDES //
+//////////////
+#include <cstdio>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// Fails the test it is in, naming the file and line of the check, and goes on to the next test.
+#define TEST_CHECK(condition) \
+	if(!(condition)) \
+	{ \
+		printf("  %s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+		return false; \
+	}
+
+
+/////////////////////////
+// FUNCTION PROTOTYPES //
+/////////////////////////
+// Every test returns true when it passed.  The tests of one class are listed in its own file and run by main.
+typedef bool (*TestFunctionType)();
+
+struct TestType
+{
+	const char* name;
+	TestFunctionType function;
+};
+
+int GetJobSystemTests(const TestType**);
+int GetRingAllocatorTests(const TestType**);
+int GetStreamedAssetTests(const TestType**);
+int GetTextureResidencyTests(const TestType**);
+
+#endif
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: jobsystemtests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginetests.h"
+#include "../Engine/jobsystemclass.h"
+
+#include <atomic>
+
+
+static bool TestWaitRunsQueuedJobs()
+{
+	JobSystemClass jobSystem;
+	atomic<int> finished;
+	int i;
+
+
+	// Wait helps with the queue on the calling thread and only returns once the jobs those jobs submitted have run too.
+	TEST_CHECK(jobSystem.Initialize(1, 0));
+	TEST_CHECK(jobSystem.GetThreadCount() == 2);
+
+	finished = 0;
+	for(i=0; i<8; i++)
+	{
+		jobSystem.Submit("wait test", [&jobSystem, &finished]()
+		{
+			jobSystem.Submit("wait test child", [&finished]()
+			{
+				finished++;
+			});
+			finished++;
+		});
+	}
+
+	jobSystem.Wait();
+	TEST_CHECK(finished == 16);
+
+	jobSystem.Shutdown();
+
+	return true;
+}
+
+
+static bool TestInJobOnlyInsideJobs()
+{
+	JobSystemClass jobSystem;
+	atomic<int> inside, outside;
+	int i;
+
+
+	// Code such as the mesh parser asks whether it is inside a job to keep to its thread, on the workers and on the main thread
+	// while Wait has it run one, but not after.
+	TEST_CHECK(jobSystem.Initialize(1, 0));
+	TEST_CHECK(!JobSystemClass::InJob());
+
+	inside = 0;
+	outside = 0;
+	for(i=0; i<8; i++)
+	{
+		jobSystem.Submit("in job test", [&inside, &outside]()
+		{
+			if(JobSystemClass::InJob())
+			{
+				inside++;
+			}
+			else
+			{
+				outside++;
+			}
+		});
+	}
+
+	jobSystem.Wait();
+	TEST_CHECK(inside == 8);
+	TEST_CHECK(outside == 0);
+	TEST_CHECK(!JobSystemClass::InJob());
+
+	jobSystem.Shutdown();
+
+	return true;
+}
+
+
+const TestType JOB_SYSTEM_TESTS[] =
+{
+	{ "JobSystem wait runs queued jobs", TestWaitRunsQueuedJobs },
+	{ "JobSystem in job only inside jobs", TestInJobOnlyInsideJobs },
+};
+
+
+int GetJobSystemTests(const TestType** tests)
+{
+	*tests = JOB_SYSTEM_TESTS;
+
+	return sizeof(JOB_SYSTEM_TESTS) / sizeof(JOB_SYSTEM_TESTS[0]);
+}
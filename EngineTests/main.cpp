@@ -0,0 +1,62 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: main.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginetests.h"
+
+#include <cstring>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The tests only use engine classes that do not touch a device or a window, so besides the project they build with any C++17
+// compiler, for example on Linux with
+//   g++ -std=c++17 -O2 -pthread -I../Engine *.cpp ../Engine/jobsystemclass.cpp ../Engine/loadlogclass.cpp
+//       ../Engine/ringallocatorclass.cpp ../Engine/streamedassetclass.cpp ../Engine/textureresidencyclass.cpp -o enginetests
+typedef int (*GetTestsFunctionType)(const TestType**);
+
+const GetTestsFunctionType TEST_LISTS[] =
+{
+	GetJobSystemTests,
+	GetRingAllocatorTests,
+	GetStreamedAssetTests,
+	GetTextureResidencyTests,
+};
+
+
+int main(int argc, char** argv)
+{
+	const TestType* tests;
+	const char* filter;
+	int list, count, i, run, failed;
+
+
+	// enginetests [name], runs only the tests whose name has the given text in it.
+	filter = argc > 1 ? argv[1] : 0;
+
+	run = 0;
+	failed = 0;
+	for(list=0; list<(int)(sizeof(TEST_LISTS) / sizeof(TEST_LISTS[0])); list++)
+	{
+		count = TEST_LISTS[list](&tests);
+		for(i=0; i<count; i++)
+		{
+			if(filter && !strstr(tests[i].name, filter))
+			{
+				continue;
+			}
+
+			printf("%s\n", tests[i].name);
+			run++;
+			if(!tests[i].function())
+			{
+				printf("  FAILED\n");
+				failed++;
+			}
+		}
+	}
+
+	printf("%d of %d tests passed\n", run - failed, run);
+
+	return failed == 0 ? 0 : 1;
+}
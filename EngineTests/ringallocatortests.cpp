@@ -0,0 +1,222 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: ringallocatortests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginetests.h"
+#include "../Engine/ringallocatorclass.h"
+
+
+/////////////
+// GLOBALS //
+/////////////
+// The alignment and size the constant ring buffer uses, in 256 byte blocks of 16 constants.
+const unsigned int TEST_ALIGNMENT = 256;
+const unsigned int TEST_SIZE = 1024;
+
+
+static bool TestAlignment()
+{
+	RingAllocatorClass allocator;
+	unsigned int offset;
+
+
+	// Only a power of two is taken as an alignment, and the size is rounded up to it.
+	TEST_CHECK(!allocator.Initialize(TEST_SIZE, 0));
+	TEST_CHECK(!allocator.Initialize(TEST_SIZE, 384));
+	TEST_CHECK(allocator.Initialize(1000, TEST_ALIGNMENT));
+	TEST_CHECK(allocator.GetSize() == TEST_SIZE);
+
+	// Every allocation starts on a multiple of 256 and takes up a whole number of blocks, however small it is.
+	allocator.BeginFrame(1);
+	TEST_CHECK(allocator.Allocate(64, offset) && offset == 0);
+	TEST_CHECK(allocator.Allocate(0, offset) && offset == 256);
+	TEST_CHECK(allocator.Allocate(257, offset) && offset == 512);
+	TEST_CHECK(allocator.GetUsed() == 1024);
+	allocator.EndFrame();
+
+	allocator.Shutdown();
+
+	return true;
+}
+
+
+static bool TestWrapSkipsTail()
+{
+	RingAllocatorClass allocator;
+	unsigned int offset;
+
+
+	TEST_CHECK(allocator.Initialize(TEST_SIZE, TEST_ALIGNMENT));
+
+	// Frame 1 takes the first half and frame 2 the block after it, leaving 256 bytes at the end.
+	allocator.BeginFrame(1);
+	TEST_CHECK(allocator.Allocate(512, offset) && offset == 0);
+	allocator.EndFrame();
+
+	allocator.BeginFrame(2);
+	TEST_CHECK(allocator.Allocate(256, offset) && offset == 512);
+	allocator.EndFrame();
+
+	// With frame 1 done there is room at the front.  A 512 byte allocation does not fit in the 256 bytes at the end, so it starts
+	// again at the front and the tail it skipped counts as used by its frame.
+	allocator.Retire(1);
+	TEST_CHECK(allocator.GetUsed() == 256);
+
+	allocator.BeginFrame(3);
+	TEST_CHECK(allocator.Allocate(512, offset) && offset == 0);
+	TEST_CHECK(allocator.GetUsed() == 256 + 256 + 512);
+	allocator.EndFrame();
+
+	// Retiring frame 2 leaves only frame 3, skipped tail included, and retiring that empties the ring.
+	allocator.Retire(2);
+	TEST_CHECK(allocator.GetUsed() == 256 + 512);
+	TEST_CHECK(allocator.GetFramesInFlight() == 1);
+
+	allocator.Retire(3);
+	TEST_CHECK(allocator.GetUsed() == 0);
+	TEST_CHECK(allocator.GetFramesInFlight() == 0);
+
+	allocator.Shutdown();
+
+	return true;
+}
+
+
+static bool TestRetireAcrossFrameWrap()
+{
+	RingAllocatorClass allocator;
+	unsigned int offset;
+
+
+	TEST_CHECK(allocator.Initialize(TEST_SIZE, TEST_ALIGNMENT));
+
+	// The last frame index before the counter wraps, and the first two after it.
+	allocator.BeginFrame(0xffffffff);
+	TEST_CHECK(allocator.Allocate(256, offset));
+	allocator.EndFrame();
+
+	allocator.BeginFrame(0);
+	TEST_CHECK(allocator.Allocate(256, offset));
+	allocator.EndFrame();
+
+	allocator.BeginFrame(1);
+	TEST_CHECK(allocator.Allocate(256, offset));
+	allocator.EndFrame();
+
+	// A frame from before the wrap is older than every frame after it, so it is retired alone.
+	allocator.Retire(0xffffffff);
+	TEST_CHECK(allocator.GetFramesInFlight() == 2);
+	TEST_CHECK(allocator.GetUsed() == 512);
+
+	// Retiring frame 0 must not retire frame 1, and retiring a frame from before the wrap again does nothing.
+	allocator.Retire(0);
+	TEST_CHECK(allocator.GetFramesInFlight() == 1);
+	allocator.Retire(0xfffffffe);
+	TEST_CHECK(allocator.GetFramesInFlight() == 1);
+
+	allocator.Retire(1);
+	TEST_CHECK(allocator.GetUsed() == 0);
+
+	allocator.Shutdown();
+
+	return true;
+}
+
+
+static bool TestFullOfFramesInFlight()
+{
+	RingAllocatorClass allocator;
+	unsigned int offset;
+	unsigned int frame;
+
+
+	TEST_CHECK(allocator.Initialize(TEST_SIZE, TEST_ALIGNMENT));
+
+	// Four frames of one block each fill the ring.
+	for(frame=1; frame<=4; frame++)
+	{
+		allocator.BeginFrame(frame);
+		TEST_CHECK(allocator.Allocate(256, offset) && offset == (frame - 1) * 256);
+		allocator.EndFrame();
+	}
+
+	// Nothing more fits until the GPU is done with a frame, retiring a frame that was not made yet changes nothing.
+	allocator.BeginFrame(5);
+	TEST_CHECK(!allocator.Allocate(1, offset));
+	allocator.Retire(0);
+	TEST_CHECK(!allocator.Allocate(1, offset));
+	TEST_CHECK(allocator.GetUsed() == TEST_SIZE);
+
+	// Once frame 1 is retired its block is handed out again, and only that block.
+	allocator.Retire(1);
+	TEST_CHECK(allocator.Allocate(256, offset) && offset == 0);
+	TEST_CHECK(!allocator.Allocate(1, offset));
+	allocator.EndFrame();
+
+	allocator.Shutdown();
+
+	return true;
+}
+
+
+static bool TestGrowAtLeastDoubles()
+{
+	RingAllocatorClass allocator;
+	unsigned int offset;
+	int i;
+
+
+	TEST_CHECK(allocator.Initialize(TEST_SIZE, TEST_ALIGNMENT));
+
+	allocator.BeginFrame(1);
+	for(i=0; i<4; i++)
+	{
+		TEST_CHECK(allocator.Allocate(200, offset));
+	}
+	allocator.EndFrame();
+
+	// Asking for less than twice the size still doubles it, asking for more gives at least that much, aligned.
+	TEST_CHECK(allocator.GetGrowSize(256) == 2 * TEST_SIZE);
+	TEST_CHECK(allocator.GetGrowSize(3000) == 3072);
+	TEST_CHECK(allocator.GetSize() == TEST_SIZE);
+
+	// The frame that did not fit grows the ring, which starts out empty with the frames in flight left behind in the old one.
+	allocator.BeginFrame(2);
+	TEST_CHECK(!allocator.Allocate(200, offset));
+
+	allocator.Grow(5 * 256);
+	TEST_CHECK(allocator.GetSize() == 2 * TEST_SIZE);
+	TEST_CHECK(allocator.GetUsed() == 0);
+	TEST_CHECK(allocator.GetFramesInFlight() == 0);
+
+	for(i=0; i<5; i++)
+	{
+		TEST_CHECK(allocator.Allocate(200, offset) && offset == (unsigned int)i * 256);
+	}
+	allocator.EndFrame();
+
+	// Growing again doubles from the new size.
+	allocator.Grow(0);
+	TEST_CHECK(allocator.GetSize() == 4 * TEST_SIZE);
+
+	allocator.Shutdown();
+
+	return true;
+}
+
+
+const TestType RING_ALLOCATOR_TESTS[] =
+{
+	{ "RingAllocator alignment", TestAlignment },
+	{ "RingAllocator wrap skips tail", TestWrapSkipsTail },
+	{ "RingAllocator retire across frame wrap", TestRetireAcrossFrameWrap },
+	{ "RingAllocator full of frames in flight", TestFullOfFramesInFlight },
+	{ "RingAllocator grow at least doubles", TestGrowAtLeastDoubles },
+};
+
+
+int GetRingAllocatorTests(const TestType** tests)
+{
+	*tests = RING_ALLOCATOR_TESTS;
+
+	return sizeof(RING_ALLOCATOR_TESTS) / sizeof(RING_ALLOCATOR_TESTS[0]);
+}
@@ -0,0 +1,306 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: streamedassettests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginetests.h"
+#include "../Engine/streamedassetclass.h"
+#include "../Engine/loadlogclass.h"
+
+#include <atomic>
+
+
+/////////////
+// GLOBALS //
+/////////////
+const int STREAM_ASSET_COUNT = 3;
+
+// Every loader job sleeps this long before it runs, like a slow disk, and then waits until the test lets its read finish.
+const int STREAM_JOB_DELAY = 20;
+
+// Frames run while nothing has loaded, to show the frame loop does not wait on the loaders.
+const int STREAM_STALLED_FRAMES = 50;
+
+// How long the loads are held back while the frame loop is timed, and the longest a frame may take meanwhile, in milliseconds.
+// A frame that waited on a loader would take the whole hold, one that does not takes microseconds.
+const double STREAM_HOLD_TIME = 200.0;
+const double STREAM_FRAME_LIMIT = 10.0;
+
+// How long a frame loop waits for a job before the test gives up on it, in milliseconds.
+const int STREAM_TIMEOUT = 5000;
+
+
+// What the test keeps for each asset, the engine class and what the frame loop did with it.
+struct StreamTestType
+{
+	StreamedAssetClass asset;
+	atomic<bool> readDone;
+	bool swapResult;
+	int swaps;
+	int placeholderDraws;
+	int draws;
+	thread::id swapThread;
+};
+
+
+static void SubmitLoader(JobSystemClass& jobSystem, StreamTestType& test, bool loadResult, bool swapResult)
+{
+	test.readDone = false;
+	test.swapResult = swapResult;
+	test.swaps = 0;
+	test.placeholderDraws = 0;
+	test.draws = 0;
+
+	jobSystem.Submit("stream test", [&test, loadResult]()
+	{
+		// Wait for the read the test holds back, then hand the result to the frame loop.
+		while(!test.readDone)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+
+		test.asset.SetLoaded(loadResult);
+	});
+
+	return;
+}
+
+
+// One frame of the frame loop, it updates every asset the way the models do and counts what each drew.
+static void RunFrame(StreamTestType* tests, int count)
+{
+	int i;
+
+
+	for(i=0; i<count; i++)
+	{
+		StreamTestType& test = tests[i];
+
+		test.asset.Update([&test]()
+		{
+			test.swaps++;
+			test.swapThread = this_thread::get_id();
+			return test.swapResult;
+		});
+
+		if(test.asset.IsResident())
+		{
+			test.draws++;
+		}
+		else
+		{
+			test.placeholderDraws++;
+		}
+	}
+
+	return;
+}
+
+
+// Runs frames until the asset's job has finished, the way the frame loop keeps going while it loads.
+static bool RunFramesUntilLoaded(StreamTestType* tests, int count, int asset)
+{
+	chrono::steady_clock::time_point startTime;
+
+
+	startTime = chrono::steady_clock::now();
+	while(tests[asset].asset.GetState() == LOAD_STATE_PENDING)
+	{
+		if(chrono::steady_clock::now() - startTime > chrono::milliseconds(STREAM_TIMEOUT))
+		{
+			return false;
+		}
+
+		RunFrame(tests, count);
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+
+	return true;
+}
+
+
+static bool TestPlaceholdersUntilLoaded()
+{
+	JobSystemClass jobSystem;
+	StreamTestType tests[STREAM_ASSET_COUNT];
+	int frame, i;
+
+
+	TEST_CHECK(jobSystem.Initialize(2, STREAM_JOB_DELAY));
+
+	for(i=0; i<STREAM_ASSET_COUNT; i++)
+	{
+		SubmitLoader(jobSystem, tests[i], true, true);
+	}
+
+	// Nothing has been read yet, so every frame draws every placeholder and nothing is swapped.
+	for(frame=0; frame<STREAM_STALLED_FRAMES; frame++)
+	{
+		RunFrame(tests, STREAM_ASSET_COUNT);
+	}
+
+	for(i=0; i<STREAM_ASSET_COUNT; i++)
+	{
+		TEST_CHECK(tests[i].asset.GetState() == LOAD_STATE_PENDING);
+		TEST_CHECK(tests[i].swaps == 0);
+		TEST_CHECK(tests[i].placeholderDraws == STREAM_STALLED_FRAMES && tests[i].draws == 0);
+	}
+
+	// Let the reads finish one at a time.  The asset whose loader finished is swapped in once, on the frame loop's thread, and
+	// drawn in full from then on, the others keep drawing their placeholders.
+	for(i=0; i<STREAM_ASSET_COUNT; i++)
+	{
+		tests[i].readDone = true;
+		TEST_CHECK(RunFramesUntilLoaded(tests, STREAM_ASSET_COUNT, i));
+
+		RunFrame(tests, STREAM_ASSET_COUNT);
+		TEST_CHECK(tests[i].asset.IsResident() && tests[i].draws > 0);
+		TEST_CHECK(tests[i].swaps == 1 && tests[i].swapThread == this_thread::get_id());
+		TEST_CHECK(!tests[i].asset.TakeFailure());
+
+		if(i + 1 < STREAM_ASSET_COUNT)
+		{
+			TEST_CHECK(tests[i + 1].asset.GetState() == LOAD_STATE_PENDING && tests[i + 1].draws == 0);
+		}
+	}
+
+	jobSystem.Shutdown();
+
+	return true;
+}
+
+
+static bool TestFramesDoNotWaitOnLoads()
+{
+	JobSystemClass jobSystem;
+	StreamTestType tests[STREAM_ASSET_COUNT];
+	double startTime, frameStart, frameTime, longestFrame;
+	int frames, i;
+
+
+	TEST_CHECK(jobSystem.Initialize(STREAM_ASSET_COUNT, 0));
+
+	for(i=0; i<STREAM_ASSET_COUNT; i++)
+	{
+		SubmitLoader(jobSystem, tests[i], true, true);
+	}
+
+	// Hold every load back and time each frame meanwhile, none may come near the time the loads take.
+	frames = 0;
+	longestFrame = 0.0;
+	startTime = LoadLogClass::GetTime();
+	while(LoadLogClass::GetTime() - startTime < STREAM_HOLD_TIME)
+	{
+		frameStart = LoadLogClass::GetTime();
+		RunFrame(tests, STREAM_ASSET_COUNT);
+		frameTime = LoadLogClass::GetTime() - frameStart;
+
+		longestFrame = frameTime > longestFrame ? frameTime : longestFrame;
+		frames++;
+		this_thread::sleep_for(chrono::milliseconds(1));
+	}
+
+	TEST_CHECK(longestFrame < STREAM_FRAME_LIMIT);
+	TEST_CHECK(frames >= (int)(STREAM_HOLD_TIME / STREAM_FRAME_LIMIT));
+
+	for(i=0; i<STREAM_ASSET_COUNT; i++)
+	{
+		TEST_CHECK(tests[i].asset.GetState() == LOAD_STATE_PENDING && tests[i].placeholderDraws == frames);
+		tests[i].readDone = true;
+	}
+
+	jobSystem.Wait();
+	RunFrame(tests, STREAM_ASSET_COUNT);
+
+	for(i=0; i<STREAM_ASSET_COUNT; i++)
+	{
+		TEST_CHECK(tests[i].asset.IsResident());
+	}
+
+	jobSystem.Shutdown();
+
+	return true;
+}
+
+
+static bool TestFailedLoadKeepsPlaceholder()
+{
+	JobSystemClass jobSystem;
+	StreamTestType tests[2];
+	int frame;
+
+
+	TEST_CHECK(jobSystem.Initialize(1, STREAM_JOB_DELAY));
+
+	SubmitLoader(jobSystem, tests[0], false, true);
+	SubmitLoader(jobSystem, tests[1], true, true);
+
+	// The failed asset is never swapped in, the one behind it on the same worker still loads.
+	tests[0].readDone = true;
+	tests[1].readDone = true;
+	TEST_CHECK(RunFramesUntilLoaded(tests, 2, 0));
+	TEST_CHECK(RunFramesUntilLoaded(tests, 2, 1));
+
+	for(frame=0; frame<3; frame++)
+	{
+		RunFrame(tests, 2);
+	}
+
+	TEST_CHECK(tests[0].asset.IsFailed() && tests[0].swaps == 0 && tests[0].draws == 0);
+	TEST_CHECK(tests[1].asset.IsResident() && tests[1].draws > 0);
+
+	// The failure is reported once, not every frame, and the placeholder is still drawn after that.
+	TEST_CHECK(tests[0].asset.TakeFailure());
+	TEST_CHECK(!tests[0].asset.TakeFailure());
+
+	RunFrame(tests, 2);
+	TEST_CHECK(tests[0].asset.IsFailed() && tests[0].draws == 0 && !tests[0].asset.TakeFailure());
+
+	jobSystem.Shutdown();
+
+	return true;
+}
+
+
+static bool TestFailedSwapKeepsPlaceholder()
+{
+	JobSystemClass jobSystem;
+	StreamTestType test;
+	int frame;
+
+
+	TEST_CHECK(jobSystem.Initialize(1, 0));
+
+	// The load works but creating its GPU resources does not, the swap is not tried again.
+	SubmitLoader(jobSystem, test, true, false);
+	test.readDone = true;
+	jobSystem.Wait();
+
+	for(frame=0; frame<3; frame++)
+	{
+		RunFrame(&test, 1);
+	}
+
+	TEST_CHECK(test.asset.IsFailed() && test.swaps == 1 && test.draws == 0 && test.placeholderDraws == 3);
+	TEST_CHECK(test.asset.TakeFailure());
+	TEST_CHECK(!test.asset.TakeFailure());
+
+	jobSystem.Shutdown();
+
+	return true;
+}
+
+
+const TestType STREAMED_ASSET_TESTS[] =
+{
+	{ "StreamedAsset placeholders until loaded", TestPlaceholdersUntilLoaded },
+	{ "StreamedAsset frames do not wait on loads", TestFramesDoNotWaitOnLoads },
+	{ "StreamedAsset failed load keeps placeholder", TestFailedLoadKeepsPlaceholder },
+	{ "StreamedAsset failed swap keeps placeholder", TestFailedSwapKeepsPlaceholder },
+};
+
+
+int GetStreamedAssetTests(const TestType** tests)
+{
+	*tests = STREAMED_ASSET_TESTS;
+
+	return sizeof(STREAMED_ASSET_TESTS) / sizeof(STREAMED_ASSET_TESTS[0]);
+}
@@ -0,0 +1,285 @@
+////////////////////////////////////////////////////////////////////////////////
+// Filename: textureresidencytests.cpp
+////////////////////////////////////////////////////////////////////////////////
+#include "enginetests.h"
+#include "../Engine/textureresidencyclass.h"
+
+#include <cfloat>
+#include <cmath>
+
+
+/////////////
+// GLOBALS //
+/////////////
+// 1024 square textures with their full chain of 11 mips, one byte a texel so the size of a chain is its texel count.  The four
+// lowest mips, 8 by 8 down, are always resident.
+const int TEST_TEXTURE_SIZE = 1024;
+const int TEST_MIP_COUNT = 11;
+const int TEST_RESIDENT_MIPS = 4;
+const int TEST_LOWEST_TOP_MIP = TEST_MIP_COUNT - TEST_RESIDENT_MIPS;
+
+// What a 60 degree field of view on a 1080 line screen makes of one unit at a distance of one.
+const float TEST_PIXEL_SCALE = 540.0f / 0.57735f;
+
+
+static long long GetChainSize(int size, int topMip, int mipCount)
+{
+	long long texels;
+	int mip;
+
+
+	texels = 0;
+	for(mip=topMip; mip<mipCount; mip++)
+	{
+		texels += (long long)(size >> mip) * (size >> mip);
+	}
+
+	return texels;
+}
+
+
+static int AddTestTexture(TextureResidencyClass& residency)
+{
+	return residency.Add(TEST_TEXTURE_SIZE, TEST_TEXTURE_SIZE, TEST_MIP_COUNT, GetChainSize(TEST_TEXTURE_SIZE, 0, TEST_MIP_COUNT));
+}
+
+
+static bool TestStartsWithLowestMips()
+{
+	TextureResidencyClass residency;
+	TextureResidencyClass::StatisticsType statistics;
+	vector<TextureResidencyClass::ChangeType> changes;
+	int texture;
+
+
+	TEST_CHECK(!residency.Initialize(0, TEST_RESIDENT_MIPS));
+	TEST_CHECK(residency.Initialize(64 * 1024 * 1024, TEST_RESIDENT_MIPS));
+
+	// A new texture only has its lowest mips, and a frame it is not drawn in changes nothing.
+	texture = AddTestTexture(residency);
+	TEST_CHECK(residency.GetTopMip(texture) == TEST_LOWEST_TOP_MIP);
+
+	residency.Update(changes);
+	TEST_CHECK(changes.empty());
+
+	residency.GetStatistics(statistics);
+	TEST_CHECK(statistics.textureCount == 1);
+	TEST_CHECK(statistics.residentBytes == GetChainSize(TEST_TEXTURE_SIZE, TEST_LOWEST_TOP_MIP, TEST_MIP_COUNT));
+
+	residency.Shutdown();
+
+	return true;
+}
+
+
+static bool TestEvictsLeastRecentlyDrawn()
+{
+	TextureResidencyClass residency;
+	TextureResidencyClass::StatisticsType statistics;
+	vector<TextureResidencyClass::ChangeType> changes;
+	long long fullSize, lowestSize;
+	int first, second, third;
+
+
+	// Room for two textures in full and the lowest mips of a third.
+	fullSize = GetChainSize(TEST_TEXTURE_SIZE, 0, TEST_MIP_COUNT);
+	lowestSize = GetChainSize(TEST_TEXTURE_SIZE, TEST_LOWEST_TOP_MIP, TEST_MIP_COUNT);
+	TEST_CHECK(residency.Initialize(2 * fullSize + lowestSize, TEST_RESIDENT_MIPS));
+
+	first = AddTestTexture(residency);
+	second = AddTestTexture(residency);
+	third = AddTestTexture(residency);
+
+	// Draw the first, then the second, up close, each streams in its whole chain in one change.
+	residency.Request(first, FLT_MAX);
+	residency.Update(changes);
+	TEST_CHECK(changes.size() == 1 && changes[0].texture == first && changes[0].topMip == 0);
+
+	residency.Request(second, FLT_MAX);
+	residency.Update(changes);
+	TEST_CHECK(changes.size() == 1 && changes[0].texture == second && changes[0].topMip == 0);
+
+	// Both keep their mips while nothing else wants the room.
+	residency.Update(changes);
+	TEST_CHECK(changes.empty());
+
+	// The third needs the room of one of them.  The first was drawn longest ago, so it goes back to its lowest mips and the second,
+	// drawn since, keeps all of its own.
+	residency.Request(third, FLT_MAX);
+	residency.Update(changes);
+
+	TEST_CHECK(residency.GetTopMip(third) == 0);
+	TEST_CHECK(residency.GetTopMip(first) == TEST_LOWEST_TOP_MIP);
+	TEST_CHECK(residency.GetTopMip(second) == 0);
+	TEST_CHECK(changes.size() == 2);
+
+	residency.GetStatistics(statistics);
+	TEST_CHECK(statistics.residentBytes <= statistics.budget);
+	TEST_CHECK(statistics.evictedMips == TEST_LOWEST_TOP_MIP);
+	TEST_CHECK(statistics.streamedMips == 3 * TEST_LOWEST_TOP_MIP);
+
+	residency.Shutdown();
+
+	return true;
+}
+
+
+static bool TestKeepsTexturesInView()
+{
+	TextureResidencyClass residency;
+	TextureResidencyClass::StatisticsType statistics;
+	vector<TextureResidencyClass::ChangeType> changes;
+	long long fullSize, lowestSize;
+	int inView, outOfView, other;
+
+
+	fullSize = GetChainSize(TEST_TEXTURE_SIZE, 0, TEST_MIP_COUNT);
+	lowestSize = GetChainSize(TEST_TEXTURE_SIZE, TEST_LOWEST_TOP_MIP, TEST_MIP_COUNT);
+	TEST_CHECK(residency.Initialize(2 * fullSize + lowestSize, TEST_RESIDENT_MIPS));
+
+	inView = AddTestTexture(residency);
+	outOfView = AddTestTexture(residency);
+	other = AddTestTexture(residency);
+
+	// The texture that stays in view was streamed in first, so it is the oldest.  It is drawn every frame after that, so the
+	// texture that left view gives up its mips for the new one instead.
+	residency.Request(inView, FLT_MAX);
+	residency.Update(changes);
+
+	residency.Request(inView, FLT_MAX);
+	residency.Request(outOfView, FLT_MAX);
+	residency.Update(changes);
+
+	residency.Request(inView, FLT_MAX);
+	residency.Request(other, FLT_MAX);
+	residency.Update(changes);
+
+	TEST_CHECK(residency.GetTopMip(inView) == 0);
+	TEST_CHECK(residency.GetTopMip(other) == 0);
+	TEST_CHECK(residency.GetTopMip(outOfView) == TEST_LOWEST_TOP_MIP);
+
+	// A budget too small for even the lowest mips takes every mip above them and never the lowest ones themselves.
+	residency.Shutdown();
+	TEST_CHECK(residency.Initialize(1, TEST_RESIDENT_MIPS));
+
+	inView = AddTestTexture(residency);
+	other = AddTestTexture(residency);
+
+	residency.Request(inView, FLT_MAX);
+	residency.Request(other, FLT_MAX);
+	residency.Update(changes);
+
+	TEST_CHECK(changes.empty());
+	TEST_CHECK(residency.GetTopMip(inView) == TEST_LOWEST_TOP_MIP);
+	TEST_CHECK(residency.GetTopMip(other) == TEST_LOWEST_TOP_MIP);
+
+	residency.GetStatistics(statistics);
+	TEST_CHECK(statistics.residentBytes == 2 * lowestSize);
+
+	residency.Shutdown();
+
+	return true;
+}
+
+
+static bool TestUploadLimitDefersStreaming()
+{
+	TextureResidencyClass residency;
+	vector<TextureResidencyClass::ChangeType> changes;
+	long long size;
+	int first, second;
+
+
+	// Two 2048 square textures of four bytes a texel are over the upload limit of a frame together, so the second one waits
+	// with the mips it has and nothing is evicted to make room for it.
+	size = 4 * GetChainSize(2048, 0, 12);
+	TEST_CHECK(size > TEXTURE_RESIDENCY_UPLOAD_LIMIT / 2 && size < TEXTURE_RESIDENCY_UPLOAD_LIMIT * 4);
+	TEST_CHECK(residency.Initialize(4 * size, TEST_RESIDENT_MIPS));
+
+	first = residency.Add(2048, 2048, 12, size);
+	second = residency.Add(2048, 2048, 12, size);
+
+	residency.Request(first, FLT_MAX);
+	residency.Request(second, FLT_MAX);
+	residency.Update(changes);
+
+	TEST_CHECK(changes.size() == 1);
+	TEST_CHECK(residency.GetTopMip(changes[0].texture) == 0);
+	TEST_CHECK(residency.GetTopMip(changes[0].texture == first ? second : first) == 12 - TEST_RESIDENT_MIPS);
+
+	// The next frame it streams in.
+	residency.Request(first, FLT_MAX);
+	residency.Request(second, FLT_MAX);
+	residency.Update(changes);
+
+	TEST_CHECK(residency.GetTopMip(first) == 0 && residency.GetTopMip(second) == 0);
+
+	residency.Shutdown();
+
+	return true;
+}
+
+
+static bool TestScreenSizeSelectsMip()
+{
+	TextureResidencyClass residency;
+	vector<TextureResidencyClass::ChangeType> changes;
+	float pixels;
+	int texture;
+
+
+	TEST_CHECK(residency.Initialize(64 * 1024 * 1024, TEST_RESIDENT_MIPS));
+	texture = AddTestTexture(residency);
+
+	// These are the sizes SelectLod asks for.  A sphere of radius one 20 units ahead covers about 94 pixels, so it wants 187
+	// texels across, which mip 2, 256 texels, still has and mip 3 does not.
+	pixels = TextureResidencyClass::GetScreenSize(20.0f, 20.0f, 1.0f, 0.0f, TEST_PIXEL_SCALE);
+	TEST_CHECK(fabsf(pixels - 93.53f) < 0.1f);
+
+	residency.Request(texture, pixels);
+	residency.Update(changes);
+	TEST_CHECK(residency.GetTopMip(texture) == 2);
+
+	// Further away it asks for less, but a texture keeps the mips it has while the budget has room.
+	residency.Request(texture, TextureResidencyClass::GetScreenSize(200.0f, 200.0f, 1.0f, 0.0f, TEST_PIXEL_SCALE));
+	residency.Update(changes);
+	TEST_CHECK(changes.empty() && residency.GetTopMip(texture) == 2);
+
+	// With the camera inside the sphere, or a group of instances spread out to reach it, everything is wanted.
+	TEST_CHECK(TextureResidencyClass::GetScreenSize(0.5f, 0.5f, 1.0f, 0.0f, TEST_PIXEL_SCALE) == FLT_MAX);
+	TEST_CHECK(TextureResidencyClass::GetScreenSize(20.0f, 20.0f, 1.0f, 19.5f, TEST_PIXEL_SCALE) == FLT_MAX);
+
+	residency.Request(texture, TextureResidencyClass::GetScreenSize(0.5f, 0.5f, 1.0f, 0.0f, TEST_PIXEL_SCALE));
+	residency.Update(changes);
+	TEST_CHECK(changes.size() == 1 && residency.GetTopMip(texture) == 0);
+
+	// Behind the camera nothing is asked for, and far away no more than the lowest mips.
+	TEST_CHECK(TextureResidencyClass::GetScreenSize(-20.0f, 20.0f, 1.0f, 0.0f, TEST_PIXEL_SCALE) == 0.0f);
+
+	texture = AddTestTexture(residency);
+	residency.Request(texture, TextureResidencyClass::GetScreenSize(10000.0f, 10000.0f, 1.0f, 0.0f, TEST_PIXEL_SCALE));
+	residency.Update(changes);
+	TEST_CHECK(changes.empty() && residency.GetTopMip(texture) == TEST_LOWEST_TOP_MIP);
+
+	residency.Shutdown();
+
+	return true;
+}
+
+
+const TestType TEXTURE_RESIDENCY_TESTS[] =
+{
+	{ "TextureResidency starts with lowest mips", TestStartsWithLowestMips },
+	{ "TextureResidency evicts least recently drawn", TestEvictsLeastRecentlyDrawn },
+	{ "TextureResidency keeps textures in view", TestKeepsTexturesInView },
+	{ "TextureResidency upload limit defers streaming", TestUploadLimitDefersStreaming },
+	{ "TextureResidency screen size selects mip", TestScreenSizeSelectsMip },
+};
+
+
+int GetTextureResidencyTests(const TestType** tests)
+{
+	*tests = TEXTURE_RESIDENCY_TESTS;
+
+	return sizeof(TEXTURE_RESIDENCY_TESTS) / sizeof(TEXTURE_RESIDENCY_TESTS[0]);
+}